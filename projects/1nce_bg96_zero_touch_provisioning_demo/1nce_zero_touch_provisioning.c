@@ -52,6 +52,9 @@
 /* 1NCE onboarding header*/
 #include "1nce_zero_touch_provisioning.h"
 
+/* Platform layer include, for the heap tags. */
+#include "cellular_platform.h"
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -484,7 +487,7 @@ static uint8_t nceReinitConnParams( char * completeResponse,
             memcpy( PART, token + 1, strlen( token ) - 1 );
             char * result = str_replace( PART, find, replaceWith );
             memcpy( PART, result, strlen( PART ) );
-            vPortFree( result );
+            Platform_FreeTagged( result );
             offset = ( int32_t ) ( &PART[ 0 ] );
             location = strstr( PART, endCert );
             strSize = ( int32_t ) location + endCertLen - offset;
@@ -509,7 +512,7 @@ static uint8_t nceReinitConnParams( char * completeResponse,
             memcpy( PART, token + 1, strlen( token ) - 1 );
             char * result = str_replace( PART, find, replaceWith );
             memcpy( PART, result, strlen( PART ) );
-            vPortFree( result );
+            Platform_FreeTagged( result );
             offset = ( int32_t ) ( &PART[ 0 ] );
             location = strstr( PART, endCert );
             strSize = ( int32_t ) location + endCertLen - offset;
@@ -533,7 +536,7 @@ static uint8_t nceReinitConnParams( char * completeResponse,
             memcpy( PART, token + 1, strlen( token ) - 1 );
             char * result = str_replace( PART, find, replaceWith );
             memcpy( PART, result, strlen( PART ) );
-            vPortFree( result );
+            Platform_FreeTagged( result );
             offset = ( int32_t ) ( &PART[ 0 ] );
             location = strstr( PART, endKey );
             strSize = ( int32_t ) location + endKeyLen - offset;
@@ -617,7 +620,7 @@ char * str_replace( char * orig,
         ins = tmp + lenRep;
     }
 
-    tmp = result = pvPortMalloc( strlen( orig ) + ( lenWith - lenRep ) * count + 1 );
+    tmp = result = Platform_MallocTagged( strlen( orig ) + ( lenWith - lenRep ) * count + 1, PLATFORM_HEAP_TAG_ONBOARDING );
 
     if( !result )
     {
@@ -46,6 +46,9 @@
 /* Demo Specific configs. */
 #include "demo_config.h"
 
+/* Cellular comm interface include file for the wire trace dump. */
+#include "comm_if.h"
+
 /* Use by the pseudo random number generator. */
 static UBaseType_t ulNextRand;
 
@@ -130,6 +133,27 @@ void vAssertCalled( const char * pcFile,
 
     configPRINTF( ( "vAssertCalled( %s, %u\n", pcFile, ulLine ) );
 
+    #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+        {
+            /* Keep the last traffic of each modem port for the post mortem. Only
+             * once, in case the dump itself asserts. */
+            static bool xTraceDumped = false;
+            char cTracePath[ 32 ];
+            uint32_t ulInstance;
+
+            if( xTraceDumped == false )
+            {
+                xTraceDumped = true;
+
+                for( ulInstance = 0; ulInstance < CELLULAR_COMM_INTERFACE_MAX_INSTANCES; ulInstance++ )
+                {
+                    ( void ) snprintf( cTracePath, sizeof( cTracePath ), "comm_trace_%u.ccap", ( unsigned int ) ulInstance );
+                    ( void ) CellularCommInterface_DumpTrace( ulInstance, cTracePath );
+                }
+            }
+        }
+    #endif
+
     /* Setting ulBlockVariable to a non-zero value in the debugger will allow
      * this function to be exited. */
     taskDISABLE_INTERRUPTS();
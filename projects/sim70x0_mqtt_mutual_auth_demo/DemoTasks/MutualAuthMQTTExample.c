@@ -65,6 +65,9 @@
     #include "1nce_zero_touch_provisioning.h"
 #endif
 
+/* Platform layer include, for the clock and the heap and run time reports. */
+#include "cellular_platform.h"
+
 /*-----------------------------------------------------------*/
 
 /* Compile time error for undefined configs. */
@@ -267,16 +270,6 @@
     #define CLIENT_USERNAME_WITH_METRICS    democonfigCLIENT_USERNAME AWS_IOT_METRICS_STRING
 #endif
 
-/**
- * @brief Milliseconds per second.
- */
-#define MILLISECONDS_PER_SECOND    ( 1000U )
-
-/**
- * @brief Milliseconds per FreeRTOS tick.
- */
-#define MILLISECONDS_PER_TICK      ( MILLISECONDS_PER_SECOND / configTICK_RATE_HZ )
-
 /*-----------------------------------------------------------*/
 
 /**
@@ -394,10 +387,10 @@ static uint8_t ucSharedBuffer[ democonfigNETWORK_BUFFER_SIZE ];
 /**
  * @brief Global entry time into the application to use as a reference timestamp
  * in the #prvGetTimeMs function. #prvGetTimeMs will always return the difference
- * between the current time and the global entry time. This will reduce the chances
+ * between the platform clock and the global entry time. This will reduce the chances
  * of overflow for the 32 bit unsigned integer used for holding the timestamp.
  */
-static uint32_t ulGlobalEntryTimeMs;
+static uint64_t ullGlobalEntryTimeMs;
 
 /**
  * @brief Packet Identifier generated when Publish request was sent to the broker;
@@ -483,7 +476,7 @@ void RunMQTTTask( void * pvParameters )
      * to calculate relative time elapsed in the execution of the demo application,
      * by the timer utility function that is provided to the MQTT library.
      */
-    ulGlobalEntryTimeMs = prvGetTimeMs();
+    ullGlobalEntryTimeMs = Platform_GetTimeMs();
 
     #ifdef USE_1NCE_ZERO_TOUCH_PROVISIONING
         uint8_t status = nce_onboard( &pThingName,
@@ -583,6 +576,12 @@ void RunMQTTTask( void * pvParameters )
         LogInfo( ( "RunMQTTTask() completed an iteration successfully. "
                    "Total free heap is %u.\r\n",
                    xPortGetFreeHeapSize() ) );
+        #if ( PLATFORM_HEAP_TAGS_ENABLE == 1 )
+            Platform_HeapTagReport();
+        #endif
+        #if ( configGENERATE_RUN_TIME_STATS == 1 )
+            Platform_RunTimeStatsReport();
+        #endif
         LogInfo( ( "Demo completed successfully.\r\n" ) );
         LogInfo( ( "Short delay before starting the next iteration.... \r\n\r\n" ) );
         vTaskDelay( mqttexampleDELAY_BETWEEN_DEMO_ITERATIONS_TICKS );
@@ -1051,18 +1050,11 @@ static void prvEventCallback( MQTTContext_t * pxMQTTContext,
 
 static uint32_t prvGetTimeMs( void )
 {
-    TickType_t xTickCount = 0;
     uint32_t ulTimeMs = 0UL;
 
-    /* Get the current tick count. */
-    xTickCount = xTaskGetTickCount();
-
-    /* Convert the ticks to milliseconds. */
-    ulTimeMs = ( uint32_t ) xTickCount * MILLISECONDS_PER_TICK;
-
-    /* Reduce ulGlobalEntryTimeMs from obtained time so as to always return the
-     * elapsed time in the application. */
-    ulTimeMs = ( uint32_t ) ( ulTimeMs - ulGlobalEntryTimeMs );
+    /* Reduce ullGlobalEntryTimeMs from the platform clock so as to always return
+     * the elapsed time in the application. */
+    ulTimeMs = ( uint32_t ) ( Platform_GetTimeMs() - ullGlobalEntryTimeMs );
 
     return ulTimeMs;
 }
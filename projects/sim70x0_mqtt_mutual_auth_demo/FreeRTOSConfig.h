@@ -47,7 +47,7 @@
 #define configMINIMAL_STACK_SIZE                   ( ( unsigned short ) 60 ) /* In this simulated case, the stack only has to hold one small structure as the real stack is part of the Win32 thread. */
 #define configTOTAL_HEAP_SIZE                      ( ( size_t ) ( 2048U * 1024U ) )
 #define configMAX_TASK_NAME_LEN                    ( 15 )
-#define configUSE_TRACE_FACILITY                   0
+#define configUSE_TRACE_FACILITY                   configGENERATE_RUN_TIME_STATS
 #define configUSE_16_BIT_TICKS                     0
 #define configIDLE_SHOULD_YIELD                    1
 #define configUSE_CO_ROUTINES                      0
@@ -57,7 +57,7 @@
 #define configUSE_APPLICATION_TASK_TAG             0
 #define configUSE_COUNTING_SEMAPHORES              1
 #define configUSE_ALTERNATIVE_API                  0
-#define configNUM_THREAD_LOCAL_STORAGE_POINTERS    0
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS    configGENERATE_RUN_TIME_STATS
 #define configENABLE_BACKWARD_COMPATIBILITY        1
 #define configSUPPORT_STATIC_ALLOCATION            1
 
@@ -76,8 +76,28 @@
 /* Event group related definitions. */
 #define configUSE_EVENT_GROUPS                     1
 
-/* Run time stats gathering configuration options. */
-#define configGENERATE_RUN_TIME_STATS              0
+/* Run time stats gathering configuration options. Set configGENERATE_RUN_TIME_STATS
+ * to 1 to count the CPU time of every task with the platform clock and the times
+ * it is switched in. Platform_RunTimeStatsReport logs them. */
+#ifndef configGENERATE_RUN_TIME_STATS
+    #define configGENERATE_RUN_TIME_STATS          0
+#endif
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+    /* The run time counter counts microseconds in 64 bits, 32 bits wrap after
+     * 71 minutes. Kernels older than V10.4.4 count in 32 bits whatever
+     * configRUN_TIME_COUNTER_TYPE is. */
+    extern uint64_t Platform_GetTimeUs( void );
+    #define configRUN_TIME_COUNTER_TYPE         uint64_t
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+    #define portGET_RUN_TIME_COUNTER_VALUE()    ( ( configRUN_TIME_COUNTER_TYPE ) Platform_GetTimeUs() )
+
+    /* The thread local storage pointer of this index counts the times a task is switched in. */
+    #define configTASK_SWITCHES_TLS_INDEX       0
+    #define traceTASK_SWITCHED_IN()                                              \
+    pxCurrentTCB->pvThreadLocalStoragePointer[ configTASK_SWITCHES_TLS_INDEX ] = \
+        ( void * ) ( ( uintptr_t ) pxCurrentTCB->pvThreadLocalStoragePointer[ configTASK_SWITCHES_TLS_INDEX ] + 1U )
+#endif
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES                      0
@@ -195,9 +215,11 @@
 #endif
 
 /* Visual studio does not have an implementation of strcasecmp(). */
-#define strcasecmp     _stricmp
-#define strncasecmp    _strnicmp
-#define strcmpi        _strcmpi
+#if defined( _MSC_VER )
+    #define strcasecmp     _stricmp
+    #define strncasecmp    _strnicmp
+    #define strcmpi        _strcmpi
+#endif
 
 /* Prototype for the function used to print out.  In this case it prints to the
  * console before the network is connected then a UDP port after the network has
@@ -24,9 +24,25 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
 #include "cellular_platform.h"
 
+/* FreeRTOS task APIs for the threads. */
+#include "task.h"
+
+#if defined( PLATFORM_GET_TIME_US )
+    /* The clock is provided by the target. */
+#elif defined( _WIN32 ) || defined( _WIN64 )
+    /* Performance counter of the Windows simulator. */
+    #include <windows.h>
+#elif defined( __unix__ ) || defined( __APPLE__ )
+    #include <time.h>
+#endif
+
 /*-----------------------------------------------------------*/
 
 typedef QueueHandle_t SemaphoreHandle_t;
@@ -35,17 +51,154 @@ typedef struct threadInfo
 {
     void * pArgument;                  /**< @brief Argument to `threadRoutine`. */
     void ( *threadRoutine )( void * ); /**< @brief Thread function to run. */
+    int32_t priority;                  /**< @brief Priority to run `threadRoutine` on a worker. */
 } threadInfo_t;
 
 /*-----------------------------------------------------------*/
 
+#if ( PLATFORM_MALLOC_SLAB_ENABLE == 1 )
+
+/**
+ * @brief Size class of the slab allocator.
+ */
+    typedef struct platformSlabClass
+    {
+        uint8_t * pStorage;             /**< @brief First block of the class. */
+        void * pFreeList;               /**< @brief Freed blocks, linked through their first bytes. */
+        uint32_t unusedIndex;           /**< @brief Blocks from this index on were never allocated. */
+        PlatformSlabClassStats_t stats; /**< @brief Counters of the class. */
+    } platformSlabClass_t;
+
+/* Blocks of the size classes, aligned for any type a block may hold. */
+    static uint64_t platformSlabStorage32[ ( PLATFORM_SLAB_BLOCKS_32 * 32U ) / sizeof( uint64_t ) ];
+    static uint64_t platformSlabStorage64[ ( PLATFORM_SLAB_BLOCKS_64 * 64U ) / sizeof( uint64_t ) ];
+    static uint64_t platformSlabStorage128[ ( PLATFORM_SLAB_BLOCKS_128 * 128U ) / sizeof( uint64_t ) ];
+    static uint64_t platformSlabStorage256[ ( PLATFORM_SLAB_BLOCKS_256 * 256U ) / sizeof( uint64_t ) ];
+
+/* Size classes, smallest first, protected by a critical section. */
+    static platformSlabClass_t platformSlabClasses[ PLATFORM_SLAB_CLASSES ] =
+    {
+        { ( uint8_t * ) platformSlabStorage32,  NULL, 0U, { 32U,  PLATFORM_SLAB_BLOCKS_32,  0U, 0U, 0U, 0U } },
+        { ( uint8_t * ) platformSlabStorage64,  NULL, 0U, { 64U,  PLATFORM_SLAB_BLOCKS_64,  0U, 0U, 0U, 0U } },
+        { ( uint8_t * ) platformSlabStorage128, NULL, 0U, { 128U, PLATFORM_SLAB_BLOCKS_128, 0U, 0U, 0U, 0U } },
+        { ( uint8_t * ) platformSlabStorage256, NULL, 0U, { 256U, PLATFORM_SLAB_BLOCKS_256, 0U, 0U, 0U, 0U } }
+    };
+
+    static uint32_t platformSlabHeapAllocations = 0;
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if ( PLATFORM_THREAD_POOL_SIZE > 0 )
+
+/* Routines queued to the workers. A worker is reserved for every queued routine. */
+    static StaticQueue_t threadPoolQueueBuffer;
+    static uint8_t threadPoolQueueStorage[ PLATFORM_THREAD_POOL_SIZE * sizeof( threadInfo_t ) ];
+    static QueueHandle_t threadPoolQueue = NULL;
+
+/* Workers created and workers waiting for a routine, protected by a critical section. */
+    static uint32_t threadPoolWorkers = 0;
+    static uint32_t threadPoolIdleWorkers = 0;
+#endif
+
+#if ( PLATFORM_STATIC_ALLOCATION == 1 )
+
+/* Every task and event group of the static allocation mode, a single symbol in the link map. */
+    typedef struct platformStaticPools
+    {
+        StaticTask_t workerTasks[ PLATFORM_THREAD_POOL_SIZE ];
+        StackType_t workerStacks[ PLATFORM_THREAD_POOL_SIZE ][ PLATFORM_THREAD_POOL_STACK_SIZE ];
+        PlatformStaticEventGroup_t eventGroups[ PLATFORM_STATIC_EVENT_GROUPS ];
+        bool eventGroupInUse[ PLATFORM_STATIC_EVENT_GROUPS ];
+    } platformStaticPools_t;
+
+    static platformStaticPools_t platformStaticPools;
+
+    #define PLATFORM_STRINGIFY_( x )    # x
+    #define PLATFORM_STRINGIFY( x )     PLATFORM_STRINGIFY_( x )
+
+    #pragma message( "Cellular platform static pools: PLATFORM_THREAD_POOL_SIZE " PLATFORM_STRINGIFY( PLATFORM_THREAD_POOL_SIZE ) \
+    " tasks of PLATFORM_THREAD_POOL_STACK_SIZE " PLATFORM_STRINGIFY( PLATFORM_THREAD_POOL_STACK_SIZE )                         \
+    " stack words, PLATFORM_STATIC_EVENT_GROUPS " PLATFORM_STRINGIFY( PLATFORM_STATIC_EVENT_GROUPS )                          \
+    " event groups. The size of platformStaticPools in the link map is the footprint in bytes." )
+#endif
+
+#if ( PLATFORM_HEAP_TAGS_ENABLE == 1 )
+
+/* Header in front of a tagged allocation, 8 bytes to keep the alignment of heap_4. */
+    typedef union platformHeapTagHeader
+    {
+        struct
+        {
+            uint32_t size; /**< @brief Bytes asked for. */
+            uint32_t tag;  /**< @brief PlatformHeapTag_t of the allocation. */
+        } block;
+        uint64_t alignment;
+    } platformHeapTagHeader_t;
+
+/* Counters of the heap tags, protected by a critical section. */
+    static PlatformHeapTagStats_t platformHeapTagStats[ PLATFORM_HEAP_TAG_MAX ];
+
+/* Names of the heap tags in the report. */
+    static const char * const platformHeapTagNames[ PLATFORM_HEAP_TAG_MAX ] =
+    {
+        "cellular",
+        "sockets",
+        "tls",
+        "mqtt",
+        "onboarding"
+    };
+#endif
+
+#if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+
+/* Mutexes which exist, newest first, and the number of mutexes created, protected by a critical section. */
+    static PlatformMutex_t * pMutexProfileList = NULL;
+    static uint32_t mutexProfileCreated = 0;
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if ( PLATFORM_STATIC_ALLOCATION == 0 )
+
 /**
  * @brief Sends provided buffer to network using transport send.
  *
  * @param[in] pArgument Argument passed to threadRoutine function.
  *
  */
-static void prvThreadRoutineWrapper( void * pArgument );
+    static void prvThreadRoutineWrapper( void * pArgument );
+#endif
+
+#if ( PLATFORM_THREAD_POOL_SIZE > 0 )
+
+/**
+ * @brief Worker of the thread pool. Runs the queued routines one after another.
+ *
+ * @param[in] pArgument Unused.
+ */
+    static void prvThreadPoolWorker( void * pArgument );
+
+/**
+ * @brief Create a worker of the thread pool.
+ *
+ * @param[in] workerIndex Index of the worker, selects its stack in static allocation mode.
+ * @param[in] priority Priority of the first routine of the worker.
+ *
+ * @return true if the worker is created.
+ */
+    static bool prvThreadPoolCreateWorker( uint32_t workerIndex,
+                                           int32_t priority );
+
+/**
+ * @brief Queue a routine to an idle worker or to a new worker.
+ *
+ * @param[in] pThreadInfo Routine to run.
+ *
+ * @return true if a worker runs the routine. false if all the workers are busy.
+ */
+    static bool prvThreadPoolSubmit( const threadInfo_t * pThreadInfo );
+#endif
 
 /**
  * @brief Lock mutex with timeout.
@@ -58,18 +211,201 @@ static void prvThreadRoutineWrapper( void * pArgument );
 static bool prIotMutexTimedLock( PlatformMutex_t * pMutex,
                                  TickType_t timeout );
 
+/**
+ * @brief Take the FreeRTOS mutex of a platform mutex.
+ *
+ * @param[in] pMutex Mutex to lock.
+ * @param[in] timeout Timeout value to lock mutex.
+ *
+ * @return pdTRUE if mutex is locked successfully.
+ */
+static BaseType_t prvMutexTake( PlatformMutex_t * pMutex,
+                                TickType_t timeout );
+
+#if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+
+/**
+ * @brief Lock mutex with timeout and update its contention counters.
+ *
+ * A lock which cannot take the mutex at once is contended, the time until it
+ * takes the mutex is its wait.
+ *
+ * @param[in] pMutex Mutex to lock.
+ * @param[in] timeout Timeout value to lock mutex.
+ *
+ * @return pdTRUE if mutex is locked successfully.
+ */
+    static BaseType_t prvMutexProfileTake( PlatformMutex_t * pMutex,
+                                           TickType_t timeout );
+
+/**
+ * @brief Update the hold time of a mutex about to be unlocked by its owner.
+ *
+ * @param[in] pMutex Mutex to unlock.
+ */
+    static void prvMutexProfileRelease( PlatformMutex_t * pMutex );
+#endif
+
+#if ( PLATFORM_EVENT_GROUP_NOTIFY == 1 )
+
+/**
+ * @brief Check the bits of an event group against a wait.
+ *
+ * @param[in] bits Bits set in the event group.
+ * @param[in] bitsToWaitFor Bits the wait is for.
+ * @param[in] waitForAllBits pdTRUE if the wait is for all of bitsToWaitFor.
+ *
+ * @return true if the wait is satisfied.
+ */
+    static bool prvEventGroupSatisfied( EventBits_t bits,
+                                        EventBits_t bitsToWaitFor,
+                                        BaseType_t waitForAllBits );
+
+/**
+ * @brief Set bits of an event group and notify the tasks whose wait they satisfy.
+ *
+ * Called in a critical section. The bits of the satisfied waits clearing on
+ * exit are cleared here, so no other wait can take them first.
+ *
+ * @param[in] groupEvent The event group.
+ * @param[in] bitsToSet Bits to set.
+ * @param[out] pHigherPriorityTaskWoken NULL from a task, else set to pdTRUE
+ * if a notified task should run when the interrupt returns.
+ *
+ * @return The bits of the event group after the waits are satisfied.
+ */
+    static EventBits_t prvEventGroupSet( PlatformEventGroupHandle_t groupEvent,
+                                         EventBits_t bitsToSet,
+                                         BaseType_t * pHigherPriorityTaskWoken );
+#endif
+
 /*-----------------------------------------------------------*/
 
-static void prvThreadRoutineWrapper( void * pArgument )
-{
-    threadInfo_t * pThreadInfo = ( threadInfo_t * ) pArgument;
+#if ( PLATFORM_STATIC_ALLOCATION == 0 )
 
-    /* Run the thread routine. */
-    pThreadInfo->threadRoutine( pThreadInfo->pArgument );
-    Platform_Free( pThreadInfo );
+    static void prvThreadRoutineWrapper( void * pArgument )
+    {
+        threadInfo_t * pThreadInfo = ( threadInfo_t * ) pArgument;
 
-    vTaskDelete( NULL );
-}
+        /* Run the thread routine. */
+        pThreadInfo->threadRoutine( pThreadInfo->pArgument );
+        Platform_Free( pThreadInfo );
+
+        vTaskDelete( NULL );
+    }
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if ( PLATFORM_THREAD_POOL_SIZE > 0 )
+
+    static void prvThreadPoolWorker( void * pArgument )
+    {
+        threadInfo_t threadInfo = { 0 };
+
+        ( void ) pArgument;
+
+        for( ; ; )
+        {
+            if( xQueueReceive( threadPoolQueue, &threadInfo, portMAX_DELAY ) == pdPASS )
+            {
+                vTaskPrioritySet( NULL, ( UBaseType_t ) threadInfo.priority );
+                threadInfo.threadRoutine( threadInfo.pArgument );
+
+                taskENTER_CRITICAL();
+                threadPoolIdleWorkers++;
+                taskEXIT_CRITICAL();
+            }
+        }
+    }
+
+/*-----------------------------------------------------------*/
+
+    static bool prvThreadPoolCreateWorker( uint32_t workerIndex,
+                                           int32_t priority )
+    {
+        bool created = false;
+
+        #if ( PLATFORM_STATIC_ALLOCATION == 1 )
+            created = ( xTaskCreateStatic( prvThreadPoolWorker,
+                                           "Cellular_Worker",
+                                           PLATFORM_THREAD_POOL_STACK_SIZE,
+                                           NULL,
+                                           priority,
+                                           platformStaticPools.workerStacks[ workerIndex ],
+                                           &platformStaticPools.workerTasks[ workerIndex ] ) != NULL );
+        #else
+            ( void ) workerIndex;
+            created = ( xTaskCreate( prvThreadPoolWorker,
+                                     "Cellular_Worker",
+                                     ( configSTACK_DEPTH_TYPE ) PLATFORM_THREAD_POOL_STACK_SIZE,
+                                     NULL,
+                                     priority,
+                                     NULL ) == pdPASS );
+        #endif
+
+        return created;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static bool prvThreadPoolSubmit( const threadInfo_t * pThreadInfo )
+    {
+        bool submitted = false;
+        bool newWorker = false;
+        uint32_t workerIndex = 0;
+
+        taskENTER_CRITICAL();
+
+        if( threadPoolQueue == NULL )
+        {
+            threadPoolQueue = xQueueCreateStatic( PLATFORM_THREAD_POOL_SIZE, sizeof( threadInfo_t ),
+                                                  threadPoolQueueStorage, &threadPoolQueueBuffer );
+        }
+
+        if( threadPoolIdleWorkers > 0U )
+        {
+            threadPoolIdleWorkers--;
+            submitted = true;
+        }
+        else if( threadPoolWorkers < PLATFORM_THREAD_POOL_SIZE )
+        {
+            workerIndex = threadPoolWorkers;
+            threadPoolWorkers++;
+            newWorker = true;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+
+        taskEXIT_CRITICAL();
+
+        if( newWorker == true )
+        {
+            if( prvThreadPoolCreateWorker( workerIndex, pThreadInfo->priority ) == true )
+            {
+                CellularLogDebug( "New thread pool worker created." );
+                submitted = true;
+            }
+            else
+            {
+                CellularLogWarn( "Failed to create thread pool worker." );
+                taskENTER_CRITICAL();
+                threadPoolWorkers--;
+                taskEXIT_CRITICAL();
+            }
+        }
+
+        if( submitted == true )
+        {
+            /* The queue holds one routine per worker, so it is never full here. */
+            ( void ) xQueueSend( threadPoolQueue, pThreadInfo, 0 );
+        }
+
+        return submitted;
+    }
+#endif /* if ( PLATFORM_THREAD_POOL_SIZE > 0 ) */
 
 /*-----------------------------------------------------------*/
 
@@ -82,6 +418,22 @@ static bool prIotMutexTimedLock( PlatformMutex_t * pMutex,
 
     CellularLogDebug( "Locking mutex %p.", pMutex );
 
+    #if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+        lockResult = prvMutexProfileTake( pMutex, timeout );
+    #else
+        lockResult = prvMutexTake( pMutex, timeout );
+    #endif
+
+    return( lockResult == pdTRUE );
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvMutexTake( PlatformMutex_t * pMutex,
+                                TickType_t timeout )
+{
+    BaseType_t lockResult = pdTRUE;
+
     /* Call the correct FreeRTOS mutex take function based on mutex type. */
     if( pMutex->recursive == pdTRUE )
     {
@@ -92,56 +444,189 @@ static bool prIotMutexTimedLock( PlatformMutex_t * pMutex,
         lockResult = xSemaphoreTake( ( SemaphoreHandle_t ) &pMutex->xMutex, timeout );
     }
 
-    return( lockResult == pdTRUE );
+    return lockResult;
 }
 
 /*-----------------------------------------------------------*/
 
+#if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+
+    static BaseType_t prvMutexProfileTake( PlatformMutex_t * pMutex,
+                                           TickType_t timeout )
+    {
+        BaseType_t lockResult = pdTRUE;
+        bool contended = false;
+        uint32_t waitStartUs = 0;
+        uint32_t waitUs = 0;
+        PlatformMutexProfile_t * pProfile = &pMutex->profile;
+
+        /* The owner of a recursive mutex takes it again at once. */
+        lockResult = prvMutexTake( pMutex, 0 );
+
+        if( ( lockResult != pdTRUE ) && ( timeout > 0U ) )
+        {
+            contended = true;
+            waitStartUs = ( uint32_t ) Platform_GetTimeUs();
+            lockResult = prvMutexTake( pMutex, timeout );
+        }
+
+        /* The counters other than failedTryLocks are only updated by the owner of the mutex. */
+        if( lockResult == pdTRUE )
+        {
+            pProfile->acquisitions++;
+
+            if( contended == true )
+            {
+                waitUs = ( uint32_t ) Platform_GetTimeUs() - waitStartUs;
+                pProfile->contended++;
+                pProfile->totalWaitUs += waitUs;
+
+                if( waitUs > pProfile->maxWaitUs )
+                {
+                    pProfile->maxWaitUs = waitUs;
+                }
+            }
+
+            if( pProfile->depth == 0U )
+            {
+                pProfile->lockTimestampUs = ( uint32_t ) Platform_GetTimeUs();
+            }
+
+            pProfile->depth++;
+        }
+        else if( timeout == 0U )
+        {
+            taskENTER_CRITICAL();
+            pProfile->failedTryLocks++;
+            taskEXIT_CRITICAL();
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+
+        return lockResult;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static void prvMutexProfileRelease( PlatformMutex_t * pMutex )
+    {
+        PlatformMutexProfile_t * pProfile = &pMutex->profile;
+        uint32_t holdUs = 0;
+
+        if( pProfile->depth > 0U )
+        {
+            pProfile->depth--;
+
+            /* Only the outermost lock of a recursive mutex is a hold. */
+            if( pProfile->depth == 0U )
+            {
+                holdUs = ( uint32_t ) Platform_GetTimeUs() - pProfile->lockTimestampUs;
+
+                if( holdUs > pProfile->maxHoldUs )
+                {
+                    pProfile->maxHoldUs = holdUs;
+                }
+            }
+        }
+    }
+#endif /* if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 ) */
+
+/*-----------------------------------------------------------*/
+
 bool Platform_CreateDetachedThread( void ( *threadRoutine )( void * ),
                                     void * pArgument,
                                     int32_t priority,
                                     size_t stackSize )
 {
-    bool status = true;
-    threadInfo_t * pThreadInfo = NULL;
+    bool status = false;
+
+    #if ( PLATFORM_THREAD_POOL_SIZE > 0 )
+        threadInfo_t threadInfo = { 0 };
+    #endif
 
     configASSERT( threadRoutine != NULL );
 
-    CellularLogDebug( "Creating new thread." );
+    #if ( PLATFORM_THREAD_POOL_SIZE > 0 )
+        if( stackSize <= PLATFORM_THREAD_POOL_STACK_SIZE )
+        {
+            threadInfo.threadRoutine = threadRoutine;
+            threadInfo.pArgument = pArgument;
+            threadInfo.priority = priority;
+            status = prvThreadPoolSubmit( &threadInfo );
+        }
+    #endif
 
-    pThreadInfo = Platform_Malloc( sizeof( threadInfo_t ) );
+    #if ( PLATFORM_STATIC_ALLOCATION == 1 )
+        if( status == false )
+        {
+            CellularLogError( "No thread pool worker for a stack of %u, raise PLATFORM_THREAD_POOL_SIZE or PLATFORM_THREAD_POOL_STACK_SIZE.",
+                              ( unsigned int ) stackSize );
+        }
+    #else
+        if( status == false )
+        {
+            status = Platform_CreateDedicatedThread( threadRoutine, pArgument, priority, stackSize );
+        }
+    #endif
 
-    if( pThreadInfo == NULL )
-    {
-        CellularLogDebug( "Unable to allocate memory for threadRoutine %p.", threadRoutine );
-        status = false;
-    }
+    return status;
+}
 
-    /* Create the FreeRTOS task that will run the thread. */
-    if( status == true )
-    {
-        pThreadInfo->threadRoutine = threadRoutine;
-        pThreadInfo->pArgument = pArgument;
+/*-----------------------------------------------------------*/
+
+bool Platform_CreateDedicatedThread( void ( *threadRoutine )( void * ),
+                                     void * pArgument,
+                                     int32_t priority,
+                                     size_t stackSize )
+{
+    #if ( PLATFORM_STATIC_ALLOCATION == 1 )
+        /* Every task is a worker of the thread pool in static allocation mode. */
+        return Platform_CreateDetachedThread( threadRoutine, pArgument, priority, stackSize );
+    #else
+        bool status = true;
+        threadInfo_t * pThreadInfo = NULL;
 
-        if( xTaskCreate( prvThreadRoutineWrapper,
-                         "Cellular_Thread",
-                         ( configSTACK_DEPTH_TYPE ) stackSize,
-                         pThreadInfo,
-                         priority,
-                         NULL ) != pdPASS )
+        configASSERT( threadRoutine != NULL );
+
+        CellularLogDebug( "Creating new thread." );
+
+        pThreadInfo = Platform_Malloc( sizeof( threadInfo_t ) );
+
+        if( pThreadInfo == NULL )
         {
-            /* Task creation failed. */
-            CellularLogWarn( "Failed to create thread." );
-            Platform_Free( pThreadInfo );
+            CellularLogDebug( "Unable to allocate memory for threadRoutine %p.", threadRoutine );
             status = false;
         }
-        else
+
+        /* Create the FreeRTOS task that will run the thread. */
+        if( status == true )
         {
-            CellularLogDebug( "New thread created." );
+            pThreadInfo->threadRoutine = threadRoutine;
+            pThreadInfo->pArgument = pArgument;
+            pThreadInfo->priority = priority;
+
+            if( xTaskCreate( prvThreadRoutineWrapper,
+                             "Cellular_Thread",
+                             ( configSTACK_DEPTH_TYPE ) stackSize,
+                             pThreadInfo,
+                             priority,
+                             NULL ) != pdPASS )
+            {
+                /* Task creation failed. */
+                CellularLogWarn( "Failed to create thread." );
+                Platform_Free( pThreadInfo );
+                status = false;
+            }
+            else
+            {
+                CellularLogDebug( "New thread created." );
+            }
         }
-    }
 
-    return status;
+        return status;
+    #endif
 }
 
 /*-----------------------------------------------------------*/
@@ -183,6 +668,17 @@ bool PlatformMutex_Create( PlatformMutex_t * pNewMutex,
     else
     {
         retMutexCreate = true;
+
+        #if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+            ( void ) memset( &pNewMutex->profile, 0, sizeof( PlatformMutexProfile_t ) );
+
+            taskENTER_CRITICAL();
+            pNewMutex->profile.id = mutexProfileCreated;
+            mutexProfileCreated++;
+            pNewMutex->profile.pNextProfiled = pMutexProfileList;
+            pMutexProfileList = pNewMutex;
+            taskEXIT_CRITICAL();
+        #endif
     }
 
     return retMutexCreate;
@@ -192,8 +688,28 @@ bool PlatformMutex_Create( PlatformMutex_t * pNewMutex,
 
 void PlatformMutex_Destroy( PlatformMutex_t * pMutex )
 {
+    #if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+        PlatformMutex_t ** ppLink = &pMutexProfileList;
+    #endif
+
     configASSERT( pMutex != NULL );
 
+    #if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+        taskENTER_CRITICAL();
+
+        while( ( *ppLink != NULL ) && ( *ppLink != pMutex ) )
+        {
+            ppLink = &( *ppLink )->profile.pNextProfiled;
+        }
+
+        if( *ppLink != NULL )
+        {
+            *ppLink = pMutex->profile.pNextProfiled;
+        }
+
+        taskEXIT_CRITICAL();
+    #endif
+
     vSemaphoreDelete( ( SemaphoreHandle_t ) &pMutex->xMutex );
 }
 
@@ -219,6 +735,10 @@ void PlatformMutex_Unlock( PlatformMutex_t * pMutex )
 
     CellularLogDebug( "Unlocking mutex %p.", pMutex );
 
+    #if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+        prvMutexProfileRelease( pMutex );
+    #endif
+
     /* Call the correct FreeRTOS mutex unlock function based on mutex type. */
     if( pMutex->recursive == pdTRUE )
     {
@@ -231,3 +751,773 @@ void PlatformMutex_Unlock( PlatformMutex_t * pMutex )
 }
 
 /*-----------------------------------------------------------*/
+
+#if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+
+    void PlatformMutex_ProfileReport( void )
+    {
+        static PlatformMutexProfile_t profiles[ PLATFORM_MUTEX_PROFILE_REPORT_SIZE ];
+        static PlatformMutex_t * pMutexes[ PLATFORM_MUTEX_PROFILE_REPORT_SIZE ];
+        PlatformMutexProfile_t profile = { 0 };
+        PlatformMutex_t * pMutex = NULL;
+        PlatformMutex_t * pCurrent = NULL;
+        uint32_t mutexCount = 0;
+        uint32_t reportCount = 0;
+        uint32_t i = 0;
+
+        /* Snapshot the counters, keeping the mutexes waited on longest in order. */
+        taskENTER_CRITICAL();
+
+        for( pCurrent = pMutexProfileList; pCurrent != NULL; pCurrent = pCurrent->profile.pNextProfiled )
+        {
+            profile = pCurrent->profile;
+            pMutex = pCurrent;
+            mutexCount++;
+
+            for( i = 0; i < reportCount; i++ )
+            {
+                if( profile.totalWaitUs > profiles[ i ].totalWaitUs )
+                {
+                    break;
+                }
+            }
+
+            if( i < PLATFORM_MUTEX_PROFILE_REPORT_SIZE )
+            {
+                if( reportCount < PLATFORM_MUTEX_PROFILE_REPORT_SIZE )
+                {
+                    reportCount++;
+                }
+
+                ( void ) memmove( &profiles[ i + 1U ], &profiles[ i ], ( reportCount - 1U - i ) * sizeof( PlatformMutexProfile_t ) );
+                ( void ) memmove( &pMutexes[ i + 1U ], &pMutexes[ i ], ( reportCount - 1U - i ) * sizeof( PlatformMutex_t * ) );
+                profiles[ i ] = profile;
+                pMutexes[ i ] = pMutex;
+            }
+        }
+
+        taskEXIT_CRITICAL();
+
+        CellularLogInfo( "Mutex profile: %u mutexes, %u listed.", ( unsigned int ) mutexCount, ( unsigned int ) reportCount );
+
+        for( i = 0; i < reportCount; i++ )
+        {
+            CellularLogInfo( "Mutex %u %p: %u locks, %u contended, %u failed try locks, wait %llu us total %u us max, hold %u us max.",
+                             ( unsigned int ) profiles[ i ].id,
+                             ( void * ) pMutexes[ i ],
+                             ( unsigned int ) profiles[ i ].acquisitions,
+                             ( unsigned int ) profiles[ i ].contended,
+                             ( unsigned int ) profiles[ i ].failedTryLocks,
+                             ( unsigned long long ) profiles[ i ].totalWaitUs,
+                             ( unsigned int ) profiles[ i ].maxWaitUs,
+                             ( unsigned int ) profiles[ i ].maxHoldUs );
+        }
+    }
+#endif /* if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 ) */
+
+/*-----------------------------------------------------------*/
+
+#if ( PLATFORM_STATIC_ALLOCATION == 1 )
+
+    PlatformEventGroupHandle_t PlatformEventGroup_Create( void )
+    {
+        PlatformEventGroupHandle_t eventGroup = NULL;
+        uint32_t index = 0;
+        bool found = false;
+
+        taskENTER_CRITICAL();
+
+        for( index = 0; index < PLATFORM_STATIC_EVENT_GROUPS; index++ )
+        {
+            if( platformStaticPools.eventGroupInUse[ index ] == false )
+            {
+                platformStaticPools.eventGroupInUse[ index ] = true;
+                found = true;
+                break;
+            }
+        }
+
+        taskEXIT_CRITICAL();
+
+        if( found == true )
+        {
+            eventGroup = PlatformEventGroup_CreateStatic( &platformStaticPools.eventGroups[ index ] );
+        }
+        else
+        {
+            CellularLogError( "No free event group, raise PLATFORM_STATIC_EVENT_GROUPS." );
+        }
+
+        return eventGroup;
+    }
+
+/*-----------------------------------------------------------*/
+
+    void PlatformEventGroup_Delete( PlatformEventGroupHandle_t groupEvent )
+    {
+        uint32_t index = 0;
+
+        configASSERT( groupEvent != NULL );
+
+        #if ( PLATFORM_EVENT_GROUP_NOTIFY == 0 )
+            vEventGroupDelete( groupEvent );
+        #endif
+
+        for( index = 0; index < PLATFORM_STATIC_EVENT_GROUPS; index++ )
+        {
+            if( groupEvent == ( PlatformEventGroupHandle_t ) &platformStaticPools.eventGroups[ index ] )
+            {
+                taskENTER_CRITICAL();
+                platformStaticPools.eventGroupInUse[ index ] = false;
+                taskEXIT_CRITICAL();
+                break;
+            }
+        }
+    }
+#elif ( PLATFORM_EVENT_GROUP_NOTIFY == 1 )
+
+    PlatformEventGroupHandle_t PlatformEventGroup_Create( void )
+    {
+        PlatformEventGroupHandle_t eventGroup = Platform_Malloc( sizeof( PlatformEventGroup_t ) );
+
+        if( eventGroup != NULL )
+        {
+            ( void ) PlatformEventGroup_CreateStatic( eventGroup );
+            eventGroup->allocated = true;
+        }
+
+        return eventGroup;
+    }
+
+/*-----------------------------------------------------------*/
+
+    void PlatformEventGroup_Delete( PlatformEventGroupHandle_t groupEvent )
+    {
+        configASSERT( groupEvent != NULL );
+
+        if( groupEvent->allocated == true )
+        {
+            Platform_Free( groupEvent );
+        }
+    }
+#endif /* if ( PLATFORM_STATIC_ALLOCATION == 1 ) */
+
+/*-----------------------------------------------------------*/
+
+#if ( PLATFORM_EVENT_GROUP_NOTIFY == 1 )
+
+    static bool prvEventGroupSatisfied( EventBits_t bits,
+                                        EventBits_t bitsToWaitFor,
+                                        BaseType_t waitForAllBits )
+    {
+        bool satisfied = false;
+
+        if( waitForAllBits == pdFALSE )
+        {
+            satisfied = ( ( bits & bitsToWaitFor ) != 0U );
+        }
+        else
+        {
+            satisfied = ( ( bits & bitsToWaitFor ) == bitsToWaitFor );
+        }
+
+        return satisfied;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static EventBits_t prvEventGroupSet( PlatformEventGroupHandle_t groupEvent,
+                                         EventBits_t bitsToSet,
+                                         BaseType_t * pHigherPriorityTaskWoken )
+    {
+        PlatformEventGroupWaiter_t * pWaiter = NULL;
+        EventBits_t bitsToClear = 0;
+        uint32_t index = 0;
+
+        groupEvent->bits = groupEvent->bits | bitsToSet;
+
+        for( index = 0; index < PLATFORM_EVENT_GROUP_WAITERS; index++ )
+        {
+            pWaiter = &groupEvent->waiters[ index ];
+
+            if( ( pWaiter->task != NULL ) && ( pWaiter->satisfied == false ) &&
+                ( prvEventGroupSatisfied( groupEvent->bits, pWaiter->bitsToWaitFor, pWaiter->waitForAllBits ) == true ) )
+            {
+                pWaiter->satisfied = true;
+                pWaiter->satisfiedBits = groupEvent->bits;
+
+                if( pWaiter->clearOnExit == pdTRUE )
+                {
+                    bitsToClear = bitsToClear | pWaiter->bitsToWaitFor;
+                }
+
+                if( pHigherPriorityTaskWoken == NULL )
+                {
+                    ( void ) xTaskNotifyGiveIndexed( pWaiter->task, PLATFORM_EVENT_GROUP_NOTIFY_INDEX );
+                }
+                else
+                {
+                    vTaskNotifyGiveIndexedFromISR( pWaiter->task, PLATFORM_EVENT_GROUP_NOTIFY_INDEX, pHigherPriorityTaskWoken );
+                }
+            }
+        }
+
+        groupEvent->bits = groupEvent->bits & ~bitsToClear;
+
+        return groupEvent->bits;
+    }
+
+/*-----------------------------------------------------------*/
+
+    PlatformEventGroupHandle_t PlatformEventGroup_CreateStatic( PlatformStaticEventGroup_t * pEventGroupBuffer )
+    {
+        configASSERT( pEventGroupBuffer != NULL );
+
+        ( void ) memset( pEventGroupBuffer, 0, sizeof( PlatformEventGroup_t ) );
+
+        return pEventGroupBuffer;
+    }
+
+/*-----------------------------------------------------------*/
+
+    EventBits_t PlatformEventGroup_ClearBits( PlatformEventGroupHandle_t groupEvent,
+                                              const EventBits_t bitsToClear )
+    {
+        EventBits_t bits = 0;
+
+        configASSERT( groupEvent != NULL );
+
+        taskENTER_CRITICAL();
+        bits = groupEvent->bits;
+        groupEvent->bits = bits & ~bitsToClear;
+        taskEXIT_CRITICAL();
+
+        return bits;
+    }
+
+/*-----------------------------------------------------------*/
+
+    EventBits_t PlatformEventGroup_SetBits( PlatformEventGroupHandle_t groupEvent,
+                                            const EventBits_t bitsToSet )
+    {
+        EventBits_t bits = 0;
+
+        configASSERT( groupEvent != NULL );
+
+        taskENTER_CRITICAL();
+        bits = prvEventGroupSet( groupEvent, bitsToSet, NULL );
+        taskEXIT_CRITICAL();
+
+        return bits;
+    }
+
+/*-----------------------------------------------------------*/
+
+    BaseType_t PlatformEventGroup_SetBitsFromISR( PlatformEventGroupHandle_t groupEvent,
+                                                  const EventBits_t bitsToSet,
+                                                  BaseType_t * pHigherPriorityTaskWoken )
+    {
+        UBaseType_t savedInterruptStatus = 0;
+
+        configASSERT( groupEvent != NULL );
+        configASSERT( pHigherPriorityTaskWoken != NULL );
+
+        savedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+        ( void ) prvEventGroupSet( groupEvent, bitsToSet, pHigherPriorityTaskWoken );
+        taskEXIT_CRITICAL_FROM_ISR( savedInterruptStatus );
+
+        return pdPASS;
+    }
+
+/*-----------------------------------------------------------*/
+
+    EventBits_t PlatformEventGroup_WaitBits( PlatformEventGroupHandle_t groupEvent,
+                                             const EventBits_t bitsToWaitFor,
+                                             const BaseType_t clearOnExit,
+                                             const BaseType_t waitForAllBits,
+                                             TickType_t ticksToWait )
+    {
+        PlatformEventGroupWaiter_t * pWaiter = NULL;
+        EventBits_t bits = 0;
+        TimeOut_t timeOut = { 0 };
+        uint32_t index = 0;
+        bool waiting = false;
+        bool noWaiterSlot = false;
+
+        configASSERT( groupEvent != NULL );
+        configASSERT( bitsToWaitFor != 0U );
+
+        taskENTER_CRITICAL();
+
+        bits = groupEvent->bits;
+
+        if( prvEventGroupSatisfied( bits, bitsToWaitFor, waitForAllBits ) == true )
+        {
+            if( clearOnExit == pdTRUE )
+            {
+                groupEvent->bits = bits & ~bitsToWaitFor;
+            }
+        }
+        else if( ticksToWait != 0U )
+        {
+            for( index = 0; index < PLATFORM_EVENT_GROUP_WAITERS; index++ )
+            {
+                if( groupEvent->waiters[ index ].task == NULL )
+                {
+                    pWaiter = &groupEvent->waiters[ index ];
+                    pWaiter->task = xTaskGetCurrentTaskHandle();
+                    pWaiter->bitsToWaitFor = bitsToWaitFor;
+                    pWaiter->waitForAllBits = waitForAllBits;
+                    pWaiter->clearOnExit = clearOnExit;
+                    pWaiter->satisfied = false;
+                    waiting = true;
+                    break;
+                }
+            }
+
+            noWaiterSlot = ( waiting == false );
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+
+        taskEXIT_CRITICAL();
+
+        if( noWaiterSlot == true )
+        {
+            CellularLogError( "No free waiter on event group %p, raise PLATFORM_EVENT_GROUP_WAITERS.", ( void * ) groupEvent );
+        }
+
+        if( waiting == true )
+        {
+            vTaskSetTimeOutState( &timeOut );
+
+            while( waiting == true )
+            {
+                /* A notification left from an earlier wait only costs another check. */
+                ( void ) ulTaskNotifyTakeIndexed( PLATFORM_EVENT_GROUP_NOTIFY_INDEX, pdTRUE, ticksToWait );
+
+                taskENTER_CRITICAL();
+
+                if( pWaiter->satisfied == true )
+                {
+                    bits = pWaiter->satisfiedBits;
+                    waiting = false;
+                }
+                else if( xTaskCheckForTimeOut( &timeOut, &ticksToWait ) == pdTRUE )
+                {
+                    bits = groupEvent->bits;
+                    waiting = false;
+                }
+                else
+                {
+                    /* Empty else for MISRA 15.7 compliance. */
+                }
+
+                if( waiting == false )
+                {
+                    pWaiter->task = NULL;
+                }
+
+                taskEXIT_CRITICAL();
+            }
+        }
+
+        return bits;
+    }
+#endif /* if ( PLATFORM_EVENT_GROUP_NOTIFY == 1 ) */
+
+/*-----------------------------------------------------------*/
+
+#if ( PLATFORM_HEAP_TAGS_ENABLE == 1 )
+
+    void * Platform_MallocTagged( size_t xWantedSize,
+                                  PlatformHeapTag_t tag )
+    {
+        platformHeapTagHeader_t * pHeader = NULL;
+        PlatformHeapTagStats_t * pStats = NULL;
+        void * pv = NULL;
+
+        configASSERT( tag < PLATFORM_HEAP_TAG_MAX );
+
+        pStats = &platformHeapTagStats[ tag ];
+
+        /* The size is kept in 32 bits. */
+        if( xWantedSize <= ( ( size_t ) UINT32_MAX - sizeof( platformHeapTagHeader_t ) ) )
+        {
+            pHeader = pvPortMalloc( sizeof( platformHeapTagHeader_t ) + xWantedSize );
+        }
+
+        taskENTER_CRITICAL();
+
+        if( pHeader != NULL )
+        {
+            pHeader->block.size = ( uint32_t ) xWantedSize;
+            pHeader->block.tag = ( uint32_t ) tag;
+
+            pStats->allocations++;
+            pStats->currentBytes += ( uint32_t ) xWantedSize;
+
+            if( pStats->currentBytes > pStats->peakBytes )
+            {
+                pStats->peakBytes = pStats->currentBytes;
+            }
+
+            if( ( uint32_t ) xWantedSize > pStats->largestBlock )
+            {
+                pStats->largestBlock = ( uint32_t ) xWantedSize;
+            }
+
+            pv = &pHeader[ 1 ];
+        }
+        else
+        {
+            pStats->failedAllocations++;
+        }
+
+        taskEXIT_CRITICAL();
+
+        return pv;
+    }
+
+/*-----------------------------------------------------------*/
+
+    void Platform_FreeTagged( void * pv )
+    {
+        platformHeapTagHeader_t * pHeader = NULL;
+
+        if( pv != NULL )
+        {
+            pHeader = &( ( platformHeapTagHeader_t * ) pv )[ -1 ];
+
+            configASSERT( pHeader->block.tag < ( uint32_t ) PLATFORM_HEAP_TAG_MAX );
+
+            taskENTER_CRITICAL();
+            platformHeapTagStats[ pHeader->block.tag ].currentBytes -= pHeader->block.size;
+            taskEXIT_CRITICAL();
+
+            vPortFree( pHeader );
+        }
+    }
+
+/*-----------------------------------------------------------*/
+
+    void Platform_GetHeapTagStats( PlatformHeapTag_t tag,
+                                   PlatformHeapTagStats_t * pStats )
+    {
+        configASSERT( tag < PLATFORM_HEAP_TAG_MAX );
+        configASSERT( pStats != NULL );
+
+        taskENTER_CRITICAL();
+        *pStats = platformHeapTagStats[ tag ];
+        taskEXIT_CRITICAL();
+    }
+
+/*-----------------------------------------------------------*/
+
+    void Platform_HeapTagReport( void )
+    {
+        PlatformHeapTagStats_t stats[ PLATFORM_HEAP_TAG_MAX ];
+        uint32_t tag = 0;
+
+        /* Log a consistent snapshot, logging in the critical section would stall the other tasks. */
+        taskENTER_CRITICAL();
+        ( void ) memcpy( stats, platformHeapTagStats, sizeof( stats ) );
+        taskEXIT_CRITICAL();
+
+        for( tag = 0; tag < ( uint32_t ) PLATFORM_HEAP_TAG_MAX; tag++ )
+        {
+            CellularLogInfo( "Heap %s: %u bytes now, %u bytes peak, %u allocations, %u failed, largest block %u.",
+                             platformHeapTagNames[ tag ],
+                             ( unsigned int ) stats[ tag ].currentBytes,
+                             ( unsigned int ) stats[ tag ].peakBytes,
+                             ( unsigned int ) stats[ tag ].allocations,
+                             ( unsigned int ) stats[ tag ].failedAllocations,
+                             ( unsigned int ) stats[ tag ].largestBlock );
+        }
+
+        CellularLogInfo( "Heap free %u bytes, lowest %u bytes.",
+                         ( unsigned int ) xPortGetFreeHeapSize(),
+                         ( unsigned int ) xPortGetMinimumEverFreeHeapSize() );
+    }
+#endif /* if ( PLATFORM_HEAP_TAGS_ENABLE == 1 ) */
+
+/*-----------------------------------------------------------*/
+
+#if ( PLATFORM_MALLOC_SLAB_ENABLE == 1 )
+
+    void * Platform_SlabMalloc( size_t xWantedSize )
+    {
+        void * pv = NULL;
+        platformSlabClass_t * pClass = NULL;
+        platformSlabClass_t * pSmallestFit = NULL;
+        uint32_t classIndex = 0;
+
+        taskENTER_CRITICAL();
+
+        /* Take a block of the smallest class that fits and has one left. */
+        for( classIndex = 0; ( classIndex < PLATFORM_SLAB_CLASSES ) && ( pv == NULL ); classIndex++ )
+        {
+            pClass = &platformSlabClasses[ classIndex ];
+
+            if( xWantedSize <= pClass->stats.blockSize )
+            {
+                if( pSmallestFit == NULL )
+                {
+                    pSmallestFit = pClass;
+                }
+
+                if( pClass->pFreeList != NULL )
+                {
+                    pv = pClass->pFreeList;
+                    pClass->pFreeList = *( ( void ** ) pv );
+                }
+                else if( pClass->unusedIndex < pClass->stats.blockCount )
+                {
+                    pv = &pClass->pStorage[ pClass->unusedIndex * pClass->stats.blockSize ];
+                    pClass->unusedIndex++;
+                }
+                else
+                {
+                    /* Empty else for MISRA 15.7 compliance. */
+                }
+
+                if( pv != NULL )
+                {
+                    pClass->stats.allocations++;
+                    pClass->stats.inUse++;
+
+                    if( pClass->stats.inUse > pClass->stats.highWater )
+                    {
+                        pClass->stats.highWater = pClass->stats.inUse;
+                    }
+                }
+            }
+        }
+
+        if( pv == NULL )
+        {
+            if( pSmallestFit != NULL )
+            {
+                pSmallestFit->stats.misses++;
+            }
+            else
+            {
+                platformSlabHeapAllocations++;
+            }
+        }
+
+        taskEXIT_CRITICAL();
+
+        if( pv == NULL )
+        {
+            pv = Platform_MallocTagged( xWantedSize, PLATFORM_HEAP_TAG_CELLULAR );
+        }
+
+        return pv;
+    }
+
+/*-----------------------------------------------------------*/
+
+    void Platform_SlabFree( void * pv )
+    {
+        platformSlabClass_t * pClass = NULL;
+        uintptr_t block = ( uintptr_t ) pv;
+        uintptr_t storage = 0;
+        uint32_t classIndex = 0;
+        bool slabBlock = false;
+
+        if( pv != NULL )
+        {
+            for( classIndex = 0; ( classIndex < PLATFORM_SLAB_CLASSES ) && ( slabBlock == false ); classIndex++ )
+            {
+                pClass = &platformSlabClasses[ classIndex ];
+                storage = ( uintptr_t ) pClass->pStorage;
+
+                if( ( block >= storage ) &&
+                    ( block < ( storage + ( ( uintptr_t ) pClass->stats.blockCount * pClass->stats.blockSize ) ) ) )
+                {
+                    taskENTER_CRITICAL();
+                    *( ( void ** ) pv ) = pClass->pFreeList;
+                    pClass->pFreeList = pv;
+                    pClass->stats.inUse--;
+                    taskEXIT_CRITICAL();
+                    slabBlock = true;
+                }
+            }
+
+            if( slabBlock == false )
+            {
+                Platform_FreeTagged( pv );
+            }
+        }
+    }
+
+/*-----------------------------------------------------------*/
+
+    void Platform_GetSlabStats( PlatformSlabStats_t * pStats )
+    {
+        uint32_t classIndex = 0;
+
+        configASSERT( pStats != NULL );
+
+        taskENTER_CRITICAL();
+
+        for( classIndex = 0; classIndex < PLATFORM_SLAB_CLASSES; classIndex++ )
+        {
+            pStats->classes[ classIndex ] = platformSlabClasses[ classIndex ].stats;
+        }
+
+        pStats->heapAllocations = platformSlabHeapAllocations;
+
+        taskEXIT_CRITICAL();
+    }
+#endif /* if ( PLATFORM_MALLOC_SLAB_ENABLE == 1 ) */
+
+/*-----------------------------------------------------------*/
+
+uint64_t Platform_GetTimeUs( void )
+{
+    uint64_t timeUs = 0;
+
+    #if defined( PLATFORM_GET_TIME_US )
+        timeUs = ( uint64_t ) PLATFORM_GET_TIME_US();
+    #elif defined( _WIN32 ) || defined( _WIN64 )
+        LARGE_INTEGER counter;
+        LARGE_INTEGER frequency;
+
+        ( void ) QueryPerformanceCounter( &counter );
+        ( void ) QueryPerformanceFrequency( &frequency );
+
+        /* Split the conversion so the counter times 1000000 does not overflow. */
+        timeUs = ( ( uint64_t ) ( counter.QuadPart / frequency.QuadPart ) * 1000000U ) +
+                 ( ( ( uint64_t ) ( counter.QuadPart % frequency.QuadPart ) * 1000000U ) /
+                   ( uint64_t ) frequency.QuadPart );
+    #elif defined( __unix__ ) || defined( __APPLE__ )
+        struct timespec now = { 0 };
+
+        ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+        timeUs = ( ( uint64_t ) now.tv_sec * 1000000U ) + ( ( uint64_t ) now.tv_nsec / 1000U );
+    #else
+        TimeOut_t currentTime = { 0 };
+        uint64_t tickCount = 0;
+
+        /* vTaskSetTimeOutState() returns the tick count with the number of
+         * times it overflowed, both are static in tasks.c. */
+        vTaskSetTimeOutState( &currentTime );
+
+        tickCount = ( ( uint64_t ) currentTime.xOverflowCount << ( sizeof( TickType_t ) * 8U ) ) +
+                    ( uint64_t ) currentTime.xTimeOnEntering;
+        timeUs = ( tickCount * 1000000U ) / ( uint64_t ) configTICK_RATE_HZ;
+    #endif /* if defined( PLATFORM_GET_TIME_US ) */
+
+    return timeUs;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+/* Kernels older than V10.4.4 count the run time in 32 bits whatever
+ * configRUN_TIME_COUNTER_TYPE is. The POSIX kernel has no version number. */
+    #if defined( tskKERNEL_VERSION_MAJOR ) &&                                         \
+    ( ( tskKERNEL_VERSION_MAJOR < 10 ) ||                                             \
+    ( ( tskKERNEL_VERSION_MAJOR == 10 ) && ( tskKERNEL_VERSION_MINOR < 4 ) ) ||       \
+    ( ( tskKERNEL_VERSION_MAJOR == 10 ) && ( tskKERNEL_VERSION_MINOR == 4 ) && ( tskKERNEL_VERSION_BUILD < 4 ) ) )
+        typedef uint32_t PlatformRunTime_t;
+    #else
+        typedef configRUN_TIME_COUNTER_TYPE PlatformRunTime_t;
+    #endif
+
+    void Platform_RunTimeStatsReport( void )
+    {
+        static TaskHandle_t previousTasks[ PLATFORM_RUN_TIME_STATS_TASKS ];
+        static UBaseType_t previousTaskNumbers[ PLATFORM_RUN_TIME_STATS_TASKS ];
+        static PlatformRunTime_t previousRunTimes[ PLATFORM_RUN_TIME_STATS_TASKS ];
+        static uint32_t previousSwitches[ PLATFORM_RUN_TIME_STATS_TASKS ];
+        static PlatformRunTime_t previousTotalRunTime = 0;
+        static uint32_t previousCount = 0;
+        TaskStatus_t * pTaskStatus = NULL;
+        uint32_t * pSwitches = NULL;
+        UBaseType_t taskCount = 0;
+        PlatformRunTime_t totalRunTime = 0;
+        PlatformRunTime_t intervalRunTime = 0;
+        PlatformRunTime_t runTime = 0;
+        uint32_t switches = 0;
+        uint32_t permille = 0;
+        uint32_t i = 0;
+        uint32_t j = 0;
+
+        /* Leave room for tasks created before the snapshot. The switch counters follow the task status array. */
+        taskCount = uxTaskGetNumberOfTasks() + 4U;
+        pTaskStatus = ( TaskStatus_t * ) pvPortMalloc( taskCount * ( sizeof( TaskStatus_t ) + sizeof( uint32_t ) ) );
+
+        if( pTaskStatus == NULL )
+        {
+            CellularLogError( "Run time stats: no memory for %u tasks.", ( unsigned int ) taskCount );
+        }
+        else
+        {
+            pSwitches = ( uint32_t * ) &pTaskStatus[ taskCount ];
+            taskCount = uxTaskGetSystemState( pTaskStatus, taskCount, &totalRunTime );
+            intervalRunTime = totalRunTime - previousTotalRunTime;
+
+            for( i = 0; i < taskCount; i++ )
+            {
+                pSwitches[ i ] = ( uint32_t ) ( uintptr_t ) pvTaskGetThreadLocalStoragePointer( pTaskStatus[ i ].xHandle,
+                                                                                                configTASK_SWITCHES_TLS_INDEX );
+            }
+
+            CellularLogInfo( "Run time stats: %u tasks, %llu us since the previous report.",
+                             ( unsigned int ) taskCount, ( unsigned long long ) intervalRunTime );
+
+            for( i = 0; i < taskCount; i++ )
+            {
+                runTime = pTaskStatus[ i ].ulRunTimeCounter;
+                switches = pSwitches[ i ];
+
+                for( j = 0; j < previousCount; j++ )
+                {
+                    /* A new task may reuse the control block of a deleted one, its number differs. */
+                    if( ( previousTasks[ j ] == pTaskStatus[ i ].xHandle ) &&
+                        ( previousTaskNumbers[ j ] == pTaskStatus[ i ].xTaskNumber ) )
+                    {
+                        runTime = runTime - previousRunTimes[ j ];
+                        switches = switches - previousSwitches[ j ];
+                        break;
+                    }
+                }
+
+                if( intervalRunTime > 0U )
+                {
+                    permille = ( uint32_t ) ( ( ( uint64_t ) runTime * 1000U ) / intervalRunTime );
+                }
+
+                CellularLogInfo( "Task %-*s: cpu %3u.%u%%, %llu us, %u switches, stack high-water mark %u.",
+                                 ( int ) configMAX_TASK_NAME_LEN, pTaskStatus[ i ].pcTaskName,
+                                 ( unsigned int ) ( permille / 10U ),
+                                 ( unsigned int ) ( permille % 10U ),
+                                 ( unsigned long long ) runTime,
+                                 ( unsigned int ) switches,
+                                 ( unsigned int ) pTaskStatus[ i ].usStackHighWaterMark );
+            }
+
+            /* Remember the counters for the interval of the next report. */
+            for( i = 0; ( i < taskCount ) && ( i < PLATFORM_RUN_TIME_STATS_TASKS ); i++ )
+            {
+                previousTasks[ i ] = pTaskStatus[ i ].xHandle;
+                previousTaskNumbers[ i ] = pTaskStatus[ i ].xTaskNumber;
+                previousRunTimes[ i ] = pTaskStatus[ i ].ulRunTimeCounter;
+                previousSwitches[ i ] = pSwitches[ i ];
+            }
+
+            previousCount = i;
+            previousTotalRunTime = totalRunTime;
+            vPortFree( pTaskStatus );
+        }
+    }
+#endif /* if ( configGENERATE_RUN_TIME_STATS == 1 ) */
+
+/*-----------------------------------------------------------*/
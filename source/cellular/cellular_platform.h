@@ -58,6 +58,11 @@
 #define CellularLogInfo( ... )     LogInfo( ( __VA_ARGS__ ) )
 #define CellularLogDebug( ... )    LogDebug( ( __VA_ARGS__ ) )
 
+/* The thread pool and the static allocation mode are set in the cellular configuration. */
+#ifndef CELLULAR_DO_NOT_USE_CUSTOM_CONFIG
+    #include "cellular_config.h"
+#endif
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -75,9 +80,77 @@ bool Platform_CreateDetachedThread( void ( * threadRoutine )( void * ),
                                     int32_t priority,
                                     size_t stackSize );
 
+/**
+ * @brief Create a detached thread on a task of its own.
+ *
+ * Platform_CreateDetachedThread runs the threadRoutine on a worker of the
+ * thread pool if one is available. Routines which run until their module is
+ * closed, such as the receive threads of the comm interfaces, are created
+ * with this API instead so they do not hold a worker.
+ */
+bool Platform_CreateDedicatedThread( void ( * threadRoutine )( void * ),
+                                     void * pArgument,
+                                     int32_t priority,
+                                     size_t stackSize );
+
 #define PLATFORM_THREAD_DEFAULT_STACK_SIZE    ( 2048U )
 #define PLATFORM_THREAD_DEFAULT_PRIORITY      ( tskIDLE_PRIORITY + 5U )
 
+/**
+ * @brief Number of worker tasks kept to run the threadRoutine of Platform_CreateDetachedThread.
+ *
+ * A threadRoutine runs on an idle worker, on a new worker while there are fewer
+ * than PLATFORM_THREAD_POOL_SIZE, and on a task of its own otherwise. Workers
+ * are never deleted. Set to 0 to create a task for every threadRoutine.
+ */
+#ifndef PLATFORM_THREAD_POOL_SIZE
+    #define PLATFORM_THREAD_POOL_SIZE    ( 2U )
+#endif
+
+/**
+ * @brief Stack size of the workers. A threadRoutine asking for more runs on a task of its own.
+ */
+#ifndef PLATFORM_THREAD_POOL_STACK_SIZE
+    #define PLATFORM_THREAD_POOL_STACK_SIZE    PLATFORM_THREAD_DEFAULT_STACK_SIZE
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Cellular library platform static allocation mode.
+ *
+ * Set to 1 to take the tasks and event groups of the platform layer, the comm
+ * interfaces and the sockets wrapper from pools sized at build time, so none
+ * of them comes from the heap. Every thread then runs on a worker of the thread
+ * pool: PLATFORM_THREAD_POOL_SIZE must cover the threads running at the same
+ * time and PLATFORM_THREAD_POOL_STACK_SIZE the largest stack they ask for.
+ * Modules whose needs are known at build time fail to compile if a pool is
+ * too small for them.
+ */
+#ifndef PLATFORM_STATIC_ALLOCATION
+    #define PLATFORM_STATIC_ALLOCATION    ( 0 )
+#endif
+
+/**
+ * @brief Number of event groups PlatformEventGroup_Create can return in static allocation mode.
+ */
+#ifndef PLATFORM_STATIC_EVENT_GROUPS
+    #define PLATFORM_STATIC_EVENT_GROUPS    ( 4U )
+#endif
+
+/* Threads and event groups of the cellular library itself, the pktio thread and its events. */
+#define PLATFORM_STATIC_LIBRARY_THREADS         ( 1U )
+#define PLATFORM_STATIC_LIBRARY_EVENT_GROUPS    ( 1U )
+
+#if ( PLATFORM_STATIC_ALLOCATION == 1 )
+    #if ( PLATFORM_THREAD_POOL_SIZE < PLATFORM_STATIC_LIBRARY_THREADS )
+        #error "PLATFORM_THREAD_POOL_SIZE is too small for the threads of the cellular library."
+    #endif
+    #if ( PLATFORM_STATIC_EVENT_GROUPS < PLATFORM_STATIC_LIBRARY_EVENT_GROUPS )
+        #error "PLATFORM_STATIC_EVENT_GROUPS is too small for the event groups of the cellular library."
+    #endif
+#endif
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -91,10 +164,49 @@ bool Platform_CreateDetachedThread( void ( * threadRoutine )( void * ),
  *
  */
 
+/**
+ * @brief Set to 1 to profile the contention of every platform mutex.
+ *
+ * Each mutex then counts its acquisitions, the acquisitions that had to wait,
+ * the total and longest wait and the longest hold. PlatformMutex_ProfileReport
+ * logs them, the mutexes waited on longest first.
+ */
+#ifndef PLATFORM_MUTEX_PROFILE_ENABLE
+    #define PLATFORM_MUTEX_PROFILE_ENABLE    ( 0 )
+#endif
+
+/**
+ * @brief Most mutexes listed by PlatformMutex_ProfileReport.
+ */
+#ifndef PLATFORM_MUTEX_PROFILE_REPORT_SIZE
+    #define PLATFORM_MUTEX_PROFILE_REPORT_SIZE    ( 32U )
+#endif
+
+/**
+ * @brief Contention counters of a platform mutex.
+ */
+typedef struct PlatformMutexProfile
+{
+    uint32_t id;                          /**< Creation order of the mutex, to tell mutexes apart in the report. */
+    uint32_t acquisitions;                /**< Locks, recursive ones included. */
+    uint32_t contended;                   /**< Locks that waited for another task to unlock. */
+    uint32_t failedTryLocks;              /**< PlatformMutex_TryLock calls that found the mutex taken. */
+    uint64_t totalWaitUs;                 /**< Time spent waiting in contended locks. */
+    uint32_t maxWaitUs;                   /**< Longest contended lock. */
+    uint32_t maxHoldUs;                   /**< Longest time from the outermost lock to its unlock. */
+    uint32_t lockTimestampUs;             /**< Time of the outermost lock held now. */
+    uint32_t depth;                       /**< Locks held now by the owner. */
+    struct PlatformMutex * pNextProfiled; /**< Next mutex in the list of the report. */
+} PlatformMutexProfile_t;
+
 typedef struct PlatformMutex
 {
     StaticSemaphore_t xMutex; /**< FreeRTOS mutex. */
     BaseType_t recursive;     /**< Type; used for indicating if this is reentrant or normal. */
+
+    #if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+        PlatformMutexProfile_t profile; /**< Contention counters. */
+    #endif
 } PlatformMutex_t;
 
 bool PlatformMutex_Create( PlatformMutex_t * pNewMutex,
@@ -104,6 +216,18 @@ void PlatformMutex_Lock( PlatformMutex_t * pMutex );
 bool PlatformMutex_TryLock( PlatformMutex_t * pMutex );
 void PlatformMutex_Unlock( PlatformMutex_t * pMutex );
 
+#if ( PLATFORM_MUTEX_PROFILE_ENABLE == 1 )
+
+/**
+ * @brief Log the contention counters of the mutexes which exist now.
+ *
+ * The mutexes waited on longest come first, with their creation order and
+ * address. Counters of a mutex start when it is created. Must not be called
+ * from two tasks at the same time.
+ */
+    void PlatformMutex_ProfileReport( void );
+#endif
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -115,8 +239,130 @@ void PlatformMutex_Unlock( PlatformMutex_t * pMutex );
  *
  */
 
-#define Platform_Malloc    pvPortMalloc
-#define Platform_Free      vPortFree
+/**
+ * @brief Set to 1 to count the heap use of each subsystem.
+ *
+ * Platform_MallocTagged then keeps the tag of an allocation in a header of 8
+ * bytes in front of it, and every tag counts the bytes allocated now, their
+ * peak, the allocations and the largest block. Platform_HeapTagReport logs
+ * them with the free heap, to size configTOTAL_HEAP_SIZE from a run.
+ */
+#ifndef PLATFORM_HEAP_TAGS_ENABLE
+    #define PLATFORM_HEAP_TAGS_ENABLE    ( 0 )
+#endif
+
+/**
+ * @brief Subsystem an allocation is counted against.
+ */
+typedef enum PlatformHeapTag
+{
+    PLATFORM_HEAP_TAG_CELLULAR = 0, /**< Cellular library and comm interfaces, through Platform_Malloc. */
+    PLATFORM_HEAP_TAG_SOCKETS,      /**< Socket contexts of the sockets wrapper. */
+    PLATFORM_HEAP_TAG_TLS,          /**< mbedtls, through mbedtls_platform_calloc. */
+    PLATFORM_HEAP_TAG_MQTT,         /**< MQTT demo tasks. */
+    PLATFORM_HEAP_TAG_ONBOARDING,   /**< 1NCE zero touch provisioning. */
+    PLATFORM_HEAP_TAG_MAX
+} PlatformHeapTag_t;
+
+/**
+ * @brief Counters of a heap tag.
+ */
+typedef struct PlatformHeapTagStats
+{
+    uint32_t currentBytes;      /**< Bytes allocated now, headers excluded. */
+    uint32_t peakBytes;         /**< Most bytes allocated at the same time. */
+    uint32_t allocations;       /**< Allocations made. */
+    uint32_t failedAllocations; /**< Allocations the heap could not serve. */
+    uint32_t largestBlock;      /**< Largest allocation made. */
+} PlatformHeapTagStats_t;
+
+#if ( PLATFORM_HEAP_TAGS_ENABLE == 1 )
+    void * Platform_MallocTagged( size_t xWantedSize,
+                                  PlatformHeapTag_t tag );
+    void Platform_FreeTagged( void * pv );
+    void Platform_GetHeapTagStats( PlatformHeapTag_t tag,
+                                   PlatformHeapTagStats_t * pStats );
+
+/**
+ * @brief Log the counters of every heap tag, the free heap and its low-water mark.
+ */
+    void Platform_HeapTagReport( void );
+#else
+    #define Platform_MallocTagged( xWantedSize, tag )    pvPortMalloc( xWantedSize )
+    #define Platform_FreeTagged( pv )                    vPortFree( pv )
+#endif
+
+/**
+ * @brief Set to 1 to serve the small allocations from fixed size classes before the heap.
+ *
+ * The cellular library allocates and frees AT responses, response lines and
+ * tokens all the time. The slab allocator serves them from blocks of 32, 64,
+ * 128 and 256 bytes kept out of the heap, so they do not fragment it. An
+ * allocation larger than 256 bytes, or finding its classes full, comes from
+ * the heap. Platform_GetSlabStats reports the hit rates and high-water
+ * marks of the classes to size PLATFORM_SLAB_BLOCKS_*.
+ */
+#ifndef PLATFORM_MALLOC_SLAB_ENABLE
+    #define PLATFORM_MALLOC_SLAB_ENABLE    ( 0 )
+#endif
+
+/**
+ * @brief Blocks of each size class of the slab allocator, at least 1.
+ *
+ * The peak demand platform_slab_soak prints for a class is the number of
+ * blocks that serves every allocation of that class.
+ */
+#ifndef PLATFORM_SLAB_BLOCKS_32
+    #define PLATFORM_SLAB_BLOCKS_32     ( 48U )
+#endif
+#ifndef PLATFORM_SLAB_BLOCKS_64
+    #define PLATFORM_SLAB_BLOCKS_64     ( 24U )
+#endif
+#ifndef PLATFORM_SLAB_BLOCKS_128
+    #define PLATFORM_SLAB_BLOCKS_128    ( 12U )
+#endif
+#ifndef PLATFORM_SLAB_BLOCKS_256
+    #define PLATFORM_SLAB_BLOCKS_256    ( 12U )
+#endif
+
+#define PLATFORM_SLAB_CLASSES           ( 4U )
+
+/**
+ * @brief Counters of a size class of the slab allocator.
+ */
+typedef struct PlatformSlabClassStats
+{
+    uint32_t blockSize;   /**< Bytes of a block. */
+    uint32_t blockCount;  /**< Blocks of the class. */
+    uint32_t allocations; /**< Allocations served by the class. */
+    uint32_t misses;      /**< Allocations this class is the smallest fit for that went to the heap because the classes were full. */
+    uint32_t inUse;       /**< Blocks allocated now. */
+    uint32_t highWater;   /**< Most blocks allocated at the same time. */
+} PlatformSlabClassStats_t;
+
+/**
+ * @brief Counters of the slab allocator.
+ */
+typedef struct PlatformSlabStats
+{
+    PlatformSlabClassStats_t classes[ PLATFORM_SLAB_CLASSES ]; /**< Size classes, smallest first. */
+    uint32_t heapAllocations;                                  /**< Allocations larger than the largest class. */
+} PlatformSlabStats_t;
+
+#if ( PLATFORM_MALLOC_SLAB_ENABLE == 1 )
+    void * Platform_SlabMalloc( size_t xWantedSize );
+    void Platform_SlabFree( void * pv );
+    void Platform_GetSlabStats( PlatformSlabStats_t * pStats );
+
+    #define Platform_Malloc    Platform_SlabMalloc
+    #define Platform_Free      Platform_SlabFree
+#elif ( PLATFORM_HEAP_TAGS_ENABLE == 1 )
+    #define Platform_Malloc( xWantedSize )    Platform_MallocTagged( ( xWantedSize ), PLATFORM_HEAP_TAG_CELLULAR )
+    #define Platform_Free                     Platform_FreeTagged
+#else
+    #define Platform_Malloc    pvPortMalloc
+    #define Platform_Free      vPortFree
+#endif
 
 /*-----------------------------------------------------------*/
 
@@ -130,17 +376,112 @@ void PlatformMutex_Unlock( PlatformMutex_t * pMutex );
  *
  */
 
-#define PlatformEventGroupHandle_t           EventGroupHandle_t
-#define PlatformEventGroup_Delete            vEventGroupDelete
-#define PlatformEventGroup_ClearBits         xEventGroupClearBits
-#define PlatformEventGroup_Create            xEventGroupCreate
-#define PlatformEventGroup_GetBits           xEventGroupGetBits
-#define PlatformEventGroup_SetBits           xEventGroupSetBits
-#define PlatformEventGroup_SetBitsFromISR    xEventGroupSetBitsFromISR
-#define PlatformEventGroup_WaitBits          xEventGroupWaitBits
+/**
+ * @brief Set to 1 to implement the platform event groups with direct to task notifications.
+ *
+ * A FreeRTOS event group comes from the heap, and setting its bits from an
+ * interrupt is deferred to the timer task. A notification event group is a
+ * few words which the setter updates in a critical section before notifying
+ * the waiting task directly, from an interrupt too. Up to
+ * PLATFORM_EVENT_GROUP_WAITERS tasks can wait on one at the same time. The
+ * waits use notification index PLATFORM_EVENT_GROUP_NOTIFY_INDEX, so the
+ * kernel needs configTASK_NOTIFICATION_ARRAY_ENTRIES above it.
+ */
+#ifndef PLATFORM_EVENT_GROUP_NOTIFY
+    #define PLATFORM_EVENT_GROUP_NOTIFY    ( 0 )
+#endif
+
+/**
+ * @brief Tasks which can wait on a notification event group at the same time.
+ *
+ * The cellular library waits on its event group from the pktio thread and
+ * from the task starting or stopping it, so at least 2.
+ */
+#ifndef PLATFORM_EVENT_GROUP_WAITERS
+    #define PLATFORM_EVENT_GROUP_WAITERS    ( 2U )
+#endif
+
+/**
+ * @brief Task notification index of the notification event groups.
+ *
+ * Index 0 is the one of xTaskNotifyGive and ulTaskNotifyTake, which the
+ * application, stream buffers and other libraries use. A wait on index 0
+ * would take their notifications and leave them waiting, so the event
+ * groups use an index of their own.
+ */
+#ifndef PLATFORM_EVENT_GROUP_NOTIFY_INDEX
+    #define PLATFORM_EVENT_GROUP_NOTIFY_INDEX    ( 1U )
+#endif
+
+#if ( PLATFORM_EVENT_GROUP_NOTIFY == 1 )
+
+    #if ( configTASK_NOTIFICATION_ARRAY_ENTRIES <= PLATFORM_EVENT_GROUP_NOTIFY_INDEX )
+        #error "PLATFORM_EVENT_GROUP_NOTIFY needs configTASK_NOTIFICATION_ARRAY_ENTRIES above PLATFORM_EVENT_GROUP_NOTIFY_INDEX"
+    #endif
+
+/**
+ * @brief A task waiting on a notification event group.
+ */
+    typedef struct PlatformEventGroupWaiter
+    {
+        TaskHandle_t task;         /**< Waiting task, NULL if the slot is free. */
+        EventBits_t bitsToWaitFor; /**< Bits the task waits for. */
+        BaseType_t waitForAllBits; /**< pdTRUE to wait for all of bitsToWaitFor, pdFALSE for any. */
+        BaseType_t clearOnExit;    /**< pdTRUE to clear bitsToWaitFor when the wait is satisfied. */
+        bool satisfied;            /**< The setter satisfied the wait and notified the task. */
+        EventBits_t satisfiedBits; /**< Bits when the wait was satisfied, before clearOnExit. */
+    } PlatformEventGroupWaiter_t;
+
+/**
+ * @brief Notification event group, protected by a critical section.
+ */
+    typedef struct PlatformEventGroup
+    {
+        EventBits_t bits;                                                   /**< Bits set now. */
+        PlatformEventGroupWaiter_t waiters[ PLATFORM_EVENT_GROUP_WAITERS ]; /**< Tasks waiting now. */
+        bool allocated;                                                     /**< Taken from the heap by PlatformEventGroup_Create. */
+    } PlatformEventGroup_t;
+
+    typedef PlatformEventGroup_t * PlatformEventGroupHandle_t;
+    #define PlatformStaticEventGroup_t    PlatformEventGroup_t
+
+    PlatformEventGroupHandle_t PlatformEventGroup_CreateStatic( PlatformStaticEventGroup_t * pEventGroupBuffer );
+    EventBits_t PlatformEventGroup_ClearBits( PlatformEventGroupHandle_t groupEvent,
+                                              const EventBits_t bitsToClear );
+    EventBits_t PlatformEventGroup_SetBits( PlatformEventGroupHandle_t groupEvent,
+                                            const EventBits_t bitsToSet );
+    BaseType_t PlatformEventGroup_SetBitsFromISR( PlatformEventGroupHandle_t groupEvent,
+                                                  const EventBits_t bitsToSet,
+                                                  BaseType_t * pHigherPriorityTaskWoken );
+    EventBits_t PlatformEventGroup_WaitBits( PlatformEventGroupHandle_t groupEvent,
+                                             const EventBits_t bitsToWaitFor,
+                                             const BaseType_t clearOnExit,
+                                             const BaseType_t waitForAllBits,
+                                             TickType_t ticksToWait );
+
+    #define PlatformEventGroup_GetBits( groupEvent )    PlatformEventGroup_ClearBits( ( groupEvent ), 0 )
+#else
+    #define PlatformEventGroupHandle_t           EventGroupHandle_t
+    #define PlatformStaticEventGroup_t           StaticEventGroup_t
+    #define PlatformEventGroup_CreateStatic      xEventGroupCreateStatic
+    #define PlatformEventGroup_ClearBits         xEventGroupClearBits
+    #define PlatformEventGroup_GetBits           xEventGroupGetBits
+    #define PlatformEventGroup_SetBits           xEventGroupSetBits
+    #define PlatformEventGroup_SetBitsFromISR    xEventGroupSetBitsFromISR
+    #define PlatformEventGroup_WaitBits          xEventGroupWaitBits
+#endif /* if ( PLATFORM_EVENT_GROUP_NOTIFY == 1 ) */
+
 #define PlatformEventGroup_EventBits         EventBits_t
 #define PlatformTickType                     TickType_t
 
+#if ( PLATFORM_STATIC_ALLOCATION == 1 ) || ( PLATFORM_EVENT_GROUP_NOTIFY == 1 )
+    PlatformEventGroupHandle_t PlatformEventGroup_Create( void );
+    void PlatformEventGroup_Delete( PlatformEventGroupHandle_t groupEvent );
+#else
+    #define PlatformEventGroup_Create        xEventGroupCreate
+    #define PlatformEventGroup_Delete        vEventGroupDelete
+#endif
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -154,4 +495,64 @@ void PlatformMutex_Unlock( PlatformMutex_t * pMutex );
  */
 #define Platform_Delay( delayMs )    vTaskDelay( pdMS_TO_TICKS( delayMs ) )
 
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Cellular library platform clock.
+ *
+ * Monotonic time since an arbitrary origin, shared by the socket timeouts,
+ * the MQTT demo and the latency counters of the comm interfaces. It counts
+ * in microseconds in 64 bits and does not wrap.
+ *
+ * The clock is read from PLATFORM_GET_TIME_US if it is defined, for example
+ * to a free running hardware timer of the target. Otherwise the Windows
+ * simulator reads the performance counter and a POSIX host CLOCK_MONOTONIC.
+ * On other targets the clock falls back to the tick count and only has the
+ * resolution of a tick.
+ */
+
+/**
+ * @brief Get the monotonic time in microseconds.
+ *
+ * @return The time in microseconds.
+ */
+uint64_t Platform_GetTimeUs( void );
+
+/**
+ * @brief Get the monotonic time in milliseconds.
+ */
+#define Platform_GetTimeMs()    ( Platform_GetTimeUs() / 1000U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Cellular library platform run time stats.
+ *
+ * Set configGENERATE_RUN_TIME_STATS to 1 in FreeRTOSConfig.h to count the CPU
+ * time of every task with the platform clock, and the times it is switched in
+ * in the thread local storage pointer configTASK_SWITCHES_TLS_INDEX.
+ */
+
+/**
+ * @brief Number of tasks Platform_RunTimeStatsReport remembers between two reports.
+ *
+ * The counters of a task are reported for the interval since the previous
+ * report. Tasks beyond this number are reported since they were created.
+ */
+#ifndef PLATFORM_RUN_TIME_STATS_TASKS
+    #define PLATFORM_RUN_TIME_STATS_TASKS    ( 24U )
+#endif
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+/**
+ * @brief Log the share of the CPU, the times switched in and the stack
+ * high-water mark of every task since the previous report.
+ *
+ * Not thread safe, the counters of the previous report are kept in static
+ * storage. Must not be called from two tasks at the same time.
+ */
+    void Platform_RunTimeStatsReport( void );
+#endif
+
 #endif /* __CELLULAR_PLATFORM_H__ */
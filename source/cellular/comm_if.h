@@ -0,0 +1,385 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if.h
+ * @brief Multi-instance API of the cellular comm interface.
+ *
+ * Each instance drives one COM port / tty with its own context, receive thread
+ * and receive callback. CellularCommInterface is instance 0 and is kept for
+ * applications with a single modem.
+ */
+
+#ifndef __COMM_IF_H__
+#define __COMM_IF_H__
+
+#include <stdint.h>
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of comm interface instances.
+ *
+ * Can be overridden in cellular_config.h. The port of each instance is taken
+ * from CELLULAR_COMM_INTERFACE_PORT_LIST, for example { "COM5", "COM6" }, or
+ * set at runtime with CellularCommInterface_SetPort.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_MAX_INSTANCES
+    #ifdef CELLULAR_COMM_INTERFACE_DATA_PORT
+        #define CELLULAR_COMM_INTERFACE_MAX_INSTANCES    ( 2U )
+    #else
+        #define CELLULAR_COMM_INTERFACE_MAX_INSTANCES    ( 1U )
+    #endif
+#endif
+
+/* Upper limit of CELLULAR_COMM_INTERFACE_MAX_INSTANCES. */
+#define COMM_IF_INSTANCE_LIMIT                       ( 16U )
+
+#if ( CELLULAR_COMM_INTERFACE_MAX_INSTANCES > COMM_IF_INSTANCE_LIMIT ) || ( CELLULAR_COMM_INTERFACE_MAX_INSTANCES == 0 )
+    #error "CELLULAR_COMM_INTERFACE_MAX_INSTANCES must be between 1 and 16"
+#endif
+
+/**
+ * @brief Instance carrying the AT commands and URCs of the modem.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_CONTROL_INSTANCE
+    #define CELLULAR_COMM_INTERFACE_CONTROL_INSTANCE    ( 0U )
+#endif
+
+/**
+ * @brief Instance carrying the bulk socket data of the modem.
+ *
+ * USB modules such as the BG96 expose separate AT and data ports. Define
+ * CELLULAR_COMM_INTERFACE_DATA_PORT, for example "/dev/ttyUSB3", to open the
+ * data port as instance 1. Otherwise the data role shares the control instance.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_DATA_INSTANCE
+    #ifdef CELLULAR_COMM_INTERFACE_DATA_PORT
+        #define CELLULAR_COMM_INTERFACE_DATA_INSTANCE    ( 1U )
+    #else
+        #define CELLULAR_COMM_INTERFACE_DATA_INSTANCE    ( CELLULAR_COMM_INTERFACE_CONTROL_INSTANCE )
+    #endif
+#endif
+
+#if ( CELLULAR_COMM_INTERFACE_CONTROL_INSTANCE >= CELLULAR_COMM_INTERFACE_MAX_INSTANCES ) || \
+    ( CELLULAR_COMM_INTERFACE_DATA_INSTANCE >= CELLULAR_COMM_INTERFACE_MAX_INSTANCES )
+    #error "CELLULAR_COMM_INTERFACE_CONTROL_INSTANCE and CELLULAR_COMM_INTERFACE_DATA_INSTANCE must be less than CELLULAR_COMM_INTERFACE_MAX_INSTANCES"
+#endif
+
+/**
+ * @brief Queue send data in a transmit ring drained by a writer thread.
+ *
+ * When enabled, send copies the data into the transmit ring of the instance
+ * and returns without waiting for the UART. It only waits, up to the send
+ * timeout, when the ring is full. The writer thread reports drained data and
+ * write errors to the callback set with CellularCommInterface_SetTxCallback.
+ * A write error is also returned by the next send.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_ASYNC_TX
+    #define CELLULAR_COMM_INTERFACE_ASYNC_TX    ( 0 )
+#endif
+
+/**
+ * @brief Line rate negotiated with the modem in open.
+ *
+ * The port is opened at 115200. A different rate is requested from the modem
+ * with AT+IPR and used once the modem answers AT at the new rate. Open falls
+ * back to 115200 if the modem rejects the rate or stops answering.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_BAUD_RATE
+    #define CELLULAR_COMM_INTERFACE_BAUD_RATE    ( 115200U )
+#endif
+
+/**
+ * @brief Enable RTS/CTS hardware flow control.
+ *
+ * Flow control is requested from the modem with AT+IFC=2,2 in open and only
+ * enabled on the port if the modem accepts it.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_FLOW_CONTROL
+    #define CELLULAR_COMM_INTERFACE_FLOW_CONTROL    ( 0 )
+#endif
+
+/**
+ * @brief Call the receive callback once per burst of received data.
+ *
+ * When enabled, the receive thread collects the bytes read from the port and
+ * calls the receive callback once the line has been idle for
+ * CELLULAR_COMM_INTERFACE_RX_IDLE_CHARS characters, CELLULAR_COMM_INTERFACE_RX_WATERMARK
+ * bytes are collected or a line is complete. Otherwise the callback is called
+ * for every read of the port.
+ *
+ * Bursts that do not end in CR LF, such as the "> " prompt, binary data and
+ * CMUX frames, wait for the idle time of at least one millisecond, which
+ * doubles the latency of AT commands over CMUX. Enable it only when the
+ * wakeups saved on long responses matter more.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_RX_COALESCE
+    #define CELLULAR_COMM_INTERFACE_RX_COALESCE    ( 0 )
+#endif
+
+/**
+ * @brief Characters of silence on the line that end a receive burst.
+ *
+ * Converted to time with the line rate of the port and rounded up to at least
+ * one millisecond.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_RX_IDLE_CHARS
+    #define CELLULAR_COMM_INTERFACE_RX_IDLE_CHARS    ( 4U )
+#endif
+
+/**
+ * @brief Bytes of a receive burst that call the receive callback without waiting for the line to go idle.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_RX_WATERMARK
+    #define CELLULAR_COMM_INTERFACE_RX_WATERMARK    ( 1024U )
+#endif
+
+/**
+ * @brief Call the receive callback as soon as a burst ends with a line terminator following text.
+ *
+ * AT responses and URCs end with CR LF, so pktio gets complete lines without
+ * waiting for the idle time.
+ */
+#ifndef CELLULAR_COMM_INTERFACE_RX_LINE_END
+    #define CELLULAR_COMM_INTERFACE_RX_LINE_END    ( 1 )
+#endif
+
+/**
+ * @brief Keep counters and histograms of the traffic of each port.
+ *
+ * Read them with CellularCommInterface_GetStats. Each counter has a single
+ * writer, so collecting them takes no lock.
+ */
+#ifndef CELLULAR_COMM_STATS_ENABLE
+    #define CELLULAR_COMM_STATS_ENABLE    ( 1 )
+#endif
+
+/**
+ * @brief Number of power of two buckets of the statistics histograms.
+ */
+#ifndef CELLULAR_COMM_STATS_BUCKETS
+    #define CELLULAR_COMM_STATS_BUCKETS    ( 16U )
+#endif
+
+/**
+ * @brief Keep a wire trace of the last bytes sent and received on each port.
+ *
+ * The trace is recorded without a lock and can be written to a file with
+ * CellularCommInterface_DumpTrace, for example from vAssertCalled.
+ */
+#ifndef CELLULAR_COMM_TRACE_ENABLE
+    #define CELLULAR_COMM_TRACE_ENABLE    ( 1 )
+#endif
+
+/**
+ * @brief Bytes of traffic kept by the wire trace for each direction. Must be a power of two.
+ */
+#ifndef CELLULAR_COMM_TRACE_SIZE
+    #define CELLULAR_COMM_TRACE_SIZE    ( 8192U )
+#endif
+
+/**
+ * @brief Reads or writes kept by the wire trace for each direction. Must be a power of two.
+ */
+#ifndef CELLULAR_COMM_TRACE_RECORDS
+    #define CELLULAR_COMM_TRACE_RECORDS    ( 512U )
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+
+/**
+ * @brief Transmit completion callback.
+ *
+ * Called when the transmit ring is drained or a write fails. On the windows
+ * simulator it is called in the simulated UART interrupt, same as the receive
+ * callback.
+ *
+ * @param[in] pUserData The pUserData set with CellularCommInterface_SetTxCallback.
+ * @param[in] commInterfaceHandle Handle of the comm interface instance.
+ * @param[in] txStatus IOT_COMM_INTERFACE_SUCCESS or the error of a failed write.
+ * @param[in] txLength Number of bytes written to the UART since the last callback.
+ */
+typedef void ( * CellularCommInterfaceTxCallback_t )( void * pUserData,
+                                                      CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                      CellularCommInterfaceError_t txStatus,
+                                                      uint32_t txLength );
+
+#endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
+
+/**
+ * @brief Role of a modem port.
+ */
+typedef enum CellularCommPortRole
+{
+    CELLULAR_COMM_PORT_ROLE_CONTROL = 0, /**< AT commands, responses and URCs. */
+    CELLULAR_COMM_PORT_ROLE_DATA         /**< Socket data reads and writes. */
+} CellularCommPortRole_t;
+
+#if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+
+/**
+ * @brief Traffic statistics of a comm interface instance.
+ *
+ * Bucket n of a histogram counts the values from 2^n to 2^(n+1) - 1, bucket 0
+ * also counts 0 and the last bucket counts everything above.
+ */
+typedef struct CellularCommStats
+{
+    uint64_t rxBytes;                                                 /**< Bytes read from the port. */
+    uint64_t txBytes;                                                 /**< Bytes written to the port. */
+    uint32_t readCount;                                               /**< Reads of the port that returned data. */
+    uint32_t writeCount;                                              /**< Writes to the port. */
+    uint32_t callbackCount;                                           /**< Receive callbacks. */
+    uint32_t recvCount;                                               /**< recv calls that returned data. */
+    uint32_t sendTimeoutCount;                                        /**< send calls that timed out. */
+    uint32_t writeErrorCount;                                         /**< Writes the driver failed. */
+    uint32_t rxOverrunCount;                                          /**< Times the receive ring was full with data left in the driver. */
+    uint32_t rxPeakFill;                                              /**< Highest number of bytes in the receive ring. */
+    uint32_t readSizeHistogram[ CELLULAR_COMM_STATS_BUCKETS ];        /**< Reads of the port by bytes read. */
+    uint32_t callbackLatencyHistogram[ CELLULAR_COMM_STATS_BUCKETS ]; /**< Microseconds from a receive callback to the next recv. */
+    uint32_t writeLatencyHistogram[ CELLULAR_COMM_STATS_BUCKETS ];    /**< Microseconds from the start of a write of the port to its completion. */
+} CellularCommStats_t;
+
+#endif /* CELLULAR_COMM_STATS_ENABLE == 1 */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Instance 0 of the comm interface.
+ */
+extern CellularCommInterface_t CellularCommInterface;
+
+/**
+ * @brief Get the comm interface of an instance.
+ *
+ * The returned interface is passed to Cellular_Init. Every instance can be
+ * opened once at a time.
+ *
+ * @param[in] instanceIndex Index of the instance, less than CELLULAR_COMM_INTERFACE_MAX_INSTANCES.
+ *
+ * @return The comm interface of the instance. NULL if instanceIndex is out of range.
+ */
+CellularCommInterface_t * CellularCommInterface_GetInstance( uint32_t instanceIndex );
+
+/**
+ * @brief Get the comm interface of a port role.
+ *
+ * The control role is passed to Cellular_Init. Bulk transfers use the data
+ * role, so they do not hold back registration queries or URC processing.
+ * When no data port is configured both roles return the same interface,
+ * which must be opened only once.
+ *
+ * @param[in] role The port role.
+ *
+ * @return The comm interface of the role. NULL if role is invalid.
+ */
+CellularCommInterface_t * CellularCommInterface_GetByRole( CellularCommPortRole_t role );
+
+/**
+ * @brief Set the port opened by an instance.
+ *
+ * Overrides the port configured in CELLULAR_COMM_INTERFACE_PORT_LIST. The
+ * string is not copied and must stay valid until the instance is closed.
+ *
+ * @param[in] instanceIndex Index of the instance, less than CELLULAR_COMM_INTERFACE_MAX_INSTANCES.
+ * @param[in] pPortName Port name, for example "COM5" on windows or "/dev/ttyUSB2" on linux.
+ *
+ * @return IOT_COMM_INTERFACE_SUCCESS if the port is set. IOT_COMM_INTERFACE_BAD_PARAMETER
+ * for invalid parameters. IOT_COMM_INTERFACE_BUSY if the instance is opened.
+ */
+CellularCommInterfaceError_t CellularCommInterface_SetPort( uint32_t instanceIndex,
+                                                            const char * pPortName );
+
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+
+/**
+ * @brief Set the transmit completion callback of an opened instance.
+ *
+ * @param[in] commInterfaceHandle Handle returned by open.
+ * @param[in] txCallback Callback to report transmit completion. NULL to disable.
+ * @param[in] pUserData User data passed to txCallback.
+ *
+ * @return IOT_COMM_INTERFACE_SUCCESS if the callback is set. Otherwise an error
+ * code defined in CellularCommInterfaceError_t.
+ */
+CellularCommInterfaceError_t CellularCommInterface_SetTxCallback( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                                  CellularCommInterfaceTxCallback_t txCallback,
+                                                                  void * pUserData );
+
+#endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
+
+#if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+
+/**
+ * @brief Get the traffic statistics of an instance.
+ *
+ * The statistics are cleared when the instance is opened and kept after it
+ * is closed. They are copied without a lock, so counters updated during the
+ * copy may be one update apart from each other. The 64-bit byte counters are
+ * read under a sequence counter and never tear, also on 32-bit hosts.
+ *
+ * @param[in] instanceIndex Index of the instance, less than CELLULAR_COMM_INTERFACE_MAX_INSTANCES.
+ * @param[out] pStats The statistics.
+ *
+ * @return IOT_COMM_INTERFACE_SUCCESS if the statistics are copied.
+ * IOT_COMM_INTERFACE_BAD_PARAMETER for invalid parameters.
+ */
+CellularCommInterfaceError_t CellularCommInterface_GetStats( uint32_t instanceIndex,
+                                                             CellularCommStats_t * pStats );
+
+#endif /* CELLULAR_COMM_STATS_ENABLE == 1 */
+
+#if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+
+/**
+ * @brief Write the wire trace of an instance to a file.
+ *
+ * The file uses the capture format described in comm_if_capture.h, with a
+ * tick rate of 1000000, so timestamps are in microseconds. It can be called at
+ * any time, also while the instance is sending and receiving. Records the
+ * instance overwrites while the trace is copied are left out.
+ *
+ * @param[in] instanceIndex Index of the instance, less than CELLULAR_COMM_INTERFACE_MAX_INSTANCES.
+ * @param[in] pPath Path of the file.
+ *
+ * @return IOT_COMM_INTERFACE_SUCCESS if the file is written. Otherwise an error
+ * code defined in CellularCommInterfaceError_t.
+ */
+CellularCommInterfaceError_t CellularCommInterface_DumpTrace( uint32_t instanceIndex,
+                                                              const char * pPath );
+
+#endif /* CELLULAR_COMM_TRACE_ENABLE == 1 */
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_H__ */
@@ -0,0 +1,144 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_burst.h
+ * @brief Receive burst detection used by the comm interfaces.
+ *
+ * The receive thread of a comm interface reads the port as soon as data
+ * arrives, which on a UART is often a few bytes at a time. Instead of calling
+ * the receive callback for every read, the bytes are collected in a burst and
+ * the callback is called once the burst is complete:
+ * - the line is idle for CELLULAR_COMM_INTERFACE_RX_IDLE_CHARS characters,
+ * - CELLULAR_COMM_INTERFACE_RX_WATERMARK bytes have been received, or
+ * - a line terminator follows text, when CELLULAR_COMM_INTERFACE_RX_LINE_END is 1.
+ */
+
+#ifndef __COMM_IF_BURST_H__
+#define __COMM_IF_BURST_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+/*-----------------------------------------------------------*/
+
+/* Bits on the line per character, 8N1. */
+#define COMM_BURST_BITS_PER_CHAR    ( 10U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Bytes received since the last receive callback.
+ */
+typedef struct CommBurst
+{
+    uint32_t length; /**< Bytes in the burst. */
+    bool text;       /**< The burst has bytes other than CR and LF. */
+    bool lineEnd;    /**< The last byte of the burst is a line terminator following text. */
+} CommBurst_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Start a new burst.
+ */
+static inline void CommBurst_Reset( CommBurst_t * pBurst )
+{
+    pBurst->length = 0U;
+    pBurst->text = false;
+    pBurst->lineEnd = false;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add bytes read from the port to the burst.
+ *
+ * @param[in] pBurst The burst.
+ * @param[in] pData The bytes read.
+ * @param[in] length Number of bytes read.
+ */
+static inline void CommBurst_Add( CommBurst_t * pBurst,
+                                  const uint8_t * pData,
+                                  uint32_t length )
+{
+    uint32_t i = 0;
+
+    if( length > 0U )
+    {
+        /* Only scan until the first text byte, socket data is not inspected byte by byte. */
+        for( i = 0; ( i < length ) && ( pBurst->text == false ); i++ )
+        {
+            pBurst->text = ( pData[ i ] != ( uint8_t ) '\r' ) && ( pData[ i ] != ( uint8_t ) '\n' );
+        }
+
+        pBurst->length = pBurst->length + length;
+        pBurst->lineEnd = ( pBurst->text == true ) && ( pData[ length - 1U ] == ( uint8_t ) '\n' );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check if the burst is complete without waiting for the line to go idle.
+ *
+ * @param[in] pBurst The burst.
+ *
+ * @return true if the receive callback should be called now.
+ */
+static inline bool CommBurst_Complete( const CommBurst_t * pBurst )
+{
+    bool complete = ( pBurst->length >= CELLULAR_COMM_INTERFACE_RX_WATERMARK );
+
+    #if ( CELLULAR_COMM_INTERFACE_RX_LINE_END == 1 )
+        complete = complete || ( pBurst->lineEnd == true );
+    #endif
+
+    return complete;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Time without new data that ends a burst.
+ *
+ * @param[in] baudRate Line rate of the port.
+ *
+ * @return Idle timeout in milliseconds, at least 1.
+ */
+static inline uint32_t CommBurst_IdleTimeoutMs( uint32_t baudRate )
+{
+    uint32_t idleBits = CELLULAR_COMM_INTERFACE_RX_IDLE_CHARS * COMM_BURST_BITS_PER_CHAR * 1000U;
+    uint32_t timeoutMs = ( baudRate > 0U ) ? ( ( idleBits + baudRate - 1U ) / baudRate ) : 1U;
+
+    return ( timeoutMs > 0U ) ? timeoutMs : 1U;
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_BURST_H__ */
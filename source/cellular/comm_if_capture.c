@@ -0,0 +1,1126 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_capture.c
+ * @brief Record and replay of the traffic of a cellular comm interface.
+ *
+ * Recording keeps one log per direction, each written by a single caller of
+ * send or recv, so the data is copied without a lock. A sequence number shared
+ * by both directions orders the entries, and the logs are merged in sequence
+ * order when the capture file is written. Traffic of one direction not
+ * interleaved with the other in the same tick extends the previous entry, so a
+ * port delivering one byte at a time does not fill the log with headers.
+ *
+ * Replay delivers each received record only after the library has sent the
+ * bytes of the sent records before it, so responses never overtake the
+ * commands they answer, in either timing mode. Sent data that differs from
+ * the capture is counted but does not change the responses, so sessions
+ * that are not repeatable, such as TLS, do not replay.
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS include. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Platform layer includes. */
+#include "cellular_platform.h"
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+#include "comm_if_capture.h"
+
+/* Receive ring include file. */
+#include "comm_if_ring.h"
+
+/*-----------------------------------------------------------*/
+
+/* Capture file header. */
+#define CAPTURE_MAGIC                  "CCAP"
+#define CAPTURE_MAGIC_LENGTH           ( 4U )
+#define CAPTURE_VERSION                ( 1U )
+#define CAPTURE_HEADER_LENGTH          ( 12U )
+
+/* Record directions, also the index of the record logs. */
+#define CAPTURE_DIRECTION_RX           ( 0U )
+#define CAPTURE_DIRECTION_TX           ( 1U )
+
+/* Tick count, sequence number and length in front of each entry of a record log. */
+#define CAPTURE_LOG_ENTRY_HEADER       ( 12U )
+#define CAPTURE_LOG_TICK_OFFSET        ( 0U )
+#define CAPTURE_LOG_SEQUENCE_OFFSET    ( 4U )
+#define CAPTURE_LOG_LENGTH_OFFSET      ( 8U )
+
+/* Largest unsigned LEB128 encoding of a uint32_t. */
+#define CAPTURE_VARINT_MAX_LENGTH      ( 5U )
+
+/* Replay thread events. */
+#define CAPTURE_EVENT_TX               ( 0x01UL )
+#define CAPTURE_EVENT_RX_SPACE         ( 0x02UL )
+#define CAPTURE_EVENT_STOP             ( 0x04UL )
+#define CAPTURE_EVENT_ALL              ( CAPTURE_EVENT_TX | CAPTURE_EVENT_RX_SPACE | CAPTURE_EVENT_STOP )
+
+/* Interval to poll for the replay thread to exit and for receive ring space in ms. */
+#define CAPTURE_POLL_MS                ( 10U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Log of the traffic of one direction.
+ */
+typedef struct _cellularCaptureLog
+{
+    uint8_t * pBuffer;
+    uint32_t length;
+    uint32_t lastEntryOffset; /**< Offset of the last entry, extended by traffic in the same tick. */
+    uint32_t lastTick;
+    uint32_t lastSequence;
+} _cellularCaptureLog_t;
+
+/**
+ * @brief Record parsed from a capture file.
+ */
+typedef struct _cellularCaptureRecord
+{
+    uint8_t direction;
+    uint32_t deltaTicks;
+    uint32_t length;
+    const uint8_t * pPayload;
+} _cellularCaptureRecord_t;
+
+/**
+ * @brief Record and replay context.
+ */
+typedef struct _cellularCaptureContext
+{
+    bool replay;
+    bool opened;
+    const char * pCapturePath;
+    CellularCommInterfaceReceiveCallback_t receiveCallback;
+    void * pUserData;
+    TickType_t startTick;
+
+    /* Record mode. */
+    CellularCommInterface_t * pPhysicalCommInterface;
+    CellularCommInterfaceHandle_t physicalHandle;
+    _cellularCaptureLog_t logs[ 2 ];
+    uint32_t sequence;
+    volatile bool logFull;
+
+    /* Replay mode. */
+    CellularCommReplayMode_t mode;
+    uint8_t * pCapture;
+    uint32_t captureLength;
+    uint32_t captureTickRate;
+    PlatformEventGroupHandle_t replayEvent;
+    volatile bool replayStop;
+    volatile bool replayRunning;
+    volatile bool rxSpaceWaiting;
+    volatile uint32_t txSentTotal;
+    CellularCommReplayStats_t stats;
+
+    /* Sent data compare cursor, only used by send. */
+    uint32_t txScanOffset;
+    const uint8_t * pTxExpected;
+    uint32_t txExpectedLength;
+
+    CommRing_t rxRing;
+    uint8_t rxRingBuffer[ CELLULAR_COMM_CAPTURE_RX_RING_SIZE ];
+} _cellularCaptureContext_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief CellularCommInterfaceOpen_t implementation.
+ */
+static CellularCommInterfaceError_t _prvCaptureOpen( CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                     void * pUserData,
+                                                     CellularCommInterfaceHandle_t * pCommInterfaceHandle );
+
+/**
+ * @brief CellularCommInterfaceSend_t implementation.
+ */
+static CellularCommInterfaceError_t _prvCaptureSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                     const uint8_t * pData,
+                                                     uint32_t dataLength,
+                                                     uint32_t timeoutMilliseconds,
+                                                     uint32_t * pDataSentLength );
+
+/**
+ * @brief CellularCommInterfaceRecv_t implementation.
+ */
+static CellularCommInterfaceError_t _prvCaptureReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                        uint8_t * pBuffer,
+                                                        uint32_t bufferLength,
+                                                        uint32_t timeoutMilliseconds,
+                                                        uint32_t * pDataReceivedLength );
+
+/**
+ * @brief CellularCommInterfaceClose_t implementation.
+ */
+static CellularCommInterfaceError_t _prvCaptureClose( CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Receive callback of the physical comm interface in record mode.
+ *
+ * @param[in] pUserData Pointer to the capture context.
+ * @param[in] commInterfaceHandle Handle of the physical comm interface.
+ *
+ * @return The return value of the receive callback of the library.
+ */
+static CellularCommInterfaceError_t _captureReceiveCallback( void * pUserData,
+                                                             CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Append traffic to the log of its direction.
+ *
+ * @param[in] pCaptureContext Capture context.
+ * @param[in] direction CAPTURE_DIRECTION_RX or CAPTURE_DIRECTION_TX.
+ * @param[in] pData Bytes sent or received.
+ * @param[in] dataLength Number of bytes in pData.
+ */
+static void _captureLogAppend( _cellularCaptureContext_t * pCaptureContext,
+                               uint32_t direction,
+                               const uint8_t * pData,
+                               uint32_t dataLength );
+
+/**
+ * @brief Merge the logs of both directions and write the capture file.
+ *
+ * @param[in] pCaptureContext Capture context.
+ *
+ * @return true if the capture file is written.
+ */
+static bool _captureWriteFile( const _cellularCaptureContext_t * pCaptureContext );
+
+/**
+ * @brief Load and validate the capture file for replay.
+ *
+ * @param[in] pCaptureContext Capture context.
+ *
+ * @return true if the capture file is loaded.
+ */
+static bool _captureLoadFile( _cellularCaptureContext_t * pCaptureContext );
+
+/**
+ * @brief Parse the record at an offset of the capture.
+ *
+ * @param[in] pCaptureContext Capture context with the loaded capture.
+ * @param[in,out] pOffset Offset of the record. Updated to the next record.
+ * @param[out] pRecord The parsed record.
+ *
+ * @return true if a complete record is parsed.
+ */
+static bool _captureParseRecord( const _cellularCaptureContext_t * pCaptureContext,
+                                 uint32_t * pOffset,
+                                 _cellularCaptureRecord_t * pRecord );
+
+/**
+ * @brief Compare sent bytes with the sent records of the capture.
+ *
+ * @param[in] pCaptureContext Capture context.
+ * @param[in] pData Bytes sent by the library.
+ * @param[in] dataLength Number of bytes in pData.
+ */
+static void _captureCompareSent( _cellularCaptureContext_t * pCaptureContext,
+                                 const uint8_t * pData,
+                                 uint32_t dataLength );
+
+/**
+ * @brief Replay thread. Delivers the received records to the library.
+ *
+ * @param[in] pArgument Pointer to the capture context.
+ */
+static void _captureReplayThread( void * pArgument );
+
+/**
+ * @brief Deliver the payload of a received record through the receive ring.
+ *
+ * @param[in] pCaptureContext Capture context.
+ * @param[in] pPayload Payload of the record.
+ * @param[in] length Payload length.
+ */
+static void _captureDeliver( _cellularCaptureContext_t * pCaptureContext,
+                             const uint8_t * pPayload,
+                             uint32_t length );
+
+/*-----------------------------------------------------------*/
+
+static _cellularCaptureContext_t _cellularCaptureContext = { 0 };
+
+static CellularCommInterface_t _cellularCaptureInterface =
+{
+    .open  = _prvCaptureOpen,
+    .send  = _prvCaptureSend,
+    .recv  = _prvCaptureReceive,
+    .close = _prvCaptureClose
+};
+
+/*-----------------------------------------------------------*/
+
+static uint32_t _captureWriteVarint( uint8_t * pBuffer,
+                                     uint32_t value )
+{
+    uint32_t length = 0;
+
+    do
+    {
+        pBuffer[ length ] = ( uint8_t ) ( value & 0x7FU );
+        value = value >> 7;
+
+        if( value != 0U )
+        {
+            pBuffer[ length ] = pBuffer[ length ] | 0x80U;
+        }
+
+        length++;
+    } while( value != 0U );
+
+    return length;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _captureReadVarint( const uint8_t * pBuffer,
+                                uint32_t bufferLength,
+                                uint32_t * pOffset,
+                                uint32_t * pValue )
+{
+    uint32_t value = 0;
+    uint32_t shift = 0;
+    bool complete = false;
+
+    while( ( complete == false ) && ( *pOffset < bufferLength ) && ( shift < ( 7U * CAPTURE_VARINT_MAX_LENGTH ) ) )
+    {
+        value = value | ( ( uint32_t ) ( pBuffer[ *pOffset ] & 0x7FU ) << shift );
+        complete = ( ( pBuffer[ *pOffset ] & 0x80U ) == 0U );
+        shift = shift + 7U;
+        *pOffset = *pOffset + 1U;
+    }
+
+    *pValue = value;
+
+    return complete;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _captureLogAppend( _cellularCaptureContext_t * pCaptureContext,
+                               uint32_t direction,
+                               const uint8_t * pData,
+                               uint32_t dataLength )
+{
+    _cellularCaptureLog_t * pLog = &pCaptureContext->logs[ direction ];
+    uint32_t tick = ( uint32_t ) ( xTaskGetTickCount() - pCaptureContext->startTick );
+    uint32_t sequence = 0;
+    uint32_t entryLength = 0;
+
+    /* Send and recv are called from different tasks. */
+    taskENTER_CRITICAL();
+    pCaptureContext->sequence++;
+    sequence = pCaptureContext->sequence;
+    taskEXIT_CRITICAL();
+
+    if( pCaptureContext->logFull == true )
+    {
+        /* Recording stopped. */
+    }
+    else if( ( pLog->length > 0U ) && ( pLog->lastTick == tick ) && ( ( pLog->lastSequence + 1U ) == sequence ) &&
+             ( ( CELLULAR_COMM_CAPTURE_BUFFER_SIZE - pLog->length ) >= dataLength ) )
+    {
+        /* Nothing happened in the other direction since the last entry, extend it. */
+        ( void ) memcpy( &pLog->pBuffer[ pLog->length ], pData, dataLength );
+        pLog->length = pLog->length + dataLength;
+        ( void ) memcpy( &entryLength, &pLog->pBuffer[ pLog->lastEntryOffset + CAPTURE_LOG_LENGTH_OFFSET ], sizeof( uint32_t ) );
+        entryLength = entryLength + dataLength;
+        ( void ) memcpy( &pLog->pBuffer[ pLog->lastEntryOffset + CAPTURE_LOG_LENGTH_OFFSET ], &entryLength, sizeof( uint32_t ) );
+        ( void ) memcpy( &pLog->pBuffer[ pLog->lastEntryOffset + CAPTURE_LOG_SEQUENCE_OFFSET ], &sequence, sizeof( uint32_t ) );
+        pLog->lastSequence = sequence;
+    }
+    else if( ( CELLULAR_COMM_CAPTURE_BUFFER_SIZE - pLog->length ) < ( CAPTURE_LOG_ENTRY_HEADER + dataLength ) )
+    {
+        /* Stop both directions, a capture missing one direction can not be replayed. */
+        CellularLogWarn( "Cellular comm capture buffer full, recording stopped" );
+        pCaptureContext->logFull = true;
+    }
+    else
+    {
+        pLog->lastEntryOffset = pLog->length;
+        pLog->lastTick = tick;
+        pLog->lastSequence = sequence;
+        ( void ) memcpy( &pLog->pBuffer[ pLog->length + CAPTURE_LOG_TICK_OFFSET ], &tick, sizeof( uint32_t ) );
+        ( void ) memcpy( &pLog->pBuffer[ pLog->length + CAPTURE_LOG_SEQUENCE_OFFSET ], &sequence, sizeof( uint32_t ) );
+        ( void ) memcpy( &pLog->pBuffer[ pLog->length + CAPTURE_LOG_LENGTH_OFFSET ], &dataLength, sizeof( uint32_t ) );
+        ( void ) memcpy( &pLog->pBuffer[ pLog->length + CAPTURE_LOG_ENTRY_HEADER ], pData, dataLength );
+        pLog->length = pLog->length + CAPTURE_LOG_ENTRY_HEADER + dataLength;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _captureWriteFile( const _cellularCaptureContext_t * pCaptureContext )
+{
+    FILE * pFile = NULL;
+    const uint8_t * pEntry = NULL;
+    uint8_t header[ CAPTURE_HEADER_LENGTH ] = { 0 };
+    uint8_t recordHeader[ 1U + ( 2U * CAPTURE_VARINT_MAX_LENGTH ) ];
+    uint32_t offsets[ 2 ] = { 0 };
+    uint32_t ticks[ 2 ] = { 0 };
+    uint32_t sequences[ 2 ] = { 0 };
+    uint32_t lengths[ 2 ] = { 0 };
+    uint32_t tickRate = configTICK_RATE_HZ;
+    uint32_t previousTick = 0;
+    uint32_t recordHeaderLength = 0;
+    uint32_t direction = 0;
+    uint32_t recordCount = 0;
+    bool ret = true;
+
+    pFile = fopen( pCaptureContext->pCapturePath, "wb" );
+
+    if( pFile == NULL )
+    {
+        CellularLogError( "Cellular comm capture can't create %s", pCaptureContext->pCapturePath );
+        ret = false;
+    }
+    else
+    {
+        ( void ) memcpy( header, CAPTURE_MAGIC, CAPTURE_MAGIC_LENGTH );
+        header[ 4 ] = CAPTURE_VERSION;
+        header[ 8 ] = ( uint8_t ) ( tickRate & 0xFFU );
+        header[ 9 ] = ( uint8_t ) ( ( tickRate >> 8 ) & 0xFFU );
+        header[ 10 ] = ( uint8_t ) ( ( tickRate >> 16 ) & 0xFFU );
+        header[ 11 ] = ( uint8_t ) ( ( tickRate >> 24 ) & 0xFFU );
+        ret = ( fwrite( header, 1U, CAPTURE_HEADER_LENGTH, pFile ) == CAPTURE_HEADER_LENGTH );
+
+        /* Merge the two logs in sequence order. */
+        while( ( ret == true ) &&
+               ( ( offsets[ CAPTURE_DIRECTION_RX ] < pCaptureContext->logs[ CAPTURE_DIRECTION_RX ].length ) ||
+                 ( offsets[ CAPTURE_DIRECTION_TX ] < pCaptureContext->logs[ CAPTURE_DIRECTION_TX ].length ) ) )
+        {
+            for( direction = 0; direction < 2U; direction++ )
+            {
+                if( offsets[ direction ] < pCaptureContext->logs[ direction ].length )
+                {
+                    pEntry = &pCaptureContext->logs[ direction ].pBuffer[ offsets[ direction ] ];
+                    ( void ) memcpy( &ticks[ direction ], &pEntry[ CAPTURE_LOG_TICK_OFFSET ], sizeof( uint32_t ) );
+                    ( void ) memcpy( &sequences[ direction ], &pEntry[ CAPTURE_LOG_SEQUENCE_OFFSET ], sizeof( uint32_t ) );
+                    ( void ) memcpy( &lengths[ direction ], &pEntry[ CAPTURE_LOG_LENGTH_OFFSET ], sizeof( uint32_t ) );
+                }
+            }
+
+            if( offsets[ CAPTURE_DIRECTION_TX ] >= pCaptureContext->logs[ CAPTURE_DIRECTION_TX ].length )
+            {
+                direction = CAPTURE_DIRECTION_RX;
+            }
+            else if( offsets[ CAPTURE_DIRECTION_RX ] >= pCaptureContext->logs[ CAPTURE_DIRECTION_RX ].length )
+            {
+                direction = CAPTURE_DIRECTION_TX;
+            }
+            else
+            {
+                direction = ( sequences[ CAPTURE_DIRECTION_RX ] < sequences[ CAPTURE_DIRECTION_TX ] ) ?
+                            CAPTURE_DIRECTION_RX : CAPTURE_DIRECTION_TX;
+            }
+
+            /* The logs are written by different tasks, keep the deltas non negative. */
+            if( ticks[ direction ] < previousTick )
+            {
+                ticks[ direction ] = previousTick;
+            }
+
+            recordHeader[ 0 ] = ( uint8_t ) direction;
+            recordHeaderLength = 1U;
+            recordHeaderLength += _captureWriteVarint( &recordHeader[ recordHeaderLength ], ticks[ direction ] - previousTick );
+            recordHeaderLength += _captureWriteVarint( &recordHeader[ recordHeaderLength ], lengths[ direction ] );
+            previousTick = ticks[ direction ];
+
+            ret = ( fwrite( recordHeader, 1U, recordHeaderLength, pFile ) == recordHeaderLength ) &&
+                  ( fwrite( &pCaptureContext->logs[ direction ].pBuffer[ offsets[ direction ] + CAPTURE_LOG_ENTRY_HEADER ],
+                            1U, lengths[ direction ], pFile ) == lengths[ direction ] );
+
+            offsets[ direction ] = offsets[ direction ] + CAPTURE_LOG_ENTRY_HEADER + lengths[ direction ];
+            recordCount++;
+        }
+
+        if( fclose( pFile ) != 0 )
+        {
+            ret = false;
+        }
+
+        if( ret == true )
+        {
+            CellularLogInfo( "Cellular comm capture %s: %u records, %u ticks",
+                             pCaptureContext->pCapturePath, recordCount, previousTick );
+        }
+        else
+        {
+            CellularLogError( "Cellular comm capture write %s failed", pCaptureContext->pCapturePath );
+        }
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _captureLoadFile( _cellularCaptureContext_t * pCaptureContext )
+{
+    FILE * pFile = NULL;
+    long fileLength = 0;
+    bool ret = false;
+
+    pFile = fopen( pCaptureContext->pCapturePath, "rb" );
+
+    if( pFile == NULL )
+    {
+        CellularLogError( "Cellular comm replay can't open %s", pCaptureContext->pCapturePath );
+    }
+    else
+    {
+        if( fseek( pFile, 0, SEEK_END ) == 0 )
+        {
+            fileLength = ftell( pFile );
+        }
+
+        if( ( fileLength >= ( long ) CAPTURE_HEADER_LENGTH ) && ( fseek( pFile, 0, SEEK_SET ) == 0 ) )
+        {
+            pCaptureContext->pCapture = ( uint8_t * ) Platform_Malloc( ( size_t ) fileLength );
+        }
+
+        if( pCaptureContext->pCapture != NULL )
+        {
+            pCaptureContext->captureLength = ( uint32_t ) fileLength;
+            ret = ( fread( pCaptureContext->pCapture, 1U, ( size_t ) fileLength, pFile ) == ( size_t ) fileLength );
+        }
+
+        ( void ) fclose( pFile );
+    }
+
+    if( ret == true )
+    {
+        pCaptureContext->captureTickRate = ( uint32_t ) pCaptureContext->pCapture[ 8 ] |
+                                           ( ( uint32_t ) pCaptureContext->pCapture[ 9 ] << 8 ) |
+                                           ( ( uint32_t ) pCaptureContext->pCapture[ 10 ] << 16 ) |
+                                           ( ( uint32_t ) pCaptureContext->pCapture[ 11 ] << 24 );
+
+        if( ( memcmp( pCaptureContext->pCapture, CAPTURE_MAGIC, CAPTURE_MAGIC_LENGTH ) != 0 ) ||
+            ( pCaptureContext->pCapture[ 4 ] != CAPTURE_VERSION ) ||
+            ( pCaptureContext->captureTickRate == 0U ) )
+        {
+            CellularLogError( "Cellular comm replay %s is not a capture file", pCaptureContext->pCapturePath );
+            ret = false;
+        }
+    }
+
+    if( ( ret == false ) && ( pCaptureContext->pCapture != NULL ) )
+    {
+        Platform_Free( pCaptureContext->pCapture );
+        pCaptureContext->pCapture = NULL;
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _captureParseRecord( const _cellularCaptureContext_t * pCaptureContext,
+                                 uint32_t * pOffset,
+                                 _cellularCaptureRecord_t * pRecord )
+{
+    uint32_t offset = *pOffset;
+    bool ret = false;
+
+    if( offset < pCaptureContext->captureLength )
+    {
+        pRecord->direction = pCaptureContext->pCapture[ offset ];
+        offset++;
+
+        if( ( pRecord->direction <= CAPTURE_DIRECTION_TX ) &&
+            ( _captureReadVarint( pCaptureContext->pCapture, pCaptureContext->captureLength, &offset, &pRecord->deltaTicks ) == true ) &&
+            ( _captureReadVarint( pCaptureContext->pCapture, pCaptureContext->captureLength, &offset, &pRecord->length ) == true ) &&
+            ( pRecord->length <= ( pCaptureContext->captureLength - offset ) ) )
+        {
+            pRecord->pPayload = &pCaptureContext->pCapture[ offset ];
+            *pOffset = offset + pRecord->length;
+            ret = true;
+        }
+        else
+        {
+            CellularLogError( "Cellular comm replay malformed record at offset %u", *pOffset );
+        }
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _captureCompareSent( _cellularCaptureContext_t * pCaptureContext,
+                                 const uint8_t * pData,
+                                 uint32_t dataLength )
+{
+    _cellularCaptureRecord_t record = { 0 };
+    uint32_t index = 0;
+    uint32_t compareLength = 0;
+
+    while( index < dataLength )
+    {
+        /* Advance to the next sent record of the capture. */
+        while( ( pCaptureContext->txExpectedLength == 0U ) &&
+               ( _captureParseRecord( pCaptureContext, &pCaptureContext->txScanOffset, &record ) == true ) )
+        {
+            if( record.direction == CAPTURE_DIRECTION_TX )
+            {
+                pCaptureContext->pTxExpected = record.pPayload;
+                pCaptureContext->txExpectedLength = record.length;
+            }
+        }
+
+        if( pCaptureContext->txExpectedLength == 0U )
+        {
+            /* Sent beyond the end of the capture. */
+            pCaptureContext->stats.txMismatchBytes += dataLength - index;
+            index = dataLength;
+        }
+        else
+        {
+            compareLength = dataLength - index;
+
+            if( compareLength > pCaptureContext->txExpectedLength )
+            {
+                compareLength = pCaptureContext->txExpectedLength;
+            }
+
+            if( memcmp( &pData[ index ], pCaptureContext->pTxExpected, compareLength ) != 0 )
+            {
+                if( pCaptureContext->stats.txMismatchBytes == 0U )
+                {
+                    CellularLogWarn( "Cellular comm replay sent data differs from the capture at byte %u",
+                                     pCaptureContext->txSentTotal + index );
+                }
+
+                pCaptureContext->stats.txMismatchBytes += compareLength;
+            }
+
+            pCaptureContext->pTxExpected = &pCaptureContext->pTxExpected[ compareLength ];
+            pCaptureContext->txExpectedLength -= compareLength;
+            index = index + compareLength;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _captureDeliver( _cellularCaptureContext_t * pCaptureContext,
+                             const uint8_t * pPayload,
+                             uint32_t length )
+{
+    uint8_t * pWrite = NULL;
+    uint32_t spanLength = 0;
+    uint32_t delivered = 0;
+
+    while( ( delivered < length ) && ( pCaptureContext->replayStop == false ) )
+    {
+        spanLength = CommRing_GetWriteSpan( &pCaptureContext->rxRing, &pWrite );
+
+        if( spanLength > 0U )
+        {
+            if( spanLength > ( length - delivered ) )
+            {
+                spanLength = length - delivered;
+            }
+
+            ( void ) memcpy( pWrite, &pPayload[ delivered ], spanLength );
+            CommRing_Commit( &pCaptureContext->rxRing, spanLength );
+            delivered = delivered + spanLength;
+        }
+        else
+        {
+            /* Ring full. Let the library drain it, then wait for recv to free space. */
+            pCaptureContext->rxSpaceWaiting = true;
+            ( void ) pCaptureContext->receiveCallback( pCaptureContext->pUserData,
+                                                       ( CellularCommInterfaceHandle_t ) pCaptureContext );
+            ( void ) PlatformEventGroup_WaitBits( pCaptureContext->replayEvent,
+                                                  CAPTURE_EVENT_RX_SPACE | CAPTURE_EVENT_STOP,
+                                                  pdTRUE, pdFALSE, pdMS_TO_TICKS( CAPTURE_POLL_MS ) );
+            pCaptureContext->rxSpaceWaiting = false;
+        }
+    }
+
+    pCaptureContext->stats.rxBytes += delivered;
+    ( void ) pCaptureContext->receiveCallback( pCaptureContext->pUserData,
+                                               ( CellularCommInterfaceHandle_t ) pCaptureContext );
+}
+
+/*-----------------------------------------------------------*/
+
+static TickType_t _captureTicksUntil( TickType_t dueTick )
+{
+    TickType_t remainingTicks = dueTick - xTaskGetTickCount();
+
+    /* A due tick in the past wraps around to a large value. */
+    return ( remainingTicks > ( portMAX_DELAY / 2U ) ) ? 0U : remainingTicks;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _captureReplayThread( void * pArgument )
+{
+    _cellularCaptureContext_t * pCaptureContext = ( _cellularCaptureContext_t * ) pArgument;
+    _cellularCaptureRecord_t record = { 0 };
+    uint32_t offset = CAPTURE_HEADER_LENGTH;
+    uint32_t txExpectedTotal = 0;
+    uint64_t captureTick = 0;
+    uint64_t anchorCaptureTick = 0;
+    TickType_t anchorTick = pCaptureContext->startTick;
+    TickType_t dueTick = 0;
+    TickType_t remainingTicks = 0;
+    TickType_t waitStartTick = 0;
+    TickType_t elapsedTicks = 0;
+    const TickType_t txTimeoutTicks = pdMS_TO_TICKS( CELLULAR_COMM_CAPTURE_TX_TIMEOUT_MS );
+
+    while( ( pCaptureContext->replayStop == false ) &&
+           ( _captureParseRecord( pCaptureContext, &offset, &record ) == true ) )
+    {
+        captureTick = captureTick + record.deltaTicks;
+
+        if( record.direction == CAPTURE_DIRECTION_TX )
+        {
+            /* Wait for the library to send this record. */
+            txExpectedTotal = txExpectedTotal + record.length;
+            waitStartTick = xTaskGetTickCount();
+
+            while( ( pCaptureContext->txSentTotal < txExpectedTotal ) && ( pCaptureContext->replayStop == false ) )
+            {
+                elapsedTicks = xTaskGetTickCount() - waitStartTick;
+
+                if( elapsedTicks >= txTimeoutTicks )
+                {
+                    CellularLogWarn( "Cellular comm replay sent record at offset %u not sent by the library", offset );
+                    pCaptureContext->stats.txStallCount++;
+                    break;
+                }
+
+                ( void ) PlatformEventGroup_WaitBits( pCaptureContext->replayEvent,
+                                                      CAPTURE_EVENT_TX | CAPTURE_EVENT_STOP,
+                                                      pdTRUE, pdFALSE, txTimeoutTicks - elapsedTicks );
+            }
+
+            /* Received records are timed from the moment the library sent its data. */
+            anchorTick = xTaskGetTickCount();
+            anchorCaptureTick = captureTick;
+        }
+        else
+        {
+            if( pCaptureContext->mode == CELLULAR_COMM_REPLAY_REAL_TIME )
+            {
+                dueTick = anchorTick + ( TickType_t ) ( ( ( captureTick - anchorCaptureTick ) * configTICK_RATE_HZ ) /
+                                                        pCaptureContext->captureTickRate );
+
+                remainingTicks = _captureTicksUntil( dueTick );
+
+                while( ( remainingTicks > 0U ) && ( pCaptureContext->replayStop == false ) )
+                {
+                    ( void ) PlatformEventGroup_WaitBits( pCaptureContext->replayEvent, CAPTURE_EVENT_STOP,
+                                                          pdFALSE, pdFALSE, remainingTicks );
+                    remainingTicks = _captureTicksUntil( dueTick );
+                }
+            }
+
+            _captureDeliver( pCaptureContext, record.pPayload, record.length );
+        }
+    }
+
+    pCaptureContext->stats.complete = ( pCaptureContext->replayStop == false ) && ( offset == pCaptureContext->captureLength );
+    pCaptureContext->stats.elapsedMs = ( uint32_t ) ( ( ( uint64_t ) ( xTaskGetTickCount() - pCaptureContext->startTick ) * 1000U ) /
+                                                      configTICK_RATE_HZ );
+
+    CellularLogInfo( "Cellular comm replay %s: %u bytes received, %u bytes sent, %u differ, %u stalls in %u ms",
+                     ( pCaptureContext->stats.complete == true ) ? "complete" : "stopped",
+                     pCaptureContext->stats.rxBytes, pCaptureContext->txSentTotal,
+                     pCaptureContext->stats.txMismatchBytes, pCaptureContext->stats.txStallCount,
+                     pCaptureContext->stats.elapsedMs );
+
+    pCaptureContext->replayRunning = false;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _captureReceiveCallback( void * pUserData,
+                                                             CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    _cellularCaptureContext_t * pCaptureContext = ( _cellularCaptureContext_t * ) pUserData;
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+
+    ( void ) commInterfaceHandle;
+
+    if( pCaptureContext->receiveCallback != NULL )
+    {
+        commIntRet = pCaptureContext->receiveCallback( pCaptureContext->pUserData,
+                                                       ( CellularCommInterfaceHandle_t ) pCaptureContext );
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCaptureOpen( CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                     void * pUserData,
+                                                     CellularCommInterfaceHandle_t * pCommInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCaptureContext_t * pCaptureContext = &_cellularCaptureContext;
+
+    if( ( pCommInterfaceHandle == NULL ) || ( receiveCallback == NULL ) || ( pCaptureContext->pCapturePath == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pCaptureContext->opened == true )
+    {
+        CellularLogError( "Cellular comm capture is opened already" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        pCaptureContext->receiveCallback = receiveCallback;
+        pCaptureContext->pUserData = pUserData;
+        pCaptureContext->logFull = false;
+        pCaptureContext->txSentTotal = 0;
+        pCaptureContext->startTick = xTaskGetTickCount();
+    }
+
+    if( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( pCaptureContext->replay == false ) )
+    {
+        pCaptureContext->logs[ CAPTURE_DIRECTION_RX ].pBuffer = ( uint8_t * ) Platform_Malloc( CELLULAR_COMM_CAPTURE_BUFFER_SIZE );
+        pCaptureContext->logs[ CAPTURE_DIRECTION_TX ].pBuffer = ( uint8_t * ) Platform_Malloc( CELLULAR_COMM_CAPTURE_BUFFER_SIZE );
+        pCaptureContext->logs[ CAPTURE_DIRECTION_RX ].length = 0;
+        pCaptureContext->logs[ CAPTURE_DIRECTION_TX ].length = 0;
+        pCaptureContext->sequence = 0;
+
+        if( ( pCaptureContext->logs[ CAPTURE_DIRECTION_RX ].pBuffer == NULL ) ||
+            ( pCaptureContext->logs[ CAPTURE_DIRECTION_TX ].pBuffer == NULL ) )
+        {
+            CellularLogError( "Cellular comm capture buffer allocation failed" );
+            commIntRet = IOT_COMM_INTERFACE_NO_MEMORY;
+        }
+        else
+        {
+            commIntRet = pCaptureContext->pPhysicalCommInterface->open( _captureReceiveCallback, pCaptureContext,
+                                                                       &pCaptureContext->physicalHandle );
+        }
+
+        if( commIntRet != IOT_COMM_INTERFACE_SUCCESS )
+        {
+            if( pCaptureContext->logs[ CAPTURE_DIRECTION_RX ].pBuffer != NULL )
+            {
+                Platform_Free( pCaptureContext->logs[ CAPTURE_DIRECTION_RX ].pBuffer );
+                pCaptureContext->logs[ CAPTURE_DIRECTION_RX ].pBuffer = NULL;
+            }
+
+            if( pCaptureContext->logs[ CAPTURE_DIRECTION_TX ].pBuffer != NULL )
+            {
+                Platform_Free( pCaptureContext->logs[ CAPTURE_DIRECTION_TX ].pBuffer );
+                pCaptureContext->logs[ CAPTURE_DIRECTION_TX ].pBuffer = NULL;
+            }
+        }
+    }
+    else if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        CommRing_Init( &pCaptureContext->rxRing, pCaptureContext->rxRingBuffer, CELLULAR_COMM_CAPTURE_RX_RING_SIZE );
+        ( void ) memset( &pCaptureContext->stats, 0, sizeof( CellularCommReplayStats_t ) );
+        pCaptureContext->txScanOffset = CAPTURE_HEADER_LENGTH;
+        pCaptureContext->txExpectedLength = 0;
+        pCaptureContext->replayStop = false;
+        pCaptureContext->rxSpaceWaiting = false;
+
+        if( _captureLoadFile( pCaptureContext ) == false )
+        {
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+        else
+        {
+            pCaptureContext->replayEvent = PlatformEventGroup_Create();
+
+            if( pCaptureContext->replayEvent == NULL )
+            {
+                commIntRet = IOT_COMM_INTERFACE_NO_MEMORY;
+            }
+            else
+            {
+                pCaptureContext->replayRunning = true;
+
+                if( Platform_CreateDedicatedThread( _captureReplayThread, pCaptureContext,
+                                                    PLATFORM_THREAD_DEFAULT_PRIORITY,
+                                                    PLATFORM_THREAD_DEFAULT_STACK_SIZE ) == false )
+                {
+                    CellularLogError( "Cellular comm replay thread create failed" );
+                    pCaptureContext->replayRunning = false;
+                    PlatformEventGroup_Delete( pCaptureContext->replayEvent );
+                    pCaptureContext->replayEvent = NULL;
+                    commIntRet = IOT_COMM_INTERFACE_FAILURE;
+                }
+            }
+
+            if( commIntRet != IOT_COMM_INTERFACE_SUCCESS )
+            {
+                Platform_Free( pCaptureContext->pCapture );
+                pCaptureContext->pCapture = NULL;
+            }
+        }
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        pCaptureContext->opened = true;
+        *pCommInterfaceHandle = ( CellularCommInterfaceHandle_t ) pCaptureContext;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCaptureSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                     const uint8_t * pData,
+                                                     uint32_t dataLength,
+                                                     uint32_t timeoutMilliseconds,
+                                                     uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCaptureContext_t * pCaptureContext = ( _cellularCaptureContext_t * ) commInterfaceHandle;
+
+    if( ( pCaptureContext == NULL ) || ( pData == NULL ) || ( pDataSentLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pCaptureContext->opened == false )
+    {
+        CellularLogError( "Cellular comm capture send is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( pCaptureContext->replay == false )
+    {
+        *pDataSentLength = 0;
+        commIntRet = pCaptureContext->pPhysicalCommInterface->send( pCaptureContext->physicalHandle, pData, dataLength,
+                                                                   timeoutMilliseconds, pDataSentLength );
+
+        if( *pDataSentLength > 0U )
+        {
+            _captureLogAppend( pCaptureContext, CAPTURE_DIRECTION_TX, pData, *pDataSentLength );
+        }
+    }
+    else
+    {
+        _captureCompareSent( pCaptureContext, pData, dataLength );
+        pCaptureContext->txSentTotal = pCaptureContext->txSentTotal + dataLength;
+        ( void ) PlatformEventGroup_SetBits( pCaptureContext->replayEvent, CAPTURE_EVENT_TX );
+        *pDataSentLength = dataLength;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCaptureReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                        uint8_t * pBuffer,
+                                                        uint32_t bufferLength,
+                                                        uint32_t timeoutMilliseconds,
+                                                        uint32_t * pDataReceivedLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCaptureContext_t * pCaptureContext = ( _cellularCaptureContext_t * ) commInterfaceHandle;
+
+    if( ( pCaptureContext == NULL ) || ( pBuffer == NULL ) || ( pDataReceivedLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pCaptureContext->opened == false )
+    {
+        CellularLogError( "Cellular comm capture read is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( pCaptureContext->replay == false )
+    {
+        *pDataReceivedLength = 0;
+        commIntRet = pCaptureContext->pPhysicalCommInterface->recv( pCaptureContext->physicalHandle, pBuffer, bufferLength,
+                                                                   timeoutMilliseconds, pDataReceivedLength );
+
+        if( *pDataReceivedLength > 0U )
+        {
+            _captureLogAppend( pCaptureContext, CAPTURE_DIRECTION_RX, pBuffer, *pDataReceivedLength );
+        }
+    }
+    else
+    {
+        /* Same as the physical comm interface, return immediately with the bytes received. */
+        *pDataReceivedLength = CommRing_Read( &pCaptureContext->rxRing, pBuffer, bufferLength );
+
+        if( pCaptureContext->rxSpaceWaiting == true )
+        {
+            ( void ) PlatformEventGroup_SetBits( pCaptureContext->replayEvent, CAPTURE_EVENT_RX_SPACE );
+        }
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCaptureClose( CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCaptureContext_t * pCaptureContext = ( _cellularCaptureContext_t * ) commInterfaceHandle;
+    uint32_t direction = 0;
+
+    if( pCaptureContext == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pCaptureContext->opened == false )
+    {
+        CellularLogError( "Cellular comm capture close is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( pCaptureContext->replay == false )
+    {
+        commIntRet = pCaptureContext->pPhysicalCommInterface->close( pCaptureContext->physicalHandle );
+
+        if( _captureWriteFile( pCaptureContext ) == false )
+        {
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+
+        for( direction = 0; direction < 2U; direction++ )
+        {
+            Platform_Free( pCaptureContext->logs[ direction ].pBuffer );
+            pCaptureContext->logs[ direction ].pBuffer = NULL;
+        }
+    }
+    else
+    {
+        pCaptureContext->replayStop = true;
+        ( void ) PlatformEventGroup_SetBits( pCaptureContext->replayEvent, CAPTURE_EVENT_ALL );
+
+        while( pCaptureContext->replayRunning == true )
+        {
+            Platform_Delay( CAPTURE_POLL_MS );
+        }
+
+        PlatformEventGroup_Delete( pCaptureContext->replayEvent );
+        pCaptureContext->replayEvent = NULL;
+        Platform_Free( pCaptureContext->pCapture );
+        pCaptureContext->pCapture = NULL;
+    }
+
+    if( pCaptureContext != NULL )
+    {
+        pCaptureContext->opened = false;
+        pCaptureContext->receiveCallback = NULL;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterface_t * CellularCommCapture_Record( CellularCommInterface_t * pPhysicalCommInterface,
+                                                      const char * pCapturePath )
+{
+    CellularCommInterface_t * pCommInterface = NULL;
+    _cellularCaptureContext_t * pCaptureContext = &_cellularCaptureContext;
+
+    if( ( pPhysicalCommInterface == NULL ) || ( pCapturePath == NULL ) )
+    {
+        CellularLogError( "Cellular comm capture record bad parameter" );
+    }
+    else if( pCaptureContext->opened == true )
+    {
+        CellularLogError( "Cellular comm capture is opened already" );
+    }
+    else
+    {
+        pCaptureContext->replay = false;
+        pCaptureContext->pPhysicalCommInterface = pPhysicalCommInterface;
+        pCaptureContext->pCapturePath = pCapturePath;
+        pCommInterface = &_cellularCaptureInterface;
+    }
+
+    return pCommInterface;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterface_t * CellularCommCapture_Replay( const char * pCapturePath,
+                                                      CellularCommReplayMode_t mode )
+{
+    CellularCommInterface_t * pCommInterface = NULL;
+    _cellularCaptureContext_t * pCaptureContext = &_cellularCaptureContext;
+
+    if( ( pCapturePath == NULL ) ||
+        ( ( mode != CELLULAR_COMM_REPLAY_REAL_TIME ) && ( mode != CELLULAR_COMM_REPLAY_FAST ) ) )
+    {
+        CellularLogError( "Cellular comm capture replay bad parameter" );
+    }
+    else if( pCaptureContext->opened == true )
+    {
+        CellularLogError( "Cellular comm capture is opened already" );
+    }
+    else
+    {
+        pCaptureContext->replay = true;
+        pCaptureContext->mode = mode;
+        pCaptureContext->pPhysicalCommInterface = NULL;
+        pCaptureContext->pCapturePath = pCapturePath;
+        pCommInterface = &_cellularCaptureInterface;
+    }
+
+    return pCommInterface;
+}
+
+/*-----------------------------------------------------------*/
+
+void CellularCommCapture_GetReplayStats( CellularCommReplayStats_t * pStats )
+{
+    if( pStats != NULL )
+    {
+        *pStats = _cellularCaptureContext.stats;
+        pStats->txBytes = _cellularCaptureContext.txSentTotal;
+    }
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,148 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_capture.h
+ * @brief Record and replay of the traffic of a cellular comm interface.
+ *
+ * In record mode the comm interface wraps a physical comm interface and keeps
+ * every byte sent and received with its tick count. The capture is written to
+ * a file when the comm interface is closed. In replay mode the comm interface
+ * plays a capture file back to the cellular library without a modem, either
+ * at the recorded timing or as fast as the library sends its commands, so the
+ * CPU cost of the layers above the comm interface can be measured repeatably.
+ *
+ * Replay only works for sessions the library repeats byte for byte, which are
+ * AT commands and plaintext socket data. The recorded responses are replayed
+ * whatever the library sends, so a TLS session fails its handshake on replay,
+ * because its random values, and so the handshake, differ from the capture.
+ *
+ * Capture file format, all values little endian:
+ * - Header: "CCAP", version, three reserved bytes, tick rate in Hz as uint32.
+ * - Records: direction ( 0 received, 1 sent ), ticks since the previous record
+ *   and payload length as unsigned LEB128, then the payload.
+ */
+
+#ifndef __COMM_IF_CAPTURE_H__
+#define __COMM_IF_CAPTURE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record buffer size of each direction. Recording stops when a buffer is full.
+ */
+#ifndef CELLULAR_COMM_CAPTURE_BUFFER_SIZE
+    #define CELLULAR_COMM_CAPTURE_BUFFER_SIZE    ( 65536U )
+#endif
+
+/**
+ * @brief Size of the replay receive ring. Must be a power of two.
+ */
+#ifndef CELLULAR_COMM_CAPTURE_RX_RING_SIZE
+    #define CELLULAR_COMM_CAPTURE_RX_RING_SIZE    ( 4096U )
+#endif
+
+/**
+ * @brief Time replay waits for the library to send the data of a sent record.
+ *
+ * Replay goes on without it after this time, so a library that diverges from
+ * the capture does not stall the replay.
+ */
+#ifndef CELLULAR_COMM_CAPTURE_TX_TIMEOUT_MS
+    #define CELLULAR_COMM_CAPTURE_TX_TIMEOUT_MS    ( 10000U )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Replay timing.
+ */
+typedef enum CellularCommReplayMode
+{
+    CELLULAR_COMM_REPLAY_REAL_TIME = 0, /**< Received data follows the sent data with the recorded delay. */
+    CELLULAR_COMM_REPLAY_FAST           /**< Received data follows the sent data immediately. */
+} CellularCommReplayMode_t;
+
+/**
+ * @brief Replay result.
+ */
+typedef struct CellularCommReplayStats
+{
+    uint32_t rxBytes;         /**< Bytes delivered to the library. */
+    uint32_t txBytes;         /**< Bytes sent by the library. */
+    uint32_t txMismatchBytes; /**< Sent bytes that differ from the capture. */
+    uint32_t txStallCount;    /**< Sent records the library did not send within CELLULAR_COMM_CAPTURE_TX_TIMEOUT_MS. */
+    uint32_t elapsedMs;       /**< Time from open to the end of the capture. */
+    bool complete;            /**< The whole capture has been replayed. */
+} CellularCommReplayStats_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get a comm interface that records the traffic of a physical comm interface.
+ *
+ * The returned comm interface opens and forwards to pPhysicalCommInterface. The
+ * capture is written to pCapturePath when it is closed.
+ *
+ * @param[in] pPhysicalCommInterface The comm interface connected to the modem.
+ * @param[in] pCapturePath Path of the capture file. Must stay valid until the comm interface is closed.
+ *
+ * @return The recording comm interface. NULL if a parameter is invalid.
+ */
+CellularCommInterface_t * CellularCommCapture_Record( CellularCommInterface_t * pPhysicalCommInterface,
+                                                      const char * pCapturePath );
+
+/**
+ * @brief Get a comm interface that replays a capture file.
+ *
+ * The capture is loaded when the comm interface is opened. The received data is
+ * delivered by a replay thread, which calls the receive callback.
+ *
+ * @param[in] pCapturePath Path of the capture file. Must stay valid until the comm interface is opened.
+ * @param[in] mode Replay timing.
+ *
+ * @return The replaying comm interface. NULL if a parameter is invalid.
+ */
+CellularCommInterface_t * CellularCommCapture_Replay( const char * pCapturePath,
+                                                      CellularCommReplayMode_t mode );
+
+/**
+ * @brief Get the result of the current or last replay.
+ *
+ * @param[out] pStats Replay result.
+ */
+void CellularCommCapture_GetReplayStats( CellularCommReplayStats_t * pStats );
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_CAPTURE_H__ */
@@ -0,0 +1,1434 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_cmux.c
+ * @brief 3GPP TS 27.010 basic option multiplexer on top of a cellular comm interface.
+ *
+ * Frames are demultiplexed in the receive callback of the physical comm
+ * interface into a receive ring per channel, then the receive callback of the
+ * channel is called. The callback context is the same as the physical comm
+ * interface, so demultiplexing never blocks. Responses the modem expects for
+ * its own commands are queued to the senders, which own the transmit path.
+ *
+ * A channel whose ring fills to CELLULAR_CMUX_CHANNEL_RX_HIGH_WATER asks the
+ * modem to stop sending on it with an MSC carrying FC = 1, and to resume with
+ * FC = 0 once recv drained it to CELLULAR_CMUX_CHANNEL_RX_LOW_WATER. The MSC
+ * goes out with the queued responses on the next send or recv.
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS include. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Platform layer includes. */
+#include "cellular_platform.h"
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+#include "comm_if_cmux.h"
+
+/* Receive ring include file. */
+#include "comm_if_ring.h"
+
+/*-----------------------------------------------------------*/
+
+/* Opening and closing flag of a basic option frame. */
+#define CMUX_FLAG                            ( 0xF9U )
+
+/* Extension and command/response bits of the address, length and message type fields. */
+#define CMUX_EA                              ( 0x01U )
+#define CMUX_CR                              ( 0x02U )
+
+/* Frame types of the control field with the poll/final bit cleared. */
+#define CMUX_FRAME_SABM                      ( 0x2FU )
+#define CMUX_FRAME_UA                        ( 0x63U )
+#define CMUX_FRAME_DM                        ( 0x0FU )
+#define CMUX_FRAME_DISC                      ( 0x43U )
+#define CMUX_FRAME_UIH                       ( 0xEFU )
+#define CMUX_CONTROL_PF                      ( 0x10U )
+
+/* Multiplexer control channel message types with the C/R bit cleared. */
+#define CMUX_MSG_CLD                         ( 0xC1U )
+#define CMUX_MSG_MSC                         ( 0xE1U )
+
+/* V.24 signals sent with MSC: EA, RTC, RTR and DV. */
+#define CMUX_MSC_SIGNALS                     ( 0x8DU )
+
+/* Flow control bit of the MSC V.24 signals. */
+#define CMUX_MSC_FC                          ( 0x02U )
+
+/* Flags, address, control, two length octets and FCS around the information field. */
+#define CMUX_FRAME_OVERHEAD                  ( 7U )
+
+/* Largest information field with a single length octet. */
+#define CMUX_SHORT_LENGTH_MAX                ( 127U )
+
+/* FCS is a reversed CRC-8 with polynomial x^8 + x^2 + x + 1. */
+#define CMUX_FCS_INIT                        ( 0xFFU )
+#define CMUX_FCS_POLYNOMIAL                  ( 0xE0U )
+
+/* Time to wait for the modem response to AT+CMUX, SABM and DISC in ms. */
+#define CMUX_RESPONSE_TIMEOUT_MS             ( 3000U )
+
+/* Interval to poll for the modem response in ms. */
+#define CMUX_RESPONSE_POLL_MS                ( 10U )
+
+/* Send timeout of AT+CMUX and control frames in ms. */
+#define CMUX_SEND_TIMEOUT_MS                 ( 1000U )
+
+/* Size of the buffer the physical comm interface is read into. */
+#define CMUX_RX_READ_SIZE                    ( 256U )
+
+/* Size of the buffer holding the response to AT+CMUX. */
+#define CMUX_AT_RESPONSE_BUFFER_SIZE         ( 64U )
+
+/* Ring of responses queued by the demultiplexer. Records never wrap around the ring. */
+#define CMUX_RESPONSE_RING_SIZE              ( 64U )
+#define CMUX_RESPONSE_RECORD_SIZE            ( 4U )
+
+/* DLCI states. */
+#define CMUX_DLCI_CLOSED                     ( 0U )
+#define CMUX_DLCI_OPENING                    ( 1U )
+#define CMUX_DLCI_OPEN                       ( 2U )
+#define CMUX_DLCI_CLOSING                    ( 3U )
+#define CMUX_DLCI_REJECTED                   ( 4U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Frame receive state.
+ */
+typedef enum CmuxParseState
+{
+    CMUX_PARSE_FLAG = 0,    /**< Waiting for the opening flag. */
+    CMUX_PARSE_ADDRESS,     /**< Waiting for the address field. Repeated flags are skipped. */
+    CMUX_PARSE_CONTROL,     /**< Waiting for the control field. */
+    CMUX_PARSE_LENGTH,      /**< Waiting for the first length octet. */
+    CMUX_PARSE_LENGTH_HIGH, /**< Waiting for the second length octet. */
+    CMUX_PARSE_DATA,        /**< Receiving the information field. */
+    CMUX_PARSE_FCS,         /**< Waiting for the FCS. */
+    CMUX_PARSE_END          /**< Waiting for the closing flag. */
+} CmuxParseState_t;
+
+/**
+ * @brief Virtual channel context.
+ */
+typedef struct _cellularCmuxChannel
+{
+    CellularCommInterfaceReceiveCallback_t receiveCallback;
+    void * pUserData;
+    uint8_t dlci;
+    bool rxPending;
+    volatile bool flowStopped;
+
+    /* Receive flow control. The demultiplexer sets rxFlowStopped at the high
+     * water mark and recv clears it at the low water mark. rxFlowSignalled is
+     * the FC bit last sent to the modem, protected by txMutex. */
+    volatile bool rxFlowStopped;
+    bool rxFlowSignalled;
+    CommRing_t rxRing;
+    uint8_t rxRingBuffer[ CELLULAR_CMUX_CHANNEL_RX_RING_SIZE ];
+} _cellularCmuxChannel_t;
+
+/**
+ * @brief Multiplexer context.
+ */
+typedef struct _cellularCmuxContext
+{
+    CellularCommInterface_t * pPhysicalCommInterface;
+    CellularCommInterfaceHandle_t physicalHandle;
+    PlatformMutex_t txMutex;
+    bool started;
+    volatile bool muxMode;
+    volatile uint8_t dlciState[ CELLULAR_CMUX_MAX_CHANNELS + 1U ];
+
+    /* AT+CMUX response. */
+    char atResponse[ CMUX_AT_RESPONSE_BUFFER_SIZE ];
+    uint32_t atResponseLength;
+    volatile bool atOkReceived;
+    volatile bool atErrorReceived;
+
+    /* Demultiplexer, only used in the physical receive callback. */
+    CmuxParseState_t parseState;
+    uint8_t frameHeader[ 4 ];
+    uint32_t frameHeaderLength;
+    uint32_t frameLength;
+    uint32_t frameReceived;
+    uint8_t frameBuffer[ CELLULAR_CMUX_FRAME_SIZE ];
+    uint8_t readBuffer[ CMUX_RX_READ_SIZE ];
+    uint32_t frameErrorCount;
+
+    /* Responses from the demultiplexer to the senders. */
+    CommRing_t responseRing;
+    uint8_t responseRingBuffer[ CMUX_RESPONSE_RING_SIZE ];
+
+    /* Transmit frame, protected by txMutex. */
+    uint8_t txFrameBuffer[ CELLULAR_CMUX_FRAME_SIZE + CMUX_FRAME_OVERHEAD ];
+
+    _cellularCmuxChannel_t channels[ CELLULAR_CMUX_MAX_CHANNELS ];
+} _cellularCmuxContext_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Open a virtual channel. Shared by the open functions of all channels.
+ *
+ * @param[in] dlci DLCI of the channel.
+ * @param[in] receiveCallback Receive callback of the channel.
+ * @param[in] pUserData User data passed to receiveCallback.
+ * @param[out] pCommInterfaceHandle Handle of the opened channel.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _prvCmuxChannelOpen( uint8_t dlci,
+                                                         CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                         void * pUserData,
+                                                         CellularCommInterfaceHandle_t * pCommInterfaceHandle );
+
+/**
+ * @brief CellularCommInterfaceSend_t implementation of a virtual channel.
+ */
+static CellularCommInterfaceError_t _prvCmuxChannelSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                         const uint8_t * pData,
+                                                         uint32_t dataLength,
+                                                         uint32_t timeoutMilliseconds,
+                                                         uint32_t * pDataSentLength );
+
+/**
+ * @brief CellularCommInterfaceRecv_t implementation of a virtual channel.
+ */
+static CellularCommInterfaceError_t _prvCmuxChannelReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                            uint8_t * pBuffer,
+                                                            uint32_t bufferLength,
+                                                            uint32_t timeoutMilliseconds,
+                                                            uint32_t * pDataReceivedLength );
+
+/**
+ * @brief CellularCommInterfaceClose_t implementation of a virtual channel.
+ */
+static CellularCommInterfaceError_t _prvCmuxChannelClose( CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Receive callback of the physical comm interface.
+ *
+ * Reads the physical comm interface until it is empty, demultiplexes the
+ * frames and calls the receive callback of the channels that received data.
+ *
+ * @param[in] pUserData Pointer to the multiplexer context.
+ * @param[in] commInterfaceHandle Handle of the physical comm interface.
+ *
+ * @return Always IOT_COMM_INTERFACE_SUCCESS.
+ */
+static CellularCommInterfaceError_t _cmuxReceiveCallback( void * pUserData,
+                                                          CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Look for the final result code of AT+CMUX.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ * @param[in] pData Bytes read from the physical comm interface.
+ * @param[in] dataLength Number of bytes in pData.
+ */
+static void _cmuxParseAtResponse( _cellularCmuxContext_t * pCmuxContext,
+                                  const uint8_t * pData,
+                                  uint32_t dataLength );
+
+/**
+ * @brief Feed bytes read from the physical comm interface to the frame receiver.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ * @param[in] pData Bytes read from the physical comm interface.
+ * @param[in] dataLength Number of bytes in pData.
+ */
+static void _cmuxParseFrames( _cellularCmuxContext_t * pCmuxContext,
+                              const uint8_t * pData,
+                              uint32_t dataLength );
+
+/**
+ * @brief Handle a received frame with a valid FCS.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ */
+static void _cmuxHandleFrame( _cellularCmuxContext_t * pCmuxContext );
+
+/**
+ * @brief Handle a message received on the multiplexer control channel.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ * @param[in] pInfo Information field of the UIH frame.
+ * @param[in] infoLength Length of the information field.
+ */
+static void _cmuxHandleControlMessage( _cellularCmuxContext_t * pCmuxContext,
+                                       const uint8_t * pInfo,
+                                       uint32_t infoLength );
+
+/**
+ * @brief Queue a response to a modem command. Sent by the next send or recv.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ * @param[in] type CMUX_FRAME_UA or CMUX_MSG_MSC.
+ * @param[in] dlci DLCI the response refers to.
+ * @param[in] value V.24 signals of an MSC response.
+ */
+static void _cmuxQueueResponse( _cellularCmuxContext_t * pCmuxContext,
+                                uint8_t type,
+                                uint8_t dlci,
+                                uint8_t value );
+
+/**
+ * @brief Send the responses queued by the demultiplexer and an MSC for every
+ * channel whose receive flow control changed. txMutex must be held.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ */
+static void _cmuxFlushResponses( _cellularCmuxContext_t * pCmuxContext );
+
+/**
+ * @brief Check for responses or flow control changes not sent yet.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ *
+ * @return true if _cmuxFlushResponses has something to send.
+ */
+static bool _cmuxFlushPending( const _cellularCmuxContext_t * pCmuxContext );
+
+/**
+ * @brief Calculate the FCS of the address, control and length fields.
+ *
+ * @param[in] pData Start of the address field.
+ * @param[in] length Number of octets covered by the FCS.
+ *
+ * @return The FCS.
+ */
+static uint8_t _cmuxFcs( const uint8_t * pData,
+                         uint32_t length );
+
+/**
+ * @brief Build a frame and send it on the physical comm interface. txMutex must be held.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ * @param[in] dlci DLCI of the frame.
+ * @param[in] control Control field.
+ * @param[in] command true for a command frame, false for a response frame.
+ * @param[in] pInfo Information field. May be NULL if infoLength is 0.
+ * @param[in] infoLength Length of the information field, up to CELLULAR_CMUX_FRAME_SIZE.
+ * @param[in] timeoutMilliseconds Send timeout of the physical comm interface.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _cmuxSendFrame( _cellularCmuxContext_t * pCmuxContext,
+                                                    uint8_t dlci,
+                                                    uint8_t control,
+                                                    bool command,
+                                                    const uint8_t * pInfo,
+                                                    uint32_t infoLength,
+                                                    uint32_t timeoutMilliseconds );
+
+/**
+ * @brief Send a message on the multiplexer control channel. txMutex must be held.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ * @param[in] type Message type, including the C/R bit.
+ * @param[in] pValue Message value octets.
+ * @param[in] valueLength Number of value octets, up to 2.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _cmuxSendControlMessage( _cellularCmuxContext_t * pCmuxContext,
+                                                             uint8_t type,
+                                                             const uint8_t * pValue,
+                                                             uint32_t valueLength );
+
+/**
+ * @brief Wait for a DLCI to reach a state.
+ *
+ * Queued responses are sent while waiting.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ * @param[in] dlci The DLCI.
+ * @param[in] state CMUX_DLCI_OPEN or CMUX_DLCI_CLOSED.
+ *
+ * @return IOT_COMM_INTERFACE_SUCCESS if the state is reached, IOT_COMM_INTERFACE_FAILURE
+ * if the modem rejected the DLCI and IOT_COMM_INTERFACE_TIMEOUT if the modem did not respond.
+ */
+static CellularCommInterfaceError_t _cmuxWaitDlciState( _cellularCmuxContext_t * pCmuxContext,
+                                                        uint8_t dlci,
+                                                        uint8_t state );
+
+/**
+ * @brief Send DISC on an open DLCI and wait for the modem to release it.
+ *
+ * @param[in] pCmuxContext Multiplexer context.
+ * @param[in] dlci The DLCI.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _cmuxCloseDlci( _cellularCmuxContext_t * pCmuxContext,
+                                                    uint8_t dlci );
+
+/*-----------------------------------------------------------*/
+
+/* Open function of every channel. */
+#define CMUX_DEFINE_CHANNEL_OPEN( dlci )                                                                                      \
+    static CellularCommInterfaceError_t _prvCmuxChannelOpen ## dlci( CellularCommInterfaceReceiveCallback_t receiveCallback, \
+                                                                     void * pUserData,                                    \
+                                                                     CellularCommInterfaceHandle_t * pCommInterfaceHandle ) \
+    {                                                                                                                         \
+        return _prvCmuxChannelOpen( dlci ## U, receiveCallback, pUserData, pCommInterfaceHandle );                            \
+    }
+
+CMUX_DEFINE_CHANNEL_OPEN( 1 )
+CMUX_DEFINE_CHANNEL_OPEN( 2 )
+CMUX_DEFINE_CHANNEL_OPEN( 3 )
+CMUX_DEFINE_CHANNEL_OPEN( 4 )
+
+static const CellularCommInterfaceOpen_t _cmuxChannelOpenFunctions[ CMUX_CHANNEL_LIMIT ] =
+{
+    _prvCmuxChannelOpen1, _prvCmuxChannelOpen2, _prvCmuxChannelOpen3, _prvCmuxChannelOpen4
+};
+
+static _cellularCmuxContext_t _cellularCmuxContext = { 0 };
+
+static CellularCommInterface_t _cellularCmuxChannelInterfaces[ CELLULAR_CMUX_MAX_CHANNELS ] = { 0 };
+
+/*-----------------------------------------------------------*/
+
+static uint8_t _cmuxFcs( const uint8_t * pData,
+                         uint32_t length )
+{
+    uint8_t fcs = CMUX_FCS_INIT;
+    uint32_t index = 0;
+    uint32_t bit = 0;
+
+    for( index = 0; index < length; index++ )
+    {
+        fcs = fcs ^ pData[ index ];
+
+        for( bit = 0; bit < 8U; bit++ )
+        {
+            fcs = ( ( fcs & 0x01U ) != 0U ) ? ( uint8_t ) ( ( fcs >> 1 ) ^ CMUX_FCS_POLYNOMIAL ) : ( uint8_t ) ( fcs >> 1 );
+        }
+    }
+
+    return ( uint8_t ) ( 0xFFU - fcs );
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _cmuxSendFrame( _cellularCmuxContext_t * pCmuxContext,
+                                                    uint8_t dlci,
+                                                    uint8_t control,
+                                                    bool command,
+                                                    const uint8_t * pInfo,
+                                                    uint32_t infoLength,
+                                                    uint32_t timeoutMilliseconds )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    uint8_t * pFrame = pCmuxContext->txFrameBuffer;
+    uint32_t headerLength = 3U;
+    uint32_t frameLength = 0;
+    uint32_t sentLength = 0;
+
+    pFrame[ 0 ] = CMUX_FLAG;
+    pFrame[ 1 ] = ( uint8_t ) ( ( uint32_t ) dlci << 2 ) | ( ( command == true ) ? CMUX_CR : 0U ) | CMUX_EA;
+    pFrame[ 2 ] = control;
+
+    if( infoLength <= CMUX_SHORT_LENGTH_MAX )
+    {
+        pFrame[ 3 ] = ( uint8_t ) ( ( infoLength << 1 ) | CMUX_EA );
+    }
+    else
+    {
+        pFrame[ 3 ] = ( uint8_t ) ( ( infoLength << 1 ) & 0xFEU );
+        pFrame[ 4 ] = ( uint8_t ) ( infoLength >> 7 );
+        headerLength = 4U;
+    }
+
+    if( infoLength > 0U )
+    {
+        ( void ) memcpy( &pFrame[ 1U + headerLength ], pInfo, infoLength );
+    }
+
+    frameLength = 1U + headerLength + infoLength;
+    pFrame[ frameLength ] = _cmuxFcs( &pFrame[ 1 ], headerLength );
+    pFrame[ frameLength + 1U ] = CMUX_FLAG;
+    frameLength = frameLength + 2U;
+
+    commIntRet = pCmuxContext->pPhysicalCommInterface->send( pCmuxContext->physicalHandle, pFrame, frameLength,
+                                                             timeoutMilliseconds, &sentLength );
+
+    if( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( sentLength != frameLength ) )
+    {
+        CellularLogError( "Cellular CMUX DLCI %u frame sent %u of %u bytes", dlci, sentLength, frameLength );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _cmuxSendControlMessage( _cellularCmuxContext_t * pCmuxContext,
+                                                             uint8_t type,
+                                                             const uint8_t * pValue,
+                                                             uint32_t valueLength )
+{
+    uint8_t message[ 4 ] = { 0 };
+
+    message[ 0 ] = type;
+    message[ 1 ] = ( uint8_t ) ( ( valueLength << 1 ) | CMUX_EA );
+
+    if( valueLength > 0U )
+    {
+        ( void ) memcpy( &message[ 2 ], pValue, valueLength );
+    }
+
+    return _cmuxSendFrame( pCmuxContext, 0U, CMUX_FRAME_UIH, true, message, 2U + valueLength, CMUX_SEND_TIMEOUT_MS );
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cmuxQueueResponse( _cellularCmuxContext_t * pCmuxContext,
+                                uint8_t type,
+                                uint8_t dlci,
+                                uint8_t value )
+{
+    uint8_t * pRecord = NULL;
+
+    if( CommRing_GetWriteSpan( &pCmuxContext->responseRing, &pRecord ) >= CMUX_RESPONSE_RECORD_SIZE )
+    {
+        pRecord[ 0 ] = type;
+        pRecord[ 1 ] = dlci;
+        pRecord[ 2 ] = value;
+        pRecord[ 3 ] = 0U;
+        CommRing_Commit( &pCmuxContext->responseRing, CMUX_RESPONSE_RECORD_SIZE );
+    }
+    else
+    {
+        CellularLogWarn( "Cellular CMUX response to DLCI %u dropped", dlci );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cmuxFlushResponses( _cellularCmuxContext_t * pCmuxContext )
+{
+    _cellularCmuxChannel_t * pChannel = NULL;
+    uint8_t * pRecord = NULL;
+    uint8_t value[ 2 ] = { 0 };
+    uint32_t index = 0;
+    bool rxFlowStopped = false;
+
+    while( CommRing_GetReadSpan( &pCmuxContext->responseRing, &pRecord ) >= CMUX_RESPONSE_RECORD_SIZE )
+    {
+        if( pRecord[ 0 ] == CMUX_FRAME_UA )
+        {
+            ( void ) _cmuxSendFrame( pCmuxContext, pRecord[ 1 ], CMUX_FRAME_UA | CMUX_CONTROL_PF, false,
+                                     NULL, 0U, CMUX_SEND_TIMEOUT_MS );
+        }
+        else
+        {
+            value[ 0 ] = ( uint8_t ) ( ( uint32_t ) pRecord[ 1 ] << 2 ) | CMUX_CR | CMUX_EA;
+            value[ 1 ] = pRecord[ 2 ];
+            ( void ) _cmuxSendControlMessage( pCmuxContext, CMUX_MSG_MSC, value, 2U );
+        }
+
+        CommRing_Release( &pCmuxContext->responseRing, CMUX_RESPONSE_RECORD_SIZE );
+    }
+
+    for( index = 0; index < CELLULAR_CMUX_MAX_CHANNELS; index++ )
+    {
+        pChannel = &pCmuxContext->channels[ index ];
+        rxFlowStopped = pChannel->rxFlowStopped;
+
+        if( ( pCmuxContext->dlciState[ index + 1U ] == CMUX_DLCI_OPEN ) && ( rxFlowStopped != pChannel->rxFlowSignalled ) )
+        {
+            value[ 0 ] = ( uint8_t ) ( ( index + 1U ) << 2 ) | CMUX_CR | CMUX_EA;
+            value[ 1 ] = ( rxFlowStopped == true ) ? ( CMUX_MSC_SIGNALS | CMUX_MSC_FC ) : CMUX_MSC_SIGNALS;
+
+            if( _cmuxSendControlMessage( pCmuxContext, CMUX_MSG_MSC | CMUX_CR, value, 2U ) == IOT_COMM_INTERFACE_SUCCESS )
+            {
+                pChannel->rxFlowSignalled = rxFlowStopped;
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _cmuxFlushPending( const _cellularCmuxContext_t * pCmuxContext )
+{
+    const _cellularCmuxChannel_t * pChannel = NULL;
+    uint32_t index = 0;
+    bool flushPending = ( CommRing_Used( &pCmuxContext->responseRing ) > 0U );
+
+    for( index = 0; ( index < CELLULAR_CMUX_MAX_CHANNELS ) && ( flushPending == false ); index++ )
+    {
+        pChannel = &pCmuxContext->channels[ index ];
+        flushPending = ( ( pCmuxContext->dlciState[ index + 1U ] == CMUX_DLCI_OPEN ) &&
+                         ( pChannel->rxFlowStopped != pChannel->rxFlowSignalled ) );
+    }
+
+    return flushPending;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _cmuxWaitDlciState( _cellularCmuxContext_t * pCmuxContext,
+                                                        uint8_t dlci,
+                                                        uint8_t state )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_TIMEOUT;
+    uint32_t waitTime = 0;
+    uint8_t dlciState = CMUX_DLCI_CLOSED;
+
+    while( ( commIntRet == IOT_COMM_INTERFACE_TIMEOUT ) && ( waitTime < CMUX_RESPONSE_TIMEOUT_MS ) )
+    {
+        Platform_Delay( CMUX_RESPONSE_POLL_MS );
+        waitTime = waitTime + CMUX_RESPONSE_POLL_MS;
+
+        PlatformMutex_Lock( &pCmuxContext->txMutex );
+        _cmuxFlushResponses( pCmuxContext );
+        PlatformMutex_Unlock( &pCmuxContext->txMutex );
+
+        dlciState = pCmuxContext->dlciState[ dlci ];
+
+        if( dlciState == state )
+        {
+            commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+        }
+        else if( dlciState == CMUX_DLCI_REJECTED )
+        {
+            CellularLogError( "Cellular CMUX DLCI %u rejected by the modem", dlci );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_TIMEOUT )
+    {
+        CellularLogError( "Cellular CMUX DLCI %u no response from the modem", dlci );
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _cmuxCloseDlci( _cellularCmuxContext_t * pCmuxContext,
+                                                    uint8_t dlci )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+
+    /* The modem may have released the DLCI already. */
+    if( pCmuxContext->dlciState[ dlci ] == CMUX_DLCI_OPEN )
+    {
+        pCmuxContext->dlciState[ dlci ] = CMUX_DLCI_CLOSING;
+
+        PlatformMutex_Lock( &pCmuxContext->txMutex );
+        commIntRet = _cmuxSendFrame( pCmuxContext, dlci, CMUX_FRAME_DISC | CMUX_CONTROL_PF, true,
+                                     NULL, 0U, CMUX_SEND_TIMEOUT_MS );
+        PlatformMutex_Unlock( &pCmuxContext->txMutex );
+
+        if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+        {
+            commIntRet = _cmuxWaitDlciState( pCmuxContext, dlci, CMUX_DLCI_CLOSED );
+        }
+    }
+
+    pCmuxContext->dlciState[ dlci ] = CMUX_DLCI_CLOSED;
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cmuxHandleControlMessage( _cellularCmuxContext_t * pCmuxContext,
+                                       const uint8_t * pInfo,
+                                       uint32_t infoLength )
+{
+    uint8_t type = 0;
+    uint8_t dlci = 0;
+
+    if( infoLength >= 2U )
+    {
+        type = pInfo[ 0 ];
+
+        if( ( ( type & ( uint8_t ) ~CMUX_CR ) == CMUX_MSG_MSC ) && ( infoLength >= 4U ) )
+        {
+            dlci = pInfo[ 2 ] >> 2;
+
+            /* Only modem commands are answered. A response to our MSC needs no action. */
+            if( ( type & CMUX_CR ) != 0U )
+            {
+                if( ( dlci >= 1U ) && ( dlci <= CELLULAR_CMUX_MAX_CHANNELS ) )
+                {
+                    pCmuxContext->channels[ dlci - 1U ].flowStopped = ( ( pInfo[ 3 ] & CMUX_MSC_FC ) != 0U );
+                }
+
+                _cmuxQueueResponse( pCmuxContext, CMUX_MSG_MSC, dlci, pInfo[ 3 ] );
+            }
+        }
+        else if( ( type & ( uint8_t ) ~CMUX_CR ) == CMUX_MSG_CLD )
+        {
+            /* The modem leaves multiplexer mode. */
+            pCmuxContext->dlciState[ 0 ] = CMUX_DLCI_CLOSED;
+        }
+        else
+        {
+            CellularLogDebug( "Cellular CMUX control message 0x%02x ignored", type );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cmuxHandleFrame( _cellularCmuxContext_t * pCmuxContext )
+{
+    uint8_t dlci = pCmuxContext->frameHeader[ 0 ] >> 2;
+    uint8_t frameType = pCmuxContext->frameHeader[ 1 ] & ( uint8_t ) ~CMUX_CONTROL_PF;
+    _cellularCmuxChannel_t * pChannel = NULL;
+    uint8_t * pWrite = NULL;
+    uint32_t writtenLength = 0;
+    uint32_t spanLength = 0;
+
+    if( dlci > CELLULAR_CMUX_MAX_CHANNELS )
+    {
+        CellularLogDebug( "Cellular CMUX frame on DLCI %u ignored", dlci );
+    }
+    else if( frameType == CMUX_FRAME_UA )
+    {
+        if( pCmuxContext->dlciState[ dlci ] == CMUX_DLCI_OPENING )
+        {
+            pCmuxContext->dlciState[ dlci ] = CMUX_DLCI_OPEN;
+        }
+        else if( pCmuxContext->dlciState[ dlci ] == CMUX_DLCI_CLOSING )
+        {
+            pCmuxContext->dlciState[ dlci ] = CMUX_DLCI_CLOSED;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+    }
+    else if( frameType == CMUX_FRAME_DM )
+    {
+        pCmuxContext->dlciState[ dlci ] = ( pCmuxContext->dlciState[ dlci ] == CMUX_DLCI_OPENING ) ?
+                                          CMUX_DLCI_REJECTED : CMUX_DLCI_CLOSED;
+    }
+    else if( frameType == CMUX_FRAME_DISC )
+    {
+        pCmuxContext->dlciState[ dlci ] = CMUX_DLCI_CLOSED;
+        _cmuxQueueResponse( pCmuxContext, CMUX_FRAME_UA, dlci, 0U );
+    }
+    else if( frameType != CMUX_FRAME_UIH )
+    {
+        CellularLogDebug( "Cellular CMUX frame type 0x%02x ignored", frameType );
+    }
+    else if( dlci == 0U )
+    {
+        _cmuxHandleControlMessage( pCmuxContext, pCmuxContext->frameBuffer, pCmuxContext->frameLength );
+    }
+    else if( pCmuxContext->dlciState[ dlci ] == CMUX_DLCI_OPEN )
+    {
+        pChannel = &pCmuxContext->channels[ dlci - 1U ];
+
+        /* The demultiplexer is the single producer of the channel ring. */
+        while( writtenLength < pCmuxContext->frameLength )
+        {
+            spanLength = CommRing_GetWriteSpan( &pChannel->rxRing, &pWrite );
+
+            if( spanLength == 0U )
+            {
+                /* The modem sent on past the FC = 1 of the high water mark. Other
+                 * channels must not wait for this one, so the rest of the frame is dropped. */
+                pChannel->rxRing.overrunCount++;
+                CellularLogWarn( "Cellular CMUX DLCI %u receive ring full, %u bytes dropped",
+                                 dlci, pCmuxContext->frameLength - writtenLength );
+                break;
+            }
+
+            if( spanLength > ( pCmuxContext->frameLength - writtenLength ) )
+            {
+                spanLength = pCmuxContext->frameLength - writtenLength;
+            }
+
+            ( void ) memcpy( pWrite, &pCmuxContext->frameBuffer[ writtenLength ], spanLength );
+            CommRing_Commit( &pChannel->rxRing, spanLength );
+            writtenLength = writtenLength + spanLength;
+        }
+
+        /* Ask the modem to hold the channel. The demultiplexer can not send, the
+         * MSC is sent by the next send or recv on any channel. */
+        if( CommRing_Used( &pChannel->rxRing ) >= CELLULAR_CMUX_CHANNEL_RX_HIGH_WATER )
+        {
+            pChannel->rxFlowStopped = true;
+        }
+
+        pChannel->rxPending = true;
+    }
+    else
+    {
+        CellularLogDebug( "Cellular CMUX data on closed DLCI %u dropped", dlci );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cmuxParseFrames( _cellularCmuxContext_t * pCmuxContext,
+                              const uint8_t * pData,
+                              uint32_t dataLength )
+{
+    uint32_t index = 0;
+    uint32_t copyLength = 0;
+    uint8_t octet = 0;
+
+    while( index < dataLength )
+    {
+        octet = pData[ index ];
+
+        switch( pCmuxContext->parseState )
+        {
+            case CMUX_PARSE_FLAG:
+
+                if( octet == CMUX_FLAG )
+                {
+                    pCmuxContext->parseState = CMUX_PARSE_ADDRESS;
+                }
+
+                index++;
+                break;
+
+            case CMUX_PARSE_ADDRESS:
+
+                if( octet != CMUX_FLAG )
+                {
+                    pCmuxContext->frameHeader[ 0 ] = octet;
+                    pCmuxContext->frameHeaderLength = 1U;
+                    pCmuxContext->parseState = CMUX_PARSE_CONTROL;
+                }
+
+                index++;
+                break;
+
+            case CMUX_PARSE_CONTROL:
+                pCmuxContext->frameHeader[ 1 ] = octet;
+                pCmuxContext->frameHeaderLength = 2U;
+                pCmuxContext->parseState = CMUX_PARSE_LENGTH;
+                index++;
+                break;
+
+            case CMUX_PARSE_LENGTH:
+                pCmuxContext->frameHeader[ 2 ] = octet;
+                pCmuxContext->frameHeaderLength = 3U;
+                pCmuxContext->frameLength = ( uint32_t ) octet >> 1;
+                pCmuxContext->frameReceived = 0U;
+                pCmuxContext->parseState = ( ( octet & CMUX_EA ) != 0U ) ? CMUX_PARSE_DATA : CMUX_PARSE_LENGTH_HIGH;
+                index++;
+                break;
+
+            case CMUX_PARSE_LENGTH_HIGH:
+                pCmuxContext->frameHeader[ 3 ] = octet;
+                pCmuxContext->frameHeaderLength = 4U;
+                pCmuxContext->frameLength = pCmuxContext->frameLength | ( ( uint32_t ) octet << 7 );
+                pCmuxContext->parseState = CMUX_PARSE_DATA;
+                index++;
+                break;
+
+            case CMUX_PARSE_DATA:
+
+                if( pCmuxContext->frameLength > CELLULAR_CMUX_FRAME_SIZE )
+                {
+                    /* Resynchronize on the next flag. */
+                    pCmuxContext->frameErrorCount++;
+                    pCmuxContext->parseState = CMUX_PARSE_FLAG;
+                }
+                else if( pCmuxContext->frameReceived == pCmuxContext->frameLength )
+                {
+                    pCmuxContext->parseState = CMUX_PARSE_FCS;
+                }
+                else
+                {
+                    copyLength = pCmuxContext->frameLength - pCmuxContext->frameReceived;
+
+                    if( copyLength > ( dataLength - index ) )
+                    {
+                        copyLength = dataLength - index;
+                    }
+
+                    ( void ) memcpy( &pCmuxContext->frameBuffer[ pCmuxContext->frameReceived ], &pData[ index ], copyLength );
+                    pCmuxContext->frameReceived = pCmuxContext->frameReceived + copyLength;
+                    index = index + copyLength;
+                }
+
+                break;
+
+            case CMUX_PARSE_FCS:
+
+                /* UIH frames exclude the information field from the FCS. Other frames carry none. */
+                if( octet == _cmuxFcs( pCmuxContext->frameHeader, pCmuxContext->frameHeaderLength ) )
+                {
+                    pCmuxContext->parseState = CMUX_PARSE_END;
+                }
+                else
+                {
+                    pCmuxContext->frameErrorCount++;
+                    pCmuxContext->parseState = CMUX_PARSE_FLAG;
+                }
+
+                index++;
+                break;
+
+            case CMUX_PARSE_END:
+            default:
+
+                if( octet == CMUX_FLAG )
+                {
+                    _cmuxHandleFrame( pCmuxContext );
+
+                    /* The closing flag may also open the next frame. */
+                    pCmuxContext->parseState = CMUX_PARSE_ADDRESS;
+                }
+                else
+                {
+                    pCmuxContext->frameErrorCount++;
+                    pCmuxContext->parseState = CMUX_PARSE_FLAG;
+                }
+
+                index++;
+                break;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cmuxParseAtResponse( _cellularCmuxContext_t * pCmuxContext,
+                                  const uint8_t * pData,
+                                  uint32_t dataLength )
+{
+    uint32_t index = 0;
+
+    for( index = 0; index < dataLength; index++ )
+    {
+        /* Keep the tail of a long echo, it may hold a partial response. */
+        if( pCmuxContext->atResponseLength == ( sizeof( pCmuxContext->atResponse ) - 1U ) )
+        {
+            ( void ) memmove( pCmuxContext->atResponse, &pCmuxContext->atResponse[ pCmuxContext->atResponseLength - 4U ], 4U );
+            pCmuxContext->atResponseLength = 4U;
+        }
+
+        pCmuxContext->atResponse[ pCmuxContext->atResponseLength ] = ( char ) pData[ index ];
+        pCmuxContext->atResponseLength++;
+    }
+
+    pCmuxContext->atResponse[ pCmuxContext->atResponseLength ] = '\0';
+
+    if( strstr( pCmuxContext->atResponse, "OK\r\n" ) != NULL )
+    {
+        pCmuxContext->atOkReceived = true;
+    }
+    else if( strstr( pCmuxContext->atResponse, "ERROR" ) != NULL )
+    {
+        pCmuxContext->atErrorReceived = true;
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _cmuxReceiveCallback( void * pUserData,
+                                                          CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    _cellularCmuxContext_t * pCmuxContext = ( _cellularCmuxContext_t * ) pUserData;
+    _cellularCmuxChannel_t * pChannel = NULL;
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    uint32_t readLength = 0;
+    uint32_t index = 0;
+
+    do
+    {
+        readLength = 0;
+        commIntRet = pCmuxContext->pPhysicalCommInterface->recv( commInterfaceHandle, pCmuxContext->readBuffer,
+                                                                 CMUX_RX_READ_SIZE, 0U, &readLength );
+
+        if( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( readLength > 0U ) )
+        {
+            if( pCmuxContext->muxMode == true )
+            {
+                _cmuxParseFrames( pCmuxContext, pCmuxContext->readBuffer, readLength );
+            }
+            else
+            {
+                _cmuxParseAtResponse( pCmuxContext, pCmuxContext->readBuffer, readLength );
+            }
+        }
+    } while( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( readLength > 0U ) );
+
+    /* Notify each channel once for the data demultiplexed in this call. */
+    for( index = 0; index < CELLULAR_CMUX_MAX_CHANNELS; index++ )
+    {
+        pChannel = &pCmuxContext->channels[ index ];
+
+        if( pChannel->rxPending == true )
+        {
+            pChannel->rxPending = false;
+
+            if( pChannel->receiveCallback != NULL )
+            {
+                ( void ) pChannel->receiveCallback( pChannel->pUserData, ( CellularCommInterfaceHandle_t ) pChannel );
+            }
+        }
+    }
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCmuxChannelOpen( uint8_t dlci,
+                                                         CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                         void * pUserData,
+                                                         CellularCommInterfaceHandle_t * pCommInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCmuxContext_t * pCmuxContext = &_cellularCmuxContext;
+    _cellularCmuxChannel_t * pChannel = &pCmuxContext->channels[ dlci - 1U ];
+    uint8_t mscValue[ 2 ] = { 0 };
+    bool dlciRequested = false;
+
+    if( pCommInterfaceHandle == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pCmuxContext->started == false )
+    {
+        CellularLogError( "Cellular CMUX is not started" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( pCmuxContext->dlciState[ dlci ] != CMUX_DLCI_CLOSED )
+    {
+        CellularLogError( "Cellular CMUX DLCI %u opened already", dlci );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        CommRing_Init( &pChannel->rxRing, pChannel->rxRingBuffer, CELLULAR_CMUX_CHANNEL_RX_RING_SIZE );
+        pChannel->dlci = dlci;
+        pChannel->rxPending = false;
+        pChannel->flowStopped = false;
+        pChannel->rxFlowStopped = false;
+        pChannel->rxFlowSignalled = false;
+        pChannel->pUserData = pUserData;
+        pChannel->receiveCallback = receiveCallback;
+
+        pCmuxContext->dlciState[ dlci ] = CMUX_DLCI_OPENING;
+        dlciRequested = true;
+
+        PlatformMutex_Lock( &pCmuxContext->txMutex );
+        commIntRet = _cmuxSendFrame( pCmuxContext, dlci, CMUX_FRAME_SABM | CMUX_CONTROL_PF, true,
+                                     NULL, 0U, CMUX_SEND_TIMEOUT_MS );
+        PlatformMutex_Unlock( &pCmuxContext->txMutex );
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        commIntRet = _cmuxWaitDlciState( pCmuxContext, dlci, CMUX_DLCI_OPEN );
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        /* Tell the modem the channel is ready to receive. */
+        mscValue[ 0 ] = ( uint8_t ) ( ( uint32_t ) dlci << 2 ) | CMUX_CR | CMUX_EA;
+        mscValue[ 1 ] = CMUX_MSC_SIGNALS;
+
+        PlatformMutex_Lock( &pCmuxContext->txMutex );
+        ( void ) _cmuxSendControlMessage( pCmuxContext, CMUX_MSG_MSC | CMUX_CR, mscValue, 2U );
+        PlatformMutex_Unlock( &pCmuxContext->txMutex );
+
+        *pCommInterfaceHandle = ( CellularCommInterfaceHandle_t ) pChannel;
+    }
+    else if( dlciRequested == true )
+    {
+        pChannel->receiveCallback = NULL;
+        pCmuxContext->dlciState[ dlci ] = CMUX_DLCI_CLOSED;
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCmuxChannelSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                         const uint8_t * pData,
+                                                         uint32_t dataLength,
+                                                         uint32_t timeoutMilliseconds,
+                                                         uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCmuxContext_t * pCmuxContext = &_cellularCmuxContext;
+    _cellularCmuxChannel_t * pChannel = ( _cellularCmuxChannel_t * ) commInterfaceHandle;
+    uint32_t sentLength = 0;
+    uint32_t frameLength = 0;
+    uint32_t waitTime = 0;
+
+    if( ( pChannel == NULL ) || ( pData == NULL ) || ( pDataSentLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pCmuxContext->dlciState[ pChannel->dlci ] != CMUX_DLCI_OPEN )
+    {
+        CellularLogError( "Cellular CMUX send DLCI %u is not opened", pChannel->dlci );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        PlatformMutex_Lock( &pCmuxContext->txMutex );
+
+        while( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( sentLength < dataLength ) )
+        {
+            /* Flow control and responses go out between the frames of a long send. */
+            _cmuxFlushResponses( pCmuxContext );
+
+            if( pChannel->flowStopped == false )
+            {
+                frameLength = dataLength - sentLength;
+
+                if( frameLength > CELLULAR_CMUX_FRAME_SIZE )
+                {
+                    frameLength = CELLULAR_CMUX_FRAME_SIZE;
+                }
+
+                commIntRet = _cmuxSendFrame( pCmuxContext, pChannel->dlci, CMUX_FRAME_UIH, true,
+                                             &pData[ sentLength ], frameLength, timeoutMilliseconds );
+
+                if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+                {
+                    sentLength = sentLength + frameLength;
+                }
+            }
+            else if( waitTime < timeoutMilliseconds )
+            {
+                /* The modem asked to hold the data of this channel. Let other channels send meanwhile. */
+                PlatformMutex_Unlock( &pCmuxContext->txMutex );
+                Platform_Delay( CMUX_RESPONSE_POLL_MS );
+                waitTime = waitTime + CMUX_RESPONSE_POLL_MS;
+                PlatformMutex_Lock( &pCmuxContext->txMutex );
+            }
+            else
+            {
+                CellularLogError( "Cellular CMUX send DLCI %u flow stopped timeout", pChannel->dlci );
+                commIntRet = IOT_COMM_INTERFACE_TIMEOUT;
+            }
+        }
+
+        PlatformMutex_Unlock( &pCmuxContext->txMutex );
+        *pDataSentLength = sentLength;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCmuxChannelReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                            uint8_t * pBuffer,
+                                                            uint32_t bufferLength,
+                                                            uint32_t timeoutMilliseconds,
+                                                            uint32_t * pDataReceivedLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCmuxContext_t * pCmuxContext = &_cellularCmuxContext;
+    _cellularCmuxChannel_t * pChannel = ( _cellularCmuxChannel_t * ) commInterfaceHandle;
+
+    /* The demultiplexer has already put the data in the ring. Same as the
+     * physical comm interface, return immediately with the bytes received. */
+    ( void ) timeoutMilliseconds;
+
+    if( ( pChannel == NULL ) || ( pBuffer == NULL ) || ( pDataReceivedLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pCmuxContext->dlciState[ pChannel->dlci ] == CMUX_DLCI_CLOSED )
+    {
+        CellularLogError( "Cellular CMUX read DLCI %u is not opened", pChannel->dlci );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        *pDataReceivedLength = CommRing_Read( &pChannel->rxRing, pBuffer, bufferLength );
+
+        if( ( pChannel->rxFlowStopped == true ) &&
+            ( CommRing_Used( &pChannel->rxRing ) <= CELLULAR_CMUX_CHANNEL_RX_LOW_WATER ) )
+        {
+            pChannel->rxFlowStopped = false;
+        }
+
+        /* Send what the demultiplexer left pending, the FC = 1 of a channel
+         * at its high water mark included. */
+        if( _cmuxFlushPending( pCmuxContext ) == true )
+        {
+            PlatformMutex_Lock( &pCmuxContext->txMutex );
+            _cmuxFlushResponses( pCmuxContext );
+            PlatformMutex_Unlock( &pCmuxContext->txMutex );
+        }
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCmuxChannelClose( CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCmuxChannel_t * pChannel = ( _cellularCmuxChannel_t * ) commInterfaceHandle;
+
+    if( pChannel == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( _cellularCmuxContext.dlciState[ pChannel->dlci ] == CMUX_DLCI_CLOSED )
+    {
+        CellularLogError( "Cellular CMUX close DLCI %u is not opened", pChannel->dlci );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        pChannel->receiveCallback = NULL;
+        commIntRet = _cmuxCloseDlci( &_cellularCmuxContext, pChannel->dlci );
+
+        CellularLogInfo( "Cellular CMUX DLCI %u RX ring peak fill %u of %u bytes, overrun %u",
+                         pChannel->dlci, pChannel->rxRing.peakFill, CELLULAR_CMUX_CHANNEL_RX_RING_SIZE,
+                         pChannel->rxRing.overrunCount );
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterfaceError_t CellularCmux_Start( CellularCommInterface_t * pPhysicalCommInterface )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCmuxContext_t * pCmuxContext = &_cellularCmuxContext;
+    char atCommand[ 32 ] = { 0 };
+    uint32_t sentLength = 0;
+    uint32_t waitTime = 0;
+    uint32_t index = 0;
+    bool mutexCreated = false;
+
+    if( pPhysicalCommInterface == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pCmuxContext->started == true )
+    {
+        CellularLogError( "Cellular CMUX started already" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        /* Clear the context. */
+        ( void ) memset( pCmuxContext, 0, sizeof( _cellularCmuxContext_t ) );
+        pCmuxContext->pPhysicalCommInterface = pPhysicalCommInterface;
+        CommRing_Init( &pCmuxContext->responseRing, pCmuxContext->responseRingBuffer, CMUX_RESPONSE_RING_SIZE );
+
+        for( index = 0; index < CELLULAR_CMUX_MAX_CHANNELS; index++ )
+        {
+            pCmuxContext->channels[ index ].dlci = ( uint8_t ) ( index + 1U );
+        }
+
+        mutexCreated = PlatformMutex_Create( &pCmuxContext->txMutex, false );
+
+        if( mutexCreated == false )
+        {
+            CellularLogError( "Cellular CMUX create mutex fail" );
+            commIntRet = IOT_COMM_INTERFACE_NO_MEMORY;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        commIntRet = pPhysicalCommInterface->open( _cmuxReceiveCallback, pCmuxContext, &pCmuxContext->physicalHandle );
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        /* Basic option, UIH frames. The port speed is left unchanged. */
+        ( void ) snprintf( atCommand, sizeof( atCommand ), "AT+CMUX=0,0,,%u\r", CELLULAR_CMUX_FRAME_SIZE );
+        commIntRet = pPhysicalCommInterface->send( pCmuxContext->physicalHandle, ( const uint8_t * ) atCommand,
+                                                   ( uint32_t ) strlen( atCommand ), CMUX_SEND_TIMEOUT_MS, &sentLength );
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        while( ( pCmuxContext->atOkReceived == false ) && ( pCmuxContext->atErrorReceived == false ) &&
+               ( waitTime < CMUX_RESPONSE_TIMEOUT_MS ) )
+        {
+            Platform_Delay( CMUX_RESPONSE_POLL_MS );
+            waitTime = waitTime + CMUX_RESPONSE_POLL_MS;
+        }
+
+        if( pCmuxContext->atOkReceived == false )
+        {
+            CellularLogError( "Cellular CMUX AT+CMUX fail" );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        /* Establish the multiplexer control channel. */
+        pCmuxContext->muxMode = true;
+        pCmuxContext->dlciState[ 0 ] = CMUX_DLCI_OPENING;
+
+        PlatformMutex_Lock( &pCmuxContext->txMutex );
+        commIntRet = _cmuxSendFrame( pCmuxContext, 0U, CMUX_FRAME_SABM | CMUX_CONTROL_PF, true,
+                                     NULL, 0U, CMUX_SEND_TIMEOUT_MS );
+        PlatformMutex_Unlock( &pCmuxContext->txMutex );
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        commIntRet = _cmuxWaitDlciState( pCmuxContext, 0U, CMUX_DLCI_OPEN );
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        pCmuxContext->started = true;
+        CellularLogInfo( "Cellular CMUX started, %u channels, frame size %u",
+                         CELLULAR_CMUX_MAX_CHANNELS, CELLULAR_CMUX_FRAME_SIZE );
+    }
+    else
+    {
+        if( pCmuxContext->physicalHandle != NULL )
+        {
+            ( void ) pPhysicalCommInterface->close( pCmuxContext->physicalHandle );
+            pCmuxContext->physicalHandle = NULL;
+        }
+
+        if( mutexCreated == true )
+        {
+            PlatformMutex_Destroy( &pCmuxContext->txMutex );
+        }
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterface_t * CellularCmux_GetChannel( uint8_t dlci )
+{
+    CellularCommInterface_t * pCommInterface = NULL;
+
+    if( ( dlci >= 1U ) && ( dlci <= CELLULAR_CMUX_MAX_CHANNELS ) )
+    {
+        pCommInterface = &_cellularCmuxChannelInterfaces[ dlci - 1U ];
+
+        if( pCommInterface->open == NULL )
+        {
+            pCommInterface->send = _prvCmuxChannelSend;
+            pCommInterface->recv = _prvCmuxChannelReceive;
+            pCommInterface->close = _prvCmuxChannelClose;
+            pCommInterface->open = _cmuxChannelOpenFunctions[ dlci - 1U ];
+        }
+    }
+
+    return pCommInterface;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterfaceError_t CellularCmux_Stop( void )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCmuxContext_t * pCmuxContext = &_cellularCmuxContext;
+    uint8_t dlci = 0;
+
+    if( pCmuxContext->started == false )
+    {
+        CellularLogError( "Cellular CMUX is not started" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        for( dlci = 1U; dlci <= CELLULAR_CMUX_MAX_CHANNELS; dlci++ )
+        {
+            pCmuxContext->channels[ dlci - 1U ].receiveCallback = NULL;
+            ( void ) _cmuxCloseDlci( pCmuxContext, dlci );
+        }
+
+        /* Ask the modem to leave multiplexer mode. It answers CLD before it returns to AT command mode. */
+        PlatformMutex_Lock( &pCmuxContext->txMutex );
+        ( void ) _cmuxSendControlMessage( pCmuxContext, CMUX_MSG_CLD | CMUX_CR, NULL, 0U );
+        PlatformMutex_Unlock( &pCmuxContext->txMutex );
+
+        if( _cmuxWaitDlciState( pCmuxContext, 0U, CMUX_DLCI_CLOSED ) != IOT_COMM_INTERFACE_SUCCESS )
+        {
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+
+        pCmuxContext->muxMode = false;
+
+        if( pCmuxContext->pPhysicalCommInterface->close( pCmuxContext->physicalHandle ) != IOT_COMM_INTERFACE_SUCCESS )
+        {
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+
+        CellularLogInfo( "Cellular CMUX stopped, frame errors %u", pCmuxContext->frameErrorCount );
+
+        pCmuxContext->physicalHandle = NULL;
+        PlatformMutex_Destroy( &pCmuxContext->txMutex );
+        pCmuxContext->started = false;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,142 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_cmux.h
+ * @brief 3GPP TS 27.010 multiplexer on top of a cellular comm interface.
+ *
+ * The multiplexer runs the basic option of TS 27.010 over a physical comm
+ * interface and exposes each virtual channel (DLCI) as a comm interface of
+ * its own. The cellular library can use one channel for AT commands and URCs
+ * while other channels carry bulk data, so a long read on one channel no
+ * longer delays the traffic of the others.
+ */
+
+#ifndef __COMM_IF_CMUX_H__
+#define __COMM_IF_CMUX_H__
+
+#include <stdint.h>
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of virtual channels, DLCI 1 to CELLULAR_CMUX_MAX_CHANNELS.
+ */
+#ifndef CELLULAR_CMUX_MAX_CHANNELS
+    #define CELLULAR_CMUX_MAX_CHANNELS    ( 2U )
+#endif
+
+/* Upper limit of CELLULAR_CMUX_MAX_CHANNELS. */
+#define CMUX_CHANNEL_LIMIT                ( 4U )
+
+#if ( CELLULAR_CMUX_MAX_CHANNELS > CMUX_CHANNEL_LIMIT ) || ( CELLULAR_CMUX_MAX_CHANNELS == 0 )
+    #error "CELLULAR_CMUX_MAX_CHANNELS must be between 1 and 4"
+#endif
+
+/**
+ * @brief Maximum information field size of a frame (N1), requested with AT+CMUX.
+ */
+#ifndef CELLULAR_CMUX_FRAME_SIZE
+    #define CELLULAR_CMUX_FRAME_SIZE    ( 127U )
+#endif
+
+#if ( CELLULAR_CMUX_FRAME_SIZE < 31U ) || ( CELLULAR_CMUX_FRAME_SIZE > 32768U )
+    #error "CELLULAR_CMUX_FRAME_SIZE must be between 31 and 32768"
+#endif
+
+/**
+ * @brief Size of the receive ring of each virtual channel. Must be a power of two.
+ */
+#ifndef CELLULAR_CMUX_CHANNEL_RX_RING_SIZE
+    #define CELLULAR_CMUX_CHANNEL_RX_RING_SIZE    ( 4096U )
+#endif
+
+/**
+ * @brief Bytes in the receive ring of a channel at which the modem is asked
+ * to stop sending on the channel, with an MSC carrying FC = 1.
+ *
+ * The space above it takes the frames the modem sends before it handles the MSC.
+ */
+#ifndef CELLULAR_CMUX_CHANNEL_RX_HIGH_WATER
+    #define CELLULAR_CMUX_CHANNEL_RX_HIGH_WATER    ( ( CELLULAR_CMUX_CHANNEL_RX_RING_SIZE * 3U ) / 4U )
+#endif
+
+/**
+ * @brief Bytes left in the receive ring of a channel after recv at which the
+ * modem is asked to resume sending on the channel, with an MSC carrying FC = 0.
+ */
+#ifndef CELLULAR_CMUX_CHANNEL_RX_LOW_WATER
+    #define CELLULAR_CMUX_CHANNEL_RX_LOW_WATER    ( CELLULAR_CMUX_CHANNEL_RX_RING_SIZE / 4U )
+#endif
+
+#if ( CELLULAR_CMUX_CHANNEL_RX_LOW_WATER >= CELLULAR_CMUX_CHANNEL_RX_HIGH_WATER ) || \
+    ( CELLULAR_CMUX_CHANNEL_RX_HIGH_WATER > CELLULAR_CMUX_CHANNEL_RX_RING_SIZE )
+    #error "CELLULAR_CMUX_CHANNEL_RX_LOW_WATER must be less than CELLULAR_CMUX_CHANNEL_RX_HIGH_WATER, which must not exceed the ring size"
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Open the physical comm interface and switch the modem to multiplexer mode.
+ *
+ * The modem must be in AT command mode. AT+CMUX is sent on the physical comm
+ * interface and the multiplexer control channel (DLCI 0) is established.
+ *
+ * @param[in] pPhysicalCommInterface The comm interface connected to the modem,
+ * for example &CellularCommInterface.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+CellularCommInterfaceError_t CellularCmux_Start( CellularCommInterface_t * pPhysicalCommInterface );
+
+/**
+ * @brief Get the comm interface of a virtual channel.
+ *
+ * Open of the returned comm interface establishes the channel and close
+ * releases it. It can be passed to Cellular_Init like a physical comm interface.
+ *
+ * @param[in] dlci Data link connection identifier, 1 to CELLULAR_CMUX_MAX_CHANNELS.
+ *
+ * @return The comm interface of the channel. NULL if dlci is out of range.
+ */
+CellularCommInterface_t * CellularCmux_GetChannel( uint8_t dlci );
+
+/**
+ * @brief Release the open channels, leave multiplexer mode and close the physical comm interface.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+CellularCommInterfaceError_t CellularCmux_Stop( void );
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_CMUX_H__ */
@@ -0,0 +1,902 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_fault.c
+ * @brief Fault injection between a cellular comm interface and the cellular library.
+ *
+ * The receive callback of the physical comm interface only wakes the fault
+ * thread. The fault thread reads the physical comm interface, damages the
+ * data and writes it to the receive ring read by the library, so it is the
+ * only producer of the ring. It also delivers the delayed URCs when they are
+ * due. Send faults are decided in the send call, which the library does not
+ * call concurrently.
+ *
+ * URCs are found by the prefix of their line. A line is held back only while
+ * its start may still match a prefix, and what is held is passed on at the
+ * end of every read, so data without line ends, such as the send prompt and
+ * socket payload, is never delayed.
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <string.h>
+
+/* FreeRTOS include. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Platform layer includes. */
+#include "cellular_platform.h"
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+#include "comm_if_fault.h"
+
+/* Receive ring include file. */
+#include "comm_if_ring.h"
+
+/*-----------------------------------------------------------*/
+
+/* Fault thread events. */
+#define FAULT_EVENT_RX          ( 0x01UL )
+#define FAULT_EVENT_RX_SPACE    ( 0x02UL )
+#define FAULT_EVENT_STOP        ( 0x04UL )
+#define FAULT_EVENT_ALL         ( FAULT_EVENT_RX | FAULT_EVENT_RX_SPACE | FAULT_EVENT_STOP )
+
+/* Interval to poll for the fault thread to exit and for delayed URCs in ms. */
+#define FAULT_POLL_MS           ( 10U )
+
+/* Bytes read from the physical comm interface at a time. */
+#define FAULT_READ_CHUNK        ( 256U )
+
+/* Receive ring space kept for a URC delivered twice or released with the read data. */
+#define FAULT_RX_HEADROOM       ( 4U * ( CELLULAR_COMM_FAULT_URC_LENGTH + 2U ) )
+
+/* Probabilities are given in parts per million. */
+#define FAULT_PPM               ( 1000000U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Line scanner state of the received data.
+ */
+typedef enum _cellularFaultLineState
+{
+    FAULT_LINE_START = 0, /**< Start of a line, nothing held. */
+    FAULT_LINE_PREFIX,    /**< The held start of the line may still match a URC prefix. */
+    FAULT_LINE_URC,       /**< The held line is a URC. */
+    FAULT_LINE_PASS       /**< The line is not a URC, bytes are passed on until its end. */
+} _cellularFaultLineState_t;
+
+/**
+ * @brief URC held back until it is due.
+ */
+typedef struct _cellularFaultDelayedUrc
+{
+    bool inUse;
+    TickType_t dueTick;
+    uint32_t length;
+    uint8_t line[ CELLULAR_COMM_FAULT_URC_LENGTH ];
+} _cellularFaultDelayedUrc_t;
+
+/**
+ * @brief Fault injection context.
+ */
+typedef struct _cellularFaultContext
+{
+    bool opened;
+    CellularCommFaultProfile_t profile;
+    CellularCommInterfaceReceiveCallback_t receiveCallback;
+    void * pUserData;
+    CellularCommInterface_t * pPhysicalCommInterface;
+    CellularCommInterfaceHandle_t physicalHandle;
+    CellularCommFaultStats_t stats;
+
+    /* Fault thread. */
+    PlatformEventGroupHandle_t faultEvent;
+    volatile bool faultStop;
+    volatile bool faultRunning;
+    volatile bool rxSpaceWaiting;
+    uint32_t rxRandom;
+    _cellularFaultLineState_t lineState;
+    uint32_t lineLength;
+    uint8_t line[ CELLULAR_COMM_FAULT_URC_LENGTH ];
+    _cellularFaultDelayedUrc_t delayedUrcs[ CELLULAR_COMM_FAULT_URC_SLOTS ];
+
+    /* Send faults, only used by send. */
+    uint32_t txRandom;
+    volatile TickType_t disconnectEndTick;
+    volatile bool disconnected;
+
+    CommRing_t rxRing;
+    uint8_t rxRingBuffer[ CELLULAR_COMM_FAULT_RX_RING_SIZE ];
+} _cellularFaultContext_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief CellularCommInterfaceOpen_t implementation.
+ */
+static CellularCommInterfaceError_t _prvFaultOpen( CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                   void * pUserData,
+                                                   CellularCommInterfaceHandle_t * pCommInterfaceHandle );
+
+/**
+ * @brief CellularCommInterfaceSend_t implementation.
+ */
+static CellularCommInterfaceError_t _prvFaultSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                   const uint8_t * pData,
+                                                   uint32_t dataLength,
+                                                   uint32_t timeoutMilliseconds,
+                                                   uint32_t * pDataSentLength );
+
+/**
+ * @brief CellularCommInterfaceRecv_t implementation.
+ */
+static CellularCommInterfaceError_t _prvFaultReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                      uint8_t * pBuffer,
+                                                      uint32_t bufferLength,
+                                                      uint32_t timeoutMilliseconds,
+                                                      uint32_t * pDataReceivedLength );
+
+/**
+ * @brief CellularCommInterfaceClose_t implementation.
+ */
+static CellularCommInterfaceError_t _prvFaultClose( CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Receive callback of the physical comm interface. Wakes the fault thread.
+ *
+ * @param[in] pUserData Pointer to the fault context.
+ * @param[in] commInterfaceHandle Handle of the physical comm interface.
+ *
+ * @return IOT_COMM_INTERFACE_SUCCESS if the fault thread is woken.
+ */
+static CellularCommInterfaceError_t _faultReceiveCallback( void * pUserData,
+                                                           CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Decide a fault with a probability.
+ *
+ * @param[in,out] pRandom State of the pseudo random generator.
+ * @param[in] ppm Probability in parts per million.
+ *
+ * @return true if the fault is injected.
+ */
+static bool _faultRoll( uint32_t * pRandom,
+                        uint32_t ppm );
+
+/**
+ * @brief Copy bytes to the receive ring.
+ *
+ * @param[in] pFaultContext Fault context.
+ * @param[in] pData Bytes for the library.
+ * @param[in] length Number of bytes in pData.
+ */
+static void _faultPut( _cellularFaultContext_t * pFaultContext,
+                       const uint8_t * pData,
+                       uint32_t length );
+
+/**
+ * @brief Apply the URC faults to a complete URC line and pass it on.
+ *
+ * @param[in] pFaultContext Fault context with the URC line held.
+ */
+static void _faultUrc( _cellularFaultContext_t * pFaultContext );
+
+/**
+ * @brief Find the URCs in the received bytes and pass the bytes on.
+ *
+ * @param[in] pFaultContext Fault context.
+ * @param[in] pData Received bytes after the byte faults.
+ * @param[in] length Number of bytes in pData.
+ */
+static void _faultScan( _cellularFaultContext_t * pFaultContext,
+                        const uint8_t * pData,
+                        uint32_t length );
+
+/**
+ * @brief Deliver the delayed URCs which are due.
+ *
+ * @param[in] pFaultContext Fault context.
+ *
+ * @return Ticks until the next delayed URC is due, FAULT_POLL_MS if there is none.
+ */
+static bool _faultDisconnected( const _cellularFaultContext_t * pFaultContext )
+{
+    TickType_t remainingTicks = 0;
+    bool disconnected = false;
+
+    if( pFaultContext->disconnected == true )
+    {
+        remainingTicks = pFaultContext->disconnectEndTick - xTaskGetTickCount();
+
+        /* An end tick in the past wraps around to a large value. */
+        disconnected = ( ( remainingTicks != 0U ) && ( remainingTicks <= ( portMAX_DELAY / 2U ) ) );
+    }
+
+    return disconnected;
+}
+
+/*-----------------------------------------------------------*/
+
+static TickType_t _faultReleaseUrcs( _cellularFaultContext_t * pFaultContext );
+
+/**
+ * @brief Check if a disconnect injected by send is still going on.
+ *
+ * @param[in] pFaultContext Fault context.
+ *
+ * @return true if the port is disconnected.
+ */
+static bool _faultDisconnected( const _cellularFaultContext_t * pFaultContext );
+
+/**
+ * @brief Fault thread. Moves the received data to the library through the faults.
+ *
+ * @param[in] pArgument Pointer to the fault context.
+ */
+static void _faultThread( void * pArgument );
+
+/*-----------------------------------------------------------*/
+
+/* Socket URCs of the BG96, SIM70x0 and Quectel GSM modules. */
+static const char * const _cellularFaultDefaultUrcPrefixes[] =
+{
+    "+QIURC:",
+    "+QIOPEN:",
+    "+QIRDI:",
+    "+CADATAIND:",
+    "+CASTATE:"
+};
+
+static _cellularFaultContext_t _cellularFaultContext = { 0 };
+
+static CellularCommInterface_t _cellularFaultInterface =
+{
+    .open  = _prvFaultOpen,
+    .send  = _prvFaultSend,
+    .recv  = _prvFaultReceive,
+    .close = _prvFaultClose
+};
+
+/*-----------------------------------------------------------*/
+
+static bool _faultRoll( uint32_t * pRandom,
+                        uint32_t ppm )
+{
+    uint32_t value = *pRandom;
+    bool inject = false;
+
+    if( ppm > 0U )
+    {
+        /* xorshift32. */
+        value = value ^ ( value << 13 );
+        value = value ^ ( value >> 17 );
+        value = value ^ ( value << 5 );
+        *pRandom = value;
+        inject = ( ( value % FAULT_PPM ) < ppm );
+    }
+
+    return inject;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _faultPut( _cellularFaultContext_t * pFaultContext,
+                       const uint8_t * pData,
+                       uint32_t length )
+{
+    uint8_t * pWrite = NULL;
+    uint32_t spanLength = 0;
+    uint32_t offset = 0;
+
+    while( offset < length )
+    {
+        spanLength = CommRing_GetWriteSpan( &pFaultContext->rxRing, &pWrite );
+
+        if( spanLength == 0U )
+        {
+            /* Only reached if the headroom is exceeded, the physical read is throttled before. */
+            pFaultContext->rxRing.overrunCount++;
+            pFaultContext->stats.rxDroppedBytes = pFaultContext->stats.rxDroppedBytes + ( length - offset );
+            break;
+        }
+
+        if( spanLength > ( length - offset ) )
+        {
+            spanLength = length - offset;
+        }
+
+        ( void ) memcpy( pWrite, &pData[ offset ], spanLength );
+        CommRing_Commit( &pFaultContext->rxRing, spanLength );
+        offset = offset + spanLength;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _faultUrc( _cellularFaultContext_t * pFaultContext )
+{
+    _cellularFaultDelayedUrc_t * pDelayedUrc = NULL;
+    uint32_t slot = 0;
+
+    pFaultContext->stats.urcCount++;
+
+    if( _faultRoll( &pFaultContext->rxRandom, pFaultContext->profile.urcDelayPpm ) == true )
+    {
+        for( slot = 0; ( slot < CELLULAR_COMM_FAULT_URC_SLOTS ) && ( pDelayedUrc == NULL ); slot++ )
+        {
+            if( pFaultContext->delayedUrcs[ slot ].inUse == false )
+            {
+                pDelayedUrc = &pFaultContext->delayedUrcs[ slot ];
+            }
+        }
+    }
+
+    if( pDelayedUrc != NULL )
+    {
+        pFaultContext->stats.urcDelayed++;
+        pDelayedUrc->dueTick = xTaskGetTickCount() + pdMS_TO_TICKS( pFaultContext->profile.urcDelayMs );
+        pDelayedUrc->length = pFaultContext->lineLength;
+        ( void ) memcpy( pDelayedUrc->line, pFaultContext->line, pFaultContext->lineLength );
+        pDelayedUrc->inUse = true;
+    }
+    else
+    {
+        _faultPut( pFaultContext, pFaultContext->line, pFaultContext->lineLength );
+
+        if( _faultRoll( &pFaultContext->rxRandom, pFaultContext->profile.urcDuplicatePpm ) == true )
+        {
+            pFaultContext->stats.urcDuplicated++;
+            _faultPut( pFaultContext, ( const uint8_t * ) "\r\n", 2U );
+            _faultPut( pFaultContext, pFaultContext->line, pFaultContext->lineLength );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _faultScan( _cellularFaultContext_t * pFaultContext,
+                        const uint8_t * pData,
+                        uint32_t length )
+{
+    const CellularCommFaultProfile_t * pProfile = &pFaultContext->profile;
+    uint32_t prefixLength = 0;
+    uint32_t compareLength = 0;
+    bool candidate = false;
+    bool matched = false;
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    for( i = 0; i < length; i++ )
+    {
+        if( pFaultContext->lineState == FAULT_LINE_START )
+        {
+            pFaultContext->lineLength = 0;
+            pFaultContext->lineState = FAULT_LINE_PREFIX;
+        }
+
+        if( pFaultContext->lineState == FAULT_LINE_PASS )
+        {
+            _faultPut( pFaultContext, &pData[ i ], 1U );
+        }
+        else
+        {
+            pFaultContext->line[ pFaultContext->lineLength ] = pData[ i ];
+            pFaultContext->lineLength++;
+        }
+
+        if( pFaultContext->lineState == FAULT_LINE_PREFIX )
+        {
+            candidate = false;
+            matched = false;
+
+            for( j = 0; j < pProfile->urcPrefixCount; j++ )
+            {
+                prefixLength = ( uint32_t ) strlen( pProfile->ppUrcPrefixes[ j ] );
+                compareLength = ( prefixLength < pFaultContext->lineLength ) ? prefixLength : pFaultContext->lineLength;
+
+                if( memcmp( pFaultContext->line, pProfile->ppUrcPrefixes[ j ], compareLength ) == 0 )
+                {
+                    candidate = true;
+                    matched = matched || ( pFaultContext->lineLength >= prefixLength );
+                }
+            }
+
+            if( matched == true )
+            {
+                pFaultContext->lineState = FAULT_LINE_URC;
+            }
+            else if( candidate == false )
+            {
+                _faultPut( pFaultContext, pFaultContext->line, pFaultContext->lineLength );
+                pFaultContext->lineState = FAULT_LINE_PASS;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+
+        if( pData[ i ] == ( uint8_t ) '\n' )
+        {
+            if( pFaultContext->lineState == FAULT_LINE_URC )
+            {
+                _faultUrc( pFaultContext );
+            }
+
+            pFaultContext->lineState = FAULT_LINE_START;
+        }
+        else if( ( pFaultContext->lineState == FAULT_LINE_URC ) &&
+                 ( pFaultContext->lineLength == CELLULAR_COMM_FAULT_URC_LENGTH ) )
+        {
+            /* Too long to hold, pass it on as it is. */
+            _faultPut( pFaultContext, pFaultContext->line, pFaultContext->lineLength );
+            pFaultContext->lineState = FAULT_LINE_PASS;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+    }
+
+    /* Do not hold data without line end, such as the send prompt, past this read. */
+    if( pFaultContext->lineState == FAULT_LINE_PREFIX )
+    {
+        _faultPut( pFaultContext, pFaultContext->line, pFaultContext->lineLength );
+        pFaultContext->lineState = FAULT_LINE_PASS;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static TickType_t _faultReleaseUrcs( _cellularFaultContext_t * pFaultContext )
+{
+    _cellularFaultDelayedUrc_t * pDelayedUrc = NULL;
+    TickType_t waitTicks = pdMS_TO_TICKS( FAULT_POLL_MS );
+    TickType_t remainingTicks = 0;
+    uint32_t slot = 0;
+
+    for( slot = 0; slot < CELLULAR_COMM_FAULT_URC_SLOTS; slot++ )
+    {
+        pDelayedUrc = &pFaultContext->delayedUrcs[ slot ];
+
+        if( pDelayedUrc->inUse == true )
+        {
+            remainingTicks = pDelayedUrc->dueTick - xTaskGetTickCount();
+
+            /* A due tick in the past wraps around to a large value. */
+            if( remainingTicks > ( portMAX_DELAY / 2U ) )
+            {
+                remainingTicks = 0;
+            }
+
+            if( remainingTicks == 0U )
+            {
+                _faultPut( pFaultContext, ( const uint8_t * ) "\r\n", 2U );
+                _faultPut( pFaultContext, pDelayedUrc->line, pDelayedUrc->length );
+                pDelayedUrc->inUse = false;
+            }
+            else if( remainingTicks < waitTicks )
+            {
+                waitTicks = remainingTicks;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    }
+
+    return waitTicks;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _faultThread( void * pArgument )
+{
+    _cellularFaultContext_t * pFaultContext = ( _cellularFaultContext_t * ) pArgument;
+    const CellularCommFaultProfile_t * pProfile = &pFaultContext->profile;
+    uint8_t chunk[ FAULT_READ_CHUNK ];
+    uint32_t readLength = 0;
+    uint32_t keptLength = 0;
+    uint32_t rxFree = 0;
+    uint32_t headBefore = 0;
+    uint32_t i = 0;
+    TickType_t waitTicks = pdMS_TO_TICKS( FAULT_POLL_MS );
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+
+    while( pFaultContext->faultStop == false )
+    {
+        ( void ) PlatformEventGroup_WaitBits( pFaultContext->faultEvent, FAULT_EVENT_ALL,
+                                              pdTRUE, pdFALSE, waitTicks );
+        headBefore = pFaultContext->rxRing.head;
+        waitTicks = _faultReleaseUrcs( pFaultContext );
+
+        do
+        {
+            /* Only read as much as fits with the URCs the faults may add. */
+            rxFree = pFaultContext->rxRing.size - CommRing_Used( &pFaultContext->rxRing );
+            readLength = 0;
+
+            if( rxFree <= FAULT_RX_HEADROOM )
+            {
+                pFaultContext->rxSpaceWaiting = true;
+                break;
+            }
+
+            commIntRet = pFaultContext->pPhysicalCommInterface->recv( pFaultContext->physicalHandle, chunk,
+                                                                     ( ( rxFree - FAULT_RX_HEADROOM ) < FAULT_READ_CHUNK ) ?
+                                                                     ( rxFree - FAULT_RX_HEADROOM ) : FAULT_READ_CHUNK,
+                                                                     0U, &readLength );
+
+            if( ( commIntRet != IOT_COMM_INTERFACE_SUCCESS ) || ( readLength == 0U ) )
+            {
+                break;
+            }
+
+            pFaultContext->stats.rxBytes = pFaultContext->stats.rxBytes + readLength;
+
+            if( _faultDisconnected( pFaultContext ) == true )
+            {
+                pFaultContext->stats.rxDroppedBytes = pFaultContext->stats.rxDroppedBytes + readLength;
+            }
+            else
+            {
+                keptLength = 0;
+
+                for( i = 0; i < readLength; i++ )
+                {
+                    if( _faultRoll( &pFaultContext->rxRandom, pProfile->rxDropPpm ) == true )
+                    {
+                        pFaultContext->stats.rxDroppedBytes++;
+                    }
+                    else
+                    {
+                        chunk[ keptLength ] = chunk[ i ];
+
+                        if( _faultRoll( &pFaultContext->rxRandom, pProfile->rxCorruptPpm ) == true )
+                        {
+                            pFaultContext->stats.rxCorruptedBytes++;
+                            chunk[ keptLength ] = chunk[ keptLength ] ^ ( uint8_t ) ( 1U << ( pFaultContext->rxRandom & 7U ) );
+                        }
+
+                        keptLength++;
+                    }
+                }
+
+                _faultScan( pFaultContext, chunk, keptLength );
+            }
+        } while( pFaultContext->faultStop == false );
+
+        if( pFaultContext->rxRing.head != headBefore )
+        {
+            ( void ) pFaultContext->receiveCallback( pFaultContext->pUserData,
+                                                     ( CellularCommInterfaceHandle_t ) pFaultContext );
+        }
+    }
+
+    pFaultContext->faultRunning = false;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _faultReceiveCallback( void * pUserData,
+                                                           CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    _cellularFaultContext_t * pFaultContext = ( _cellularFaultContext_t * ) pUserData;
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+    ( void ) commInterfaceHandle;
+
+    /* Called like the receive callback of the library, which may be an interrupt. */
+    if( PlatformEventGroup_SetBitsFromISR( pFaultContext->faultEvent, FAULT_EVENT_RX,
+                                           &higherPriorityTaskWoken ) == pdPASS )
+    {
+        commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+        portYIELD_FROM_ISR( higherPriorityTaskWoken );
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvFaultOpen( CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                   void * pUserData,
+                                                   CellularCommInterfaceHandle_t * pCommInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularFaultContext_t * pFaultContext = &_cellularFaultContext;
+
+    if( ( pCommInterfaceHandle == NULL ) || ( receiveCallback == NULL ) || ( pFaultContext->pPhysicalCommInterface == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pFaultContext->opened == true )
+    {
+        CellularLogError( "Cellular comm fault is opened already" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        pFaultContext->receiveCallback = receiveCallback;
+        pFaultContext->pUserData = pUserData;
+        ( void ) memset( &pFaultContext->stats, 0, sizeof( CellularCommFaultStats_t ) );
+        ( void ) memset( pFaultContext->delayedUrcs, 0, sizeof( pFaultContext->delayedUrcs ) );
+        pFaultContext->rxRandom = pFaultContext->profile.seed;
+        pFaultContext->txRandom = pFaultContext->profile.seed ^ 0x9E3779B9UL;
+        pFaultContext->lineState = FAULT_LINE_START;
+        pFaultContext->disconnected = false;
+        pFaultContext->faultStop = false;
+        pFaultContext->rxSpaceWaiting = false;
+        CommRing_Init( &pFaultContext->rxRing, pFaultContext->rxRingBuffer, CELLULAR_COMM_FAULT_RX_RING_SIZE );
+
+        pFaultContext->faultEvent = PlatformEventGroup_Create();
+
+        if( pFaultContext->faultEvent == NULL )
+        {
+            commIntRet = IOT_COMM_INTERFACE_NO_MEMORY;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        pFaultContext->faultRunning = true;
+
+        if( Platform_CreateDedicatedThread( _faultThread, pFaultContext,
+                                            PLATFORM_THREAD_DEFAULT_PRIORITY,
+                                            PLATFORM_THREAD_DEFAULT_STACK_SIZE ) == false )
+        {
+            CellularLogError( "Cellular comm fault thread create failed" );
+            pFaultContext->faultRunning = false;
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+        else
+        {
+            commIntRet = pFaultContext->pPhysicalCommInterface->open( _faultReceiveCallback, pFaultContext,
+                                                                     &pFaultContext->physicalHandle );
+        }
+
+        if( commIntRet != IOT_COMM_INTERFACE_SUCCESS )
+        {
+            pFaultContext->faultStop = true;
+            ( void ) PlatformEventGroup_SetBits( pFaultContext->faultEvent, FAULT_EVENT_STOP );
+
+            while( pFaultContext->faultRunning == true )
+            {
+                Platform_Delay( FAULT_POLL_MS );
+            }
+
+            PlatformEventGroup_Delete( pFaultContext->faultEvent );
+            pFaultContext->faultEvent = NULL;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        pFaultContext->opened = true;
+        *pCommInterfaceHandle = ( CellularCommInterfaceHandle_t ) pFaultContext;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvFaultSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                   const uint8_t * pData,
+                                                   uint32_t dataLength,
+                                                   uint32_t timeoutMilliseconds,
+                                                   uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularFaultContext_t * pFaultContext = ( _cellularFaultContext_t * ) commInterfaceHandle;
+
+    if( ( pFaultContext == NULL ) || ( pData == NULL ) || ( pDataSentLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pFaultContext->opened == false )
+    {
+        CellularLogError( "Cellular comm fault send is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        *pDataSentLength = 0;
+
+        if( pFaultContext->disconnected == true )
+        {
+            if( _faultDisconnected( pFaultContext ) == false )
+            {
+                CellularLogInfo( "Cellular comm fault port reconnected" );
+                pFaultContext->disconnected = false;
+            }
+        }
+        else if( _faultRoll( &pFaultContext->txRandom, pFaultContext->profile.disconnectPpm ) == true )
+        {
+            CellularLogInfo( "Cellular comm fault port disconnected for %u ms", pFaultContext->profile.disconnectMs );
+            pFaultContext->stats.disconnects++;
+            pFaultContext->disconnectEndTick = xTaskGetTickCount() + pdMS_TO_TICKS( pFaultContext->profile.disconnectMs );
+            pFaultContext->disconnected = true;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+
+        if( pFaultContext->disconnected == true )
+        {
+            pFaultContext->stats.txFailedSends++;
+            commIntRet = IOT_COMM_INTERFACE_DRIVER_ERROR;
+        }
+        else
+        {
+            if( _faultRoll( &pFaultContext->txRandom, pFaultContext->profile.txStallPpm ) == true )
+            {
+                pFaultContext->stats.txStalls++;
+                Platform_Delay( pFaultContext->profile.txStallMs );
+            }
+
+            commIntRet = pFaultContext->pPhysicalCommInterface->send( pFaultContext->physicalHandle, pData, dataLength,
+                                                                     timeoutMilliseconds, pDataSentLength );
+        }
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvFaultReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                      uint8_t * pBuffer,
+                                                      uint32_t bufferLength,
+                                                      uint32_t timeoutMilliseconds,
+                                                      uint32_t * pDataReceivedLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularFaultContext_t * pFaultContext = ( _cellularFaultContext_t * ) commInterfaceHandle;
+
+    /* Same as the physical comm interface, return immediately with the bytes received. */
+    ( void ) timeoutMilliseconds;
+
+    if( ( pFaultContext == NULL ) || ( pBuffer == NULL ) || ( pDataReceivedLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pFaultContext->opened == false )
+    {
+        CellularLogError( "Cellular comm fault read is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        *pDataReceivedLength = CommRing_Read( &pFaultContext->rxRing, pBuffer, bufferLength );
+
+        if( pFaultContext->rxSpaceWaiting == true )
+        {
+            pFaultContext->rxSpaceWaiting = false;
+            ( void ) PlatformEventGroup_SetBits( pFaultContext->faultEvent, FAULT_EVENT_RX_SPACE );
+        }
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvFaultClose( CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularFaultContext_t * pFaultContext = ( _cellularFaultContext_t * ) commInterfaceHandle;
+
+    if( pFaultContext == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pFaultContext->opened == false )
+    {
+        CellularLogError( "Cellular comm fault close is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        /* Stop the fault thread before the physical comm interface it reads is closed. */
+        pFaultContext->faultStop = true;
+        ( void ) PlatformEventGroup_SetBits( pFaultContext->faultEvent, FAULT_EVENT_STOP );
+
+        while( pFaultContext->faultRunning == true )
+        {
+            Platform_Delay( FAULT_POLL_MS );
+        }
+
+        commIntRet = pFaultContext->pPhysicalCommInterface->close( pFaultContext->physicalHandle );
+        PlatformEventGroup_Delete( pFaultContext->faultEvent );
+        pFaultContext->faultEvent = NULL;
+        pFaultContext->opened = false;
+        pFaultContext->receiveCallback = NULL;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterface_t * CellularCommFault_Wrap( CellularCommInterface_t * pPhysicalCommInterface,
+                                                  const CellularCommFaultProfile_t * pProfile )
+{
+    CellularCommInterface_t * pCommInterface = NULL;
+    _cellularFaultContext_t * pFaultContext = &_cellularFaultContext;
+
+    if( ( pPhysicalCommInterface == NULL ) || ( pProfile == NULL ) ||
+        ( ( pProfile->ppUrcPrefixes == NULL ) && ( pProfile->urcPrefixCount > 0U ) ) )
+    {
+        CellularLogError( "Cellular comm fault wrap bad parameter" );
+    }
+    else if( pFaultContext->opened == true )
+    {
+        CellularLogError( "Cellular comm fault is opened already" );
+    }
+    else
+    {
+        pFaultContext->pPhysicalCommInterface = pPhysicalCommInterface;
+        pFaultContext->profile = *pProfile;
+
+        /* xorshift32 stays at 0 from a 0 seed. */
+        if( pFaultContext->profile.seed == 0U )
+        {
+            pFaultContext->profile.seed = 1U;
+        }
+
+        if( pFaultContext->profile.ppUrcPrefixes == NULL )
+        {
+            pFaultContext->profile.ppUrcPrefixes = _cellularFaultDefaultUrcPrefixes;
+            pFaultContext->profile.urcPrefixCount = sizeof( _cellularFaultDefaultUrcPrefixes ) /
+                                                    sizeof( _cellularFaultDefaultUrcPrefixes[ 0 ] );
+        }
+
+        pCommInterface = &_cellularFaultInterface;
+    }
+
+    return pCommInterface;
+}
+
+/*-----------------------------------------------------------*/
+
+void CellularCommFault_GetStats( CellularCommFaultStats_t * pStats )
+{
+    if( pStats != NULL )
+    {
+        *pStats = _cellularFaultContext.stats;
+    }
+}
+
+/*-----------------------------------------------------------*/
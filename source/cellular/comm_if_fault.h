@@ -0,0 +1,140 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_fault.h
+ * @brief Fault injection between a cellular comm interface and the cellular library.
+ *
+ * The fault comm interface wraps a physical comm interface and damages the
+ * traffic according to a profile: received bytes are dropped or corrupted,
+ * URCs are duplicated or delayed past the data that follows them, sends stall
+ * and the port disconnects for a while. All decisions come from a pseudo
+ * random generator seeded by the profile, so a run with the same traffic
+ * sees the same faults.
+ *
+ * Probabilities are given in parts per million: per received byte for loss
+ * and corruption, per URC for duplication and delay, and per send call for
+ * stalls and disconnects.
+ */
+
+#ifndef __COMM_IF_FAULT_H__
+#define __COMM_IF_FAULT_H__
+
+#include <stdint.h>
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Size of the ring of received data after the faults. Must be a power of two.
+ */
+#ifndef CELLULAR_COMM_FAULT_RX_RING_SIZE
+    #define CELLULAR_COMM_FAULT_RX_RING_SIZE    ( 4096U )
+#endif
+
+/**
+ * @brief Longest URC line the fault comm interface can duplicate or delay.
+ */
+#ifndef CELLULAR_COMM_FAULT_URC_LENGTH
+    #define CELLULAR_COMM_FAULT_URC_LENGTH    ( 128U )
+#endif
+
+/**
+ * @brief Number of URCs that can be delayed at the same time.
+ *
+ * A URC to delay when all of them are in use is delivered in order.
+ */
+#ifndef CELLULAR_COMM_FAULT_URC_SLOTS
+    #define CELLULAR_COMM_FAULT_URC_SLOTS    ( 4U )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Fault profile. A zero profile passes the traffic through unchanged.
+ */
+typedef struct CellularCommFaultProfile
+{
+    uint32_t seed;                      /**< Seed of the pseudo random generator, 0 is replaced by 1. */
+    uint32_t rxDropPpm;                 /**< Probability to drop a received byte. */
+    uint32_t rxCorruptPpm;              /**< Probability to flip a bit of a received byte. */
+    uint32_t urcDuplicatePpm;           /**< Probability to deliver a URC twice. */
+    uint32_t urcDelayPpm;               /**< Probability to hold a URC back by urcDelayMs. */
+    uint32_t urcDelayMs;                /**< Delay of a held back URC. */
+    uint32_t txStallPpm;                /**< Probability for a send call to stall for txStallMs first. */
+    uint32_t txStallMs;                 /**< Duration of a send stall. */
+    uint32_t disconnectPpm;             /**< Probability for a send call to disconnect the port for disconnectMs. */
+    uint32_t disconnectMs;              /**< Duration of a disconnect. Sends fail and received data is lost. */
+    const char * const * ppUrcPrefixes; /**< Prefixes of the URC lines, NULL for the socket URCs of the supported modules. */
+    uint32_t urcPrefixCount;            /**< Number of entries in ppUrcPrefixes. */
+} CellularCommFaultProfile_t;
+
+/**
+ * @brief Faults injected since the fault comm interface was opened.
+ */
+typedef struct CellularCommFaultStats
+{
+    uint32_t rxBytes;          /**< Bytes received from the physical comm interface. */
+    uint32_t rxDroppedBytes;   /**< Received bytes dropped, including the bytes lost while disconnected. */
+    uint32_t rxCorruptedBytes; /**< Received bytes with a flipped bit. */
+    uint32_t urcCount;         /**< URC lines seen. */
+    uint32_t urcDuplicated;    /**< URCs delivered twice. */
+    uint32_t urcDelayed;       /**< URCs held back. */
+    uint32_t txStalls;         /**< Send calls stalled. */
+    uint32_t disconnects;      /**< Disconnects started. */
+    uint32_t txFailedSends;    /**< Send calls failed because the port was disconnected. */
+} CellularCommFaultStats_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get a comm interface that injects faults into the traffic of a physical comm interface.
+ *
+ * The returned comm interface opens and forwards to pPhysicalCommInterface.
+ * The profile is copied, the URC prefixes it points to must stay valid until
+ * the comm interface is closed.
+ *
+ * @param[in] pPhysicalCommInterface The comm interface connected to the modem.
+ * @param[in] pProfile Faults to inject.
+ *
+ * @return The fault comm interface. NULL if a parameter is invalid.
+ */
+CellularCommInterface_t * CellularCommFault_Wrap( CellularCommInterface_t * pPhysicalCommInterface,
+                                                  const CellularCommFaultProfile_t * pProfile );
+
+/**
+ * @brief Get the faults injected since the fault comm interface was opened.
+ *
+ * @param[out] pStats Injected faults.
+ */
+void CellularCommFault_GetStats( CellularCommFaultStats_t * pStats );
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_FAULT_H__ */
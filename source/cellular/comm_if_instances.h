@@ -0,0 +1,158 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_instances.h
+ * @brief Instance table of a cellular comm interface port.
+ *
+ * Cellular_Init takes a CellularCommInterface_t whose open function has no
+ * instance argument, so every instance needs its own open function. This
+ * file defines them and the instances for comm_if_windows.c and
+ * comm_if_posix.c. A port includes it once, after it declares
+ * _prvCommIntfOpenInstance, _prvCommIntfSend, _prvCommIntfReceive and
+ * _prvCommIntfClose.
+ *
+ * Instance 0 is CellularCommInterface itself, so applications using
+ * CellularCommInterface and CellularCommInterface_GetInstance( 0 ) share one
+ * interface.
+ */
+
+#ifndef __COMM_IF_INSTANCES_H__
+#define __COMM_IF_INSTANCES_H__
+
+#include <stdint.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+/*-----------------------------------------------------------*/
+
+/* Open function of every instance. */
+#define COMM_IF_DEFINE_INSTANCE_OPEN( index )                                                                              \
+    static CellularCommInterfaceError_t _prvCommIntfOpen ## index( CellularCommInterfaceReceiveCallback_t receiveCallback, \
+                                                                   void * pUserData,                                    \
+                                                                   CellularCommInterfaceHandle_t * pCommInterfaceHandle ) \
+    {                                                                                                                      \
+        return _prvCommIntfOpenInstance( index ## U, receiveCallback, pUserData, pCommInterfaceHandle );                   \
+    }
+
+COMM_IF_DEFINE_INSTANCE_OPEN( 0 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 1 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 2 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 3 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 4 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 5 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 6 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 7 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 8 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 9 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 10 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 11 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 12 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 13 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 14 )
+COMM_IF_DEFINE_INSTANCE_OPEN( 15 )
+
+static const CellularCommInterfaceOpen_t _commIntfOpenFunctions[ COMM_IF_INSTANCE_LIMIT ] =
+{
+    _prvCommIntfOpen0,  _prvCommIntfOpen1,  _prvCommIntfOpen2,  _prvCommIntfOpen3,
+    _prvCommIntfOpen4,  _prvCommIntfOpen5,  _prvCommIntfOpen6,  _prvCommIntfOpen7,
+    _prvCommIntfOpen8,  _prvCommIntfOpen9,  _prvCommIntfOpen10, _prvCommIntfOpen11,
+    _prvCommIntfOpen12, _prvCommIntfOpen13, _prvCommIntfOpen14, _prvCommIntfOpen15
+};
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterface_t CellularCommInterface =
+{
+    .open  = _prvCommIntfOpen0,
+    .send  = _prvCommIntfSend,
+    .recv  = _prvCommIntfReceive,
+    .close = _prvCommIntfClose
+};
+
+#if ( CELLULAR_COMM_INTERFACE_MAX_INSTANCES > 1U )
+    /* Instances 1 and up, set up on their first CellularCommInterface_GetInstance. */
+    static CellularCommInterface_t _iotCellularCommInterfaces[ CELLULAR_COMM_INTERFACE_MAX_INSTANCES - 1U ] = { 0 };
+#endif
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterface_t * CellularCommInterface_GetInstance( uint32_t instanceIndex )
+{
+    CellularCommInterface_t * pCommInterface = NULL;
+
+    if( instanceIndex == 0U )
+    {
+        pCommInterface = &CellularCommInterface;
+    }
+
+    #if ( CELLULAR_COMM_INTERFACE_MAX_INSTANCES > 1U )
+        else if( instanceIndex < CELLULAR_COMM_INTERFACE_MAX_INSTANCES )
+        {
+            pCommInterface = &_iotCellularCommInterfaces[ instanceIndex - 1U ];
+
+            if( pCommInterface->open == NULL )
+            {
+                pCommInterface->send = _prvCommIntfSend;
+                pCommInterface->recv = _prvCommIntfReceive;
+                pCommInterface->close = _prvCommIntfClose;
+                pCommInterface->open = _commIntfOpenFunctions[ instanceIndex ];
+            }
+        }
+    #endif
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return pCommInterface;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterface_t * CellularCommInterface_GetByRole( CellularCommPortRole_t role )
+{
+    CellularCommInterface_t * pCommInterface = NULL;
+
+    if( role == CELLULAR_COMM_PORT_ROLE_CONTROL )
+    {
+        pCommInterface = CellularCommInterface_GetInstance( CELLULAR_COMM_INTERFACE_CONTROL_INSTANCE );
+    }
+    else if( role == CELLULAR_COMM_PORT_ROLE_DATA )
+    {
+        pCommInterface = CellularCommInterface_GetInstance( CELLULAR_COMM_INTERFACE_DATA_INSTANCE );
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return pCommInterface;
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_INSTANCES_H__ */
@@ -0,0 +1,849 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_loopback.c
+ * @brief In-process comm interface connected to a scripted modem model.
+ *
+ * The modem model runs in the send call of the library and in
+ * CellularCommLoopback_Deliver. A recursive mutex serializes the two, so the
+ * model is the only producer of the receive ring, and a peer may deliver its
+ * answer from the send call. The receive callback is called once the model
+ * is left, like the receive thread of a physical comm interface would after
+ * a burst of received data.
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <string.h>
+
+/* Platform layer includes. */
+#include "cellular_platform.h"
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+#include "comm_if_loopback.h"
+
+/* Receive ring include file. */
+#include "comm_if_ring.h"
+
+/*-----------------------------------------------------------*/
+
+/* Longest command line accepted by the model. */
+#define LOOPBACK_LINE_MAX             ( 256U )
+
+/* Numeric arguments parsed from a command line. */
+#define LOOPBACK_MAX_ARGUMENTS        ( 8U )
+
+/* Receive ring space kept for the header and the responses around read data. */
+#define LOOPBACK_READ_RESERVE         ( 64U )
+
+/* Response to a socket command with an invalid socket ID. */
+#define LOOPBACK_ERROR_RESPONSE       "\r\nERROR\r\n"
+
+/* Longest decimal representation of a uint32_t. */
+#define LOOPBACK_DECIMAL_MAX_LENGTH    ( 10U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Socket of the modem model.
+ */
+typedef struct _cellularLoopbackSocket
+{
+    CommRing_t ring;
+    uint8_t ringBuffer[ CELLULAR_COMM_LOOPBACK_SOCKET_BUFFER_SIZE ];
+    bool notified; /**< The receive URC was sent and the data was not read to the end yet. */
+} _cellularLoopbackSocket_t;
+
+/**
+ * @brief Loopback context.
+ */
+typedef struct _cellularLoopbackContext
+{
+    bool opened;
+    const CellularCommLoopbackScript_t * pScript;
+    CellularCommLoopbackPeer_t peer;
+    void * pPeerContext;
+    CellularCommInterfaceReceiveCallback_t receiveCallback;
+    void * pUserData;
+    CellularCommLoopbackStats_t stats;
+
+    /* Modem model state, only accessed with modelMutex held. */
+    PlatformMutex_t modelMutex;
+    uint32_t modelDepth;  /**< Nesting of modelMutex, the peer may deliver from send. */
+    bool rxNotify;        /**< Data was added to the receive ring since the receive callback. */
+    char line[ LOOPBACK_LINE_MAX ];
+    uint32_t lineLength;
+    bool lineOverflow;
+    uint32_t sendSocketId;
+    uint32_t sendRemaining; /**< Socket data still expected for the last SEND_DATA command. */
+    _cellularLoopbackSocket_t sockets[ CELLULAR_COMM_LOOPBACK_SOCKETS ];
+
+    CommRing_t rxRing;
+    uint8_t rxRingBuffer[ CELLULAR_COMM_LOOPBACK_RX_RING_SIZE ];
+} _cellularLoopbackContext_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief CellularCommInterfaceOpen_t implementation.
+ */
+static CellularCommInterfaceError_t _prvLoopbackOpen( CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                      void * pUserData,
+                                                      CellularCommInterfaceHandle_t * pCommInterfaceHandle );
+
+/**
+ * @brief CellularCommInterfaceSend_t implementation.
+ */
+static CellularCommInterfaceError_t _prvLoopbackSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                      const uint8_t * pData,
+                                                      uint32_t dataLength,
+                                                      uint32_t timeoutMilliseconds,
+                                                      uint32_t * pDataSentLength );
+
+/**
+ * @brief CellularCommInterfaceRecv_t implementation.
+ */
+static CellularCommInterfaceError_t _prvLoopbackReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                         uint8_t * pBuffer,
+                                                         uint32_t bufferLength,
+                                                         uint32_t timeoutMilliseconds,
+                                                         uint32_t * pDataReceivedLength );
+
+/**
+ * @brief CellularCommInterfaceClose_t implementation.
+ */
+static CellularCommInterfaceError_t _prvLoopbackClose( CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Enter the modem model.
+ *
+ * @param[in] pLoopbackContext Loopback context.
+ */
+static void _loopbackEnter( _cellularLoopbackContext_t * pLoopbackContext );
+
+/**
+ * @brief Leave the modem model. Calls the receive callback when the outermost
+ * caller leaves and data was added to the receive ring.
+ *
+ * @param[in] pLoopbackContext Loopback context.
+ */
+static void _loopbackLeave( _cellularLoopbackContext_t * pLoopbackContext );
+
+/**
+ * @brief Copy bytes to the receive ring.
+ *
+ * @param[in] pLoopbackContext Loopback context.
+ * @param[in] pData Bytes for the library.
+ * @param[in] length Number of bytes in pData.
+ */
+static void _loopbackPut( _cellularLoopbackContext_t * pLoopbackContext,
+                          const uint8_t * pData,
+                          uint32_t length );
+
+/**
+ * @brief Copy a script response to the receive ring, with "%u" replaced by value.
+ *
+ * @param[in] pLoopbackContext Loopback context.
+ * @param[in] pText Script response. Nothing is sent if NULL.
+ * @param[in] value Value of "%u".
+ */
+static void _loopbackRespond( _cellularLoopbackContext_t * pLoopbackContext,
+                              const char * pText,
+                              uint32_t value );
+
+/**
+ * @brief Queue socket data for the library and report it with the receive URC.
+ *
+ * @param[in] pLoopbackContext Loopback context.
+ * @param[in] socketId Socket of the data. Must be valid.
+ * @param[in] pData Socket data.
+ * @param[in] length Number of bytes in pData.
+ *
+ * @return Number of bytes queued.
+ */
+static uint32_t _loopbackSocketPut( _cellularLoopbackContext_t * pLoopbackContext,
+                                    uint32_t socketId,
+                                    const uint8_t * pData,
+                                    uint32_t length );
+
+/**
+ * @brief Run the script for a complete command line.
+ *
+ * @param[in] pLoopbackContext Loopback context.
+ */
+static void _loopbackCommand( _cellularLoopbackContext_t * pLoopbackContext );
+
+/**
+ * @brief Pass bytes sent by the library to the modem model.
+ *
+ * @param[in] pLoopbackContext Loopback context.
+ * @param[in] pData Bytes sent by the library.
+ * @param[in] length Number of bytes in pData.
+ */
+static void _loopbackInput( _cellularLoopbackContext_t * pLoopbackContext,
+                            const uint8_t * pData,
+                            uint32_t length );
+
+/*-----------------------------------------------------------*/
+
+static const CellularCommLoopbackRule_t _cellularLoopbackBg96Rules[] =
+{
+    { "AT+CPIN?",     "\r\n+CPIN: READY\r\n\r\nOK\r\n",                                    CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+QSIMSTAT?", "\r\n+QSIMSTAT: 0,1\r\n\r\nOK\r\n",                                  CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CFUN?",     "\r\n+CFUN: 1\r\n\r\nOK\r\n",                                        CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CREG?",     "\r\n+CREG: 2,1,\"0001\",\"00000001\",8\r\n\r\nOK\r\n",              CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CGREG?",    "\r\n+CGREG: 2,1,\"0001\",\"00000001\",8\r\n\r\nOK\r\n",             CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CEREG?",    "\r\n+CEREG: 2,1,\"0001\",\"00000001\",8\r\n\r\nOK\r\n",             CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+COPS?",     "\r\n+COPS: 0,0,\"LOOPBACK\",8\r\n\r\nOK\r\n",                       CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CSQ",       "\r\n+CSQ: 20,99\r\n\r\nOK\r\n",                                     CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CGATT?",    "\r\n+CGATT: 1\r\n\r\nOK\r\n",                                       CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CGMI",      "\r\nQuectel\r\n\r\nOK\r\n",                                         CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CGMM",      "\r\nBG96\r\n\r\nOK\r\n",                                            CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CGMR",      "\r\nLOOPBACK01A01\r\n\r\nOK\r\n",                                   CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CGSN",      "\r\n869000000000001\r\n\r\nOK\r\n",                                 CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CIMI",      "\r\n001010000000001\r\n\r\nOK\r\n",                                 CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+QCCID",     "\r\n+QCCID: 89000000000000000001\r\n\r\nOK\r\n",                    CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+QIACT?",    "\r\n+QIACT: 1,1,1,\"10.0.0.2\"\r\n\r\nOK\r\n",                      CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+CGPADDR=",  "\r\n+CGPADDR: %u,10.0.0.2\r\n\r\nOK\r\n",                           CELLULAR_COMM_LOOPBACK_RESPOND,   0U },
+    { "AT+QIOPEN=",   "\r\nOK\r\n\r\n+QIOPEN: %u,0\r\n",                                   CELLULAR_COMM_LOOPBACK_RESPOND,   1U },
+    { "AT+QISEND=",   "\r\n> ",                                                            CELLULAR_COMM_LOOPBACK_SEND_DATA, 0U },
+    { "AT+QIRD=",     "\r\nOK\r\n",                                                        CELLULAR_COMM_LOOPBACK_READ_DATA, 0U },
+    { "AT+QICLOSE=",  "\r\nOK\r\n",                                                        CELLULAR_COMM_LOOPBACK_CLOSE,     0U }
+};
+
+const CellularCommLoopbackScript_t CellularCommLoopbackBg96Script =
+{
+    .pRules           = _cellularLoopbackBg96Rules,
+    .ruleCount        = sizeof( _cellularLoopbackBg96Rules ) / sizeof( _cellularLoopbackBg96Rules[ 0 ] ),
+    .pDefaultResponse = "\r\nOK\r\n",
+    .pSendResponse    = "\r\nSEND OK\r\n",
+    .pReadHeader      = "\r\n+QIRD: %u\r\n",
+    .pReadTrailer     = "\r\n",
+    .pRecvUrc         = "\r\n+QIURC: \"recv\",%u\r\n"
+};
+
+/*-----------------------------------------------------------*/
+
+static _cellularLoopbackContext_t _cellularLoopbackContext = { 0 };
+
+static CellularCommInterface_t _cellularLoopbackInterface =
+{
+    .open  = _prvLoopbackOpen,
+    .send  = _prvLoopbackSend,
+    .recv  = _prvLoopbackReceive,
+    .close = _prvLoopbackClose
+};
+
+/*-----------------------------------------------------------*/
+
+static void _loopbackEnter( _cellularLoopbackContext_t * pLoopbackContext )
+{
+    PlatformMutex_Lock( &pLoopbackContext->modelMutex );
+    pLoopbackContext->modelDepth++;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _loopbackLeave( _cellularLoopbackContext_t * pLoopbackContext )
+{
+    bool notify = false;
+
+    pLoopbackContext->modelDepth--;
+
+    if( ( pLoopbackContext->modelDepth == 0U ) && ( pLoopbackContext->rxNotify == true ) )
+    {
+        pLoopbackContext->rxNotify = false;
+        notify = true;
+    }
+
+    PlatformMutex_Unlock( &pLoopbackContext->modelMutex );
+
+    if( ( notify == true ) && ( pLoopbackContext->receiveCallback != NULL ) )
+    {
+        ( void ) pLoopbackContext->receiveCallback( pLoopbackContext->pUserData,
+                                                    ( CellularCommInterfaceHandle_t ) pLoopbackContext );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _loopbackPut( _cellularLoopbackContext_t * pLoopbackContext,
+                          const uint8_t * pData,
+                          uint32_t length )
+{
+    CommRing_t * pRing = &pLoopbackContext->rxRing;
+    uint8_t * pWrite = NULL;
+    uint32_t spanLength = 0;
+    uint32_t offset = 0;
+
+    while( offset < length )
+    {
+        spanLength = CommRing_GetWriteSpan( pRing, &pWrite );
+
+        if( spanLength == 0U )
+        {
+            CellularLogWarn( "Cellular comm loopback receive ring full, %u bytes dropped", length - offset );
+            pRing->overrunCount++;
+            pLoopbackContext->stats.dropBytes = pLoopbackContext->stats.dropBytes + ( length - offset );
+            break;
+        }
+
+        if( spanLength > ( length - offset ) )
+        {
+            spanLength = length - offset;
+        }
+
+        ( void ) memcpy( pWrite, &pData[ offset ], spanLength );
+        CommRing_Commit( pRing, spanLength );
+        offset = offset + spanLength;
+    }
+
+    if( offset > 0U )
+    {
+        pLoopbackContext->rxNotify = true;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _loopbackRespond( _cellularLoopbackContext_t * pLoopbackContext,
+                              const char * pText,
+                              uint32_t value )
+{
+    const char * pStart = pText;
+    const char * pFormat = NULL;
+    char decimal[ LOOPBACK_DECIMAL_MAX_LENGTH ];
+    uint32_t digits = 0;
+
+    while( pStart != NULL )
+    {
+        pFormat = strstr( pStart, "%u" );
+
+        if( pFormat == NULL )
+        {
+            _loopbackPut( pLoopbackContext, ( const uint8_t * ) pStart, ( uint32_t ) strlen( pStart ) );
+            pStart = NULL;
+        }
+        else
+        {
+            _loopbackPut( pLoopbackContext, ( const uint8_t * ) pStart, ( uint32_t ) ( pFormat - pStart ) );
+
+            /* Digits are generated from the end of the buffer. */
+            digits = 0;
+
+            do
+            {
+                digits++;
+                decimal[ LOOPBACK_DECIMAL_MAX_LENGTH - digits ] = ( char ) ( '0' + ( value % 10U ) );
+                value = value / 10U;
+            } while( value != 0U );
+
+            _loopbackPut( pLoopbackContext, ( const uint8_t * ) &decimal[ LOOPBACK_DECIMAL_MAX_LENGTH - digits ], digits );
+            pStart = &pFormat[ 2 ];
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t _loopbackSocketPut( _cellularLoopbackContext_t * pLoopbackContext,
+                                    uint32_t socketId,
+                                    const uint8_t * pData,
+                                    uint32_t length )
+{
+    _cellularLoopbackSocket_t * pSocket = &pLoopbackContext->sockets[ socketId ];
+    uint8_t * pWrite = NULL;
+    uint32_t spanLength = 0;
+    uint32_t offset = 0;
+
+    while( offset < length )
+    {
+        spanLength = CommRing_GetWriteSpan( &pSocket->ring, &pWrite );
+
+        if( spanLength == 0U )
+        {
+            pSocket->ring.overrunCount++;
+            pLoopbackContext->stats.dropBytes = pLoopbackContext->stats.dropBytes + ( length - offset );
+            break;
+        }
+
+        if( spanLength > ( length - offset ) )
+        {
+            spanLength = length - offset;
+        }
+
+        ( void ) memcpy( pWrite, &pData[ offset ], spanLength );
+        CommRing_Commit( &pSocket->ring, spanLength );
+        offset = offset + spanLength;
+    }
+
+    /* The module reports new data again once the library read the socket to the end. */
+    if( ( offset > 0U ) && ( pSocket->notified == false ) )
+    {
+        pSocket->notified = true;
+        _loopbackRespond( pLoopbackContext, pLoopbackContext->pScript->pRecvUrc, socketId );
+    }
+
+    return offset;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _loopbackCommand( _cellularLoopbackContext_t * pLoopbackContext )
+{
+    const CellularCommLoopbackScript_t * pScript = pLoopbackContext->pScript;
+    const CellularCommLoopbackRule_t * pRule = NULL;
+    _cellularLoopbackSocket_t * pSocket = NULL;
+    const char * pArgs = NULL;
+    uint32_t arguments[ LOOPBACK_MAX_ARGUMENTS ] = { 0 };
+    uint32_t argumentCount = 0;
+    uint32_t socketId = 0;
+    uint32_t lastArgument = 0;
+    uint32_t readLength = 0;
+    uint32_t rxFree = 0;
+    uint8_t * pRead = NULL;
+    uint32_t spanLength = 0;
+    uint32_t i = 0;
+
+    pLoopbackContext->stats.commandCount++;
+
+    for( i = 0; ( i < pScript->ruleCount ) && ( pRule == NULL ); i++ )
+    {
+        if( strncmp( pLoopbackContext->line, pScript->pRules[ i ].pCommand,
+                     strlen( pScript->pRules[ i ].pCommand ) ) == 0 )
+        {
+            pRule = &pScript->pRules[ i ];
+        }
+    }
+
+    /* Numeric arguments, a quoted or empty argument counts as 0. */
+    pArgs = strchr( pLoopbackContext->line, '=' );
+
+    if( pArgs != NULL )
+    {
+        argumentCount = 1U;
+
+        for( pArgs = &pArgs[ 1 ]; *pArgs != '\0'; pArgs++ )
+        {
+            if( *pArgs == ',' )
+            {
+                if( argumentCount == LOOPBACK_MAX_ARGUMENTS )
+                {
+                    break;
+                }
+
+                argumentCount++;
+            }
+            else if( ( *pArgs >= '0' ) && ( *pArgs <= '9' ) )
+            {
+                arguments[ argumentCount - 1U ] = ( arguments[ argumentCount - 1U ] * 10U ) + ( uint32_t ) ( *pArgs - '0' );
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+
+        lastArgument = arguments[ argumentCount - 1U ];
+    }
+
+    if( ( pRule != NULL ) && ( pRule->socketArgument < LOOPBACK_MAX_ARGUMENTS ) )
+    {
+        socketId = arguments[ pRule->socketArgument ];
+    }
+
+    if( pRule == NULL )
+    {
+        pLoopbackContext->stats.unmatchedCount++;
+        _loopbackRespond( pLoopbackContext, pScript->pDefaultResponse, 0U );
+    }
+    else if( pRule->action == CELLULAR_COMM_LOOPBACK_RESPOND )
+    {
+        _loopbackRespond( pLoopbackContext, pRule->pResponse, socketId );
+    }
+    else if( socketId >= CELLULAR_COMM_LOOPBACK_SOCKETS )
+    {
+        CellularLogWarn( "Cellular comm loopback invalid socket %u in %s", socketId, pLoopbackContext->line );
+        _loopbackRespond( pLoopbackContext, LOOPBACK_ERROR_RESPONSE, 0U );
+    }
+    else if( pRule->action == CELLULAR_COMM_LOOPBACK_SEND_DATA )
+    {
+        _loopbackRespond( pLoopbackContext, pRule->pResponse, socketId );
+        pLoopbackContext->sendSocketId = socketId;
+        pLoopbackContext->sendRemaining = lastArgument;
+    }
+    else if( pRule->action == CELLULAR_COMM_LOOPBACK_READ_DATA )
+    {
+        pSocket = &pLoopbackContext->sockets[ socketId ];
+        rxFree = pLoopbackContext->rxRing.size - CommRing_Used( &pLoopbackContext->rxRing );
+        readLength = CommRing_Used( &pSocket->ring );
+
+        if( readLength > lastArgument )
+        {
+            readLength = lastArgument;
+        }
+
+        /* Only read what fits in the receive ring with the responses around it. */
+        if( rxFree < LOOPBACK_READ_RESERVE )
+        {
+            readLength = 0;
+        }
+        else if( readLength > ( rxFree - LOOPBACK_READ_RESERVE ) )
+        {
+            readLength = rxFree - LOOPBACK_READ_RESERVE;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+
+        _loopbackRespond( pLoopbackContext, pScript->pReadHeader, readLength );
+        pLoopbackContext->stats.socketRxBytes = pLoopbackContext->stats.socketRxBytes + readLength;
+
+        for( i = 0; i < readLength; i = i + spanLength )
+        {
+            spanLength = CommRing_GetReadSpan( &pSocket->ring, &pRead );
+
+            if( spanLength > ( readLength - i ) )
+            {
+                spanLength = readLength - i;
+            }
+
+            _loopbackPut( pLoopbackContext, pRead, spanLength );
+            CommRing_Release( &pSocket->ring, spanLength );
+        }
+
+        if( readLength > 0U )
+        {
+            _loopbackRespond( pLoopbackContext, pScript->pReadTrailer, 0U );
+        }
+
+        if( CommRing_Used( &pSocket->ring ) == 0U )
+        {
+            pSocket->notified = false;
+        }
+
+        _loopbackRespond( pLoopbackContext, pRule->pResponse, socketId );
+    }
+    else
+    {
+        pSocket = &pLoopbackContext->sockets[ socketId ];
+        CommRing_Release( &pSocket->ring, CommRing_Used( &pSocket->ring ) );
+        pSocket->notified = false;
+        _loopbackRespond( pLoopbackContext, pRule->pResponse, socketId );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _loopbackInput( _cellularLoopbackContext_t * pLoopbackContext,
+                            const uint8_t * pData,
+                            uint32_t length )
+{
+    uint32_t i = 0;
+    uint32_t copyLength = 0;
+
+    while( i < length )
+    {
+        if( pLoopbackContext->sendRemaining > 0U )
+        {
+            copyLength = pLoopbackContext->sendRemaining;
+
+            if( copyLength > ( length - i ) )
+            {
+                copyLength = length - i;
+            }
+
+            pLoopbackContext->stats.socketTxBytes = pLoopbackContext->stats.socketTxBytes + copyLength;
+
+            if( pLoopbackContext->peer != NULL )
+            {
+                pLoopbackContext->peer( pLoopbackContext->pPeerContext, pLoopbackContext->sendSocketId,
+                                        &pData[ i ], copyLength );
+            }
+            else
+            {
+                ( void ) _loopbackSocketPut( pLoopbackContext, pLoopbackContext->sendSocketId, &pData[ i ], copyLength );
+            }
+
+            pLoopbackContext->sendRemaining = pLoopbackContext->sendRemaining - copyLength;
+            i = i + copyLength;
+
+            if( pLoopbackContext->sendRemaining == 0U )
+            {
+                _loopbackRespond( pLoopbackContext, pLoopbackContext->pScript->pSendResponse,
+                                  pLoopbackContext->sendSocketId );
+            }
+        }
+        else
+        {
+            if( pData[ i ] == ( uint8_t ) '\r' )
+            {
+                pLoopbackContext->line[ pLoopbackContext->lineLength ] = '\0';
+
+                if( ( pLoopbackContext->lineOverflow == false ) && ( pLoopbackContext->lineLength > 0U ) )
+                {
+                    _loopbackCommand( pLoopbackContext );
+                }
+
+                pLoopbackContext->lineLength = 0;
+                pLoopbackContext->lineOverflow = false;
+            }
+            else if( pData[ i ] == ( uint8_t ) '\n' )
+            {
+                /* Line feeds after the carriage return are ignored. */
+            }
+            else if( pLoopbackContext->lineLength < ( LOOPBACK_LINE_MAX - 1U ) )
+            {
+                pLoopbackContext->line[ pLoopbackContext->lineLength ] = ( char ) pData[ i ];
+                pLoopbackContext->lineLength++;
+            }
+            else
+            {
+                pLoopbackContext->lineOverflow = true;
+            }
+
+            i++;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvLoopbackOpen( CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                      void * pUserData,
+                                                      CellularCommInterfaceHandle_t * pCommInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularLoopbackContext_t * pLoopbackContext = &_cellularLoopbackContext;
+    uint32_t socketId = 0;
+
+    if( ( pCommInterfaceHandle == NULL ) || ( receiveCallback == NULL ) || ( pLoopbackContext->pScript == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pLoopbackContext->opened == true )
+    {
+        CellularLogError( "Cellular comm loopback is opened already" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( PlatformMutex_Create( &pLoopbackContext->modelMutex, true ) == false )
+    {
+        CellularLogError( "Cellular comm loopback mutex create failed" );
+        commIntRet = IOT_COMM_INTERFACE_NO_MEMORY;
+    }
+    else
+    {
+        pLoopbackContext->receiveCallback = receiveCallback;
+        pLoopbackContext->pUserData = pUserData;
+        ( void ) memset( &pLoopbackContext->stats, 0, sizeof( CellularCommLoopbackStats_t ) );
+        pLoopbackContext->modelDepth = 0;
+        pLoopbackContext->rxNotify = false;
+        pLoopbackContext->lineLength = 0;
+        pLoopbackContext->lineOverflow = false;
+        pLoopbackContext->sendRemaining = 0;
+        CommRing_Init( &pLoopbackContext->rxRing, pLoopbackContext->rxRingBuffer, CELLULAR_COMM_LOOPBACK_RX_RING_SIZE );
+
+        for( socketId = 0; socketId < CELLULAR_COMM_LOOPBACK_SOCKETS; socketId++ )
+        {
+            CommRing_Init( &pLoopbackContext->sockets[ socketId ].ring, pLoopbackContext->sockets[ socketId ].ringBuffer,
+                           CELLULAR_COMM_LOOPBACK_SOCKET_BUFFER_SIZE );
+            pLoopbackContext->sockets[ socketId ].notified = false;
+        }
+
+        pLoopbackContext->opened = true;
+        *pCommInterfaceHandle = ( CellularCommInterfaceHandle_t ) pLoopbackContext;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvLoopbackSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                      const uint8_t * pData,
+                                                      uint32_t dataLength,
+                                                      uint32_t timeoutMilliseconds,
+                                                      uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularLoopbackContext_t * pLoopbackContext = ( _cellularLoopbackContext_t * ) commInterfaceHandle;
+
+    /* The model answers in this call, it never waits. */
+    ( void ) timeoutMilliseconds;
+
+    if( ( pLoopbackContext == NULL ) || ( pData == NULL ) || ( pDataSentLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pLoopbackContext->opened == false )
+    {
+        CellularLogError( "Cellular comm loopback send is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        _loopbackEnter( pLoopbackContext );
+        pLoopbackContext->stats.txBytes = pLoopbackContext->stats.txBytes + dataLength;
+        _loopbackInput( pLoopbackContext, pData, dataLength );
+        _loopbackLeave( pLoopbackContext );
+        *pDataSentLength = dataLength;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvLoopbackReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                         uint8_t * pBuffer,
+                                                         uint32_t bufferLength,
+                                                         uint32_t timeoutMilliseconds,
+                                                         uint32_t * pDataReceivedLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularLoopbackContext_t * pLoopbackContext = ( _cellularLoopbackContext_t * ) commInterfaceHandle;
+
+    /* Same as the physical comm interface, return immediately with the bytes received. */
+    ( void ) timeoutMilliseconds;
+
+    if( ( pLoopbackContext == NULL ) || ( pBuffer == NULL ) || ( pDataReceivedLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pLoopbackContext->opened == false )
+    {
+        CellularLogError( "Cellular comm loopback read is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        /* The model is the only producer of the receive ring, so no lock is taken. */
+        *pDataReceivedLength = CommRing_Read( &pLoopbackContext->rxRing, pBuffer, bufferLength );
+        pLoopbackContext->stats.rxBytes = pLoopbackContext->stats.rxBytes + *pDataReceivedLength;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvLoopbackClose( CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularLoopbackContext_t * pLoopbackContext = ( _cellularLoopbackContext_t * ) commInterfaceHandle;
+
+    if( pLoopbackContext == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( pLoopbackContext->opened == false )
+    {
+        CellularLogError( "Cellular comm loopback close is not opened" );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        /* Wait for a delivery in progress before the mutex is destroyed. */
+        PlatformMutex_Lock( &pLoopbackContext->modelMutex );
+        pLoopbackContext->opened = false;
+        pLoopbackContext->receiveCallback = NULL;
+        PlatformMutex_Unlock( &pLoopbackContext->modelMutex );
+        PlatformMutex_Destroy( &pLoopbackContext->modelMutex );
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterface_t * CellularCommLoopback_Get( const CellularCommLoopbackScript_t * pScript,
+                                                    CellularCommLoopbackPeer_t peer,
+                                                    void * pPeerContext )
+{
+    CellularCommInterface_t * pCommInterface = NULL;
+    _cellularLoopbackContext_t * pLoopbackContext = &_cellularLoopbackContext;
+
+    if( ( pScript == NULL ) || ( ( pScript->pRules == NULL ) && ( pScript->ruleCount > 0U ) ) )
+    {
+        CellularLogError( "Cellular comm loopback bad parameter" );
+    }
+    else if( pLoopbackContext->opened == true )
+    {
+        CellularLogError( "Cellular comm loopback is opened already" );
+    }
+    else
+    {
+        pLoopbackContext->pScript = pScript;
+        pLoopbackContext->peer = peer;
+        pLoopbackContext->pPeerContext = pPeerContext;
+        pCommInterface = &_cellularLoopbackInterface;
+    }
+
+    return pCommInterface;
+}
+
+/*-----------------------------------------------------------*/
+
+uint32_t CellularCommLoopback_Deliver( uint32_t socketId,
+                                       const uint8_t * pData,
+                                       uint32_t length )
+{
+    _cellularLoopbackContext_t * pLoopbackContext = &_cellularLoopbackContext;
+    uint32_t deliveredLength = 0;
+
+    if( ( pData == NULL ) || ( socketId >= CELLULAR_COMM_LOOPBACK_SOCKETS ) )
+    {
+        CellularLogError( "Cellular comm loopback deliver bad parameter" );
+    }
+    else if( pLoopbackContext->opened == false )
+    {
+        CellularLogError( "Cellular comm loopback deliver is not opened" );
+    }
+    else
+    {
+        _loopbackEnter( pLoopbackContext );
+        deliveredLength = _loopbackSocketPut( pLoopbackContext, socketId, pData, length );
+        _loopbackLeave( pLoopbackContext );
+    }
+
+    return deliveredLength;
+}
+
+/*-----------------------------------------------------------*/
+
+void CellularCommLoopback_GetStats( CellularCommLoopbackStats_t * pStats )
+{
+    if( pStats != NULL )
+    {
+        *pStats = _cellularLoopbackContext.stats;
+    }
+}
+
+/*-----------------------------------------------------------*/
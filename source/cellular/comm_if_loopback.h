@@ -0,0 +1,191 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_loopback.h
+ * @brief In-process comm interface connected to a scripted modem model.
+ *
+ * The loopback comm interface answers the AT commands of the cellular library
+ * from a script, in the send call that completes the command line. No port,
+ * thread or timer sits between the library and the model, so the time spent
+ * in Cellular_Init, setupCellular, the socket calls and the layers above them
+ * is the CPU cost of that code alone.
+ *
+ * Socket data sent by the library is passed to a peer function, or looped
+ * back to the same socket if there is none. Data for the library is queued
+ * with CellularCommLoopback_Deliver and read by the library with the read
+ * command of the script.
+ */
+
+#ifndef __COMM_IF_LOOPBACK_H__
+#define __COMM_IF_LOOPBACK_H__
+
+#include <stdint.h>
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Size of the ring of data for the library. Must be a power of two.
+ */
+#ifndef CELLULAR_COMM_LOOPBACK_RX_RING_SIZE
+    #define CELLULAR_COMM_LOOPBACK_RX_RING_SIZE    ( 8192U )
+#endif
+
+/**
+ * @brief Number of sockets of the modem model, the socket ID range of the script.
+ */
+#ifndef CELLULAR_COMM_LOOPBACK_SOCKETS
+    #define CELLULAR_COMM_LOOPBACK_SOCKETS    ( 4U )
+#endif
+
+/**
+ * @brief Data buffered for each socket until the library reads it. Must be a power of two.
+ */
+#ifndef CELLULAR_COMM_LOOPBACK_SOCKET_BUFFER_SIZE
+    #define CELLULAR_COMM_LOOPBACK_SOCKET_BUFFER_SIZE    ( 4096U )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief What the modem model does for a command matched by a script rule.
+ */
+typedef enum CellularCommLoopbackAction
+{
+    CELLULAR_COMM_LOOPBACK_RESPOND = 0, /**< Send the response of the rule. */
+    CELLULAR_COMM_LOOPBACK_SEND_DATA,   /**< Send the response of the rule, a data prompt, then take the last argument in bytes as socket data. */
+    CELLULAR_COMM_LOOPBACK_READ_DATA,   /**< Send up to the last argument in bytes of socket data, then the response of the rule. */
+    CELLULAR_COMM_LOOPBACK_CLOSE        /**< Drop the buffered socket data, then send the response of the rule. */
+} CellularCommLoopbackAction_t;
+
+/**
+ * @brief Script rule.
+ *
+ * A response may contain "%u", which is replaced by the socket ID.
+ */
+typedef struct CellularCommLoopbackRule
+{
+    const char * pCommand;               /**< Prefix of the command lines the rule matches, for example "AT+CPIN?". */
+    const char * pResponse;              /**< Response, for example "\r\n+CPIN: READY\r\n\r\nOK\r\n". */
+    CellularCommLoopbackAction_t action; /**< What the model does for the command. */
+    uint8_t socketArgument;              /**< Index of the argument holding the socket ID. */
+} CellularCommLoopbackRule_t;
+
+/**
+ * @brief Modem model script. The first rule matching a command line is used.
+ */
+typedef struct CellularCommLoopbackScript
+{
+    const CellularCommLoopbackRule_t * pRules; /**< Rules in match order. */
+    uint32_t ruleCount;                        /**< Number of rules. */
+    const char * pDefaultResponse;             /**< Response to command lines no rule matches. */
+    const char * pSendResponse;                /**< Response after the socket data of a SEND_DATA command. */
+    const char * pReadHeader;                  /**< Response before the socket data of a READ_DATA command. "%u" is the data length. */
+    const char * pReadTrailer;                 /**< Response after the socket data of a READ_DATA command, if there is data. */
+    const char * pRecvUrc;                     /**< URC reporting data to a socket with no data reported yet. */
+} CellularCommLoopbackScript_t;
+
+/**
+ * @brief Peer of the sockets of the modem model.
+ *
+ * Called with the socket data sent by the library, in the send call of the
+ * library. It may call CellularCommLoopback_Deliver to answer.
+ *
+ * @param[in] pPeerContext Context given to CellularCommLoopback_Get.
+ * @param[in] socketId Socket the data is sent to.
+ * @param[in] pData Socket data.
+ * @param[in] length Number of bytes in pData.
+ */
+typedef void ( * CellularCommLoopbackPeer_t )( void * pPeerContext,
+                                               uint32_t socketId,
+                                               const uint8_t * pData,
+                                               uint32_t length );
+
+/**
+ * @brief Loopback counters, to normalize benchmark results.
+ */
+typedef struct CellularCommLoopbackStats
+{
+    uint32_t commandCount;   /**< Command lines answered. */
+    uint32_t unmatchedCount; /**< Command lines answered with the default response. */
+    uint32_t txBytes;        /**< Bytes sent by the library. */
+    uint32_t rxBytes;        /**< Bytes read by the library. */
+    uint32_t socketTxBytes;  /**< Socket data sent by the library. */
+    uint32_t socketRxBytes;  /**< Socket data read by the library. */
+    uint32_t dropBytes;      /**< Bytes dropped because a ring or socket buffer was full. */
+} CellularCommLoopbackStats_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Script of a BG96 that is registered on the network with PDN context 1 active.
+ */
+extern const CellularCommLoopbackScript_t CellularCommLoopbackBg96Script;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the loopback comm interface.
+ *
+ * @param[in] pScript Modem model script. Must stay valid until the comm interface is closed.
+ * @param[in] peer Peer of the sockets. NULL to send the socket data back to the same socket.
+ * @param[in] pPeerContext Context passed to peer.
+ *
+ * @return The loopback comm interface. NULL if a parameter is invalid.
+ */
+CellularCommInterface_t * CellularCommLoopback_Get( const CellularCommLoopbackScript_t * pScript,
+                                                    CellularCommLoopbackPeer_t peer,
+                                                    void * pPeerContext );
+
+/**
+ * @brief Queue socket data for the library.
+ *
+ * Sends the receive URC of the script if the socket has no data reported yet.
+ *
+ * @param[in] socketId Socket of the data.
+ * @param[in] pData Socket data.
+ * @param[in] length Number of bytes in pData.
+ *
+ * @return Number of bytes queued. Less than length if the socket buffer is full.
+ */
+uint32_t CellularCommLoopback_Deliver( uint32_t socketId,
+                                       const uint8_t * pData,
+                                       uint32_t length );
+
+/**
+ * @brief Get the counters since the loopback comm interface was opened.
+ *
+ * @param[out] pStats The counters.
+ */
+void CellularCommLoopback_GetStats( CellularCommLoopbackStats_t * pStats );
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_LOOPBACK_H__ */
@@ -0,0 +1,1835 @@
+/*
+ * Amazon FreeRTOS Cellular Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/**
+ * @file comm_if_posix.c
+ * @brief POSIX termios implementation of the cellular comm interface.
+ *
+ * The comm interface opens a tty or pty in raw mode. A native receive thread
+ * blocks in epoll_wait() on the port and reads the pending bytes into a
+ * receive ring as soon as they arrive.
+ *
+ * The receive callback of the cellular library ends in the FromISR event
+ * group functions. With the pthread kernel of source/posix every task is a
+ * native thread, so the receive thread calls the callback itself and receive
+ * latency is bounded by the kernel wake-up time. The FreeRTOS POSIX port has
+ * no way for a native thread to wake a task, so the comm interface does not
+ * build there rather than poll the receive thread on a timer.
+ */
+
+/*-----------------------------------------------------------*/
+
+/* POSIX include files for serial port I/O. */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Platform layer includes. */
+#include "cellular_platform.h"
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+#include "comm_if.h"
+
+/* Receive ring include file. */
+#include "comm_if_ring.h"
+
+/* Wire trace include file. */
+#include "comm_if_trace.h"
+
+/* Receive burst include file. */
+#include "comm_if_burst.h"
+
+/* Statistics include file. */
+#include "comm_if_stats.h"
+
+/*-----------------------------------------------------------*/
+
+/* Define the tty devices used by the comm interface instances, for example "/dev/ttyUSB2". */
+#ifndef CELLULAR_COMM_INTERFACE_PORT_LIST
+    #ifndef CELLULAR_COMM_INTERFACE_PORT
+        #error "Define CELLULAR_COMM_INTERFACE_PORT or CELLULAR_COMM_INTERFACE_PORT_LIST in cellular_config.h"
+    #endif
+    #ifdef CELLULAR_COMM_INTERFACE_DATA_PORT
+        #define CELLULAR_COMM_INTERFACE_PORT_LIST    { CELLULAR_COMM_INTERFACE_PORT, CELLULAR_COMM_INTERFACE_DATA_PORT }
+    #else
+        #define CELLULAR_COMM_INTERFACE_PORT_LIST    { CELLULAR_COMM_INTERFACE_PORT }
+    #endif
+#endif
+
+/* Line rate the modem answers at after power on. */
+#define COMM_DEFAULT_BAUD_RATE               ( 115200U )
+
+/* Negotiate the line rate and flow control with the modem in open. */
+#if ( CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE ) || ( CELLULAR_COMM_INTERFACE_FLOW_CONTROL == 1 )
+    #define COMM_IF_NEGOTIATE_LINE_SETTINGS    ( 1 )
+#else
+    #define COMM_IF_NEGOTIATE_LINE_SETTINGS    ( 0 )
+#endif
+
+/* Time to wait for the modem response to a negotiation AT command. */
+#define COMM_AT_RESPONSE_TIMEOUT_MS          ( 500 )
+
+/* Size of the buffer holding the echo and response of a negotiation AT command. */
+#define COMM_AT_RESPONSE_BUFFER_SIZE         ( 64U )
+
+/* Number of AT commands sent to check the modem answers at a line rate. */
+#define COMM_AT_PROBE_RETRY                  ( 3U )
+
+/* Size of the receive ring filled by the receive thread. Must be a power of two. */
+#define COMM_RX_RING_SIZE                    ( 8192U )
+
+/* Size of the transmit ring drained by the writer thread. Must be a power of two. */
+#define COMM_TX_RING_SIZE                    ( 8192U )
+
+/* Time close waits for the writer thread to write the transmit ring in ms. */
+#define COMM_TX_DRAIN_TIMEOUT_MS             ( 1000U )
+
+/* Number of epoll events handled per epoll_wait call. */
+#define COMM_RECV_THREAD_MAX_EVENTS          ( 2 )
+
+/* Comm status. */
+#define CELLULAR_COMM_OPEN_BIT               ( 0x01U )
+
+/* The receive and transmit callbacks are called from the native threads of the
+ * comm interface, which only the pthread kernel of source/posix allows. A kernel
+ * port whose native threads may call the FromISR functions can define
+ * portNATIVE_THREADS_CALL_KERNEL in its portmacro.h. */
+#ifndef portNATIVE_THREADS_CALL_KERNEL
+    #error "comm_if_posix.c needs a kernel whose native threads may call the FromISR functions, build it with the kernel of source/posix."
+#endif
+
+/*-----------------------------------------------------------*/
+
+typedef struct _cellularCommContext
+{
+    CellularCommInterfaceReceiveCallback_t commReceiveCallback;
+    pthread_t commReceiveCallbackThread;
+    bool commReceiveCallbackThreadStarted;
+    uint8_t commStatus;
+    void * pUserData;
+    int commFileDescriptor;
+    int commEpollDescriptor;
+    int commAbortEventDescriptor;
+    CellularCommInterface_t * pCommInterface;
+    volatile bool commRxStalled; /* Receive thread stopped reading on a full ring. */
+    CommRing_t commRxRing;
+    uint8_t commRxRingBuffer[ COMM_RX_RING_SIZE ];
+    uint32_t instanceIndex;
+    const char * pCommPath;
+    uint32_t commBaudRate; /* Line rate of the port, times the receive idle timeout. */
+    #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+        CommBurst_t commRxBurst; /* Bytes read since the last receive callback. */
+    #endif
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        pthread_t commTransmitThread;
+        bool commTransmitThreadStarted;
+        int commTxDataEventDescriptor;  /* Signaled by send when data is queued. */
+        int commTxSpaceEventDescriptor; /* Signaled by the writer thread when space is released. */
+        CellularCommInterfaceTxCallback_t commTxCallback;
+        void * pTxUserData;
+        CellularCommInterfaceError_t commTxStatus; /* Last write error, cleared by send. */
+        uint32_t commTxCompletedLength;            /* Bytes written since the last transmit callback. */
+        CommRing_t commTxRing;
+        uint8_t commTxRingBuffer[ COMM_TX_RING_SIZE ];
+    #endif
+    #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+        CommTrace_t commTrace; /* Cleared by open and kept after close, so a dump shows the last session. */
+    #endif
+    #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+        CommStats_t commStats;
+    #endif
+} _cellularCommContext_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief CellularCommInterfaceOpen_t implementation of an instance.
+ *
+ * CellularCommInterfaceOpen_t has no parameter to select the port, so every
+ * instance has its own open function calling this one with its index.
+ */
+static CellularCommInterfaceError_t _prvCommIntfOpenInstance( uint32_t instanceIndex,
+                                                              CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                              void * pUserData,
+                                                              CellularCommInterfaceHandle_t * pCommInterfaceHandle );
+
+/**
+ * @brief CellularCommInterfaceSend_t implementation.
+ */
+static CellularCommInterfaceError_t _prvCommIntfSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                      const uint8_t * pData,
+                                                      uint32_t dataLength,
+                                                      uint32_t timeoutMilliseconds,
+                                                      uint32_t * pDataSentLength );
+
+/**
+ * @brief CellularCommInterfaceRecv_t implementation.
+ */
+static CellularCommInterfaceError_t _prvCommIntfReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                         uint8_t * pBuffer,
+                                                         uint32_t bufferLength,
+                                                         uint32_t timeoutMilliseconds,
+                                                         uint32_t * pDataReceivedLength );
+
+/**
+ * @brief CellularCommInterfaceClose_t implementation.
+ */
+static CellularCommInterfaceError_t _prvCommIntfClose( CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Get the comm interface context of an instance.
+ *
+ * @param[in] instanceIndex Index of the instance.
+ *
+ * @return The context of the instance. NULL if instanceIndex is out of range.
+ */
+static _cellularCommContext_t * _getCellularCommContext( uint32_t instanceIndex );
+
+/**
+ * @brief Map a line rate in bits per second to a termios speed.
+ *
+ * @param[in] baudRate Line rate in bits per second.
+ *
+ * @return The termios speed. B0 if the rate is not supported.
+ */
+static speed_t _commBaudRateToSpeed( uint32_t baudRate );
+
+/**
+ * @brief Set tty line settings. The port is put in raw 8N1 mode.
+ *
+ * @param[in] commFd File descriptor of the opened tty.
+ * @param[in] baudRate Line rate in bits per second.
+ * @param[in] flowControl Enable RTS/CTS hardware flow control.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _setupCommSettings( int commFd,
+                                                        uint32_t baudRate,
+                                                        bool flowControl );
+
+#if ( COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 )
+
+/**
+ * @brief Send an AT command and wait for the modem to answer OK.
+ *
+ * Only used in open, before the receive thread reads the tty.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ * @param[in] pCommand AT command terminated with a carriage return.
+ *
+ * @return true if the modem answered OK.
+ */
+static bool _commAtCommand( _cellularCommContext_t * pCellularCommContext,
+                            const char * pCommand );
+
+#if ( CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE )
+
+/**
+ * @brief Check the modem answers AT at the current line rate.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return true if the modem answered OK.
+ */
+static bool _commProbeModem( _cellularCommContext_t * pCellularCommContext );
+
+#endif
+
+/**
+ * @brief Negotiate the line rate and flow control with the modem.
+ *
+ * The rate is requested with AT+IPR and flow control with AT+IFC. The tty
+ * falls back to 115200 without flow control if the modem does not accept
+ * the configured settings.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _commNegotiateLineSettings( _cellularCommContext_t * pCellularCommContext );
+
+#endif /* COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 */
+
+/**
+ * @brief Register the tty and the abort eventfd with the epoll instance.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _setupCommEpoll( _cellularCommContext_t * pCellularCommContext );
+
+/**
+ * @brief Re-arm the one-shot receive event of the tty.
+ *
+ * The receive thread reports a readable port only once. The event is armed
+ * again after the port is drained into the ring, or by recv after it freed
+ * space in a full ring, so the receive thread never spins on a port it can
+ * not read.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ */
+static void _rearmCommRxEvent( const _cellularCommContext_t * pCellularCommContext );
+
+/**
+ * @brief Read the bytes pending in the tty into the receive ring.
+ *
+ * Called only from the receive thread, which is the single producer of the ring.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return Number of bytes added to the ring.
+ */
+static uint32_t _commRxFill( _cellularCommContext_t * pCellularCommContext );
+
+/**
+ * @brief Call the receive callback of the instance.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ */
+static void _commCallReceiveCallback( _cellularCommContext_t * pCellularCommContext );
+
+/**
+ * @brief Communication receiver thread function.
+ *
+ * @param[in] pArgument Pointer to _cellularCommContext_t allocated in comm interface open.
+ *
+ * @return Always NULL.
+ */
+static void * _CellularCommReceiveCBThreadFunc( void * pArgument );
+
+
+/**
+ * @brief Stop the receive, writer and comm task threads and wait for them to exit.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _cleanCommThreads( _cellularCommContext_t * pCellularCommContext );
+
+/**
+ * @brief Write send data to the tty and wait for the write to complete.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _commTxWrite( _cellularCommContext_t * pCellularCommContext,
+                                                  const uint8_t * pData,
+                                                  uint32_t dataLength,
+                                                  uint32_t timeoutMilliseconds,
+                                                  uint32_t * pDataSentLength );
+
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+
+/**
+ * @brief Create the eventfds used between send and the writer thread.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _setupCommTxEvents( _cellularCommContext_t * pCellularCommContext );
+
+/**
+ * @brief Call the transmit callback of the instance.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ * @param[in] txStatus IOT_COMM_INTERFACE_SUCCESS or the error of the write.
+ */
+static void _commCallTxCallback( _cellularCommContext_t * pCellularCommContext,
+                                 CellularCommInterfaceError_t txStatus );
+
+/**
+ * @brief Release written bytes of the transmit ring and report completion.
+ *
+ * Called only from the writer thread, which is the single consumer of the ring.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ * @param[in] length Number of bytes written or dropped.
+ * @param[in] txStatus IOT_COMM_INTERFACE_SUCCESS or the error of the write.
+ */
+static void _commTxRelease( _cellularCommContext_t * pCellularCommContext,
+                            uint32_t length,
+                            CellularCommInterfaceError_t txStatus );
+
+/**
+ * @brief Communication writer thread function.
+ *
+ * @param[in] pArgument Pointer to _cellularCommContext_t allocated in comm interface open.
+ *
+ * @return Always NULL.
+ */
+static void * _CellularCommTransmitThreadFunc( void * pArgument );
+
+/**
+ * @brief Copy send data into the transmit ring.
+ *
+ * Waits up to timeoutMilliseconds for the writer thread to release space
+ * when the ring is full.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _commTxQueue( _cellularCommContext_t * pCellularCommContext,
+                                                  const uint8_t * pData,
+                                                  uint32_t dataLength,
+                                                  uint32_t timeoutMilliseconds,
+                                                  uint32_t * pDataSentLength );
+
+/**
+ * @brief Wait up to COMM_TX_DRAIN_TIMEOUT_MS for the writer thread to write the transmit ring.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return Bytes left in the transmit ring.
+ */
+static uint32_t _commTxDrain( _cellularCommContext_t * pCellularCommContext );
+
+#endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
+
+/**
+ * @brief Release the file descriptors owned by the comm interface context.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _cleanCommDescriptors( _cellularCommContext_t * pCellularCommContext );
+
+/*-----------------------------------------------------------*/
+
+/* Open functions of the instances, CellularCommInterface and the instance accessors. */
+#include "comm_if_instances.h"
+
+/*-----------------------------------------------------------*/
+
+static _cellularCommContext_t _iotCellularCommContexts[ CELLULAR_COMM_INTERFACE_MAX_INSTANCES ] = { 0 };
+
+static const char * _iotCellularCommPorts[ CELLULAR_COMM_INTERFACE_MAX_INSTANCES ] = CELLULAR_COMM_INTERFACE_PORT_LIST;
+
+/*-----------------------------------------------------------*/
+
+static _cellularCommContext_t * _getCellularCommContext( uint32_t instanceIndex )
+{
+    _cellularCommContext_t * pCellularCommContext = NULL;
+
+    if( instanceIndex < CELLULAR_COMM_INTERFACE_MAX_INSTANCES )
+    {
+        pCellularCommContext = &_iotCellularCommContexts[ instanceIndex ];
+    }
+
+    return pCellularCommContext;
+}
+
+/*-----------------------------------------------------------*/
+
+static speed_t _commBaudRateToSpeed( uint32_t baudRate )
+{
+    speed_t speed = B0;
+
+    switch( baudRate )
+    {
+        case 9600U:
+            speed = B9600;
+            break;
+
+        case 19200U:
+            speed = B19200;
+            break;
+
+        case 38400U:
+            speed = B38400;
+            break;
+
+        case 57600U:
+            speed = B57600;
+            break;
+
+        case 115200U:
+            speed = B115200;
+            break;
+
+        case 230400U:
+            speed = B230400;
+            break;
+
+        #ifdef B460800
+            case 460800U:
+                speed = B460800;
+                break;
+        #endif
+
+        #ifdef B921600
+            case 921600U:
+                speed = B921600;
+                break;
+        #endif
+
+        #ifdef B3000000
+            case 3000000U:
+                speed = B3000000;
+                break;
+        #endif
+
+        default:
+            speed = B0;
+            break;
+    }
+
+    return speed;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _setupCommSettings( int commFd,
+                                                        uint32_t baudRate,
+                                                        bool flowControl )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    struct termios commSettings = { 0 };
+    speed_t speed = _commBaudRateToSpeed( baudRate );
+
+    if( speed == B0 )
+    {
+        CellularLogError( "Cellular line rate %u is not supported", baudRate );
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( tcgetattr( commFd, &commSettings ) != 0 )
+    {
+        CellularLogError( "Cellular tcgetattr fail %d", errno );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        cfmakeraw( &commSettings );
+        commSettings.c_cflag &= ~( ( tcflag_t ) ( CSTOPB | PARENB | CRTSCTS ) );
+        commSettings.c_cflag |= ( tcflag_t ) ( CS8 | CLOCAL | CREAD );
+
+        if( flowControl == true )
+        {
+            commSettings.c_cflag |= ( tcflag_t ) CRTSCTS;
+        }
+
+        /* Reads never block in the driver. Waiting is done by the receive thread. */
+        commSettings.c_cc[ VMIN ] = 0;
+        commSettings.c_cc[ VTIME ] = 0;
+
+        if( ( cfsetispeed( &commSettings, speed ) != 0 ) ||
+            ( cfsetospeed( &commSettings, speed ) != 0 ) )
+        {
+            CellularLogError( "Cellular cfsetspeed fail %d", errno );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+        else if( tcsetattr( commFd, TCSANOW, &commSettings ) != 0 )
+        {
+            CellularLogError( "Cellular tcsetattr fail %d", errno );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+        else
+        {
+            ( void ) tcflush( commFd, TCIOFLUSH );
+        }
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 )
+
+static bool _commAtCommand( _cellularCommContext_t * pCellularCommContext,
+                            const char * pCommand )
+{
+    struct pollfd commPollFd = { 0 };
+    uint64_t startTimeMs = 0;
+    char response[ COMM_AT_RESPONSE_BUFFER_SIZE ] = { 0 };
+    uint32_t responseLength = 0;
+    uint32_t sentLength = 0;
+    int64_t elapsedTime = 0;
+    ssize_t readRet = 0;
+    bool okReceived = false;
+    bool errorReceived = false;
+
+    commPollFd.fd = pCellularCommContext->commFileDescriptor;
+    commPollFd.events = POLLIN;
+
+    /* Drop anything the modem sent before the command. */
+    ( void ) tcflush( commPollFd.fd, TCIFLUSH );
+
+    if( _commTxWrite( pCellularCommContext, ( const uint8_t * ) pCommand, ( uint32_t ) strlen( pCommand ),
+                      COMM_AT_RESPONSE_TIMEOUT_MS, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        startTimeMs = Platform_GetTimeMs();
+
+        while( ( okReceived == false ) && ( errorReceived == false ) && ( elapsedTime < COMM_AT_RESPONSE_TIMEOUT_MS ) )
+        {
+            if( poll( &commPollFd, 1, ( int ) ( COMM_AT_RESPONSE_TIMEOUT_MS - elapsedTime ) ) > 0 )
+            {
+                readRet = read( commPollFd.fd, &response[ responseLength ],
+                                sizeof( response ) - 1U - responseLength );
+
+                if( readRet > 0 )
+                {
+                    #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+                        CommTrace_Record( &pCellularCommContext->commTrace, COMM_TRACE_RX,
+                                          ( const uint8_t * ) &response[ responseLength ], ( uint32_t ) readRet );
+                    #endif
+                    responseLength = responseLength + ( uint32_t ) readRet;
+                    response[ responseLength ] = '\0';
+                    okReceived = ( strstr( response, "OK\r\n" ) != NULL );
+                    errorReceived = ( strstr( response, "ERROR" ) != NULL );
+                }
+
+                /* Keep the tail of a long echo, it may hold a partial response. */
+                if( responseLength == ( sizeof( response ) - 1U ) )
+                {
+                    ( void ) memmove( response, &response[ responseLength - 4U ], 4U );
+                    responseLength = 4U;
+                }
+            }
+
+            elapsedTime = ( int64_t ) ( Platform_GetTimeMs() - startTimeMs );
+        }
+    }
+
+    return okReceived;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE )
+
+static bool _commProbeModem( _cellularCommContext_t * pCellularCommContext )
+{
+    bool okReceived = false;
+    uint32_t retry = 0;
+
+    /* The first command after a rate change may be lost while the modem switches. */
+    for( retry = 0; ( retry < COMM_AT_PROBE_RETRY ) && ( okReceived == false ); retry++ )
+    {
+        okReceived = _commAtCommand( pCellularCommContext, "AT\r" );
+    }
+
+    return okReceived;
+}
+
+#endif /* CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE */
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _commNegotiateLineSettings( _cellularCommContext_t * pCellularCommContext )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    int commFd = pCellularCommContext->commFileDescriptor;
+    uint32_t baudRate = COMM_DEFAULT_BAUD_RATE;
+    bool flowControl = false;
+
+    #if ( CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE )
+        char atCommand[ 32 ] = { 0 };
+
+        if( _commProbeModem( pCellularCommContext ) == false )
+        {
+            /* The modem may still run at the rate negotiated in a previous session. */
+            if( ( _setupCommSettings( commFd, CELLULAR_COMM_INTERFACE_BAUD_RATE, false ) == IOT_COMM_INTERFACE_SUCCESS ) &&
+                ( _commProbeModem( pCellularCommContext ) == true ) )
+            {
+                baudRate = CELLULAR_COMM_INTERFACE_BAUD_RATE;
+            }
+        }
+        else
+        {
+            ( void ) snprintf( atCommand, sizeof( atCommand ), "AT+IPR=%u\r", CELLULAR_COMM_INTERFACE_BAUD_RATE );
+
+            /* The modem answers OK at the old rate and switches after the response. */
+            if( _commAtCommand( pCellularCommContext, atCommand ) == true )
+            {
+                if( ( _setupCommSettings( commFd, CELLULAR_COMM_INTERFACE_BAUD_RATE, false ) == IOT_COMM_INTERFACE_SUCCESS ) &&
+                    ( _commProbeModem( pCellularCommContext ) == true ) )
+                {
+                    baudRate = CELLULAR_COMM_INTERFACE_BAUD_RATE;
+                }
+                else
+                {
+                    /* Ask the modem to go back to the default rate in case it switched. */
+                    ( void ) _commAtCommand( pCellularCommContext, "AT+IPR=115200\r" );
+                }
+            }
+        }
+
+        if( baudRate != CELLULAR_COMM_INTERFACE_BAUD_RATE )
+        {
+            CellularLogWarn( "Cellular comm %u line rate %u not accepted, fall back to %u",
+                             pCellularCommContext->instanceIndex, CELLULAR_COMM_INTERFACE_BAUD_RATE, baudRate );
+            commIntRet = _setupCommSettings( commFd, baudRate, false );
+        }
+    #endif /* CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE */
+
+    #if ( CELLULAR_COMM_INTERFACE_FLOW_CONTROL == 1 )
+        if( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) &&
+            ( _commAtCommand( pCellularCommContext, "AT+IFC=2,2\r" ) == true ) )
+        {
+            flowControl = true;
+            commIntRet = _setupCommSettings( commFd, baudRate, flowControl );
+        }
+    #else
+        /* Only read by the log. */
+        ( void ) flowControl;
+    #endif
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        pCellularCommContext->commBaudRate = baudRate;
+        CellularLogInfo( "Cellular comm %u line rate %u, flow control %s",
+                         pCellularCommContext->instanceIndex, baudRate, ( flowControl == true ) ? "on" : "off" );
+    }
+
+    return commIntRet;
+}
+
+#endif /* COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 */
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _setupCommEpoll( _cellularCommContext_t * pCellularCommContext )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    struct epoll_event commEvent = { 0 };
+
+    pCellularCommContext->commEpollDescriptor = epoll_create1( EPOLL_CLOEXEC );
+
+    if( pCellularCommContext->commEpollDescriptor < 0 )
+    {
+        CellularLogError( "Cellular epoll_create1 fail %d", errno );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        pCellularCommContext->commAbortEventDescriptor = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+
+        if( pCellularCommContext->commAbortEventDescriptor < 0 )
+        {
+            CellularLogError( "Cellular eventfd fail %d", errno );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        commEvent.events = EPOLLIN;
+        commEvent.data.fd = pCellularCommContext->commAbortEventDescriptor;
+
+        if( epoll_ctl( pCellularCommContext->commEpollDescriptor, EPOLL_CTL_ADD,
+                       pCellularCommContext->commAbortEventDescriptor, &commEvent ) != 0 )
+        {
+            CellularLogError( "Cellular epoll_ctl abort event fail %d", errno );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        commEvent.events = EPOLLIN | EPOLLONESHOT;
+        commEvent.data.fd = pCellularCommContext->commFileDescriptor;
+
+        if( epoll_ctl( pCellularCommContext->commEpollDescriptor, EPOLL_CTL_ADD,
+                       pCellularCommContext->commFileDescriptor, &commEvent ) != 0 )
+        {
+            CellularLogError( "Cellular epoll_ctl comm port fail %d", errno );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _rearmCommRxEvent( const _cellularCommContext_t * pCellularCommContext )
+{
+    struct epoll_event commEvent = { 0 };
+
+    commEvent.events = EPOLLIN | EPOLLONESHOT;
+    commEvent.data.fd = pCellularCommContext->commFileDescriptor;
+
+    if( epoll_ctl( pCellularCommContext->commEpollDescriptor, EPOLL_CTL_MOD,
+                   pCellularCommContext->commFileDescriptor, &commEvent ) != 0 )
+    {
+        CellularLogDebug( "Cellular epoll_ctl rearm fail %d", errno );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t _commRxFill( _cellularCommContext_t * pCellularCommContext )
+{
+    CommRing_t * pRing = &pCellularCommContext->commRxRing;
+    uint8_t * pWrite = NULL;
+    uint32_t spanLength = 0;
+    uint32_t totalRead = 0;
+    ssize_t readRet = 0;
+    int pendingLength = 0;
+    bool rearm = true;
+
+    while( true )
+    {
+        spanLength = CommRing_GetWriteSpan( pRing, &pWrite );
+
+        if( spanLength == 0U )
+        {
+            /* Ring is full. Leave the port disarmed until recv frees space. */
+            pCellularCommContext->commRxStalled = true;
+            COMM_RING_MEMORY_BARRIER();
+
+            /* Check again in case recv freed space before it could see the flag. */
+            if( CommRing_GetWriteSpan( pRing, &pWrite ) == 0U )
+            {
+                if( ( ioctl( pCellularCommContext->commFileDescriptor, FIONREAD, &pendingLength ) == 0 ) &&
+                    ( pendingLength > 0 ) )
+                {
+                    pRing->overrunCount++;
+                }
+
+                rearm = false;
+                break;
+            }
+
+            pCellularCommContext->commRxStalled = false;
+            continue;
+        }
+
+        readRet = read( pCellularCommContext->commFileDescriptor, pWrite, spanLength );
+
+        if( readRet > 0 )
+        {
+            #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+                CommTrace_Record( &pCellularCommContext->commTrace, COMM_TRACE_RX, pWrite, ( uint32_t ) readRet );
+            #endif
+            #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+                CommBurst_Add( &pCellularCommContext->commRxBurst, pWrite, ( uint32_t ) readRet );
+            #endif
+            #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                CommStats_Read( &pCellularCommContext->commStats, ( uint32_t ) readRet );
+            #endif
+            CommRing_Commit( pRing, ( uint32_t ) readRet );
+            totalRead = totalRead + ( uint32_t ) readRet;
+        }
+        else if( ( readRet < 0 ) && ( errno == EINTR ) )
+        {
+            continue;
+        }
+        else
+        {
+            /* Port is drained. EAGAIN or peer closed. */
+            break;
+        }
+    }
+
+    if( rearm == true )
+    {
+        _rearmCommRxEvent( pCellularCommContext );
+    }
+
+    return totalRead;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _commCallReceiveCallback( _cellularCommContext_t * pCellularCommContext )
+{
+    CellularCommInterfaceReceiveCallback_t receiveCallback = pCellularCommContext->commReceiveCallback;
+
+    if( receiveCallback != NULL )
+    {
+        #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+            CommStats_Callback( &pCellularCommContext->commStats );
+        #endif
+        ( void ) receiveCallback( pCellularCommContext->pUserData,
+                                  ( CellularCommInterfaceHandle_t ) pCellularCommContext );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void * _CellularCommReceiveCBThreadFunc( void * pArgument )
+{
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) pArgument;
+    struct epoll_event commEvents[ COMM_RECV_THREAD_MAX_EVENTS ];
+    bool threadExit = false;
+    bool rxNotify = false;
+    int waitTimeout = -1;
+    int eventCount = 0;
+    int i = 0;
+
+    while( threadExit == false )
+    {
+        #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+            /* Wait for the line to go idle while a burst is collected. */
+            waitTimeout = ( pCellularCommContext->commRxBurst.length > 0U ) ?
+                          ( int ) CommBurst_IdleTimeoutMs( pCellularCommContext->commBaudRate ) : -1;
+        #endif
+
+        eventCount = epoll_wait( pCellularCommContext->commEpollDescriptor, commEvents,
+                                 COMM_RECV_THREAD_MAX_EVENTS, waitTimeout );
+        rxNotify = false;
+
+        if( eventCount < 0 )
+        {
+            if( errno != EINTR )
+            {
+                CellularLogInfo( "Cellular receiver thread epoll_wait error %d", errno );
+                threadExit = true;
+            }
+        }
+        else if( eventCount == 0 )
+        {
+            /* The line is idle, the burst is complete. */
+            rxNotify = true;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+
+        for( i = 0; i < eventCount; i++ )
+        {
+            if( commEvents[ i ].data.fd == pCellularCommContext->commAbortEventDescriptor )
+            {
+                /* Comm interface is closing. */
+                threadExit = true;
+            }
+            else if( ( commEvents[ i ].events & ( EPOLLHUP | EPOLLERR ) ) != 0U )
+            {
+                /* Device removed or pty peer closed. */
+                CellularLogInfo( "Cellular comm port %s closed by peer", pCellularCommContext->pCommPath );
+                threadExit = true;
+            }
+            else if( _commRxFill( pCellularCommContext ) > 0U )
+            {
+                #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+                    /* A full ring can only be drained by recv, don't wait for the line to go idle. */
+                    rxNotify = ( CommBurst_Complete( &pCellularCommContext->commRxBurst ) == true ) ||
+                               ( pCellularCommContext->commRxStalled == true );
+                #else
+                    rxNotify = true;
+                #endif
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+
+        if( ( rxNotify == true ) && ( threadExit == false ) )
+        {
+            #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+                CommBurst_Reset( &pCellularCommContext->commRxBurst );
+            #endif
+
+            /* Call the receive callback once for all the bytes read. */
+            _commCallReceiveCallback( pCellularCommContext );
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _cleanCommDescriptors( _cellularCommContext_t * pCellularCommContext )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+
+    if( pCellularCommContext->commFileDescriptor >= 0 )
+    {
+        if( close( pCellularCommContext->commFileDescriptor ) != 0 )
+        {
+            CellularLogDebug( "Cellular close comm port fail %d", errno );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+
+        pCellularCommContext->commFileDescriptor = -1;
+    }
+
+    if( pCellularCommContext->commEpollDescriptor >= 0 )
+    {
+        ( void ) close( pCellularCommContext->commEpollDescriptor );
+        pCellularCommContext->commEpollDescriptor = -1;
+    }
+
+    if( pCellularCommContext->commAbortEventDescriptor >= 0 )
+    {
+        ( void ) close( pCellularCommContext->commAbortEventDescriptor );
+        pCellularCommContext->commAbortEventDescriptor = -1;
+    }
+
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        if( pCellularCommContext->commTxDataEventDescriptor >= 0 )
+        {
+            ( void ) close( pCellularCommContext->commTxDataEventDescriptor );
+            pCellularCommContext->commTxDataEventDescriptor = -1;
+        }
+
+        if( pCellularCommContext->commTxSpaceEventDescriptor >= 0 )
+        {
+            ( void ) close( pCellularCommContext->commTxSpaceEventDescriptor );
+            pCellularCommContext->commTxSpaceEventDescriptor = -1;
+        }
+    #endif
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _cleanCommThreads( _cellularCommContext_t * pCellularCommContext )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    uint64_t abortEvent = 1U;
+    int pthreadRet = 0;
+
+    /* The abort eventfd is never read, so it wakes both threads. */
+    if( pCellularCommContext->commAbortEventDescriptor >= 0 )
+    {
+        if( write( pCellularCommContext->commAbortEventDescriptor, &abortEvent, sizeof( abortEvent ) ) < 0 )
+        {
+            CellularLogDebug( "Cellular close signal comm threads fail %d", errno );
+        }
+    }
+
+    if( pCellularCommContext->commReceiveCallbackThreadStarted == true )
+    {
+        pthreadRet = pthread_join( pCellularCommContext->commReceiveCallbackThread, NULL );
+
+        if( pthreadRet != 0 )
+        {
+            CellularLogDebug( "Cellular close wait receiveCallbackThread fail %d", pthreadRet );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+
+        pCellularCommContext->commReceiveCallbackThreadStarted = false;
+    }
+
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        if( pCellularCommContext->commTransmitThreadStarted == true )
+        {
+            pthreadRet = pthread_join( pCellularCommContext->commTransmitThread, NULL );
+
+            if( pthreadRet != 0 )
+            {
+                CellularLogDebug( "Cellular close wait transmitThread fail %d", pthreadRet );
+                commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            }
+
+            pCellularCommContext->commTransmitThreadStarted = false;
+        }
+    #endif
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _commTxWrite( _cellularCommContext_t * pCellularCommContext,
+                                                  const uint8_t * pData,
+                                                  uint32_t dataLength,
+                                                  uint32_t timeoutMilliseconds,
+                                                  uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    struct pollfd commPollFd = { 0 };
+    uint64_t startTimeMs = Platform_GetTimeMs();
+    uint32_t dataSentLength = 0;
+    ssize_t writeRet = 0;
+    int64_t elapsedTime = 0;
+    int pollRet = 0;
+
+    #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+        uint32_t writeStartUs = CommTrace_TimestampUs();
+    #endif
+
+    commPollFd.fd = pCellularCommContext->commFileDescriptor;
+    commPollFd.events = POLLOUT;
+
+    while( dataSentLength < dataLength )
+    {
+        writeRet = write( commPollFd.fd, &pData[ dataSentLength ], dataLength - dataSentLength );
+
+        if( writeRet > 0 )
+        {
+            #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+                CommTrace_Record( &pCellularCommContext->commTrace, COMM_TRACE_TX, &pData[ dataSentLength ], ( uint32_t ) writeRet );
+            #endif
+            #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                CommStats_Write( &pCellularCommContext->commStats, ( uint32_t ) writeRet, writeStartUs );
+                writeStartUs = CommTrace_TimestampUs();
+            #endif
+            dataSentLength = dataSentLength + ( uint32_t ) writeRet;
+        }
+        else if( ( writeRet < 0 ) && ( errno != EAGAIN ) && ( errno != EINTR ) )
+        {
+            CellularLogError( "Cellular write fail %d", errno );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                pCellularCommContext->commStats.stats.writeErrorCount++;
+            #endif
+            break;
+        }
+        else
+        {
+            /* Output buffer is full. Wait until the driver drains it, for what is left of the timeout. */
+            elapsedTime = ( int64_t ) ( Platform_GetTimeMs() - startTimeMs );
+            pollRet = ( elapsedTime < ( int64_t ) timeoutMilliseconds ) ?
+                      poll( &commPollFd, 1, ( int ) ( ( int64_t ) timeoutMilliseconds - elapsedTime ) ) : 0;
+
+            if( pollRet == 0 )
+            {
+                CellularLogError( "Cellular send poll timeout" );
+                commIntRet = IOT_COMM_INTERFACE_TIMEOUT;
+                break;
+            }
+            else if( ( pollRet < 0 ) && ( errno != EINTR ) )
+            {
+                CellularLogError( "Cellular send poll fail %d", errno );
+                commIntRet = IOT_COMM_INTERFACE_FAILURE;
+                break;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    }
+
+    *pDataSentLength = dataSentLength;
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+
+static CellularCommInterfaceError_t _setupCommTxEvents( _cellularCommContext_t * pCellularCommContext )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+
+    pCellularCommContext->commTxDataEventDescriptor = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+    pCellularCommContext->commTxSpaceEventDescriptor = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+
+    if( ( pCellularCommContext->commTxDataEventDescriptor < 0 ) ||
+        ( pCellularCommContext->commTxSpaceEventDescriptor < 0 ) )
+    {
+        CellularLogError( "Cellular eventfd fail %d", errno );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        CommRing_Init( &pCellularCommContext->commTxRing,
+                       pCellularCommContext->commTxRingBuffer,
+                       COMM_TX_RING_SIZE );
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _commTxRelease( _cellularCommContext_t * pCellularCommContext,
+                            uint32_t length,
+                            CellularCommInterfaceError_t txStatus )
+{
+    CellularCommInterfaceTxCallback_t txCallback = pCellularCommContext->commTxCallback;
+    uint64_t spaceEvent = 1U;
+
+    CommRing_Release( &pCellularCommContext->commTxRing, length );
+
+    if( write( pCellularCommContext->commTxSpaceEventDescriptor, &spaceEvent, sizeof( spaceEvent ) ) < 0 )
+    {
+        CellularLogDebug( "Cellular writer thread signal space fail %d", errno );
+    }
+
+    if( txStatus == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        ( void ) __atomic_add_fetch( &pCellularCommContext->commTxCompletedLength, length, __ATOMIC_ACQ_REL );
+    }
+    else
+    {
+        __atomic_store_n( &pCellularCommContext->commTxStatus, txStatus, __ATOMIC_SEQ_CST );
+    }
+
+    /* Report completion once the ring is drained, or the error right away. */
+    if( ( txCallback != NULL ) &&
+        ( ( txStatus != IOT_COMM_INTERFACE_SUCCESS ) || ( CommRing_Used( &pCellularCommContext->commTxRing ) == 0U ) ) )
+    {
+        _commCallTxCallback( pCellularCommContext, txStatus );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _commCallTxCallback( _cellularCommContext_t * pCellularCommContext,
+                                 CellularCommInterfaceError_t txStatus )
+{
+    CellularCommInterfaceTxCallback_t txCallback = pCellularCommContext->commTxCallback;
+
+    if( txCallback != NULL )
+    {
+        txCallback( pCellularCommContext->pTxUserData,
+                    ( CellularCommInterfaceHandle_t ) pCellularCommContext,
+                    txStatus,
+                    __atomic_exchange_n( &pCellularCommContext->commTxCompletedLength, 0U, __ATOMIC_ACQ_REL ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void * _CellularCommTransmitThreadFunc( void * pArgument )
+{
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) pArgument;
+    CommRing_t * pRing = &pCellularCommContext->commTxRing;
+    struct pollfd commPollFds[ 2 ] = { 0 };
+    uint8_t * pRead = NULL;
+    uint32_t spanLength = 0;
+    ssize_t writeRet = 0;
+    uint64_t dataEvent = 0;
+    int pollRet = 0;
+    bool exitThread = false;
+
+    #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+        uint32_t writeStartUs = 0;
+    #endif
+
+    commPollFds[ 1 ].fd = pCellularCommContext->commAbortEventDescriptor;
+    commPollFds[ 1 ].events = POLLIN;
+
+    while( exitThread == false )
+    {
+        commPollFds[ 0 ].fd = -1;
+        spanLength = CommRing_GetReadSpan( pRing, &pRead );
+
+        if( spanLength == 0U )
+        {
+            /* Wait for send to queue more data. */
+            commPollFds[ 0 ].fd = pCellularCommContext->commTxDataEventDescriptor;
+            commPollFds[ 0 ].events = POLLIN;
+        }
+        else
+        {
+            #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                /* The write starts when the data is first seen, waiting for the driver included. */
+                if( writeStartUs == 0U )
+                {
+                    writeStartUs = CommTrace_TimestampUs();
+                }
+            #endif
+
+            writeRet = write( pCellularCommContext->commFileDescriptor, pRead, spanLength );
+
+            if( writeRet > 0 )
+            {
+                #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+                    CommTrace_Record( &pCellularCommContext->commTrace, COMM_TRACE_TX, pRead, ( uint32_t ) writeRet );
+                #endif
+                #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                    CommStats_Write( &pCellularCommContext->commStats, ( uint32_t ) writeRet, writeStartUs );
+                    writeStartUs = 0;
+                #endif
+                _commTxRelease( pCellularCommContext, ( uint32_t ) writeRet, IOT_COMM_INTERFACE_SUCCESS );
+            }
+            else if( ( writeRet < 0 ) && ( ( errno == EAGAIN ) || ( errno == EINTR ) ) )
+            {
+                /* Output buffer is full. Wait until the driver drains it. */
+                commPollFds[ 0 ].fd = pCellularCommContext->commFileDescriptor;
+                commPollFds[ 0 ].events = POLLOUT;
+            }
+            else
+            {
+                /* Drop the span which can not be written. */
+                CellularLogError( "Cellular writer thread write fail %d", errno );
+                #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                    pCellularCommContext->commStats.stats.writeErrorCount++;
+                    writeStartUs = 0;
+                #endif
+                _commTxRelease( pCellularCommContext, spanLength, IOT_COMM_INTERFACE_DRIVER_ERROR );
+            }
+        }
+
+        if( commPollFds[ 0 ].fd >= 0 )
+        {
+            pollRet = poll( commPollFds, 2, -1 );
+
+            if( ( pollRet > 0 ) && ( commPollFds[ 1 ].revents != 0 ) )
+            {
+                /* Abort event from close. */
+                exitThread = true;
+            }
+            else if( ( pollRet > 0 ) && ( commPollFds[ 0 ].fd == pCellularCommContext->commTxDataEventDescriptor ) )
+            {
+                ( void ) read( commPollFds[ 0 ].fd, &dataEvent, sizeof( dataEvent ) );
+            }
+            else if( ( pollRet < 0 ) && ( errno != EINTR ) )
+            {
+                CellularLogError( "Cellular writer thread poll fail %d", errno );
+                exitThread = true;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _commTxQueue( _cellularCommContext_t * pCellularCommContext,
+                                                  const uint8_t * pData,
+                                                  uint32_t dataLength,
+                                                  uint32_t timeoutMilliseconds,
+                                                  uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    CommRing_t * pRing = &pCellularCommContext->commTxRing;
+    struct pollfd spacePollFd = { 0 };
+    uint64_t startTimeMs = Platform_GetTimeMs();
+    uint8_t * pWrite = NULL;
+    uint32_t spanLength = 0;
+    uint32_t queuedLength = 0;
+    uint64_t txEvent = 1U;
+    int64_t elapsedTime = 0;
+    int pollRet = 0;
+
+    spacePollFd.fd = pCellularCommContext->commTxSpaceEventDescriptor;
+    spacePollFd.events = POLLIN;
+
+    /* Report the write error of data queued by a previous send. */
+    commIntRet = __atomic_exchange_n( &pCellularCommContext->commTxStatus, IOT_COMM_INTERFACE_SUCCESS, __ATOMIC_SEQ_CST );
+
+    while( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( queuedLength < dataLength ) )
+    {
+        spanLength = CommRing_GetWriteSpan( pRing, &pWrite );
+
+        if( spanLength > 0U )
+        {
+            if( spanLength > ( dataLength - queuedLength ) )
+            {
+                spanLength = dataLength - queuedLength;
+            }
+
+            ( void ) memcpy( pWrite, &pData[ queuedLength ], spanLength );
+            CommRing_Commit( pRing, spanLength );
+            queuedLength = queuedLength + spanLength;
+
+            if( write( pCellularCommContext->commTxDataEventDescriptor, &txEvent, sizeof( txEvent ) ) < 0 )
+            {
+                CellularLogDebug( "Cellular send signal writer thread fail %d", errno );
+            }
+        }
+        else
+        {
+            /* Ring is full. Wait for the writer thread to release space. */
+            elapsedTime = ( int64_t ) ( Platform_GetTimeMs() - startTimeMs );
+            pollRet = ( elapsedTime < ( int64_t ) timeoutMilliseconds ) ?
+                      poll( &spacePollFd, 1, ( int ) ( ( int64_t ) timeoutMilliseconds - elapsedTime ) ) : 0;
+
+            if( pollRet == 0 )
+            {
+                CellularLogError( "Cellular send transmit ring full timeout" );
+                commIntRet = IOT_COMM_INTERFACE_TIMEOUT;
+            }
+            else if( pollRet > 0 )
+            {
+                ( void ) read( spacePollFd.fd, &txEvent, sizeof( txEvent ) );
+                txEvent = 1U;
+            }
+            else if( errno != EINTR )
+            {
+                CellularLogError( "Cellular send poll fail %d", errno );
+                commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    }
+
+    *pDataSentLength = queuedLength;
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t _commTxDrain( _cellularCommContext_t * pCellularCommContext )
+{
+    CommRing_t * pRing = &pCellularCommContext->commTxRing;
+    struct pollfd spacePollFd = { 0 };
+    uint64_t startTimeMs = Platform_GetTimeMs();
+    uint64_t txEvent = 0;
+    int64_t elapsedTime = 0;
+    int pollRet = 1;
+
+    spacePollFd.fd = pCellularCommContext->commTxSpaceEventDescriptor;
+    spacePollFd.events = POLLIN;
+
+    while( ( CommRing_Used( pRing ) > 0U ) && ( ( pollRet > 0 ) || ( ( pollRet < 0 ) && ( errno == EINTR ) ) ) )
+    {
+        elapsedTime = ( int64_t ) ( Platform_GetTimeMs() - startTimeMs );
+        pollRet = ( elapsedTime < ( int64_t ) COMM_TX_DRAIN_TIMEOUT_MS ) ?
+                  poll( &spacePollFd, 1, ( int ) ( ( int64_t ) COMM_TX_DRAIN_TIMEOUT_MS - elapsedTime ) ) : 0;
+
+        if( pollRet > 0 )
+        {
+            ( void ) read( spacePollFd.fd, &txEvent, sizeof( txEvent ) );
+        }
+    }
+
+    return CommRing_Used( pRing );
+}
+
+#endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCommIntfOpenInstance( uint32_t instanceIndex,
+                                                              CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                              void * pUserData,
+                                                              CellularCommInterfaceHandle_t * pCommInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext( instanceIndex );
+    int pthreadRet = 0;
+    bool contextCleared = false;
+
+    if( pCellularCommContext == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) != 0 )
+    {
+        CellularLogError( "Cellular comm interface %u opened already", instanceIndex );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( _iotCellularCommPorts[ instanceIndex ] == NULL )
+    {
+        CellularLogError( "Cellular comm interface %u has no comm port", instanceIndex );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        /* Clear the context. */
+        memset( pCellularCommContext, 0, sizeof( _cellularCommContext_t ) );
+        contextCleared = true;
+        pCellularCommContext->instanceIndex = instanceIndex;
+        pCellularCommContext->pCommPath = _iotCellularCommPorts[ instanceIndex ];
+        pCellularCommContext->pCommInterface = CellularCommInterface_GetInstance( instanceIndex );
+        pCellularCommContext->commEpollDescriptor = -1;
+        pCellularCommContext->commAbortEventDescriptor = -1;
+
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            pCellularCommContext->commTxDataEventDescriptor = -1;
+            pCellularCommContext->commTxSpaceEventDescriptor = -1;
+        #endif
+
+        pCellularCommContext->commFileDescriptor = open( pCellularCommContext->pCommPath,
+                                                         O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+
+        if( pCellularCommContext->commFileDescriptor < 0 )
+        {
+            CellularLogError( "Cellular open comm port %s fail %d", pCellularCommContext->pCommPath, errno );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        commIntRet = _setupCommSettings( pCellularCommContext->commFileDescriptor, COMM_DEFAULT_BAUD_RATE, false );
+        pCellularCommContext->commBaudRate = COMM_DEFAULT_BAUD_RATE;
+    }
+
+    #if ( COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 )
+        if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+        {
+            /* Negotiate before the receive thread starts reading the tty. */
+            commIntRet = _commNegotiateLineSettings( pCellularCommContext );
+        }
+    #endif
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        commIntRet = _setupCommEpoll( pCellularCommContext );
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        CommRing_Init( &pCellularCommContext->commRxRing,
+                       pCellularCommContext->commRxRingBuffer,
+                       COMM_RX_RING_SIZE );
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        pCellularCommContext->commReceiveCallback = receiveCallback;
+        pCellularCommContext->pUserData = pUserData;
+        pthreadRet = pthread_create( &pCellularCommContext->commReceiveCallbackThread, NULL,
+                                     _CellularCommReceiveCBThreadFunc, pCellularCommContext );
+
+        if( pthreadRet != 0 )
+        {
+            CellularLogError( "Cellular pthread_create fail %d", pthreadRet );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+        else
+        {
+            pCellularCommContext->commReceiveCallbackThreadStarted = true;
+        }
+    }
+
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+        {
+            commIntRet = _setupCommTxEvents( pCellularCommContext );
+        }
+
+        if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+        {
+            pthreadRet = pthread_create( &pCellularCommContext->commTransmitThread, NULL,
+                                         _CellularCommTransmitThreadFunc, pCellularCommContext );
+
+            if( pthreadRet != 0 )
+            {
+                CellularLogError( "Cellular pthread_create fail %d", pthreadRet );
+                commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            }
+            else
+            {
+                pCellularCommContext->commTransmitThreadStarted = true;
+            }
+        }
+    #endif
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        *pCommInterfaceHandle = ( CellularCommInterfaceHandle_t ) pCellularCommContext;
+        pCellularCommContext->commStatus |= CELLULAR_COMM_OPEN_BIT;
+    }
+    else if( contextCleared == true )
+    {
+        /* Comm interface open fail. Clean the data. An instance opened already is left untouched. */
+        pCellularCommContext->commReceiveCallback = NULL;
+        ( void ) _cleanCommThreads( pCellularCommContext );
+        ( void ) _cleanCommDescriptors( pCellularCommContext );
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCommIntfClose( CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
+
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        uint32_t txDroppedLength = 0;
+    #endif
+
+    if( pCellularCommContext == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) == 0 )
+    {
+        CellularLogError( "Cellular close comm interface is not opened before." );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            /* Write the data queued by send before the writer thread is stopped. */
+            txDroppedLength = _commTxDrain( pCellularCommContext );
+
+            if( txDroppedLength > 0U )
+            {
+                CellularLogError( "Cellular comm %u close dropped %u queued transmit bytes",
+                                  pCellularCommContext->instanceIndex, txDroppedLength );
+            }
+        #endif
+
+        /* clean the receive callback. */
+        pCellularCommContext->commReceiveCallback = NULL;
+
+        /* Stop the receive, writer and comm task threads and wait for them to exit. */
+        commIntRet = _cleanCommThreads( pCellularCommContext );
+
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            pCellularCommContext->commTxCallback = NULL;
+            CellularLogInfo( "Cellular comm %u TX ring peak fill %u of %u bytes, dropped %u",
+                             pCellularCommContext->instanceIndex,
+                             pCellularCommContext->commTxRing.peakFill, COMM_TX_RING_SIZE,
+                             CommRing_Used( &pCellularCommContext->commTxRing ) );
+        #endif
+
+        CellularLogInfo( "Cellular comm %u RX ring peak fill %u of %u bytes, overrun %u",
+                         pCellularCommContext->instanceIndex,
+                         pCellularCommContext->commRxRing.peakFill, COMM_RX_RING_SIZE,
+                         pCellularCommContext->commRxRing.overrunCount );
+
+        /* Close the comm port. */
+        if( _cleanCommDescriptors( pCellularCommContext ) != IOT_COMM_INTERFACE_SUCCESS )
+        {
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+
+        /* clean the data structure. */
+        pCellularCommContext->commStatus &= ~( CELLULAR_COMM_OPEN_BIT );
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCommIntfSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                      const uint8_t * pData,
+                                                      uint32_t dataLength,
+                                                      uint32_t timeoutMilliseconds,
+                                                      uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
+
+    if( ( pCellularCommContext == NULL ) || ( pData == NULL ) || ( pDataSentLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) == 0 )
+    {
+        CellularLogError( "Cellular send comm interface is not opened before." );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            /* The writer thread writes the queued data to the tty. */
+            commIntRet = _commTxQueue( pCellularCommContext, pData, dataLength, timeoutMilliseconds, pDataSentLength );
+        #else
+            commIntRet = _commTxWrite( pCellularCommContext, pData, dataLength, timeoutMilliseconds, pDataSentLength );
+        #endif
+
+        #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+            if( commIntRet == IOT_COMM_INTERFACE_TIMEOUT )
+            {
+                pCellularCommContext->commStats.stats.sendTimeoutCount++;
+            }
+        #endif
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCommIntfReceive( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                         uint8_t * pBuffer,
+                                                         uint32_t bufferLength,
+                                                         uint32_t timeoutMilliseconds,
+                                                         uint32_t * pDataReceivedLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
+    uint32_t readLength = 0;
+
+    /* The receive thread has already read the data into the ring. Same as the
+     * windows comm interface, return immediately with the bytes that have
+     * already been received. */
+    ( void ) timeoutMilliseconds;
+
+    if( ( pCellularCommContext == NULL ) || ( pBuffer == NULL ) || ( pDataReceivedLength == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) == 0 )
+    {
+        CellularLogError( "Cellular read comm interface is not opened before." );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        readLength = CommRing_Read( &pCellularCommContext->commRxRing, pBuffer, bufferLength );
+        *pDataReceivedLength = readLength;
+
+        #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+            CommStats_Recv( &pCellularCommContext->commStats, readLength );
+        #endif
+
+        /* Let the receive thread read the port again if it stalled on a full ring. */
+        COMM_RING_MEMORY_BARRIER();
+
+        if( ( readLength > 0U ) && ( pCellularCommContext->commRxStalled == true ) )
+        {
+            pCellularCommContext->commRxStalled = false;
+            _rearmCommRxEvent( pCellularCommContext );
+        }
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterfaceError_t CellularCommInterface_SetPort( uint32_t instanceIndex,
+                                                            const char * pPortName )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext( instanceIndex );
+
+    if( ( pCellularCommContext == NULL ) || ( pPortName == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) != 0 )
+    {
+        CellularLogError( "Cellular comm interface %u is opened", instanceIndex );
+        commIntRet = IOT_COMM_INTERFACE_BUSY;
+    }
+    else
+    {
+        _iotCellularCommPorts[ instanceIndex ] = pPortName;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+
+CellularCommInterfaceError_t CellularCommInterface_GetStats( uint32_t instanceIndex,
+                                                             CellularCommStats_t * pStats )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext( instanceIndex );
+
+    if( ( pCellularCommContext == NULL ) || ( pStats == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else
+    {
+        CommStats_Copy( &pCellularCommContext->commStats, pStats );
+        pStats->rxOverrunCount = pCellularCommContext->commRxRing.overrunCount;
+        pStats->rxPeakFill = pCellularCommContext->commRxRing.peakFill;
+    }
+
+    return commIntRet;
+}
+
+#endif /* CELLULAR_COMM_STATS_ENABLE == 1 */
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+
+CellularCommInterfaceError_t CellularCommInterface_DumpTrace( uint32_t instanceIndex,
+                                                              const char * pPath )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext( instanceIndex );
+
+    if( ( pCellularCommContext == NULL ) || ( pPath == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else
+    {
+        commIntRet = CommTrace_Dump( &pCellularCommContext->commTrace, pPath );
+    }
+
+    return commIntRet;
+}
+
+#endif /* CELLULAR_COMM_TRACE_ENABLE == 1 */
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+
+CellularCommInterfaceError_t CellularCommInterface_SetTxCallback( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                                  CellularCommInterfaceTxCallback_t txCallback,
+                                                                  void * pUserData )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
+
+    if( pCellularCommContext == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) == 0 )
+    {
+        CellularLogError( "Cellular comm interface is not opened before." );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        pCellularCommContext->pTxUserData = pUserData;
+        pCellularCommContext->commTxCallback = txCallback;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
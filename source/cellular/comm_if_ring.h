@@ -0,0 +1,238 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_ring.h
+ * @brief Lock-free single-producer/single-consumer byte ring used by the comm interfaces.
+ *
+ * For the receive ring the comm interface receive thread is the only producer
+ * and the pktio task calling recv is the only consumer. The transmit ring is
+ * used the other way around. Each side only writes its own index, so
+ * no lock is required. A memory barrier orders the data copy against the
+ * index update on each side.
+ */
+
+#ifndef __COMM_IF_RING_H__
+#define __COMM_IF_RING_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+#if defined( _WIN32 ) || defined( _WIN64 )
+    #define COMM_RING_MEMORY_BARRIER()    MemoryBarrier()
+#else
+    #define COMM_RING_MEMORY_BARRIER()    __sync_synchronize()
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Byte ring with free running indexes.
+ *
+ * The buffer size must be a power of two. head and tail are never masked when
+ * stored, so head - tail is always the number of used bytes.
+ */
+typedef struct CommRing
+{
+    uint8_t * pBuffer;              /**< Ring storage provided by the owner. */
+    uint32_t size;                  /**< Storage size in bytes, power of two. */
+    volatile uint32_t head;         /**< Write index. Only updated by the producer. */
+    volatile uint32_t tail;         /**< Read index. Only updated by the consumer. */
+    volatile uint32_t overrunCount; /**< Times the producer found the ring full. */
+    volatile uint32_t peakFill;     /**< Highest number of used bytes seen by the producer. */
+} CommRing_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize the ring over the provided storage.
+ *
+ * @param[in] pRing The ring to initialize.
+ * @param[in] pBuffer Ring storage.
+ * @param[in] size Size of pBuffer in bytes. Must be a power of two.
+ */
+static inline void CommRing_Init( CommRing_t * pRing,
+                                  uint8_t * pBuffer,
+                                  uint32_t size )
+{
+    pRing->pBuffer = pBuffer;
+    pRing->size = size;
+    pRing->head = 0U;
+    pRing->tail = 0U;
+    pRing->overrunCount = 0U;
+    pRing->peakFill = 0U;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of bytes available to the consumer.
+ */
+static inline uint32_t CommRing_Used( const CommRing_t * pRing )
+{
+    return pRing->head - pRing->tail;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the contiguous free span the producer can write to.
+ *
+ * @param[in] pRing The ring.
+ * @param[out] ppWrite Start of the free span.
+ *
+ * @return Length of the contiguous free span in bytes. 0 if the ring is full.
+ */
+static inline uint32_t CommRing_GetWriteSpan( const CommRing_t * pRing,
+                                              uint8_t ** ppWrite )
+{
+    uint32_t head = pRing->head;
+    uint32_t freeLength = pRing->size - ( head - pRing->tail );
+    uint32_t offset = head & ( pRing->size - 1U );
+    uint32_t spanLength = pRing->size - offset;
+
+    *ppWrite = &pRing->pBuffer[ offset ];
+
+    return ( freeLength < spanLength ) ? freeLength : spanLength;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish bytes written to the span returned by CommRing_GetWriteSpan.
+ *
+ * @param[in] pRing The ring.
+ * @param[in] length Number of bytes written.
+ */
+static inline void CommRing_Commit( CommRing_t * pRing,
+                                    uint32_t length )
+{
+    uint32_t usedLength = 0;
+
+    /* Data must be visible before the new head. */
+    COMM_RING_MEMORY_BARRIER();
+    pRing->head = pRing->head + length;
+
+    usedLength = pRing->head - pRing->tail;
+
+    if( usedLength > pRing->peakFill )
+    {
+        pRing->peakFill = usedLength;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the contiguous used span the consumer can read from.
+ *
+ * @param[in] pRing The ring.
+ * @param[out] ppRead Start of the used span.
+ *
+ * @return Length of the contiguous used span in bytes. 0 if the ring is empty.
+ */
+static inline uint32_t CommRing_GetReadSpan( const CommRing_t * pRing,
+                                             uint8_t ** ppRead )
+{
+    uint32_t tail = pRing->tail;
+    uint32_t usedLength = pRing->head - tail;
+    uint32_t offset = tail & ( pRing->size - 1U );
+    uint32_t spanLength = pRing->size - offset;
+
+    /* Head must be read before the data it publishes. */
+    COMM_RING_MEMORY_BARRIER();
+
+    *ppRead = &pRing->pBuffer[ offset ];
+
+    return ( usedLength < spanLength ) ? usedLength : spanLength;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Release bytes read from the span returned by CommRing_GetReadSpan.
+ *
+ * @param[in] pRing The ring.
+ * @param[in] length Number of bytes consumed.
+ */
+static inline void CommRing_Release( CommRing_t * pRing,
+                                     uint32_t length )
+{
+    /* Data must be consumed before the space is released. */
+    COMM_RING_MEMORY_BARRIER();
+    pRing->tail = pRing->tail + length;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy bytes out of the ring.
+ *
+ * @param[in] pRing The ring.
+ * @param[out] pBuffer Destination buffer.
+ * @param[in] bufferLength Size of pBuffer.
+ *
+ * @return Number of bytes copied.
+ */
+static inline uint32_t CommRing_Read( CommRing_t * pRing,
+                                      uint8_t * pBuffer,
+                                      uint32_t bufferLength )
+{
+    uint32_t tail = pRing->tail;
+    uint32_t readLength = pRing->head - tail;
+    uint32_t offset = tail & ( pRing->size - 1U );
+    uint32_t firstLength = 0;
+
+    if( readLength > bufferLength )
+    {
+        readLength = bufferLength;
+    }
+
+    /* Head must be read before the data it publishes. */
+    COMM_RING_MEMORY_BARRIER();
+
+    firstLength = pRing->size - offset;
+
+    if( firstLength > readLength )
+    {
+        firstLength = readLength;
+    }
+
+    ( void ) memcpy( pBuffer, &pRing->pBuffer[ offset ], firstLength );
+    ( void ) memcpy( &pBuffer[ firstLength ], pRing->pBuffer, readLength - firstLength );
+
+    /* Data must be copied out before the space is released. */
+    COMM_RING_MEMORY_BARRIER();
+    pRing->tail = tail + readLength;
+
+    return readLength;
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_RING_H__ */
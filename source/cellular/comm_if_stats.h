@@ -0,0 +1,236 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_stats.h
+ * @brief Traffic statistics collected by the comm interfaces.
+ *
+ * Every field has a single writer: the receive thread for the reads of the
+ * port and the receive callbacks, the caller of recv for the recv calls, and
+ * the sender or writer thread for the writes. The updates are plain stores,
+ * except for the 64-bit byte counters, which a 32-bit host writes in two
+ * halves. They are published under a sequence counter, so CommStats_Copy
+ * never returns a torn value.
+ */
+
+#ifndef __COMM_IF_STATS_H__
+#define __COMM_IF_STATS_H__
+
+#include <stdint.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+/* Microsecond clock and memory barrier include file. */
+#include "comm_if_trace.h"
+
+#if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Statistics of a comm interface instance and the state to time them.
+ */
+typedef struct CommStats
+{
+    CellularCommStats_t stats;
+    volatile uint32_t callbackSequence;    /**< Receive callbacks. Written by the receive callback side. */
+    volatile uint32_t callbackTimestampUs; /**< Time of the last receive callback. */
+    uint32_t recvSequence;                 /**< Last receive callback seen by recv. */
+    volatile uint32_t rxBytesSequence;     /**< Odd while rxBytes is updated. */
+    volatile uint32_t txBytesSequence;     /**< Odd while txBytes is updated. */
+} CommStats_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Count a value in a power of two histogram.
+ */
+static inline void CommStats_Histogram( uint32_t * pHistogram,
+                                        uint32_t value )
+{
+    uint32_t bucket = 0;
+
+    while( ( value > 1U ) && ( bucket < ( CELLULAR_COMM_STATS_BUCKETS - 1U ) ) )
+    {
+        value = value >> 1;
+        bucket++;
+    }
+
+    pHistogram[ bucket ]++;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add to a 64-bit counter published under a sequence counter.
+ *
+ * @param[in,out] pSequence Sequence of the counter, odd during the update.
+ * @param[in,out] pCounter The counter.
+ * @param[in] length Value to add.
+ */
+static inline void CommStats_Add64( volatile uint32_t * pSequence,
+                                    volatile uint64_t * pCounter,
+                                    uint32_t length )
+{
+    *pSequence = *pSequence + 1U;
+
+    /* Odd sequence must be visible before either half of the counter. */
+    COMM_RING_MEMORY_BARRIER();
+    *pCounter = *pCounter + length;
+
+    /* Counter must be visible before the even sequence. */
+    COMM_RING_MEMORY_BARRIER();
+    *pSequence = *pSequence + 1U;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read a 64-bit counter published under a sequence counter.
+ *
+ * Retries while the writer is updating the counter.
+ *
+ * @param[in] pSequence Sequence of the counter.
+ * @param[in] pCounter The counter.
+ *
+ * @return The counter.
+ */
+static inline uint64_t CommStats_Load64( const volatile uint32_t * pSequence,
+                                         const volatile uint64_t * pCounter )
+{
+    uint32_t sequence = 0;
+    uint64_t counter = 0;
+
+    do
+    {
+        sequence = *pSequence;
+
+        /* Sequence must be read before the counter. */
+        COMM_RING_MEMORY_BARRIER();
+        counter = *pCounter;
+
+        /* Counter must be read before the sequence is checked again. */
+        COMM_RING_MEMORY_BARRIER();
+    } while( ( ( sequence & 1U ) != 0U ) || ( sequence != *pSequence ) );
+
+    return counter;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy the statistics for CellularCommInterface_GetStats.
+ *
+ * The 32-bit counters are copied with plain loads. The byte counters are
+ * read under their sequence counters.
+ *
+ * @param[in] pCommStats The statistics.
+ * @param[out] pStats The copy.
+ */
+static inline void CommStats_Copy( const CommStats_t * pCommStats,
+                                   CellularCommStats_t * pStats )
+{
+    *pStats = pCommStats->stats;
+    pStats->rxBytes = CommStats_Load64( &pCommStats->rxBytesSequence, &pCommStats->stats.rxBytes );
+    pStats->txBytes = CommStats_Load64( &pCommStats->txBytesSequence, &pCommStats->stats.txBytes );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Count a read of the port.
+ */
+static inline void CommStats_Read( CommStats_t * pCommStats,
+                                   uint32_t length )
+{
+    CommStats_Add64( &pCommStats->rxBytesSequence, &pCommStats->stats.rxBytes, length );
+    pCommStats->stats.readCount++;
+    CommStats_Histogram( pCommStats->stats.readSizeHistogram, length );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Count a receive callback and start timing its recv.
+ */
+static inline void CommStats_Callback( CommStats_t * pCommStats )
+{
+    pCommStats->stats.callbackCount++;
+    pCommStats->callbackTimestampUs = CommTrace_TimestampUs();
+
+    /* Timestamp must be visible before the sequence. */
+    COMM_RING_MEMORY_BARRIER();
+    pCommStats->callbackSequence = pCommStats->callbackSequence + 1U;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Count a recv call and time the first one after a receive callback.
+ */
+static inline void CommStats_Recv( CommStats_t * pCommStats,
+                                   uint32_t length )
+{
+    uint32_t callbackSequence = pCommStats->callbackSequence;
+
+    if( callbackSequence != pCommStats->recvSequence )
+    {
+        /* Sequence must be read before the timestamp it publishes. */
+        COMM_RING_MEMORY_BARRIER();
+        pCommStats->recvSequence = callbackSequence;
+        CommStats_Histogram( pCommStats->stats.callbackLatencyHistogram,
+                             CommTrace_TimestampUs() - pCommStats->callbackTimestampUs );
+    }
+
+    if( length > 0U )
+    {
+        pCommStats->stats.recvCount++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Count a completed write of the port.
+ *
+ * @param[in] pCommStats The statistics.
+ * @param[in] length Bytes written.
+ * @param[in] startTimestampUs CommTrace_TimestampUs at the start of the write.
+ */
+static inline void CommStats_Write( CommStats_t * pCommStats,
+                                    uint32_t length,
+                                    uint32_t startTimestampUs )
+{
+    CommStats_Add64( &pCommStats->txBytesSequence, &pCommStats->stats.txBytes, length );
+    pCommStats->stats.writeCount++;
+    CommStats_Histogram( pCommStats->stats.writeLatencyHistogram, CommTrace_TimestampUs() - startTimestampUs );
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* CELLULAR_COMM_STATS_ENABLE == 1 */
+
+#endif /* __COMM_IF_STATS_H__ */
@@ -0,0 +1,328 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_trace.c
+ * @brief Dump of the wire trace of the comm interfaces.
+ */
+
+/*-----------------------------------------------------------*/
+
+#if defined( _WIN32 ) || defined( _WIN64 )
+    #include <windows.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS include. */
+#include "FreeRTOS.h"
+
+/* Platform layer includes. */
+#include "cellular_platform.h"
+
+/* Cellular comm interface include file. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_comm_interface.h"
+#include "comm_if_trace.h"
+
+/*-----------------------------------------------------------*/
+
+/* Capture file header, see comm_if_capture.h. */
+#define TRACE_CAPTURE_MAGIC            "CCAP"
+#define TRACE_CAPTURE_MAGIC_LENGTH     ( 4U )
+#define TRACE_CAPTURE_VERSION          ( 1U )
+#define TRACE_CAPTURE_HEADER_LENGTH    ( 12U )
+#define TRACE_CAPTURE_TICK_RATE        ( 1000000U )
+
+/* Maximum length of an unsigned LEB128 encoded uint32_t. */
+#define TRACE_VARINT_MAX_LENGTH        ( 5U )
+
+/*-----------------------------------------------------------*/
+
+/* Copy of a trace ring and the range of its records still intact after the copy. */
+typedef struct _commTraceSnapshot
+{
+    CommTraceRecord_t records[ CELLULAR_COMM_TRACE_RECORDS ];
+    uint8_t data[ CELLULAR_COMM_TRACE_SIZE ];
+    uint32_t first; /* Index of the oldest intact record. */
+    uint32_t end;   /* Index after the newest record. */
+} _commTraceSnapshot_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy a trace ring while its writer may be running.
+ *
+ * @param[in] pRing The trace ring.
+ * @param[out] pSnapshot The copy.
+ */
+static void _commTraceSnapshot( const CommTraceRing_t * pRing,
+                                _commTraceSnapshot_t * pSnapshot );
+
+/**
+ * @brief Encode an unsigned LEB128 value.
+ *
+ * @param[out] pBuffer At least TRACE_VARINT_MAX_LENGTH bytes.
+ * @param[in] value The value.
+ *
+ * @return Number of bytes written to pBuffer.
+ */
+static uint32_t _commTraceWriteVarint( uint8_t * pBuffer,
+                                       uint32_t value );
+
+/**
+ * @brief Write the snapshots merged in time order.
+ *
+ * @param[in] pFile The file.
+ * @param[in] pSnapshots The snapshots of both directions.
+ *
+ * @return true if the records are written.
+ */
+static bool _commTraceWriteRecords( FILE * pFile,
+                                    _commTraceSnapshot_t * pSnapshots );
+
+/*-----------------------------------------------------------*/
+
+static void _commTraceSnapshot( const CommTraceRing_t * pRing,
+                                _commTraceSnapshot_t * pSnapshot )
+{
+    uint32_t dataHead = 0;
+    uint32_t recordHead = 0;
+    uint32_t first = 0;
+    uint32_t end = pRing->recordHead;
+
+    /* Head must be read before the records it publishes. */
+    COMM_RING_MEMORY_BARRIER();
+    ( void ) memcpy( pSnapshot->records, ( const void * ) pRing->records, sizeof( pSnapshot->records ) );
+    ( void ) memcpy( pSnapshot->data, ( const void * ) pRing->data, sizeof( pSnapshot->data ) );
+
+    /* Everything the writer reserved from here on may have been copied half written. */
+    COMM_RING_MEMORY_BARRIER();
+    dataHead = pRing->dataHead;
+    recordHead = pRing->recordHead;
+
+    first = ( end > CELLULAR_COMM_TRACE_RECORDS ) ? ( end - CELLULAR_COMM_TRACE_RECORDS ) : 0U;
+
+    /* The slot of record recordHead - CELLULAR_COMM_TRACE_RECORDS is being rewritten. */
+    if( ( recordHead - first ) >= CELLULAR_COMM_TRACE_RECORDS )
+    {
+        first = recordHead - CELLULAR_COMM_TRACE_RECORDS + 1U;
+    }
+
+    if( ( int32_t ) ( end - first ) < 0 )
+    {
+        first = end;
+    }
+
+    /* Drop the oldest records whose data has been reserved again. */
+    while( ( first != end ) &&
+           ( ( dataHead - pSnapshot->records[ first & ( CELLULAR_COMM_TRACE_RECORDS - 1U ) ].dataStart ) > CELLULAR_COMM_TRACE_SIZE ) )
+    {
+        first++;
+    }
+
+    pSnapshot->first = first;
+    pSnapshot->end = end;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t _commTraceWriteVarint( uint8_t * pBuffer,
+                                       uint32_t value )
+{
+    uint32_t length = 0;
+
+    do
+    {
+        pBuffer[ length ] = ( uint8_t ) ( value & 0x7FU );
+        value = value >> 7;
+
+        if( value != 0U )
+        {
+            pBuffer[ length ] = pBuffer[ length ] | 0x80U;
+        }
+
+        length++;
+    } while( value != 0U );
+
+    return length;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _commTraceWriteRecords( FILE * pFile,
+                                    _commTraceSnapshot_t * pSnapshots )
+{
+    const CommTraceRecord_t * pRecords[ 2 ] = { NULL };
+    const _commTraceSnapshot_t * pSnapshot = NULL;
+    uint8_t recordHeader[ 1U + ( 2U * TRACE_VARINT_MAX_LENGTH ) ];
+    uint32_t recordHeaderLength = 0;
+    uint32_t previousTimestamp = 0;
+    uint32_t delta = 0;
+    uint32_t offset = 0;
+    uint32_t firstLength = 0;
+    uint32_t direction = 0;
+    bool previousValid = false;
+    bool ret = true;
+
+    while( ( ret == true ) &&
+           ( ( pSnapshots[ COMM_TRACE_RX ].first != pSnapshots[ COMM_TRACE_RX ].end ) ||
+             ( pSnapshots[ COMM_TRACE_TX ].first != pSnapshots[ COMM_TRACE_TX ].end ) ) )
+    {
+        for( direction = 0; direction < 2U; direction++ )
+        {
+            pSnapshot = &pSnapshots[ direction ];
+            pRecords[ direction ] = ( pSnapshot->first != pSnapshot->end ) ?
+                                    &pSnapshot->records[ pSnapshot->first & ( CELLULAR_COMM_TRACE_RECORDS - 1U ) ] : NULL;
+        }
+
+        if( pRecords[ COMM_TRACE_TX ] == NULL )
+        {
+            direction = COMM_TRACE_RX;
+        }
+        else if( pRecords[ COMM_TRACE_RX ] == NULL )
+        {
+            direction = COMM_TRACE_TX;
+        }
+        else
+        {
+            direction = ( ( int32_t ) ( pRecords[ COMM_TRACE_RX ]->timestampUs - pRecords[ COMM_TRACE_TX ]->timestampUs ) <= 0 ) ?
+                        COMM_TRACE_RX : COMM_TRACE_TX;
+        }
+
+        if( previousValid == false )
+        {
+            previousTimestamp = pRecords[ direction ]->timestampUs;
+            previousValid = true;
+        }
+
+        /* The two directions are timed by different threads, keep the deltas non negative. */
+        delta = pRecords[ direction ]->timestampUs - previousTimestamp;
+
+        if( ( int32_t ) delta < 0 )
+        {
+            delta = 0;
+        }
+        else
+        {
+            previousTimestamp = pRecords[ direction ]->timestampUs;
+        }
+
+        recordHeader[ 0 ] = ( uint8_t ) direction;
+        recordHeaderLength = 1U;
+        recordHeaderLength += _commTraceWriteVarint( &recordHeader[ recordHeaderLength ], delta );
+        recordHeaderLength += _commTraceWriteVarint( &recordHeader[ recordHeaderLength ], pRecords[ direction ]->length );
+
+        pSnapshot = &pSnapshots[ direction ];
+        offset = pRecords[ direction ]->dataStart & ( CELLULAR_COMM_TRACE_SIZE - 1U );
+        firstLength = CELLULAR_COMM_TRACE_SIZE - offset;
+
+        if( firstLength > pRecords[ direction ]->length )
+        {
+            firstLength = pRecords[ direction ]->length;
+        }
+
+        ret = ( fwrite( recordHeader, 1U, recordHeaderLength, pFile ) == recordHeaderLength ) &&
+              ( fwrite( &pSnapshot->data[ offset ], 1U, firstLength, pFile ) == firstLength ) &&
+              ( fwrite( pSnapshot->data, 1U, pRecords[ direction ]->length - firstLength, pFile ) ==
+                ( pRecords[ direction ]->length - firstLength ) );
+
+        pSnapshots[ direction ].first++;
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+CellularCommInterfaceError_t CommTrace_Dump( const CommTrace_t * pTrace,
+                                             const char * pPath )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _commTraceSnapshot_t * pSnapshots = NULL;
+    FILE * pFile = NULL;
+    uint8_t header[ TRACE_CAPTURE_HEADER_LENGTH ] = { 0 };
+    uint32_t tickRate = TRACE_CAPTURE_TICK_RATE;
+    bool writeOk = false;
+
+    if( ( pTrace == NULL ) || ( pPath == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else
+    {
+        pSnapshots = ( _commTraceSnapshot_t * ) Platform_Malloc( 2U * sizeof( _commTraceSnapshot_t ) );
+
+        if( pSnapshots == NULL )
+        {
+            CellularLogError( "Cellular comm trace dump out of memory" );
+            commIntRet = IOT_COMM_INTERFACE_NO_MEMORY;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        /* Copy first, writing the file takes long enough for the writers to wrap around. */
+        _commTraceSnapshot( &pTrace->rings[ COMM_TRACE_RX ], &pSnapshots[ COMM_TRACE_RX ] );
+        _commTraceSnapshot( &pTrace->rings[ COMM_TRACE_TX ], &pSnapshots[ COMM_TRACE_TX ] );
+
+        pFile = fopen( pPath, "wb" );
+
+        if( pFile == NULL )
+        {
+            CellularLogError( "Cellular comm trace can't create %s", pPath );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+    }
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        ( void ) memcpy( header, TRACE_CAPTURE_MAGIC, TRACE_CAPTURE_MAGIC_LENGTH );
+        header[ 4 ] = TRACE_CAPTURE_VERSION;
+        header[ 8 ] = ( uint8_t ) ( tickRate & 0xFFU );
+        header[ 9 ] = ( uint8_t ) ( ( tickRate >> 8 ) & 0xFFU );
+        header[ 10 ] = ( uint8_t ) ( ( tickRate >> 16 ) & 0xFFU );
+        header[ 11 ] = ( uint8_t ) ( ( tickRate >> 24 ) & 0xFFU );
+
+        writeOk = ( fwrite( header, 1U, TRACE_CAPTURE_HEADER_LENGTH, pFile ) == TRACE_CAPTURE_HEADER_LENGTH ) &&
+                  ( _commTraceWriteRecords( pFile, pSnapshots ) == true );
+
+        if( ( fclose( pFile ) != 0 ) || ( writeOk == false ) )
+        {
+            CellularLogError( "Cellular comm trace write %s failed", pPath );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+    }
+
+    if( pSnapshots != NULL )
+    {
+        Platform_Free( pSnapshots );
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,174 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_trace.h
+ * @brief Lock-free wire trace of the comm interfaces.
+ *
+ * Each comm interface instance keeps the last bytes received and sent on its
+ * port in two overwrite rings, one per direction, with the time of each read
+ * or write in microseconds. Each ring has one writer, the receive thread for
+ * received data and the sender or writer thread for sent data, so recording
+ * takes no lock. The writer reserves the data space before it copies, and
+ * publishes the record after. A dump copies the ring and then drops every
+ * record whose data or slot the writer may have reused in the meantime.
+ */
+
+#ifndef __COMM_IF_TRACE_H__
+#define __COMM_IF_TRACE_H__
+
+#include <stdint.h>
+#include <string.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+/* Platform clock include file. */
+#include "cellular_platform.h"
+
+/* Memory barrier include file. */
+#include "comm_if_ring.h"
+
+/*-----------------------------------------------------------*/
+
+/* Directions of the trace, also the index of the rings. */
+#define COMM_TRACE_RX    ( 0U )
+#define COMM_TRACE_TX    ( 1U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief One read or write of the port.
+ */
+typedef struct CommTraceRecord
+{
+    uint32_t timestampUs; /**< Time of the read or write. */
+    uint32_t dataStart;   /**< Free running data index of the first byte. */
+    uint32_t length;      /**< Number of bytes kept. */
+} CommTraceRecord_t;
+
+/**
+ * @brief Trace of one direction.
+ *
+ * dataHead and recordHead are free running and never masked when stored. A
+ * zero initialized ring is empty.
+ */
+typedef struct CommTraceRing
+{
+    volatile uint32_t dataHead;   /**< Data reserved by the writer. Updated before the data is copied. */
+    volatile uint32_t recordHead; /**< Records published by the writer. Updated after the record is written. */
+    CommTraceRecord_t records[ CELLULAR_COMM_TRACE_RECORDS ];
+    uint8_t data[ CELLULAR_COMM_TRACE_SIZE ];
+} CommTraceRing_t;
+
+/**
+ * @brief Trace of a comm interface instance.
+ */
+typedef struct CommTrace
+{
+    CommTraceRing_t rings[ 2 ];
+} CommTrace_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Platform clock truncated to 32 bits. Wraps after about 71 minutes.
+ */
+static inline uint32_t CommTrace_TimestampUs( void )
+{
+    return ( uint32_t ) Platform_GetTimeUs();
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record a read or write of the port.
+ *
+ * Must only be called by the single writer of the direction. Only the last
+ * CELLULAR_COMM_TRACE_SIZE bytes of a longer read or write are kept.
+ *
+ * @param[in] pTrace The trace of the instance.
+ * @param[in] direction COMM_TRACE_RX or COMM_TRACE_TX.
+ * @param[in] pData The data read or written.
+ * @param[in] dataLength Number of bytes read or written.
+ */
+static inline void CommTrace_Record( CommTrace_t * pTrace,
+                                     uint32_t direction,
+                                     const uint8_t * pData,
+                                     uint32_t dataLength )
+{
+    CommTraceRing_t * pRing = &pTrace->rings[ direction ];
+    CommTraceRecord_t * pRecord = &pRing->records[ pRing->recordHead & ( CELLULAR_COMM_TRACE_RECORDS - 1U ) ];
+    uint32_t dataStart = pRing->dataHead;
+    uint32_t offset = dataStart & ( CELLULAR_COMM_TRACE_SIZE - 1U );
+    uint32_t length = dataLength;
+    uint32_t firstLength = 0;
+
+    if( length > CELLULAR_COMM_TRACE_SIZE )
+    {
+        pData = &pData[ length - CELLULAR_COMM_TRACE_SIZE ];
+        length = CELLULAR_COMM_TRACE_SIZE;
+    }
+
+    /* Reserve the space before overwriting it, so a dump sees the old data is gone. */
+    pRing->dataHead = dataStart + length;
+    COMM_RING_MEMORY_BARRIER();
+
+    firstLength = CELLULAR_COMM_TRACE_SIZE - offset;
+
+    if( firstLength > length )
+    {
+        firstLength = length;
+    }
+
+    ( void ) memcpy( &pRing->data[ offset ], pData, firstLength );
+    ( void ) memcpy( pRing->data, &pData[ firstLength ], length - firstLength );
+
+    pRecord->timestampUs = CommTrace_TimestampUs();
+    pRecord->dataStart = dataStart;
+    pRecord->length = length;
+
+    /* Data and record must be visible before the record is published. */
+    COMM_RING_MEMORY_BARRIER();
+    pRing->recordHead = pRing->recordHead + 1U;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a trace to a file in the capture format of comm_if_capture.h.
+ *
+ * @param[in] pTrace The trace of the instance.
+ * @param[in] pPath Path of the file.
+ *
+ * @return IOT_COMM_INTERFACE_SUCCESS if the file is written. Otherwise an error
+ * code defined in CellularCommInterfaceError_t.
+ */
+CellularCommInterfaceError_t CommTrace_Dump( const CommTrace_t * pTrace,
+                                             const char * pPath );
+
+/*-----------------------------------------------------------*/
+
+#endif /* __COMM_IF_TRACE_H__ */
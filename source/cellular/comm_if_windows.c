@@ -33,6 +33,11 @@
 
 /* Windows include file for COM port I/O. */
 #include <windows.h>
+#include <stdio.h>
+
+/* FreeRTOS include. */
+#include "FreeRTOS.h"
+#include "task.h"
 
 /* Platform layer includes. */
 #include "cellular_platform.h"
@@ -41,28 +46,97 @@
 #include "cellular_config.h"
 #include "cellular_config_defaults.h"
 #include "cellular_comm_interface.h"
+#include "comm_if.h"
+
+/* Receive ring include file. */
+#include "comm_if_ring.h"
+
+/* Wire trace include file. */
+#include "comm_if_trace.h"
+
+/* Receive burst include file. */
+#include "comm_if_burst.h"
+
+/* Statistics include file. */
+#include "comm_if_stats.h"
 
 /*-----------------------------------------------------------*/
 
-/* Define the COM port used as comm interface. */
-#ifndef CELLULAR_COMM_INTERFACE_PORT
-    #error "Define CELLULAR_COMM_INTERFACE_PORT in cellular_config.h"
+/* Define the COM ports used by the comm interface instances. */
+#ifndef CELLULAR_COMM_INTERFACE_PORT_LIST
+    #ifndef CELLULAR_COMM_INTERFACE_PORT
+        #error "Define CELLULAR_COMM_INTERFACE_PORT or CELLULAR_COMM_INTERFACE_PORT_LIST in cellular_config.h"
+    #endif
+    #ifdef CELLULAR_COMM_INTERFACE_DATA_PORT
+        #define CELLULAR_COMM_INTERFACE_PORT_LIST    { CELLULAR_COMM_INTERFACE_PORT, CELLULAR_COMM_INTERFACE_DATA_PORT }
+    #else
+        #define CELLULAR_COMM_INTERFACE_PORT_LIST    { CELLULAR_COMM_INTERFACE_PORT }
+    #endif
 #endif
-#define CELLULAR_COMM_PATH                   "\\\\.\\"CELLULAR_COMM_INTERFACE_PORT
+#define CELLULAR_COMM_PATH_PREFIX            "\\\\.\\"
+#define CELLULAR_COMM_PATH_MAX_LENGTH        ( 64U )
 
-/* Define the simulated UART interrupt number. */
+/* Define the simulated UART interrupt number. It is shared by all the
+ * instances. The receive threads mark their instance in a pending mask and the
+ * interrupt handler calls the receive callback of each marked instance. */
 #define portINTERRUPT_UART                   ( 2UL )
 
+/* Since FreeRTOS kernel V10.6.0 the Windows port allows a native Windows thread
+ * to raise a simulated interrupt. The receive thread then raises the UART
+ * interrupt directly. Older kernels need a FreeRTOS task to poll the receive
+ * event and raise the interrupt. Defining COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD
+ * to 0 keeps the polling task on newer kernels, to compare the two. */
+#ifndef COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD
+    #if ( tskKERNEL_VERSION_MAJOR > 10 ) || ( ( tskKERNEL_VERSION_MAJOR == 10 ) && ( tskKERNEL_VERSION_MINOR >= 6 ) )
+        #define COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD    ( 1 )
+    #else
+        #define COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD    ( 0 )
+    #endif
+#elif ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 1 ) && ( tskKERNEL_VERSION_MAJOR == 10 ) && ( tskKERNEL_VERSION_MINOR < 6 )
+    #error "COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD needs FreeRTOS kernel V10.6.0 or later."
+#endif
+
 /* Define the read write buffer size. */
 #define COMM_TX_BUFFER_SIZE                  ( 8192 )
 #define COMM_RX_BUFFER_SIZE                  ( 8192 )
 
-/* Receive thread timeout in ms. */
+/* Size of the receive ring filled by the receive thread. Must be a power of two. */
+#define COMM_RX_RING_SIZE                    ( 8192U )
+
+/* Size of the transmit ring drained by the writer thread. Must be a power of two. */
+#define COMM_TX_RING_SIZE                    ( 8192U )
+
+/* Receive and writer thread exit timeout in ms. */
 #define COMM_RECV_THREAD_TIMEOUT             ( 5000 )
 
 /* Write operation timeout in ms. */
 #define COMM_WRITE_OPERATION_TIMEOUT         ( 500 )
 
+/* Time close waits for the writer thread to write the transmit ring in ms. */
+#define COMM_TX_DRAIN_TIMEOUT_MS             ( 1000U )
+
+/* Line rate the modem answers at after power on. */
+#define COMM_DEFAULT_BAUD_RATE               ( 115200U )
+
+/* Negotiate the line rate and flow control with the modem in open. */
+#if ( CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE ) || ( CELLULAR_COMM_INTERFACE_FLOW_CONTROL == 1 )
+    #define COMM_IF_NEGOTIATE_LINE_SETTINGS    ( 1 )
+#else
+    #define COMM_IF_NEGOTIATE_LINE_SETTINGS    ( 0 )
+#endif
+
+/* Time to wait for the modem response to a negotiation AT command in ms. */
+#define COMM_AT_RESPONSE_TIMEOUT_MS          ( 500U )
+
+/* Interval to poll the COM port for the response of a negotiation AT command in ms. */
+#define COMM_AT_RESPONSE_POLL_MS             ( 10U )
+
+/* Size of the buffer holding the echo and response of a negotiation AT command. */
+#define COMM_AT_RESPONSE_BUFFER_SIZE         ( 64U )
+
+/* Number of AT commands sent to check the modem answers at a line rate. */
+#define COMM_AT_PROBE_RETRY                  ( 3U )
+
 /* Comm status. */
 #define CELLULAR_COMM_OPEN_BIT               ( 0x01U )
 
@@ -80,6 +154,21 @@
 #define COMM_IF_THREAD_DEFAULT_STACK_SIZE    ( 2048U )
 #define COMM_IF_THREAD_DEFAULT_PRIORITY      ( tskIDLE_PRIORITY + 5U )
 
+/* Each instance runs a commTaskThread with its own event group, next to the
+ * library's. Kernels that let the receive thread raise the UART interrupt
+ * itself have no commTaskThread. */
+#if ( PLATFORM_STATIC_ALLOCATION == 1 ) && ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 )
+    #if ( PLATFORM_THREAD_POOL_SIZE < ( PLATFORM_STATIC_LIBRARY_THREADS + CELLULAR_COMM_INTERFACE_MAX_INSTANCES ) )
+        #error "PLATFORM_THREAD_POOL_SIZE is too small for the commTaskThread of each comm interface instance."
+    #endif
+    #if ( PLATFORM_STATIC_EVENT_GROUPS < ( PLATFORM_STATIC_LIBRARY_EVENT_GROUPS + CELLULAR_COMM_INTERFACE_MAX_INSTANCES ) )
+        #error "PLATFORM_STATIC_EVENT_GROUPS is too small for the commTaskThread of each comm interface instance."
+    #endif
+    #if ( PLATFORM_THREAD_POOL_STACK_SIZE < COMM_IF_THREAD_DEFAULT_STACK_SIZE )
+        #error "PLATFORM_THREAD_POOL_STACK_SIZE is too small for commTaskThread."
+    #endif
+#endif
+
 /*-----------------------------------------------------------*/
 
 typedef struct _cellularCommContext
@@ -91,17 +180,53 @@ typedef struct _cellularCommContext
     HANDLE commFileHandle;
     CellularCommInterface_t * pCommInterface;
     bool commTaskThreadStarted;
-    EventGroupHandle_t pCommTaskEvent;
+    PlatformEventGroupHandle_t pCommTaskEvent;
+    HANDLE commAbortEvent;    /* Set by close to stop the receive and writer threads. */
+    HANDLE commRxResumeEvent; /* Set by recv to resume a receive thread stalled on a full ring. */
+    volatile bool commRxStalled;
+    CommRing_t commRxRing;
+    uint8_t commRxRingBuffer[ COMM_RX_RING_SIZE ];
+    OVERLAPPED commTxOverlapped; /* Reused by every synchronous send. */
+    uint32_t instanceIndex;
+    uint32_t commBaudRate; /* Line rate of the port, times the receive idle timeout. */
+    #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+        CommBurst_t commRxBurst; /* Bytes read since the last receive callback. */
+    #endif
+    #if ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 )
+        volatile bool intEvent; /* Indicate the UART interrupt is pending for this instance. */
+    #endif
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        HANDLE commTransmitThread;
+        HANDLE commTxDataEvent;  /* Set by send when data is queued. */
+        HANDLE commTxSpaceEvent; /* Set by the writer thread when space is released. */
+        CellularCommInterfaceTxCallback_t commTxCallback;
+        void * pTxUserData;
+        volatile LONG commTxStatus;          /* Last write error, cleared by send. */
+        volatile LONG commTxPendingStatus;   /* Write error for the next transmit callback, cleared by the interrupt. */
+        volatile LONG commTxCompletedLength; /* Bytes written since the last transmit callback. */
+        CommRing_t commTxRing;
+        uint8_t commTxRingBuffer[ COMM_TX_RING_SIZE ];
+    #endif
+    #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+        CommTrace_t commTrace; /* Cleared by open and kept after close, so a dump shows the last session. */
+    #endif
+    #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+        CommStats_t commStats;
+    #endif
 } _cellularCommContext_t;
 
 /*-----------------------------------------------------------*/
 
 /**
- * @brief CellularCommInterfaceOpen_t implementation.
+ * @brief CellularCommInterfaceOpen_t implementation of an instance.
+ *
+ * CellularCommInterfaceOpen_t has no parameter to select the port, so every
+ * instance has its own open function calling this one with its index.
  */
-static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceReceiveCallback_t receiveCallback,
-                                                      void * pUserData,
-                                                      CellularCommInterfaceHandle_t * pCommInterfaceHandle );
+static CellularCommInterfaceError_t _prvCommIntfOpenInstance( uint32_t instanceIndex,
+                                                              CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                              void * pUserData,
+                                                              CellularCommInterfaceHandle_t * pCommInterfaceHandle );
 
 /**
  * @brief CellularCommInterfaceSend_t implementation.
@@ -127,12 +252,13 @@ static CellularCommInterfaceError_t _prvCommIntfReceive( CellularCommInterfaceHa
 static CellularCommInterfaceError_t _prvCommIntfClose( CellularCommInterfaceHandle_t commInterfaceHandle );
 
 /**
- * @brief Get default comm interface context.
+ * @brief Get the comm interface context of an instance.
+ *
+ * @param[in] instanceIndex Index of the instance.
  *
- * @return On success, SOCKETS_ERROR_NONE is returned. If an error occurred, error code defined
- * in sockets_wrapper.h is returned.
+ * @return The context of the instance. NULL if instanceIndex is out of range.
  */
-static _cellularCommContext_t * _getCellularCommContext( void );
+static _cellularCommContext_t * _getCellularCommContext( uint32_t instanceIndex );
 
 /**
  * @brief UART interrupt handler.
@@ -142,6 +268,95 @@ static _cellularCommContext_t * _getCellularCommContext( void );
  */
 static uint32_t prvProcessUartInt( void );
 
+/**
+ * @brief Read the bytes pending in the COM driver into the receive ring.
+ *
+ * Called only from the receive thread, which is the single producer of the ring.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ * @param[in] pOsRead Overlapped structure owned by the receive thread.
+ *
+ * @return Number of bytes added to the ring.
+ */
+static uint32_t _commRxFill( _cellularCommContext_t * pCellularCommContext,
+                             OVERLAPPED * pOsRead );
+
+/**
+ * @brief Create the events used by the comm interface threads and send.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _setupCommEvents( _cellularCommContext_t * pCellularCommContext );
+
+/**
+ * @brief Close the events created in open.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ */
+static void _cleanCommEvents( _cellularCommContext_t * pCellularCommContext );
+
+/**
+ * @brief Wait for a comm interface thread to exit and close its handle.
+ *
+ * @param[in] pThread Thread handle returned by CreateThread. Set to NULL.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _cleanCommThread( HANDLE * pThread );
+
+/**
+ * @brief Mark the instance in a pending mask and raise the UART interrupt.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ * @param[in] pPendingMask The receive or transmit pending mask.
+ */
+static void _commGenerateInterrupt( _cellularCommContext_t * pCellularCommContext,
+                                    volatile LONG * pPendingMask );
+
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+
+/**
+ * @brief Copy send data into the transmit ring.
+ *
+ * Waits up to timeoutMilliseconds for the writer thread to release space
+ * when the ring is full.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _commTxQueue( _cellularCommContext_t * pCellularCommContext,
+                                                  const uint8_t * pData,
+                                                  uint32_t dataLength,
+                                                  uint32_t timeoutMilliseconds,
+                                                  uint32_t * pDataSentLength );
+
+/**
+ * @brief Wait up to COMM_TX_DRAIN_TIMEOUT_MS for the writer thread to write the transmit ring.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return Bytes left in the transmit ring.
+ */
+static uint32_t _commTxDrain( _cellularCommContext_t * pCellularCommContext );
+
+#endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
+
+/**
+ * @brief Write send data to the COM port and wait for the write to complete.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _commTxWrite( _cellularCommContext_t * pCellularCommContext,
+                                                  const uint8_t * pData,
+                                                  uint32_t dataLength,
+                                                  uint32_t timeoutMilliseconds,
+                                                  uint32_t * pDataSentLength );
+
 /**
  * @brief Set COM port timeout settings.
  *
@@ -156,11 +371,61 @@ static CellularCommInterfaceError_t _setupCommTimeout( HANDLE hComm );
  * @brief Set COM port control settings.
  *
  * @param[in] hComm COM handle returned by CreateFile.
+ * @param[in] baudRate Line rate in bits per second.
+ * @param[in] flowControl Enable RTS/CTS hardware flow control.
+ *
+ * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
+ * in CellularCommInterfaceError_t is returned.
+ */
+static CellularCommInterfaceError_t _setupCommSettings( HANDLE hComm,
+                                                        uint32_t baudRate,
+                                                        bool flowControl );
+
+#if ( COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 )
+
+/**
+ * @brief Send an AT command and wait for the modem to answer OK.
+ *
+ * Only used in open, before the receive thread reads the COM port.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ * @param[in] pCommand AT command terminated with a carriage return.
+ *
+ * @return true if the modem answered OK.
+ */
+static bool _commAtCommand( _cellularCommContext_t * pCellularCommContext,
+                            const char * pCommand );
+
+#if ( CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE )
+
+/**
+ * @brief Check the modem answers AT at the current line rate.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
+ *
+ * @return true if the modem answered OK.
+ */
+static bool _commProbeModem( _cellularCommContext_t * pCellularCommContext );
+
+#endif
+
+/**
+ * @brief Negotiate the line rate and flow control with the modem.
+ *
+ * The rate is requested with AT+IPR and flow control with AT+IFC. The COM
+ * port falls back to 115200 without flow control if the modem does not
+ * accept the configured settings.
+ *
+ * @param[in] pCellularCommContext Cellular comm interface context allocated in open.
  *
  * @return On success, IOT_COMM_INTERFACE_SUCCESS is returned. If an error occurred, error code defined
  * in CellularCommInterfaceError_t is returned.
  */
-static CellularCommInterfaceError_t _setupCommSettings( HANDLE hComm );
+static CellularCommInterfaceError_t _commNegotiateLineSettings( _cellularCommContext_t * pCellularCommContext );
+
+#endif /* COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 */
+
+#if ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 )
 
 /**
  * @brief Thread routine to generate simulated interrupt.
@@ -189,62 +454,300 @@ static CellularCommInterfaceError_t setupCommTaskThread( _cellularCommContext_t
  */
 static CellularCommInterfaceError_t cleanCommTaskThread( _cellularCommContext_t * pCellularCommContext );
 
+#endif /* COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 */
+
 /*-----------------------------------------------------------*/
 
-CellularCommInterface_t CellularCommInterface =
-{
-    .open  = _prvCommIntfOpen,
-    .send  = _prvCommIntfSend,
-    .recv  = _prvCommIntfReceive,
-    .close = _prvCommIntfClose
-};
+/* Open functions of the instances, CellularCommInterface and the instance accessors. */
+#include "comm_if_instances.h"
 
-static _cellularCommContext_t _iotCellularCommContext =
-{
-    .commReceiveCallback       = NULL,
-    .commReceiveCallbackThread = NULL,
-    .pCommInterface            = &CellularCommInterface,
-    .commFileHandle            = NULL,
-    .pUserData                 = NULL,
-    .commStatus                = 0U,
-    .commTaskThreadStarted     = false,
-    .pCommTaskEvent            = NULL
-};
+/*-----------------------------------------------------------*/
+
+static _cellularCommContext_t _iotCellularCommContexts[ CELLULAR_COMM_INTERFACE_MAX_INSTANCES ] = { 0 };
 
-/* Inidicate RX event is received in comm driver. */
-static bool rxEvent = false;
+static const char * _iotCellularCommPorts[ CELLULAR_COMM_INTERFACE_MAX_INSTANCES ] = CELLULAR_COMM_INTERFACE_PORT_LIST;
+
+/* Instances with received data not yet passed to the receive callback. */
+static volatile LONG _commRxPendingMask = 0;
+
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+    /* Instances with transmit completion not yet passed to the transmit callback. */
+    static volatile LONG _commTxPendingMask = 0;
+#endif
 
 /*-----------------------------------------------------------*/
 
-static _cellularCommContext_t * _getCellularCommContext( void )
+static _cellularCommContext_t * _getCellularCommContext( uint32_t instanceIndex )
 {
-    return &_iotCellularCommContext;
+    _cellularCommContext_t * pCellularCommContext = NULL;
+
+    if( instanceIndex < CELLULAR_COMM_INTERFACE_MAX_INSTANCES )
+    {
+        pCellularCommContext = &_iotCellularCommContexts[ instanceIndex ];
+    }
+
+    return pCellularCommContext;
 }
 
 /*-----------------------------------------------------------*/
 
 static uint32_t prvProcessUartInt( void )
 {
-    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext();
+    _cellularCommContext_t * pCellularCommContext = NULL;
+    CellularCommInterfaceReceiveCallback_t receiveCallback = NULL;
     CellularCommInterfaceError_t callbackRet = IOT_COMM_INTERFACE_FAILURE;
-    uint32_t retUartInt = pdTRUE;
+    uint32_t retUartInt = pdFALSE;
+    uint32_t pendingMask = ( uint32_t ) InterlockedExchange( &_commRxPendingMask, 0 );
+    uint32_t instanceIndex = 0;
+
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        CellularCommInterfaceTxCallback_t txCallback = NULL;
+        uint32_t txPendingMask = ( uint32_t ) InterlockedExchange( &_commTxPendingMask, 0 );
+        uint32_t txLength = 0;
+        CellularCommInterfaceError_t txStatus = IOT_COMM_INTERFACE_SUCCESS;
+
+        for( instanceIndex = 0; instanceIndex < CELLULAR_COMM_INTERFACE_MAX_INSTANCES; instanceIndex++ )
+        {
+            if( ( txPendingMask & ( 1UL << instanceIndex ) ) != 0U )
+            {
+                pCellularCommContext = &_iotCellularCommContexts[ instanceIndex ];
+                txCallback = pCellularCommContext->commTxCallback;
+                txLength = ( uint32_t ) InterlockedExchange( &pCellularCommContext->commTxCompletedLength, 0 );
+
+                /* Send clears commTxStatus, so the error is reported from its own copy. */
+                txStatus = ( CellularCommInterfaceError_t ) InterlockedExchange( &pCellularCommContext->commTxPendingStatus,
+                                                                                 ( LONG ) IOT_COMM_INTERFACE_SUCCESS );
+
+                if( txCallback != NULL )
+                {
+                    txCallback( pCellularCommContext->pTxUserData,
+                                ( CellularCommInterfaceHandle_t ) pCellularCommContext,
+                                txStatus,
+                                txLength );
+                }
+            }
+        }
+    #endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
 
-    if( pCellularCommContext->commReceiveCallback != NULL )
+    for( instanceIndex = 0; instanceIndex < CELLULAR_COMM_INTERFACE_MAX_INSTANCES; instanceIndex++ )
     {
-        callbackRet = pCellularCommContext->commReceiveCallback( pCellularCommContext->pUserData,
-                                                                 ( CellularCommInterfaceHandle_t ) pCellularCommContext );
+        if( ( pendingMask & ( 1UL << instanceIndex ) ) != 0U )
+        {
+            pCellularCommContext = &_iotCellularCommContexts[ instanceIndex ];
+            receiveCallback = pCellularCommContext->commReceiveCallback;
+
+            if( receiveCallback != NULL )
+            {
+                #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                    CommStats_Callback( &pCellularCommContext->commStats );
+                #endif
+                callbackRet = receiveCallback( pCellularCommContext->pUserData,
+                                               ( CellularCommInterfaceHandle_t ) pCellularCommContext );
+
+                if( callbackRet == IOT_COMM_INTERFACE_SUCCESS )
+                {
+                    retUartInt = pdTRUE;
+                }
+            }
+        }
     }
 
-    if( callbackRet == IOT_COMM_INTERFACE_SUCCESS )
+    return retUartInt;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t _commRxFill( _cellularCommContext_t * pCellularCommContext,
+                             OVERLAPPED * pOsRead )
+{
+    HANDLE hComm = pCellularCommContext->commFileHandle;
+    CommRing_t * pRing = &pCellularCommContext->commRxRing;
+    uint8_t * pWrite = NULL;
+    uint32_t spanLength = 0;
+    uint32_t totalRead = 0;
+    DWORD dwRead = 0;
+    DWORD dwErrors = 0;
+    COMSTAT comStat = { 0 };
+    BOOL Status = TRUE;
+
+    while( true )
     {
-        retUartInt = pdTRUE;
+        spanLength = CommRing_GetWriteSpan( pRing, &pWrite );
+
+        if( spanLength == 0U )
+        {
+            /* Ring is full. Stall until recv frees space if the driver still has data. */
+            if( ( ClearCommError( hComm, &dwErrors, &comStat ) != FALSE ) && ( comStat.cbInQue > 0U ) )
+            {
+                pCellularCommContext->commRxStalled = true;
+                COMM_RING_MEMORY_BARRIER();
+
+                /* Check again in case recv freed space before it could see the flag. */
+                if( CommRing_GetWriteSpan( pRing, &pWrite ) == 0U )
+                {
+                    pRing->overrunCount++;
+                    break;
+                }
+
+                pCellularCommContext->commRxStalled = false;
+                continue;
+            }
+
+            break;
+        }
+
+        dwRead = 0;
+        Status = ReadFile( hComm, pWrite, spanLength, &dwRead, pOsRead );
+
+        /* ReadIntervalTimeout is MAXDWORD so pending reads complete immediately. */
+        if( ( Status == FALSE ) && ( GetLastError() == ERROR_IO_PENDING ) )
+        {
+            Status = GetOverlappedResult( hComm, pOsRead, &dwRead, TRUE );
+        }
+
+        if( Status == FALSE )
+        {
+            CellularLogDebug( "Cellular receive thread ReadFile fail %d", GetLastError() );
+            break;
+        }
+
+        if( dwRead == 0U )
+        {
+            break;
+        }
+
+        #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+            CommTrace_Record( &pCellularCommContext->commTrace, COMM_TRACE_RX, pWrite, ( uint32_t ) dwRead );
+        #endif
+        #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+            CommBurst_Add( &pCellularCommContext->commRxBurst, pWrite, ( uint32_t ) dwRead );
+        #endif
+        #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+            CommStats_Read( &pCellularCommContext->commStats, ( uint32_t ) dwRead );
+        #endif
+        CommRing_Commit( pRing, ( uint32_t ) dwRead );
+        totalRead = totalRead + ( uint32_t ) dwRead;
+
+        if( dwRead < spanLength )
+        {
+            /* COM driver is drained. */
+            break;
+        }
     }
-    else
+
+    return totalRead;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _setupCommEvents( _cellularCommContext_t * pCellularCommContext )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+
+    pCellularCommContext->commAbortEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+    pCellularCommContext->commRxResumeEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+    pCellularCommContext->commTxOverlapped.hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+    if( ( pCellularCommContext->commAbortEvent == NULL ) || ( pCellularCommContext->commRxResumeEvent == NULL ) ||
+        ( pCellularCommContext->commTxOverlapped.hEvent == NULL ) )
     {
-        retUartInt = pdFALSE;
+        CellularLogError( "Cellular CreateEvent fail %d", GetLastError() );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
     }
 
-    return retUartInt;
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+        {
+            pCellularCommContext->commTxDataEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+            pCellularCommContext->commTxSpaceEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+
+            if( ( pCellularCommContext->commTxDataEvent == NULL ) || ( pCellularCommContext->commTxSpaceEvent == NULL ) )
+            {
+                CellularLogError( "Cellular CreateEvent fail %d", GetLastError() );
+                commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            }
+        }
+    #endif
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _cleanCommEvents( _cellularCommContext_t * pCellularCommContext )
+{
+    if( pCellularCommContext->commAbortEvent != NULL )
+    {
+        ( void ) CloseHandle( pCellularCommContext->commAbortEvent );
+        pCellularCommContext->commAbortEvent = NULL;
+    }
+
+    if( pCellularCommContext->commRxResumeEvent != NULL )
+    {
+        ( void ) CloseHandle( pCellularCommContext->commRxResumeEvent );
+        pCellularCommContext->commRxResumeEvent = NULL;
+    }
+
+    if( pCellularCommContext->commTxOverlapped.hEvent != NULL )
+    {
+        ( void ) CloseHandle( pCellularCommContext->commTxOverlapped.hEvent );
+        pCellularCommContext->commTxOverlapped.hEvent = NULL;
+    }
+
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        if( pCellularCommContext->commTxDataEvent != NULL )
+        {
+            ( void ) CloseHandle( pCellularCommContext->commTxDataEvent );
+            pCellularCommContext->commTxDataEvent = NULL;
+        }
+
+        if( pCellularCommContext->commTxSpaceEvent != NULL )
+        {
+            ( void ) CloseHandle( pCellularCommContext->commTxSpaceEvent );
+            pCellularCommContext->commTxSpaceEvent = NULL;
+        }
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _cleanCommThread( HANDLE * pThread )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    DWORD dwRes = 0;
+
+    if( *pThread != NULL )
+    {
+        dwRes = WaitForSingleObject( *pThread, COMM_RECV_THREAD_TIMEOUT );
+
+        if( dwRes != WAIT_OBJECT_0 )
+        {
+            CellularLogDebug( "Cellular close wait thread %p fail %d", *pThread, dwRes );
+            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        }
+        else
+        {
+            ( void ) CloseHandle( *pThread );
+        }
+    }
+
+    *pThread = NULL;
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _commGenerateInterrupt( _cellularCommContext_t * pCellularCommContext,
+                                    volatile LONG * pPendingMask )
+{
+    ( void ) InterlockedOr( pPendingMask, ( LONG ) ( 1UL << pCellularCommContext->instanceIndex ) );
+
+    #if ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 1 )
+        vPortGenerateSimulatedInterruptFromWindowsThread( portINTERRUPT_UART );
+    #else
+        pCellularCommContext->intEvent = true;
+    #endif
 }
 
 /*-----------------------------------------------------------*/
@@ -252,55 +755,386 @@ static uint32_t prvProcessUartInt( void )
 /**
  * @brief Communication receiver thread function.
  *
- * @param[in] pArgument windows COM port handle.
+ * The thread waits for COM events, reads everything pending in the COM driver
+ * into the receive ring and then raises the UART interrupt once for the burst.
+ * With CELLULAR_COMM_INTERFACE_RX_COALESCE, reads are collected until the
+ * burst is complete, see comm_if_burst.h.
+ *
+ * @param[in] pArgument Pointer to _cellularCommContext_t allocated in comm interface open.
  * @return 0 if thread function exit without error. Others for error.
  */
 DWORD WINAPI _CellularCommReceiveCBThreadFunc( LPVOID pArgument )
 {
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) pArgument;
+    HANDLE hComm = pCellularCommContext->commFileHandle;
+    OVERLAPPED osWait = { 0 };
+    OVERLAPPED osRead = { 0 };
+    HANDLE waitEvents[ 3 ] = { NULL };
     DWORD dwCommStatus = 0;
-    HANDLE hComm = ( HANDLE ) pArgument;
+    DWORD dwTransferred = 0;
+    DWORD dwRes = 0;
+    DWORD waitTimeout = INFINITE;
+    uint32_t rxLength = 0;
+    bool rxNotify = false;
     BOOL retWait = FALSE;
+    bool waitPending = false;
     DWORD retValue = 0;
 
-    if( hComm == ( HANDLE ) INVALID_HANDLE_VALUE )
+    osWait.hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+    osRead.hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+    if( ( osWait.hEvent == NULL ) || ( osRead.hEvent == NULL ) )
     {
-        retValue = ERROR_INVALID_HANDLE;
+        CellularLogError( "Cellular receiver thread CreateEvent fail %d", GetLastError() );
+        retValue = GetLastError();
     }
 
+    waitEvents[ 0 ] = osWait.hEvent;
+    waitEvents[ 1 ] = pCellularCommContext->commRxResumeEvent;
+    waitEvents[ 2 ] = pCellularCommContext->commAbortEvent;
+
     while( retValue == 0 )
     {
-        retWait = WaitCommEvent( hComm, &dwCommStatus, NULL );
-
-        if( ( retWait != FALSE ) && ( ( dwCommStatus & EV_RXCHAR ) != 0 ) )
+        if( waitPending == false )
         {
-            if( ( dwCommStatus & EV_RXCHAR ) != 0 )
+            retWait = WaitCommEvent( hComm, &dwCommStatus, &osWait );
+
+            if( ( retWait == FALSE ) && ( GetLastError() != ERROR_IO_PENDING ) )
             {
-                rxEvent = true;
+                CellularLogInfo( "Cellular receiver thread wait comm error %p %d", hComm, GetLastError() );
+                retValue = GetLastError();
+                break;
             }
+
+            /* The event of osWait is signaled on both immediate and pending completion. */
+            waitPending = true;
         }
-        else
+
+        #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+            /* Wait for the line to go idle while a burst is collected. */
+            waitTimeout = ( pCellularCommContext->commRxBurst.length > 0U ) ?
+                          ( DWORD ) CommBurst_IdleTimeoutMs( pCellularCommContext->commBaudRate ) : INFINITE;
+        #endif
+
+        dwRes = WaitForMultipleObjects( 3, waitEvents, FALSE, waitTimeout );
+        rxLength = 0;
+        rxNotify = false;
+
+        if( dwRes == WAIT_OBJECT_0 )
         {
-            if( ( GetLastError() == ERROR_INVALID_HANDLE ) || ( GetLastError() == ERROR_OPERATION_ABORTED ) )
+            waitPending = false;
+
+            if( GetOverlappedResult( hComm, &osWait, &dwTransferred, FALSE ) == FALSE )
             {
                 /* COM port closed. */
-                CellularLogInfo( "Cellular COM port %p closed", hComm );
+                CellularLogInfo( "Cellular COM port %p closed %d", hComm, GetLastError() );
+                retValue = GetLastError();
+            }
+            else if( ( dwCommStatus & EV_RXCHAR ) != 0 )
+            {
+                rxLength = _commRxFill( pCellularCommContext, &osRead );
             }
             else
             {
-                CellularLogInfo( "Cellular receiver thread wait comm error %p %d", hComm, GetLastError() );
+                /* Empty else for MISRA 15.7 compliance. */
             }
+        }
+        else if( dwRes == ( WAIT_OBJECT_0 + 1U ) )
+        {
+            /* recv freed space in the ring. Read the data left in the COM driver. */
+            rxLength = _commRxFill( pCellularCommContext, &osRead );
+        }
+        else if( dwRes == WAIT_TIMEOUT )
+        {
+            /* The line is idle, the burst is complete. */
+            rxNotify = true;
+        }
+        else
+        {
+            /* Abort event from close or wait failure. */
+            retValue = ( dwRes == ( WAIT_OBJECT_0 + 2U ) ) ? ERROR_OPERATION_ABORTED : GetLastError();
+        }
 
-            retValue = GetLastError();
+        if( rxLength > 0U )
+        {
+            #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+                /* A full ring can only be drained by recv, don't wait for the line to go idle. */
+                rxNotify = ( CommBurst_Complete( &pCellularCommContext->commRxBurst ) == true ) ||
+                           ( pCellularCommContext->commRxStalled == true );
+            #else
+                rxNotify = true;
+            #endif
+        }
 
-            break;
+        /* Raise the UART interrupt once for all the bytes read. */
+        if( ( rxNotify == true ) && ( retValue == 0U ) )
+        {
+            #if ( CELLULAR_COMM_INTERFACE_RX_COALESCE == 1 )
+                CommBurst_Reset( &pCellularCommContext->commRxBurst );
+            #endif
+
+            _commGenerateInterrupt( pCellularCommContext, &_commRxPendingMask );
         }
     }
 
+    /* Cancel the pending WaitCommEvent before its OVERLAPPED goes out of scope. */
+    if( waitPending == true )
+    {
+        ( void ) SetCommMask( hComm, 0 );
+        ( void ) GetOverlappedResult( hComm, &osWait, &dwTransferred, TRUE );
+    }
+
+    if( osWait.hEvent != NULL )
+    {
+        ( void ) CloseHandle( osWait.hEvent );
+    }
+
+    if( osRead.hEvent != NULL )
+    {
+        ( void ) CloseHandle( osRead.hEvent );
+    }
+
     return retValue;
 }
 
 /*-----------------------------------------------------------*/
 
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+
+/**
+ * @brief Communication writer thread function.
+ *
+ * The thread writes the data queued by send in the transmit ring to the COM
+ * port and raises the UART interrupt to report completion when the ring is
+ * drained or a write fails.
+ *
+ * @param[in] pArgument Pointer to _cellularCommContext_t allocated in comm interface open.
+ * @return 0 if thread function exit without error. Others for error.
+ */
+DWORD WINAPI _CellularCommTransmitThreadFunc( LPVOID pArgument )
+{
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) pArgument;
+    HANDLE hComm = pCellularCommContext->commFileHandle;
+    CommRing_t * pRing = &pCellularCommContext->commTxRing;
+    OVERLAPPED osWrite = { 0 };
+    HANDLE dataEvents[ 2 ] = { NULL };
+    HANDLE writeEvents[ 2 ] = { NULL };
+    uint8_t * pRead = NULL;
+    uint32_t spanLength = 0;
+    CellularCommInterfaceError_t txStatus = IOT_COMM_INTERFACE_SUCCESS;
+    DWORD dwWritten = 0;
+    DWORD dwRes = 0;
+    BOOL Status = TRUE;
+    DWORD retValue = 0;
+
+    #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+        uint32_t writeStartUs = 0;
+    #endif
+
+    osWrite.hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+    if( osWrite.hEvent == NULL )
+    {
+        CellularLogError( "Cellular writer thread CreateEvent fail %d", GetLastError() );
+        retValue = GetLastError();
+    }
+
+    dataEvents[ 0 ] = pCellularCommContext->commTxDataEvent;
+    dataEvents[ 1 ] = pCellularCommContext->commAbortEvent;
+    writeEvents[ 0 ] = osWrite.hEvent;
+    writeEvents[ 1 ] = pCellularCommContext->commAbortEvent;
+
+    while( retValue == 0 )
+    {
+        spanLength = CommRing_GetReadSpan( pRing, &pRead );
+
+        if( spanLength == 0U )
+        {
+            /* Wait for send to queue more data. */
+            dwRes = WaitForMultipleObjects( 2, dataEvents, FALSE, INFINITE );
+
+            if( dwRes != WAIT_OBJECT_0 )
+            {
+                retValue = ( dwRes == ( WAIT_OBJECT_0 + 1U ) ) ? ERROR_OPERATION_ABORTED : GetLastError();
+            }
+
+            continue;
+        }
+
+        dwWritten = 0;
+        txStatus = IOT_COMM_INTERFACE_SUCCESS;
+
+        #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+            /* A write retried after a timeout keeps its start time. */
+            if( writeStartUs == 0U )
+            {
+                writeStartUs = CommTrace_TimestampUs();
+            }
+        #endif
+
+        Status = WriteFile( hComm, pRead, spanLength, &dwWritten, &osWrite );
+
+        if( ( Status == FALSE ) && ( GetLastError() == ERROR_IO_PENDING ) )
+        {
+            dwRes = WaitForMultipleObjects( 2, writeEvents, FALSE, INFINITE );
+
+            if( dwRes != WAIT_OBJECT_0 )
+            {
+                /* Close is in progress. Cancel the write before osWrite goes out of scope. */
+                ( void ) CancelIo( hComm );
+                retValue = ERROR_OPERATION_ABORTED;
+            }
+
+            Status = GetOverlappedResult( hComm, &osWrite, &dwWritten, TRUE );
+        }
+
+        if( Status == FALSE )
+        {
+            CellularLogError( "Cellular writer thread WriteFile fail %d", GetLastError() );
+            txStatus = IOT_COMM_INTERFACE_DRIVER_ERROR;
+
+            /* Drop the span which can not be written. */
+            dwWritten = spanLength;
+
+            #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                pCellularCommContext->commStats.stats.writeErrorCount++;
+                writeStartUs = 0;
+            #endif
+        }
+        else if( dwWritten == 0U )
+        {
+            /* Write timeout, the modem holds CTS. The span stays in the ring and is
+             * written again on the next loop. A send finding the ring full reports
+             * the stall. */
+        }
+        else
+        {
+            #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+                CommTrace_Record( &pCellularCommContext->commTrace, COMM_TRACE_TX, pRead, ( uint32_t ) dwWritten );
+            #endif
+            #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+                CommStats_Write( &pCellularCommContext->commStats, ( uint32_t ) dwWritten, writeStartUs );
+                writeStartUs = 0;
+            #endif
+            ( void ) InterlockedExchangeAdd( &pCellularCommContext->commTxCompletedLength, ( LONG ) dwWritten );
+        }
+
+        CommRing_Release( pRing, ( uint32_t ) dwWritten );
+        ( void ) SetEvent( pCellularCommContext->commTxSpaceEvent );
+
+        if( txStatus != IOT_COMM_INTERFACE_SUCCESS )
+        {
+            ( void ) InterlockedExchange( &pCellularCommContext->commTxStatus, ( LONG ) txStatus );
+            ( void ) InterlockedExchange( &pCellularCommContext->commTxPendingStatus, ( LONG ) txStatus );
+        }
+
+        /* Report completion once the ring is drained, or the error right away. */
+        if( ( pCellularCommContext->commTxCallback != NULL ) &&
+            ( ( txStatus != IOT_COMM_INTERFACE_SUCCESS ) || ( CommRing_Used( pRing ) == 0U ) ) )
+        {
+            _commGenerateInterrupt( pCellularCommContext, &_commTxPendingMask );
+        }
+    }
+
+    if( osWrite.hEvent != NULL )
+    {
+        ( void ) CloseHandle( osWrite.hEvent );
+    }
+
+    return retValue;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _commTxQueue( _cellularCommContext_t * pCellularCommContext,
+                                                  const uint8_t * pData,
+                                                  uint32_t dataLength,
+                                                  uint32_t timeoutMilliseconds,
+                                                  uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    CommRing_t * pRing = &pCellularCommContext->commTxRing;
+    uint8_t * pWrite = NULL;
+    uint32_t spanLength = 0;
+    uint32_t queuedLength = 0;
+    uint64_t startTimeMs = Platform_GetTimeMs();
+    DWORD elapsedTime = 0;
+    DWORD dwRes = 0;
+
+    /* Report the write error of data queued by a previous send. */
+    commIntRet = ( CellularCommInterfaceError_t ) InterlockedExchange( &pCellularCommContext->commTxStatus,
+                                                                       ( LONG ) IOT_COMM_INTERFACE_SUCCESS );
+
+    while( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( queuedLength < dataLength ) )
+    {
+        spanLength = CommRing_GetWriteSpan( pRing, &pWrite );
+
+        if( spanLength > 0U )
+        {
+            if( spanLength > ( dataLength - queuedLength ) )
+            {
+                spanLength = dataLength - queuedLength;
+            }
+
+            ( void ) memcpy( pWrite, &pData[ queuedLength ], spanLength );
+            CommRing_Commit( pRing, spanLength );
+            queuedLength = queuedLength + spanLength;
+            ( void ) SetEvent( pCellularCommContext->commTxDataEvent );
+        }
+        else
+        {
+            /* Ring is full. Wait for the writer thread to release space. */
+            elapsedTime = ( DWORD ) ( Platform_GetTimeMs() - startTimeMs );
+            dwRes = ( elapsedTime < timeoutMilliseconds ) ?
+                    WaitForSingleObject( pCellularCommContext->commTxSpaceEvent, timeoutMilliseconds - elapsedTime ) :
+                    WAIT_TIMEOUT;
+
+            if( dwRes == WAIT_TIMEOUT )
+            {
+                CellularLogError( "Cellular send transmit ring full timeout" );
+                commIntRet = IOT_COMM_INTERFACE_TIMEOUT;
+            }
+            else if( dwRes != WAIT_OBJECT_0 )
+            {
+                CellularLogError( "Cellular WaitForSingleObject fail %d", dwRes );
+                commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    }
+
+    *pDataSentLength = queuedLength;
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t _commTxDrain( _cellularCommContext_t * pCellularCommContext )
+{
+    CommRing_t * pRing = &pCellularCommContext->commTxRing;
+    uint64_t startTimeMs = Platform_GetTimeMs();
+    DWORD elapsedTime = 0;
+    DWORD dwRes = WAIT_OBJECT_0;
+
+    while( ( CommRing_Used( pRing ) > 0U ) && ( dwRes == WAIT_OBJECT_0 ) )
+    {
+        elapsedTime = ( DWORD ) ( Platform_GetTimeMs() - startTimeMs );
+        dwRes = ( elapsedTime < COMM_TX_DRAIN_TIMEOUT_MS ) ?
+                WaitForSingleObject( pCellularCommContext->commTxSpaceEvent, COMM_TX_DRAIN_TIMEOUT_MS - elapsedTime ) :
+                WAIT_TIMEOUT;
+    }
+
+    return CommRing_Used( pRing );
+}
+
+#endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
+
+/*-----------------------------------------------------------*/
+
 static CellularCommInterfaceError_t _setupCommTimeout( HANDLE hComm )
 {
     CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
@@ -328,7 +1162,9 @@ static CellularCommInterfaceError_t _setupCommTimeout( HANDLE hComm )
 
 /*-----------------------------------------------------------*/
 
-static CellularCommInterfaceError_t _setupCommSettings( HANDLE hComm )
+static CellularCommInterfaceError_t _setupCommSettings( HANDLE hComm,
+                                                        uint32_t baudRate,
+                                                        bool flowControl )
 {
     CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
     DCB dcbSerialParams = { 0 };
@@ -336,52 +1172,224 @@ static CellularCommInterfaceError_t _setupCommSettings( HANDLE hComm )
 
     ( void ) memset( &dcbSerialParams, 0, sizeof( dcbSerialParams ) );
     dcbSerialParams.DCBlength = sizeof( dcbSerialParams );
-    dcbSerialParams.BaudRate = CBR_115200;
+    dcbSerialParams.BaudRate = baudRate;
     dcbSerialParams.fBinary = 1;
     dcbSerialParams.ByteSize = 8;
     dcbSerialParams.StopBits = ONESTOPBIT;
     dcbSerialParams.Parity = NOPARITY;
 
-    dcbSerialParams.fOutxCtsFlow = FALSE;
-    dcbSerialParams.fOutxDsrFlow = FALSE;
-    dcbSerialParams.fDtrControl = DTR_CONTROL_ENABLE;
-    dcbSerialParams.fRtsControl = RTS_CONTROL_ENABLE;
+    dcbSerialParams.fOutxCtsFlow = ( flowControl == true ) ? TRUE : FALSE;
+    dcbSerialParams.fOutxDsrFlow = FALSE;
+    dcbSerialParams.fDtrControl = DTR_CONTROL_ENABLE;
+    dcbSerialParams.fRtsControl = ( flowControl == true ) ? RTS_CONTROL_HANDSHAKE : RTS_CONTROL_ENABLE;
+
+    Status = SetCommState( hComm, &dcbSerialParams );
+
+    if( Status == FALSE )
+    {
+        CellularLogError( "Cellular SetCommState fail %d", GetLastError() );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 )
+
+static bool _commAtCommand( _cellularCommContext_t * pCellularCommContext,
+                            const char * pCommand )
+{
+    HANDLE hComm = pCellularCommContext->commFileHandle;
+    OVERLAPPED osRead = { 0 };
+    char response[ COMM_AT_RESPONSE_BUFFER_SIZE ] = { 0 };
+    uint32_t responseLength = 0;
+    uint32_t sentLength = 0;
+    uint32_t waitTime = 0;
+    DWORD dwRead = 0;
+    bool okReceived = false;
+    bool errorReceived = false;
+
+    osRead.hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+    /* Drop anything the modem sent before the command. */
+    ( void ) PurgeComm( hComm, PURGE_RXCLEAR );
+
+    if( osRead.hEvent == NULL )
+    {
+        CellularLogError( "Cellular CreateEvent fail %d", GetLastError() );
+    }
+    else if( _commTxWrite( pCellularCommContext, ( const uint8_t * ) pCommand, ( uint32_t ) strlen( pCommand ),
+                           COMM_AT_RESPONSE_TIMEOUT_MS, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        while( ( okReceived == false ) && ( errorReceived == false ) && ( waitTime < COMM_AT_RESPONSE_TIMEOUT_MS ) )
+        {
+            vTaskDelay( pdMS_TO_TICKS( COMM_AT_RESPONSE_POLL_MS ) );
+            waitTime = waitTime + COMM_AT_RESPONSE_POLL_MS;
+            dwRead = 0;
+
+            /* ReadFile returns immediately with the bytes already received. */
+            if( ( ReadFile( hComm, &response[ responseLength ], ( DWORD ) ( sizeof( response ) - 1U - responseLength ),
+                            &dwRead, &osRead ) == FALSE ) &&
+                ( ( GetLastError() != ERROR_IO_PENDING ) ||
+                  ( GetOverlappedResult( hComm, &osRead, &dwRead, TRUE ) == FALSE ) ) )
+            {
+                dwRead = 0;
+            }
+
+            #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+                if( dwRead > 0U )
+                {
+                    CommTrace_Record( &pCellularCommContext->commTrace, COMM_TRACE_RX,
+                                      ( const uint8_t * ) &response[ responseLength ], ( uint32_t ) dwRead );
+                }
+            #endif
+            responseLength = responseLength + ( uint32_t ) dwRead;
+            response[ responseLength ] = '\0';
+            okReceived = ( strstr( response, "OK\r\n" ) != NULL );
+            errorReceived = ( strstr( response, "ERROR" ) != NULL );
+
+            /* Keep the tail of a long echo, it may hold a partial response. */
+            if( responseLength == ( sizeof( response ) - 1U ) )
+            {
+                ( void ) memmove( response, &response[ responseLength - 4U ], 4U );
+                responseLength = 4U;
+            }
+        }
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    if( osRead.hEvent != NULL )
+    {
+        ( void ) CloseHandle( osRead.hEvent );
+    }
+
+    return okReceived;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE )
+
+static bool _commProbeModem( _cellularCommContext_t * pCellularCommContext )
+{
+    bool okReceived = false;
+    uint32_t retry = 0;
+
+    /* The first command after a rate change may be lost while the modem switches. */
+    for( retry = 0; ( retry < COMM_AT_PROBE_RETRY ) && ( okReceived == false ); retry++ )
+    {
+        okReceived = _commAtCommand( pCellularCommContext, "AT\r" );
+    }
+
+    return okReceived;
+}
+
+#endif /* CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE */
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _commNegotiateLineSettings( _cellularCommContext_t * pCellularCommContext )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    HANDLE hComm = pCellularCommContext->commFileHandle;
+    uint32_t baudRate = COMM_DEFAULT_BAUD_RATE;
+    bool flowControl = false;
+
+    #if ( CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE )
+        char atCommand[ 32 ] = { 0 };
+
+        if( _commProbeModem( pCellularCommContext ) == false )
+        {
+            /* The modem may still run at the rate negotiated in a previous session. */
+            if( ( _setupCommSettings( hComm, CELLULAR_COMM_INTERFACE_BAUD_RATE, false ) == IOT_COMM_INTERFACE_SUCCESS ) &&
+                ( _commProbeModem( pCellularCommContext ) == true ) )
+            {
+                baudRate = CELLULAR_COMM_INTERFACE_BAUD_RATE;
+            }
+        }
+        else
+        {
+            ( void ) snprintf( atCommand, sizeof( atCommand ), "AT+IPR=%u\r", CELLULAR_COMM_INTERFACE_BAUD_RATE );
+
+            /* The modem answers OK at the old rate and switches after the response. */
+            if( _commAtCommand( pCellularCommContext, atCommand ) == true )
+            {
+                if( ( _setupCommSettings( hComm, CELLULAR_COMM_INTERFACE_BAUD_RATE, false ) == IOT_COMM_INTERFACE_SUCCESS ) &&
+                    ( _commProbeModem( pCellularCommContext ) == true ) )
+                {
+                    baudRate = CELLULAR_COMM_INTERFACE_BAUD_RATE;
+                }
+                else
+                {
+                    /* Ask the modem to go back to the default rate in case it switched. */
+                    ( void ) _commAtCommand( pCellularCommContext, "AT+IPR=115200\r" );
+                }
+            }
+        }
+
+        if( baudRate != CELLULAR_COMM_INTERFACE_BAUD_RATE )
+        {
+            CellularLogWarn( "Cellular comm %u line rate %u not accepted, fall back to %u",
+                             pCellularCommContext->instanceIndex, CELLULAR_COMM_INTERFACE_BAUD_RATE, baudRate );
+            commIntRet = _setupCommSettings( hComm, baudRate, false );
+        }
+    #endif /* CELLULAR_COMM_INTERFACE_BAUD_RATE != COMM_DEFAULT_BAUD_RATE */
 
-    Status = SetCommState( hComm, &dcbSerialParams );
+    #if ( CELLULAR_COMM_INTERFACE_FLOW_CONTROL == 1 )
+        if( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) &&
+            ( _commAtCommand( pCellularCommContext, "AT+IFC=2,2\r" ) == true ) )
+        {
+            flowControl = true;
+            commIntRet = _setupCommSettings( hComm, baudRate, flowControl );
+        }
+    #else
+        /* Only read by the log. */
+        ( void ) flowControl;
+    #endif
 
-    if( Status == FALSE )
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
     {
-        CellularLogError( "Cellular SetCommState fail %d", GetLastError() );
-        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+        pCellularCommContext->commBaudRate = baudRate;
+        CellularLogInfo( "Cellular comm %u line rate %u, flow control %s",
+                         pCellularCommContext->instanceIndex, baudRate, ( flowControl == true ) ? "on" : "off" );
     }
 
     return commIntRet;
 }
 
+#endif /* COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 */
+
 /*-----------------------------------------------------------*/
 
+#if ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 )
+
 static void commTaskThread( void * pUserData )
 {
     _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) pUserData;
     EventBits_t uxBits = 0;
 
     /* Inform thread ready. */
-    CellularLogInfo( "Cellular commTaskThread started" );
+    CellularLogInfo( "Cellular commTaskThread %u started", pCellularCommContext->instanceIndex );
 
     if( pCellularCommContext != NULL )
     {
-        ( void ) xEventGroupSetBits( pCellularCommContext->pCommTaskEvent,
-                                     COMMTASK_EVT_MASK_STARTED );
+        ( void ) PlatformEventGroup_SetBits( pCellularCommContext->pCommTaskEvent,
+                                             COMMTASK_EVT_MASK_STARTED );
     }
 
     while( true )
     {
         /* Wait for notification from eventqueue. */
-        uxBits = xEventGroupWaitBits( ( pCellularCommContext->pCommTaskEvent ),
-                                      ( ( EventBits_t ) COMMTASK_EVT_MASK_ABORT ),
-                                      pdTRUE,
-                                      pdFALSE,
-                                      pdMS_TO_TICKS( COMMTASK_POLLING_TIME_MS ) );
+        uxBits = PlatformEventGroup_WaitBits( ( pCellularCommContext->pCommTaskEvent ),
+                                              ( ( EventBits_t ) COMMTASK_EVT_MASK_ABORT ),
+                                              pdTRUE,
+                                              pdFALSE,
+                                              pdMS_TO_TICKS( COMMTASK_POLLING_TIME_MS ) );
 
         if( ( uxBits & ( EventBits_t ) COMMTASK_EVT_MASK_ABORT ) != 0U )
         {
@@ -390,10 +1398,10 @@ static void commTaskThread( void * pUserData )
         }
         else
         {
-            /* Polling the global share variabe to trigger the interrupt. */
-            if( rxEvent == true )
+            /* Polling the receive event of this instance to trigger the interrupt. */
+            if( pCellularCommContext->intEvent == true )
             {
-                rxEvent = false;
+                pCellularCommContext->intEvent = false;
                 vPortGenerateSimulatedInterrupt( portINTERRUPT_UART );
             }
         }
@@ -402,10 +1410,10 @@ static void commTaskThread( void * pUserData )
     /* Inform thread ready. */
     if( pCellularCommContext != NULL )
     {
-        ( void ) xEventGroupSetBits( pCellularCommContext->pCommTaskEvent, COMMTASK_EVT_MASK_ABORTED );
+        ( void ) PlatformEventGroup_SetBits( pCellularCommContext->pCommTaskEvent, COMMTASK_EVT_MASK_ABORTED );
     }
 
-    CellularLogInfo( "Cellular commTaskThread exit" );
+    CellularLogInfo( "Cellular commTaskThread %u exit", pCellularCommContext->instanceIndex );
 }
 
 /*-----------------------------------------------------------*/
@@ -416,15 +1424,15 @@ static CellularCommInterfaceError_t setupCommTaskThread( _cellularCommContext_t
     EventBits_t uxBits = 0;
     CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
 
-    pCellularCommContext->pCommTaskEvent = xEventGroupCreate();
+    pCellularCommContext->pCommTaskEvent = PlatformEventGroup_Create();
 
     if( pCellularCommContext->pCommTaskEvent != NULL )
     {
         /* Create the FreeRTOS thread to generate the simulated interrupt. */
-        Status = Platform_CreateDetachedThread( commTaskThread,
-                                                ( void * ) pCellularCommContext,
-                                                COMM_IF_THREAD_DEFAULT_PRIORITY,
-                                                COMM_IF_THREAD_DEFAULT_STACK_SIZE );
+        Status = Platform_CreateDedicatedThread( commTaskThread,
+                                                 ( void * ) pCellularCommContext,
+                                                 COMM_IF_THREAD_DEFAULT_PRIORITY,
+                                                 COMM_IF_THREAD_DEFAULT_STACK_SIZE );
 
         if( Status != true )
         {
@@ -438,11 +1446,11 @@ static CellularCommInterfaceError_t setupCommTaskThread( _cellularCommContext_t
 
     if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
     {
-        uxBits = xEventGroupWaitBits( ( pCellularCommContext->pCommTaskEvent ),
-                                      ( ( EventBits_t ) COMMTASK_EVT_MASK_STARTED | ( EventBits_t ) COMMTASK_EVT_MASK_ABORTED ),
-                                      pdTRUE,
-                                      pdFALSE,
-                                      portMAX_DELAY );
+        uxBits = PlatformEventGroup_WaitBits( ( pCellularCommContext->pCommTaskEvent ),
+                                              ( ( EventBits_t ) COMMTASK_EVT_MASK_STARTED | ( EventBits_t ) COMMTASK_EVT_MASK_ABORTED ),
+                                              pdTRUE,
+                                              pdFALSE,
+                                              portMAX_DELAY );
 
         if( ( uxBits & ( EventBits_t ) COMMTASK_EVT_MASK_STARTED ) == COMMTASK_EVT_MASK_STARTED )
         {
@@ -468,13 +1476,13 @@ static CellularCommInterfaceError_t cleanCommTaskThread( _cellularCommContext_t
     /* Wait for the commTaskThreadStarted exit. */
     if( ( pCellularCommContext->commTaskThreadStarted == true ) && ( pCellularCommContext->pCommTaskEvent != NULL ) )
     {
-        ( void ) xEventGroupSetBits( pCellularCommContext->pCommTaskEvent,
-                                     COMMTASK_EVT_MASK_ABORT );
-        uxBits = xEventGroupWaitBits( ( pCellularCommContext->pCommTaskEvent ),
-                                      ( ( EventBits_t ) COMMTASK_EVT_MASK_ABORTED ),
-                                      pdTRUE,
-                                      pdFALSE,
-                                      portMAX_DELAY );
+        ( void ) PlatformEventGroup_SetBits( pCellularCommContext->pCommTaskEvent,
+                                             COMMTASK_EVT_MASK_ABORT );
+        uxBits = PlatformEventGroup_WaitBits( ( pCellularCommContext->pCommTaskEvent ),
+                                              ( ( EventBits_t ) COMMTASK_EVT_MASK_ABORTED ),
+                                              pdTRUE,
+                                              pdFALSE,
+                                              portMAX_DELAY );
 
         if( ( uxBits & ( EventBits_t ) COMMTASK_EVT_MASK_ABORTED ) != COMMTASK_EVT_MASK_ABORTED )
         {
@@ -488,24 +1496,28 @@ static CellularCommInterfaceError_t cleanCommTaskThread( _cellularCommContext_t
     /* Clean the event group. */
     if( pCellularCommContext->pCommTaskEvent != NULL )
     {
-        vEventGroupDelete( pCellularCommContext->pCommTaskEvent );
+        PlatformEventGroup_Delete( pCellularCommContext->pCommTaskEvent );
         pCellularCommContext->pCommTaskEvent = NULL;
     }
 
     return commIntRet;
 }
 
+#endif /* COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 */
+
 /*-----------------------------------------------------------*/
 
-static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceReceiveCallback_t receiveCallback,
-                                                      void * pUserData,
-                                                      CellularCommInterfaceHandle_t * pCommInterfaceHandle )
+static CellularCommInterfaceError_t _prvCommIntfOpenInstance( uint32_t instanceIndex,
+                                                              CellularCommInterfaceReceiveCallback_t receiveCallback,
+                                                              void * pUserData,
+                                                              CellularCommInterfaceHandle_t * pCommInterfaceHandle )
 {
     CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
     HANDLE hComm = ( HANDLE ) INVALID_HANDLE_VALUE;
     BOOL Status = TRUE;
-    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext();
-    DWORD dwRes = 0;
+    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext( instanceIndex );
+    char commPath[ CELLULAR_COMM_PATH_MAX_LENGTH ] = { 0 };
+    bool contextCleared = false;
 
     if( pCellularCommContext == NULL )
     {
@@ -513,17 +1525,27 @@ static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceRecei
     }
     else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) != 0 )
     {
-        CellularLogError( "Cellular comm interface opened already" );
+        CellularLogError( "Cellular comm interface %u opened already", instanceIndex );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else if( _iotCellularCommPorts[ instanceIndex ] == NULL )
+    {
+        CellularLogError( "Cellular comm interface %u has no COM port", instanceIndex );
         commIntRet = IOT_COMM_INTERFACE_FAILURE;
     }
     else
     {
         /* Clear the context. */
         memset( pCellularCommContext, 0, sizeof( _cellularCommContext_t ) );
-        pCellularCommContext->pCommInterface = &CellularCommInterface;
+        contextCleared = true;
+        pCellularCommContext->instanceIndex = instanceIndex;
+        pCellularCommContext->pCommInterface = CellularCommInterface_GetInstance( instanceIndex );
+
+        ( void ) snprintf( commPath, sizeof( commPath ), "%s%s",
+                           CELLULAR_COMM_PATH_PREFIX, _iotCellularCommPorts[ instanceIndex ] );
 
         /* If CreateFile fails, the return value is INVALID_HANDLE_VALUE. */
-        hComm = CreateFile( TEXT( CELLULAR_COMM_PATH ),
+        hComm = CreateFileA( commPath,
                             GENERIC_READ | GENERIC_WRITE,
                             0,
                             NULL,
@@ -536,7 +1558,7 @@ static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceRecei
     if( ( hComm == ( HANDLE ) INVALID_HANDLE_VALUE ) && ( GetLastError() == 5 ) )
     {
         vTaskDelay( pdMS_TO_TICKS( 1000UL ) );
-        hComm = CreateFile( TEXT( CELLULAR_COMM_PATH ),
+        hComm = CreateFileA( commPath,
                             GENERIC_READ | GENERIC_WRITE,
                             0,
                             NULL,
@@ -547,7 +1569,7 @@ static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceRecei
 
     if( hComm == ( HANDLE ) INVALID_HANDLE_VALUE )
     {
-        CellularLogError( "Cellular open COM port fail %d", GetLastError() );
+        CellularLogError( "Cellular open COM port %s fail %d", commPath, GetLastError() );
         commIntRet = IOT_COMM_INTERFACE_FAILURE;
     }
     else
@@ -568,7 +1590,8 @@ static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceRecei
 
     if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
     {
-        commIntRet = _setupCommSettings( hComm );
+        commIntRet = _setupCommSettings( hComm, COMM_DEFAULT_BAUD_RATE, false );
+        pCellularCommContext->commBaudRate = COMM_DEFAULT_BAUD_RATE;
     }
 
     if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
@@ -582,17 +1605,48 @@ static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceRecei
         }
     }
 
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        commIntRet = _setupCommEvents( pCellularCommContext );
+    }
+
+    #if ( COMM_IF_NEGOTIATE_LINE_SETTINGS == 1 )
+        if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+        {
+            /* Negotiate before the receive thread starts reading the COM port. */
+            pCellularCommContext->commFileHandle = hComm;
+            commIntRet = _commNegotiateLineSettings( pCellularCommContext );
+        }
+    #endif
+
+    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        CommRing_Init( &pCellularCommContext->commRxRing,
+                       pCellularCommContext->commRxRingBuffer,
+                       COMM_RX_RING_SIZE );
+
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            CommRing_Init( &pCellularCommContext->commTxRing,
+                           pCellularCommContext->commTxRingBuffer,
+                           COMM_TX_RING_SIZE );
+        #endif
+    }
+
     if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
     {
         pCellularCommContext->commReceiveCallback = receiveCallback;
-        commIntRet = setupCommTaskThread( pCellularCommContext );
+
+        #if ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 )
+            commIntRet = setupCommTaskThread( pCellularCommContext );
+        #endif
     }
 
     if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
     {
         vPortSetInterruptHandler( portINTERRUPT_UART, prvProcessUartInt );
+        pCellularCommContext->commFileHandle = hComm;
         pCellularCommContext->commReceiveCallbackThread =
-            CreateThread( NULL, 0, _CellularCommReceiveCBThreadFunc, hComm, 0, NULL );
+            CreateThread( NULL, 0, _CellularCommReceiveCBThreadFunc, pCellularCommContext, 0, NULL );
 
         /* CreateThread return NULL for error. */
         if( pCellularCommContext->commReceiveCallbackThread == NULL )
@@ -602,16 +1656,43 @@ static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceRecei
         }
     }
 
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+        {
+            pCellularCommContext->commTransmitThread =
+                CreateThread( NULL, 0, _CellularCommTransmitThreadFunc, pCellularCommContext, 0, NULL );
+
+            if( pCellularCommContext->commTransmitThread == NULL )
+            {
+                CellularLogError( "Cellular CreateThread fail %d", GetLastError() );
+                commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            }
+        }
+    #endif
+
     if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
     {
         pCellularCommContext->pUserData = pUserData;
-        pCellularCommContext->commFileHandle = hComm;
         *pCommInterfaceHandle = ( CellularCommInterfaceHandle_t ) pCellularCommContext;
         pCellularCommContext->commStatus |= CELLULAR_COMM_OPEN_BIT;
     }
-    else
+    else if( contextCleared == true )
     {
-        /* Comm interface open fail. Clean the data. */
+        /* Comm interface open fail. Clean the data. An instance opened already is left untouched. */
+        if( pCellularCommContext->commAbortEvent != NULL )
+        {
+            ( void ) SetEvent( pCellularCommContext->commAbortEvent );
+        }
+
+        /* Wait for the threads to exit before the COM port is closed. */
+        ( void ) _cleanCommThread( &pCellularCommContext->commReceiveCallbackThread );
+
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            ( void ) _cleanCommThread( &pCellularCommContext->commTransmitThread );
+        #endif
+
+        _cleanCommEvents( pCellularCommContext );
+
         if( hComm != ( HANDLE ) INVALID_HANDLE_VALUE )
         {
             ( void ) CloseHandle( hComm );
@@ -619,22 +1700,16 @@ static CellularCommInterfaceError_t _prvCommIntfOpen( CellularCommInterfaceRecei
             commIntRet = IOT_COMM_INTERFACE_FAILURE;
         }
 
-        /* Wait for the commReceiveCallbackThread exit. */
-        if( pCellularCommContext->commReceiveCallbackThread != NULL )
-        {
-            dwRes = WaitForSingleObject( pCellularCommContext->commReceiveCallbackThread, COMM_RECV_THREAD_TIMEOUT );
-
-            if( dwRes != WAIT_OBJECT_0 )
-            {
-                CellularLogDebug( "Cellular close wait receiveCallbackThread %p fail %d",
-                                  pCellularCommContext->commReceiveCallbackThread, dwRes );
-            }
-        }
-
-        pCellularCommContext->commReceiveCallbackThread = NULL;
+        pCellularCommContext->commFileHandle = NULL;
 
-        /* Wait for the commTaskThreadStarted exit. */
-        ( void ) cleanCommTaskThread( pCellularCommContext );
+        #if ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 )
+            /* Wait for the commTaskThreadStarted exit. */
+            ( void ) cleanCommTaskThread( pCellularCommContext );
+        #endif
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
     }
 
     return commIntRet;
@@ -648,7 +1723,10 @@ static CellularCommInterfaceError_t _prvCommIntfClose( CellularCommInterfaceHand
     _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
     HANDLE hComm = NULL;
     BOOL Status = TRUE;
-    DWORD dwRes = 0;
+
+    #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+        uint32_t txDroppedLength = 0;
+    #endif
 
     if( pCellularCommContext == NULL )
     {
@@ -661,9 +1739,46 @@ static CellularCommInterfaceError_t _prvCommIntfClose( CellularCommInterfaceHand
     }
     else
     {
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            /* Write the data queued by send before the writer thread is stopped. */
+            txDroppedLength = _commTxDrain( pCellularCommContext );
+
+            if( txDroppedLength > 0U )
+            {
+                CellularLogError( "Cellular comm %u close dropped %u queued transmit bytes",
+                                  pCellularCommContext->instanceIndex, txDroppedLength );
+            }
+        #endif
+
         /* clean the receive callback. */
         pCellularCommContext->commReceiveCallback = NULL;
 
+        /* Stop the receive and writer threads before the COM port is closed. */
+        ( void ) SetEvent( pCellularCommContext->commAbortEvent );
+
+        /* Wait for the threads exit. */
+        commIntRet = _cleanCommThread( &pCellularCommContext->commReceiveCallbackThread );
+
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            if( _cleanCommThread( &pCellularCommContext->commTransmitThread ) != IOT_COMM_INTERFACE_SUCCESS )
+            {
+                commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            }
+
+            pCellularCommContext->commTxCallback = NULL;
+            CellularLogInfo( "Cellular comm %u TX ring peak fill %u of %u bytes, dropped %u",
+                             pCellularCommContext->instanceIndex,
+                             pCellularCommContext->commTxRing.peakFill, COMM_TX_RING_SIZE,
+                             CommRing_Used( &pCellularCommContext->commTxRing ) );
+        #endif
+
+        _cleanCommEvents( pCellularCommContext );
+
+        CellularLogInfo( "Cellular comm %u RX ring peak fill %u of %u bytes, overrun %u",
+                         pCellularCommContext->instanceIndex,
+                         pCellularCommContext->commRxRing.peakFill, COMM_RX_RING_SIZE,
+                         pCellularCommContext->commRxRing.overrunCount );
+
         /* Close the COM port. */
         hComm = pCellularCommContext->commFileHandle;
 
@@ -684,27 +1799,10 @@ static CellularCommInterfaceError_t _prvCommIntfClose( CellularCommInterfaceHand
 
         pCellularCommContext->commFileHandle = NULL;
 
-        /* Wait for the thread exit. */
-        if( pCellularCommContext->commReceiveCallbackThread != NULL )
-        {
-            dwRes = WaitForSingleObject( pCellularCommContext->commReceiveCallbackThread, COMM_RECV_THREAD_TIMEOUT );
-
-            if( dwRes != WAIT_OBJECT_0 )
-            {
-                CellularLogDebug( "Cellular close wait receiveCallbackThread %p fail %d",
-                                  pCellularCommContext->commReceiveCallbackThread, dwRes );
-                commIntRet = IOT_COMM_INTERFACE_FAILURE;
-            }
-            else
-            {
-                CloseHandle( pCellularCommContext->commReceiveCallbackThread );
-            }
-        }
-
-        pCellularCommContext->commReceiveCallbackThread = NULL;
-
-        /* Clean the commTaskThread. */
-        ( void ) cleanCommTaskThread( pCellularCommContext );
+        #if ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 )
+            /* Clean the commTaskThread. */
+            ( void ) cleanCommTaskThread( pCellularCommContext );
+        #endif
 
         /* clean the data structure. */
         pCellularCommContext->commStatus &= ~( CELLULAR_COMM_OPEN_BIT );
@@ -715,68 +1813,47 @@ static CellularCommInterfaceError_t _prvCommIntfClose( CellularCommInterfaceHand
 
 /*-----------------------------------------------------------*/
 
-static CellularCommInterfaceError_t _prvCommIntfSend( CellularCommInterfaceHandle_t commInterfaceHandle,
-                                                      const uint8_t * pData,
-                                                      uint32_t dataLength,
-                                                      uint32_t timeoutMilliseconds,
-                                                      uint32_t * pDataSentLength )
+static CellularCommInterfaceError_t _commTxWrite( _cellularCommContext_t * pCellularCommContext,
+                                                  const uint8_t * pData,
+                                                  uint32_t dataLength,
+                                                  uint32_t timeoutMilliseconds,
+                                                  uint32_t * pDataSentLength )
 {
     CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
-    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
-    HANDLE hComm = NULL;
-    OVERLAPPED osWrite = { 0 };
+    HANDLE hComm = pCellularCommContext->commFileHandle;
+    OVERLAPPED * pOsWrite = &pCellularCommContext->commTxOverlapped;
     DWORD dwRes = 0;
     DWORD dwWritten = 0;
     BOOL Status = TRUE;
 
-    if( pCellularCommContext == NULL )
-    {
-        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
-    }
-    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) == 0 )
+    #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+        uint32_t writeStartUs = CommTrace_TimestampUs();
+    #endif
+
+    Status = WriteFile( hComm, pData, dataLength, &dwWritten, pOsWrite );
+
+    /* WriteFile fail and error is not the ERROR_IO_PENDING. */
+    if( ( Status == FALSE ) && ( GetLastError() != ERROR_IO_PENDING ) )
     {
-        CellularLogError( "Cellular send comm interface is not opened before." );
+        CellularLogError( "Cellular WriteFile fail %d", GetLastError() );
         commIntRet = IOT_COMM_INTERFACE_FAILURE;
     }
-    else
-    {
-        hComm = pCellularCommContext->commFileHandle;
-        osWrite.hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
-
-        if( osWrite.hEvent == NULL )
-        {
-            CellularLogError( "Cellular CreateEvent fail %d", GetLastError() );
-            commIntRet = IOT_COMM_INTERFACE_FAILURE;
-        }
-    }
 
-    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
+    if( Status == TRUE )
     {
-        Status = WriteFile( hComm, pData, dataLength, &dwWritten, &osWrite );
-
-        /* WriteFile fail and error is not the ERROR_IO_PENDING. */
-        if( ( Status == FALSE ) && ( GetLastError() != ERROR_IO_PENDING ) )
-        {
-            CellularLogError( "Cellular WriteFile fail %d", GetLastError() );
-            commIntRet = IOT_COMM_INTERFACE_FAILURE;
-        }
-
-        if( Status == TRUE )
-        {
-            *pDataSentLength = ( uint32_t ) dwWritten;
-        }
+        *pDataSentLength = ( uint32_t ) dwWritten;
     }
 
     /* Handle pending I/O. */
     if( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( Status == FALSE ) )
     {
-        dwRes = WaitForSingleObject( osWrite.hEvent, timeoutMilliseconds );
+        dwRes = WaitForSingleObject( pOsWrite->hEvent, timeoutMilliseconds );
 
         switch( dwRes )
         {
             case WAIT_OBJECT_0:
 
-                if( GetOverlappedResult( hComm, &osWrite, &dwWritten, FALSE ) == FALSE )
+                if( GetOverlappedResult( hComm, pOsWrite, &dwWritten, FALSE ) == FALSE )
                 {
                     CellularLogError( "Cellular GetOverlappedResult fail %d", GetLastError() );
                     commIntRet = IOT_COMM_INTERFACE_FAILURE;
@@ -787,6 +1864,10 @@ static CellularCommInterfaceError_t _prvCommIntfSend( CellularCommInterfaceHandl
             case STATUS_TIMEOUT:
                 CellularLogError( "Cellular WaitForSingleObject timeout" );
                 commIntRet = IOT_COMM_INTERFACE_TIMEOUT;
+
+                /* Cancel the write before the OVERLAPPED structure is reused. */
+                ( void ) CancelIo( hComm );
+                ( void ) GetOverlappedResult( hComm, pOsWrite, &dwWritten, TRUE );
                 break;
 
             default:
@@ -798,14 +1879,63 @@ static CellularCommInterfaceError_t _prvCommIntfSend( CellularCommInterfaceHandl
         *pDataSentLength = ( uint32_t ) dwWritten;
     }
 
-    if( osWrite.hEvent != NULL )
-    {
-        Status = CloseHandle( osWrite.hEvent );
+    #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+        if( dwWritten > 0U )
+        {
+            CommTrace_Record( &pCellularCommContext->commTrace, COMM_TRACE_TX, pData, ( uint32_t ) dwWritten );
+        }
+    #endif
 
-        if( Status == FALSE )
+    #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+        if( dwWritten > 0U )
+        {
+            CommStats_Write( &pCellularCommContext->commStats, ( uint32_t ) dwWritten, writeStartUs );
+        }
+
+        if( commIntRet == IOT_COMM_INTERFACE_FAILURE )
         {
-            CellularLogDebug( "Cellular send CloseHandle fail" );
+            pCellularCommContext->commStats.stats.writeErrorCount++;
         }
+    #endif
+
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t _prvCommIntfSend( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                      const uint8_t * pData,
+                                                      uint32_t dataLength,
+                                                      uint32_t timeoutMilliseconds,
+                                                      uint32_t * pDataSentLength )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
+
+    if( pCellularCommContext == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) == 0 )
+    {
+        CellularLogError( "Cellular send comm interface is not opened before." );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        #if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+            /* The writer thread writes the queued data to the COM port. */
+            commIntRet = _commTxQueue( pCellularCommContext, pData, dataLength, timeoutMilliseconds, pDataSentLength );
+        #else
+            commIntRet = _commTxWrite( pCellularCommContext, pData, dataLength, timeoutMilliseconds, pDataSentLength );
+        #endif
+
+        #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+            if( commIntRet == IOT_COMM_INTERFACE_TIMEOUT )
+            {
+                pCellularCommContext->commStats.stats.sendTimeoutCount++;
+            }
+        #endif
     }
 
     return commIntRet;
@@ -821,13 +1951,14 @@ static CellularCommInterfaceError_t _prvCommIntfReceive( CellularCommInterfaceHa
 {
     CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
     _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
-    HANDLE hComm = NULL;
-    OVERLAPPED osRead = { 0 };
-    BOOL Status = TRUE;
-    DWORD dwRes = 0;
-    DWORD dwRead = 0;
+    uint32_t readLength = 0;
 
-    if( pCellularCommContext == NULL )
+    /* The receive thread has already read the data into the ring. Same as the
+     * COM port read timeout settings, return immediately with the bytes that
+     * have already been received. */
+    ( void ) timeoutMilliseconds;
+
+    if( ( pCellularCommContext == NULL ) || ( pBuffer == NULL ) || ( pDataReceivedLength == NULL ) )
     {
         commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
     }
@@ -838,74 +1969,131 @@ static CellularCommInterfaceError_t _prvCommIntfReceive( CellularCommInterfaceHa
     }
     else
     {
-        hComm = pCellularCommContext->commFileHandle;
-        osRead.hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+        readLength = CommRing_Read( &pCellularCommContext->commRxRing, pBuffer, bufferLength );
+        *pDataReceivedLength = readLength;
+
+        #if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+            CommStats_Recv( &pCellularCommContext->commStats, readLength );
+        #endif
+
+        /* Resume the receive thread if it stalled on a full ring. */
+        COMM_RING_MEMORY_BARRIER();
 
-        if( osRead.hEvent == NULL )
+        if( ( readLength > 0U ) && ( pCellularCommContext->commRxStalled == true ) )
         {
-            CellularLogError( "Cellular CreateEvent fail %d", GetLastError() );
-            commIntRet = IOT_COMM_INTERFACE_FAILURE;
+            pCellularCommContext->commRxStalled = false;
+            ( void ) SetEvent( pCellularCommContext->commRxResumeEvent );
         }
     }
 
-    if( commIntRet == IOT_COMM_INTERFACE_SUCCESS )
-    {
-        Status = ReadFile( hComm, pBuffer, bufferLength, &dwRead, &osRead );
+    return commIntRet;
+}
 
-        if( ( Status == FALSE ) && ( GetLastError() != ERROR_IO_PENDING ) )
-        {
-            CellularLogError( "Cellular ReadFile fail %d", GetLastError() );
-            commIntRet = IOT_COMM_INTERFACE_FAILURE;
-        }
+/*-----------------------------------------------------------*/
 
-        if( Status == TRUE )
-        {
-            *pDataReceivedLength = ( uint32_t ) dwRead;
-        }
+CellularCommInterfaceError_t CellularCommInterface_SetPort( uint32_t instanceIndex,
+                                                            const char * pPortName )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext( instanceIndex );
+
+    if( ( pCellularCommContext == NULL ) || ( pPortName == NULL ) ||
+        ( ( strlen( pPortName ) + sizeof( CELLULAR_COMM_PATH_PREFIX ) ) > CELLULAR_COMM_PATH_MAX_LENGTH ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) != 0 )
+    {
+        CellularLogError( "Cellular comm interface %u is opened", instanceIndex );
+        commIntRet = IOT_COMM_INTERFACE_BUSY;
+    }
+    else
+    {
+        _iotCellularCommPorts[ instanceIndex ] = pPortName;
     }
 
-    /* Handle pending I/O. */
-    if( ( commIntRet == IOT_COMM_INTERFACE_SUCCESS ) && ( Status == FALSE ) )
+    return commIntRet;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_STATS_ENABLE == 1 )
+
+CellularCommInterfaceError_t CellularCommInterface_GetStats( uint32_t instanceIndex,
+                                                             CellularCommStats_t * pStats )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext( instanceIndex );
+
+    if( ( pCellularCommContext == NULL ) || ( pStats == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else
     {
-        dwRes = WaitForSingleObject( osRead.hEvent, timeoutMilliseconds );
+        CommStats_Copy( &pCellularCommContext->commStats, pStats );
+        pStats->rxOverrunCount = pCellularCommContext->commRxRing.overrunCount;
+        pStats->rxPeakFill = pCellularCommContext->commRxRing.peakFill;
+    }
 
-        switch( dwRes )
-        {
-            case WAIT_OBJECT_0:
+    return commIntRet;
+}
 
-                if( GetOverlappedResult( hComm, &osRead, &dwRead, FALSE ) == FALSE )
-                {
-                    CellularLogError( "Cellular receive GetOverlappedResult fail %d", GetLastError() );
-                    commIntRet = IOT_COMM_INTERFACE_FAILURE;
-                }
+#endif /* CELLULAR_COMM_STATS_ENABLE == 1 */
 
-                break;
+/*-----------------------------------------------------------*/
 
-            case STATUS_TIMEOUT:
-                CellularLogError( "Cellular receive WaitForSingleObject timeout" );
-                commIntRet = IOT_COMM_INTERFACE_TIMEOUT;
-                break;
+#if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
 
-            default:
-                CellularLogError( "Cellular receive WaitForSingleObject fail %d", dwRes );
-                commIntRet = IOT_COMM_INTERFACE_FAILURE;
-                break;
-        }
+CellularCommInterfaceError_t CellularCommInterface_DumpTrace( uint32_t instanceIndex,
+                                                              const char * pPath )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = _getCellularCommContext( instanceIndex );
 
-        *pDataReceivedLength = ( uint32_t ) dwRead;
+    if( ( pCellularCommContext == NULL ) || ( pPath == NULL ) )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
     }
-
-    if( osRead.hEvent != NULL )
+    else
     {
-        Status = CloseHandle( osRead.hEvent );
+        commIntRet = CommTrace_Dump( &pCellularCommContext->commTrace, pPath );
+    }
 
-        if( Status == FALSE )
-        {
-            CellularLogDebug( "Cellular recv CloseHandle fail" );
-        }
+    return commIntRet;
+}
+
+#endif /* CELLULAR_COMM_TRACE_ENABLE == 1 */
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 )
+
+CellularCommInterfaceError_t CellularCommInterface_SetTxCallback( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                                                  CellularCommInterfaceTxCallback_t txCallback,
+                                                                  void * pUserData )
+{
+    CellularCommInterfaceError_t commIntRet = IOT_COMM_INTERFACE_SUCCESS;
+    _cellularCommContext_t * pCellularCommContext = ( _cellularCommContext_t * ) commInterfaceHandle;
+
+    if( pCellularCommContext == NULL )
+    {
+        commIntRet = IOT_COMM_INTERFACE_BAD_PARAMETER;
+    }
+    else if( ( pCellularCommContext->commStatus & CELLULAR_COMM_OPEN_BIT ) == 0 )
+    {
+        CellularLogError( "Cellular comm interface is not opened before." );
+        commIntRet = IOT_COMM_INTERFACE_FAILURE;
+    }
+    else
+    {
+        pCellularCommContext->pTxUserData = pUserData;
+        pCellularCommContext->commTxCallback = txCallback;
     }
 
     return commIntRet;
 }
 
 /*-----------------------------------------------------------*/
+
+#endif /* CELLULAR_COMM_INTERFACE_ASYNC_TX == 1 */
@@ -43,6 +43,9 @@
 #include "cellular_api.h"
 #include "cellular_comm_interface.h"
 
+/* Platform layer include, for the event group and the clock. */
+#include "cellular_platform.h"
+
 /*-----------------------------------------------------------*/
 
 #ifndef CELLULAR_APN
@@ -52,10 +55,76 @@
 #define CELLULAR_SIM_CARD_WAIT_INTERVAL_MS       ( 500UL )
 #define CELLULAR_MAX_SIM_RETRY                   ( 5U )
 
-#define CELLULAR_PDN_CONNECT_WAIT_INTERVAL_MS    ( 1000UL )
-
 #define CELLULAR_PDN_CONTEXT_NUM                 ( CELLULAR_PDN_CONTEXT_ID_MAX - CELLULAR_PDN_CONTEXT_ID_MIN + 1U )
 
+/**
+ * @brief Time the registration state waits for a registration URC before it
+ * asks the modem, in case the URC was lost.
+ */
+#ifndef CELLULAR_SETUP_REGISTRATION_POLL_MS
+    #define CELLULAR_SETUP_REGISTRATION_POLL_MS    ( 5000UL )
+#endif
+
+/**
+ * @brief Time the PDN activation state retries a failed activation while the module is registered.
+ */
+#ifndef CELLULAR_SETUP_PDN_ACTIVATE_TIMEOUT_MS
+    #define CELLULAR_SETUP_PDN_ACTIVATE_TIMEOUT_MS    ( 30000UL )
+#endif
+
+/**
+ * @brief Time setupCellular may take from its call, whatever the states.
+ *
+ * The registration and activation states restart their timeouts when the
+ * module loses the registration, but never beyond this limit. The default is
+ * a registration and an activation that each take their full timeout.
+ */
+#ifndef CELLULAR_SETUP_TIMEOUT_MS
+    #define CELLULAR_SETUP_TIMEOUT_MS    ( CELLULAR_PDN_CONNECT_TIMEOUT + CELLULAR_SETUP_PDN_ACTIVATE_TIMEOUT_MS )
+#endif
+
+/**
+ * @brief Wait between two PDN activation attempts.
+ */
+#ifndef CELLULAR_SETUP_PDN_ACTIVATE_RETRY_MS
+    #define CELLULAR_SETUP_PDN_ACTIVATE_RETRY_MS    ( 1000UL )
+#endif
+
+/* Events set by the URC callbacks. */
+#define CELLULAR_SETUP_REGISTERED_BIT            ( 0x00000001U )
+#define CELLULAR_SETUP_DEREGISTERED_BIT          ( 0x00000002U )
+#define CELLULAR_SETUP_PDN_DEACTIVATED_BIT       ( 0x00000004U )
+#define CELLULAR_SETUP_ALL_BITS                  ( 0x00000007U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief States of the bring-up, in the order they are passed.
+ */
+typedef enum CellularSetupState
+{
+    CELLULAR_SETUP_STATE_SIM = 0,      /**< Wait for the SIM, polled as no URC reports it. */
+    CELLULAR_SETUP_STATE_PDN_CONFIG,   /**< Set the APN. */
+    CELLULAR_SETUP_STATE_RF,           /**< Rescan the network if the module neither is registered nor searches. */
+    CELLULAR_SETUP_STATE_REGISTRATION, /**< Wait for the PS registration URC, up to CELLULAR_PDN_CONNECT_TIMEOUT. */
+    CELLULAR_SETUP_STATE_PDN_ACTIVATE, /**< Activate the PDN, retried up to CELLULAR_SETUP_PDN_ACTIVATE_TIMEOUT_MS. */
+    CELLULAR_SETUP_STATE_IP_ADDRESS,   /**< Get the IP address and check the PDN is still active. */
+    CELLULAR_SETUP_STATE_DONE,         /**< Connected. */
+    CELLULAR_SETUP_STATE_FAILED        /**< Bring-up failed. */
+} CellularSetupState_t;
+
+/**
+ * @brief Context of the bring-up state machine.
+ */
+typedef struct CellularSetupContext
+{
+    CellularSetupState_t state;                /**< Current state. */
+    uint64_t startTimeMs;                      /**< Platform clock when setupCellular was called. */
+    uint64_t registrationDeadlineMs;           /**< End of the registration state, 0 when it is entered. */
+    uint64_t activationDeadlineMs;             /**< End of the PDN activation state, 0 when the registration state is entered. */
+    char localIP[ CELLULAR_IP_ADDRESS_MAX_SIZE ]; /**< IP address of the PDN. */
+} CellularSetupContext_t;
+
 /*-----------------------------------------------------------*/
 
 /* the default Cellular comm interface in system. */
@@ -70,146 +139,424 @@ CellularHandle_t CellularHandle = NULL;
 /* User of secure sockets cellular should provide this variable. */
 uint8_t CellularSocketPdnContextId = CELLULAR_PDN_CONTEXT_ID;
 
+/* Events of the URC callbacks. Static so a callback running while setupCellular returns finds it. */
+static PlatformStaticEventGroup_t setupEventGroupBuffer;
+static PlatformEventGroupHandle_t setupEventGroup = NULL;
+
 /*-----------------------------------------------------------*/
 
-bool setupCellular( void )
+/**
+ * @brief Network registration URC callback. Runs in the pktio thread of the cellular library.
+ *
+ * @param[in] urcEvent CS or PS registration event.
+ * @param[in] pServiceStatus Registration status from the URC.
+ * @param[in] pCallbackContext Not used.
+ */
+static void prvRegistrationCallback( CellularUrcEvent_t urcEvent,
+                                     const CellularServiceStatus_t * pServiceStatus,
+                                     void * pCallbackContext );
+
+/**
+ * @brief PDN URC callback. Runs in the pktio thread of the cellular library.
+ *
+ * @param[in] urcEvent PDN activated or deactivated event.
+ * @param[in] contextId Context of the event.
+ * @param[in] pCallbackContext Not used.
+ */
+static void prvPdnCallback( CellularUrcEvent_t urcEvent,
+                            uint8_t contextId,
+                            void * pCallbackContext );
+
+/**
+ * @brief Check if a PS registration status is registered.
+ *
+ * @param[in] registrationStatus PS registration status.
+ *
+ * @return true if registered home or roaming.
+ */
+static bool prvIsRegistered( CellularNetworkRegistrationStatus_t registrationStatus );
+
+/**
+ * @brief Wait for the SIM to be ready.
+ *
+ * @param[in] pContext Context of the state machine.
+ *
+ * @return The next state.
+ */
+static CellularSetupState_t prvSetupSim( CellularSetupContext_t * pContext );
+
+/**
+ * @brief Set the PDN configuration.
+ *
+ * @param[in] pContext Context of the state machine.
+ *
+ * @return The next state.
+ */
+static CellularSetupState_t prvSetupPdnConfig( CellularSetupContext_t * pContext );
+
+/**
+ * @brief Rescan the network unless the module is registered or searching.
+ *
+ * @param[in] pContext Context of the state machine.
+ *
+ * @return The next state.
+ */
+static CellularSetupState_t prvSetupRf( CellularSetupContext_t * pContext );
+
+/**
+ * @brief Deadline of a state, no later than CELLULAR_SETUP_TIMEOUT_MS after setupCellular was called.
+ *
+ * @param[in] pContext Context of the state machine.
+ * @param[in] timeoutMs Timeout of the state from now.
+ *
+ * @return The platform clock of the deadline.
+ */
+static uint64_t prvStateDeadlineMs( const CellularSetupContext_t * pContext,
+                                    uint64_t timeoutMs );
+
+/**
+ * @brief Wait for the PS registration URC, asking the modem every CELLULAR_SETUP_REGISTRATION_POLL_MS.
+ *
+ * @param[in] pContext Context of the state machine.
+ *
+ * @return The next state.
+ */
+static CellularSetupState_t prvSetupRegistration( CellularSetupContext_t * pContext );
+
+/**
+ * @brief Activate the PDN.
+ *
+ * @param[in] pContext Context of the state machine.
+ *
+ * @return The next state.
+ */
+static CellularSetupState_t prvSetupPdnActivate( CellularSetupContext_t * pContext );
+
+/**
+ * @brief Get the IP address and check that the PDN is active.
+ *
+ * @param[in] pContext Context of the state machine.
+ *
+ * @return The next state.
+ */
+static CellularSetupState_t prvSetupIpAddress( CellularSetupContext_t * pContext );
+
+/*-----------------------------------------------------------*/
+
+static void prvRegistrationCallback( CellularUrcEvent_t urcEvent,
+                                     const CellularServiceStatus_t * pServiceStatus,
+                                     void * pCallbackContext )
 {
-    bool cellularRet = true;
+    ( void ) pCallbackContext;
+
+    if( ( urcEvent == CELLULAR_URC_EVENT_NETWORK_PS_REGISTRATION ) && ( pServiceStatus != NULL ) )
+    {
+        if( prvIsRegistered( pServiceStatus->psRegistrationStatus ) == true )
+        {
+            ( void ) PlatformEventGroup_ClearBits( setupEventGroup, CELLULAR_SETUP_DEREGISTERED_BIT );
+            ( void ) PlatformEventGroup_SetBits( setupEventGroup, CELLULAR_SETUP_REGISTERED_BIT );
+        }
+        else
+        {
+            ( void ) PlatformEventGroup_ClearBits( setupEventGroup, CELLULAR_SETUP_REGISTERED_BIT );
+            ( void ) PlatformEventGroup_SetBits( setupEventGroup, CELLULAR_SETUP_DEREGISTERED_BIT );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvPdnCallback( CellularUrcEvent_t urcEvent,
+                            uint8_t contextId,
+                            void * pCallbackContext )
+{
+    ( void ) pCallbackContext;
+
+    if( ( urcEvent == CELLULAR_URC_EVENT_PDN_DEACTIVATED ) && ( contextId == CellularSocketPdnContextId ) )
+    {
+        ( void ) PlatformEventGroup_SetBits( setupEventGroup, CELLULAR_SETUP_PDN_DEACTIVATED_BIT );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvIsRegistered( CellularNetworkRegistrationStatus_t registrationStatus )
+{
+    return ( registrationStatus == REGISTRATION_STATUS_REGISTERED_HOME ) ||
+           ( registrationStatus == REGISTRATION_STATUS_ROAMING_REGISTERED );
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularSetupState_t prvSetupSim( CellularSetupContext_t * pContext )
+{
+    CellularSetupState_t nextState = CELLULAR_SETUP_STATE_FAILED;
     CellularError_t cellularStatus = CELLULAR_SUCCESS;
     CellularSimCardStatus_t simStatus = { 0 };
-    CellularServiceStatus_t serviceStatus = { 0 };
-    CellularCommInterface_t * pCommIntf = &CellularCommInterface;
     uint8_t tries = 0;
+
+    ( void ) pContext;
+
+    /* wait until SIM is ready */
+    for( tries = 0; tries < CELLULAR_MAX_SIM_RETRY; tries++ )
+    {
+        cellularStatus = Cellular_GetSimCardStatus( CellularHandle, &simStatus );
+
+        if( ( cellularStatus == CELLULAR_SUCCESS ) &&
+            ( ( simStatus.simCardState == CELLULAR_SIM_CARD_INSERTED ) &&
+              ( simStatus.simCardLockState == CELLULAR_SIM_CARD_READY ) ) )
+        {
+            configPRINTF( ( ">>>  Cellular SIM okay  <<<\r\n" ) );
+            break;
+        }
+        else
+        {
+            configPRINTF( ( ">>>  Cellular SIM card state %d, Lock State %d <<<\r\n",
+                            simStatus.simCardState,
+                            simStatus.simCardLockState ) );
+        }
+
+        vTaskDelay( pdMS_TO_TICKS( CELLULAR_SIM_CARD_WAIT_INTERVAL_MS ) );
+    }
+
+    /* Go on with a SIM which is not ready yet, the registration state times out if it never is. */
+    if( cellularStatus != CELLULAR_SUCCESS )
+    {
+        configPRINTF( ( ">>>  Cellular SIM failure  <<<\r\n" ) );
+    }
+    else
+    {
+        nextState = CELLULAR_SETUP_STATE_PDN_CONFIG;
+    }
+
+    return nextState;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularSetupState_t prvSetupPdnConfig( CellularSetupContext_t * pContext )
+{
+    CellularSetupState_t nextState = CELLULAR_SETUP_STATE_FAILED;
+    CellularError_t cellularStatus = CELLULAR_SUCCESS;
     CellularPdnConfig_t pdnConfig = { CELLULAR_PDN_CONTEXT_IPV4, CELLULAR_PDN_AUTH_NONE, CELLULAR_APN, "", "" };
-    CellularPdnStatus_t PdnStatusBuffers[ CELLULAR_PDN_CONTEXT_NUM ] = { 0 };
-    char localIP[ CELLULAR_IP_ADDRESS_MAX_SIZE ] = { '\0' };
-    uint32_t timeoutCountLimit = ( CELLULAR_PDN_CONNECT_TIMEOUT / CELLULAR_PDN_CONNECT_WAIT_INTERVAL_MS ) + 1U;
-    uint32_t timeoutCount = 0;
-    uint8_t NumStatus = 0;
-    bool pdnStatus = false;
-    uint32_t i = 0U;
 
-    /* Initialize Cellular Comm Interface. */
-    cellularStatus = Cellular_Init( &CellularHandle, pCommIntf );
+    ( void ) pContext;
+
+    cellularStatus = Cellular_SetPdnConfig( CellularHandle, CellularSocketPdnContextId, &pdnConfig );
 
     if( cellularStatus != CELLULAR_SUCCESS )
     {
-        configPRINTF( ( ">>>  Cellular_Init failure %d  <<<\r\n", cellularStatus ) );
+        configPRINTF( ( ">>>  Cellular_SetPdnConfig failure %d  <<<\r\n", cellularStatus ) );
+    }
+    else
+    {
+        nextState = CELLULAR_SETUP_STATE_RF;
+    }
+
+    return nextState;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularSetupState_t prvSetupRf( CellularSetupContext_t * pContext )
+{
+    CellularSetupState_t nextState = CELLULAR_SETUP_STATE_FAILED;
+    CellularError_t cellularStatus = CELLULAR_SUCCESS;
+    CellularServiceStatus_t serviceStatus = { 0 };
+
+    ( void ) pContext;
+
+    /* A URC from now on sets the events, so none is lost between the query and the wait. */
+    ( void ) PlatformEventGroup_ClearBits( setupEventGroup, CELLULAR_SETUP_ALL_BITS );
+    cellularStatus = Cellular_GetServiceStatus( CellularHandle, &serviceStatus );
+
+    if( ( cellularStatus == CELLULAR_SUCCESS ) && ( prvIsRegistered( serviceStatus.psRegistrationStatus ) == true ) )
+    {
+        configPRINTF( ( ">>>  Cellular module registered  <<<\r\n" ) );
+        nextState = CELLULAR_SETUP_STATE_PDN_ACTIVATE;
+    }
+    else if( ( cellularStatus == CELLULAR_SUCCESS ) &&
+             ( serviceStatus.psRegistrationStatus == REGISTRATION_STATUS_NOT_REGISTERED_SEARCHING ) )
+    {
+        /* A rescan would restart the search. */
+        nextState = CELLULAR_SETUP_STATE_REGISTRATION;
     }
     else
     {
-        /* wait until SIM is ready */
-        for( tries = 0; tries < CELLULAR_MAX_SIM_RETRY; tries++ )
+        /* Rescan network. */
+        cellularStatus = Cellular_RfOff( CellularHandle );
+
+        if( cellularStatus != CELLULAR_SUCCESS )
+        {
+            configPRINTF( ( ">>>  Cellular_RfOff failure %d  <<<\r\n", cellularStatus ) );
+        }
+        else
         {
-            cellularStatus = Cellular_GetSimCardStatus( CellularHandle, &simStatus );
+            cellularStatus = Cellular_RfOn( CellularHandle );
 
-            if( ( cellularStatus == CELLULAR_SUCCESS ) &&
-                ( ( simStatus.simCardState == CELLULAR_SIM_CARD_INSERTED ) &&
-                  ( simStatus.simCardLockState == CELLULAR_SIM_CARD_READY ) ) )
+            if( cellularStatus != CELLULAR_SUCCESS )
             {
-                configPRINTF( ( ">>>  Cellular SIM okay  <<<\r\n" ) );
-                break;
+                configPRINTF( ( ">>>  Cellular_RfOn failure %d  <<<\r\n", cellularStatus ) );
             }
             else
             {
-                configPRINTF( ( ">>>  Cellular SIM card state %d, Lock State %d <<<\r\n",
-                                simStatus.simCardState,
-                                simStatus.simCardLockState ) );
+                nextState = CELLULAR_SETUP_STATE_REGISTRATION;
             }
-
-            vTaskDelay( pdMS_TO_TICKS( CELLULAR_SIM_CARD_WAIT_INTERVAL_MS ) );
         }
+    }
 
-        if( cellularStatus != CELLULAR_SUCCESS )
-        {
-            configPRINTF( ( ">>>  Cellular SIM failure  <<<\r\n" ) );
-        }
+    return nextState;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvStateDeadlineMs( const CellularSetupContext_t * pContext,
+                                    uint64_t timeoutMs )
+{
+    uint64_t deadlineMs = Platform_GetTimeMs() + timeoutMs;
+
+    if( deadlineMs > ( pContext->startTimeMs + CELLULAR_SETUP_TIMEOUT_MS ) )
+    {
+        deadlineMs = pContext->startTimeMs + CELLULAR_SETUP_TIMEOUT_MS;
     }
 
-    /* Setup the PDN config. */
-    if( cellularStatus == CELLULAR_SUCCESS )
+    return deadlineMs;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularSetupState_t prvSetupRegistration( CellularSetupContext_t * pContext )
+{
+    CellularSetupState_t nextState = CELLULAR_SETUP_STATE_REGISTRATION;
+    CellularError_t cellularStatus = CELLULAR_SUCCESS;
+    CellularServiceStatus_t serviceStatus = { 0 };
+    PlatformEventGroup_EventBits waitEventBits = 0;
+    uint64_t nowMs = Platform_GetTimeMs();
+    uint64_t waitMs = 0;
+
+    if( pContext->registrationDeadlineMs == 0U )
     {
-        cellularStatus = Cellular_SetPdnConfig( CellularHandle, CellularSocketPdnContextId, &pdnConfig );
+        pContext->registrationDeadlineMs = prvStateDeadlineMs( pContext, CELLULAR_PDN_CONNECT_TIMEOUT );
 
-        if( cellularStatus != CELLULAR_SUCCESS )
-        {
-            configPRINTF( ( ">>>  Cellular_SetPdnConfig failure %d  <<<\r\n", cellularStatus ) );
-        }
+        /* A deregistration seen before this state must not send the activation
+         * back here once the module is registered again. */
+        ( void ) PlatformEventGroup_ClearBits( setupEventGroup, CELLULAR_SETUP_DEREGISTERED_BIT );
     }
 
-    /* Rescan network. */
-    if( cellularStatus == CELLULAR_SUCCESS )
+    if( nowMs >= pContext->registrationDeadlineMs )
     {
-        cellularStatus = Cellular_RfOff( CellularHandle );
+        configPRINTF( ( ">>>  Cellular module can't be registered  <<<\r\n" ) );
+        nextState = CELLULAR_SETUP_STATE_FAILED;
+    }
+    else
+    {
+        waitMs = pContext->registrationDeadlineMs - nowMs;
 
-        if( cellularStatus != CELLULAR_SUCCESS )
+        if( waitMs > CELLULAR_SETUP_REGISTRATION_POLL_MS )
         {
-            configPRINTF( ( ">>>  Cellular_RfOff failure %d  <<<\r\n", cellularStatus ) );
+            waitMs = CELLULAR_SETUP_REGISTRATION_POLL_MS;
         }
-    }
 
-    if( cellularStatus == CELLULAR_SUCCESS )
-    {
-        cellularStatus = Cellular_RfOn( CellularHandle );
+        waitEventBits = PlatformEventGroup_WaitBits( setupEventGroup,
+                                                     CELLULAR_SETUP_REGISTERED_BIT,
+                                                     pdFALSE,
+                                                     pdFALSE,
+                                                     pdMS_TO_TICKS( waitMs ) );
 
-        if( cellularStatus != CELLULAR_SUCCESS )
+        if( ( waitEventBits & CELLULAR_SETUP_REGISTERED_BIT ) != 0U )
         {
-            configPRINTF( ( ">>>  Cellular_RfOn failure %d  <<<\r\n", cellularStatus ) );
+            configPRINTF( ( ">>>  Cellular module registered  <<<\r\n" ) );
+            nextState = CELLULAR_SETUP_STATE_PDN_ACTIVATE;
         }
-    }
-
-    /* Get service status. */
-    if( cellularStatus == CELLULAR_SUCCESS )
-    {
-        while( timeoutCount < timeoutCountLimit )
+        else
         {
+            /* No URC, ask the modem in case it was lost. */
             cellularStatus = Cellular_GetServiceStatus( CellularHandle, &serviceStatus );
 
-            if( ( cellularStatus == CELLULAR_SUCCESS ) &&
-                ( ( serviceStatus.psRegistrationStatus == REGISTRATION_STATUS_REGISTERED_HOME ) ||
-                  ( serviceStatus.psRegistrationStatus == REGISTRATION_STATUS_ROAMING_REGISTERED ) ) )
+            if( ( cellularStatus == CELLULAR_SUCCESS ) && ( prvIsRegistered( serviceStatus.psRegistrationStatus ) == true ) )
             {
+                /* The registration URC was lost, so the callback did not clear the bit. */
+                ( void ) PlatformEventGroup_ClearBits( setupEventGroup, CELLULAR_SETUP_DEREGISTERED_BIT );
                 configPRINTF( ( ">>>  Cellular module registered  <<<\r\n" ) );
-                break;
+                nextState = CELLULAR_SETUP_STATE_PDN_ACTIVATE;
             }
             else
             {
                 configPRINTF( ( ">>>  Cellular GetServiceStatus failed %d, ps registration status %d  <<<\r\n",
                                 cellularStatus, serviceStatus.psRegistrationStatus ) );
             }
+        }
+    }
 
-            timeoutCount++;
+    return nextState;
+}
 
-            if( timeoutCount >= timeoutCountLimit )
-            {
-                configPRINTF( ( ">>>  Cellular module can't be registered  <<<\r\n" ) );
-            }
+/*-----------------------------------------------------------*/
 
-            vTaskDelay( pdMS_TO_TICKS( CELLULAR_PDN_CONNECT_WAIT_INTERVAL_MS ) );
-        }
-    }
+static CellularSetupState_t prvSetupPdnActivate( CellularSetupContext_t * pContext )
+{
+    CellularSetupState_t nextState = CELLULAR_SETUP_STATE_PDN_ACTIVATE;
+    CellularError_t cellularStatus = CELLULAR_SUCCESS;
+    PlatformEventGroup_EventBits waitEventBits = 0;
 
-    if( cellularStatus == CELLULAR_SUCCESS )
+    if( pContext->activationDeadlineMs == 0U )
     {
-        cellularStatus = Cellular_ActivatePdn( CellularHandle, CellularSocketPdnContextId );
-
-        if( cellularStatus != CELLULAR_SUCCESS )
-        {
-            configPRINTF( ( ">>>  Cellular_ActivatePdn failure %d  <<<\r\n", cellularStatus ) );
-        }
+        pContext->activationDeadlineMs = prvStateDeadlineMs( pContext, CELLULAR_SETUP_PDN_ACTIVATE_TIMEOUT_MS );
     }
 
+    ( void ) PlatformEventGroup_ClearBits( setupEventGroup, CELLULAR_SETUP_PDN_DEACTIVATED_BIT );
+    cellularStatus = Cellular_ActivatePdn( CellularHandle, CellularSocketPdnContextId );
+
     if( cellularStatus == CELLULAR_SUCCESS )
     {
-        cellularStatus = Cellular_GetIPAddress( CellularHandle, CellularSocketPdnContextId, localIP, sizeof( localIP ) );
+        nextState = CELLULAR_SETUP_STATE_IP_ADDRESS;
+    }
+    else
+    {
+        configPRINTF( ( ">>>  Cellular_ActivatePdn failure %d  <<<\r\n", cellularStatus ) );
 
-        if( cellularStatus != CELLULAR_SUCCESS )
+        if( Platform_GetTimeMs() >= pContext->activationDeadlineMs )
         {
-            configPRINTF( ( ">>>  Cellular_GetIPAddress failure %d  <<<\r\n", cellularStatus ) );
+            nextState = CELLULAR_SETUP_STATE_FAILED;
+        }
+        else
+        {
+            /* Retry, or wait for the registration again if the module lost it. */
+            waitEventBits = PlatformEventGroup_WaitBits( setupEventGroup,
+                                                         CELLULAR_SETUP_DEREGISTERED_BIT,
+                                                         pdFALSE,
+                                                         pdFALSE,
+                                                         pdMS_TO_TICKS( CELLULAR_SETUP_PDN_ACTIVATE_RETRY_MS ) );
+
+            if( ( waitEventBits & CELLULAR_SETUP_DEREGISTERED_BIT ) != 0U )
+            {
+                nextState = CELLULAR_SETUP_STATE_REGISTRATION;
+            }
         }
     }
 
-    if( cellularStatus == CELLULAR_SUCCESS )
+    return nextState;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularSetupState_t prvSetupIpAddress( CellularSetupContext_t * pContext )
+{
+    CellularSetupState_t nextState = CELLULAR_SETUP_STATE_FAILED;
+    CellularError_t cellularStatus = CELLULAR_SUCCESS;
+    CellularPdnStatus_t PdnStatusBuffers[ CELLULAR_PDN_CONTEXT_NUM ] = { 0 };
+    uint8_t NumStatus = 0;
+    bool pdnStatus = false;
+    uint32_t i = 0U;
+
+    cellularStatus = Cellular_GetIPAddress( CellularHandle, CellularSocketPdnContextId,
+                                            pContext->localIP, sizeof( pContext->localIP ) );
+
+    if( cellularStatus != CELLULAR_SUCCESS )
+    {
+        configPRINTF( ( ">>>  Cellular_GetIPAddress failure %d  <<<\r\n", cellularStatus ) );
+    }
+    else
     {
         cellularStatus = Cellular_GetPdnStatus( CellularHandle, PdnStatusBuffers, CELLULAR_PDN_CONTEXT_NUM, &NumStatus );
 
@@ -230,15 +577,131 @@ bool setupCellular( void )
             }
         }
 
-        if( pdnStatus == false )
+        if( ( pdnStatus == true ) &&
+            ( ( PlatformEventGroup_GetBits( setupEventGroup ) & CELLULAR_SETUP_PDN_DEACTIVATED_BIT ) == 0U ) )
+        {
+            nextState = CELLULAR_SETUP_STATE_DONE;
+        }
+        else if( Platform_GetTimeMs() < pContext->activationDeadlineMs )
+        {
+            /* The network dropped the PDN, activate it again. */
+            configPRINTF( ( ">>>  Cellular PDN is not activated <<<\r\n" ) );
+            nextState = CELLULAR_SETUP_STATE_PDN_ACTIVATE;
+        }
+        else
+        {
+            configPRINTF( ( ">>>  Cellular PDN is not activated <<<\r\n" ) );
+        }
+    }
+
+    return nextState;
+}
+
+/*-----------------------------------------------------------*/
+
+bool setupCellular( void )
+{
+    bool cellularRet = true;
+    CellularError_t cellularStatus = CELLULAR_SUCCESS;
+    CellularCommInterface_t * pCommIntf = &CellularCommInterface;
+    CellularSetupContext_t context = { 0 };
+    CellularSetupState_t previousState = CELLULAR_SETUP_STATE_SIM;
+
+    context.startTimeMs = Platform_GetTimeMs();
+    context.state = CELLULAR_SETUP_STATE_SIM;
+
+    if( setupEventGroup == NULL )
+    {
+        setupEventGroup = PlatformEventGroup_CreateStatic( &setupEventGroupBuffer );
+    }
+
+    /* Initialize Cellular Comm Interface. */
+    cellularStatus = Cellular_Init( &CellularHandle, pCommIntf );
+
+    if( cellularStatus != CELLULAR_SUCCESS )
+    {
+        configPRINTF( ( ">>>  Cellular_Init failure %d  <<<\r\n", cellularStatus ) );
+        context.state = CELLULAR_SETUP_STATE_FAILED;
+    }
+    else
+    {
+        /* The states wait for these URCs instead of polling the modem. */
+        cellularStatus = Cellular_RegisterUrcNetworkRegistrationEventCallback( CellularHandle, prvRegistrationCallback, NULL );
+
+        if( cellularStatus == CELLULAR_SUCCESS )
+        {
+            cellularStatus = Cellular_RegisterUrcPdnEventCallback( CellularHandle, prvPdnCallback, NULL );
+        }
+
+        if( cellularStatus != CELLULAR_SUCCESS )
         {
-            configPRINTF( ( ">>>  Cellular PDN is not activated <<<" ) );
+            configPRINTF( ( ">>>  Cellular URC callback registration failure %d  <<<\r\n", cellularStatus ) );
+            context.state = CELLULAR_SETUP_STATE_FAILED;
         }
     }
 
-    if( ( cellularStatus == CELLULAR_SUCCESS ) && ( pdnStatus == true ) )
+    while( ( context.state != CELLULAR_SETUP_STATE_DONE ) && ( context.state != CELLULAR_SETUP_STATE_FAILED ) )
+    {
+        previousState = context.state;
+
+        switch( context.state )
+        {
+            case CELLULAR_SETUP_STATE_SIM:
+                context.state = prvSetupSim( &context );
+                break;
+
+            case CELLULAR_SETUP_STATE_PDN_CONFIG:
+                context.state = prvSetupPdnConfig( &context );
+                break;
+
+            case CELLULAR_SETUP_STATE_RF:
+                context.state = prvSetupRf( &context );
+                break;
+
+            case CELLULAR_SETUP_STATE_REGISTRATION:
+                context.state = prvSetupRegistration( &context );
+                break;
+
+            case CELLULAR_SETUP_STATE_PDN_ACTIVATE:
+                context.state = prvSetupPdnActivate( &context );
+                break;
+
+            case CELLULAR_SETUP_STATE_IP_ADDRESS:
+                context.state = prvSetupIpAddress( &context );
+                break;
+
+            default:
+                context.state = CELLULAR_SETUP_STATE_FAILED;
+                break;
+        }
+
+        if( context.state != previousState )
+        {
+            configPRINTF( ( ">>>  Cellular setup state %d -> %d at %u ms  <<<\r\n",
+                            previousState, context.state,
+                            ( unsigned int ) ( Platform_GetTimeMs() - context.startTimeMs ) ) );
+
+            /* Every registration, the first one or after the module lost it, gets
+             * the full registration and activation timeouts, up to CELLULAR_SETUP_TIMEOUT_MS. */
+            if( context.state == CELLULAR_SETUP_STATE_REGISTRATION )
+            {
+                context.registrationDeadlineMs = 0U;
+                context.activationDeadlineMs = 0U;
+            }
+        }
+    }
+
+    /* The application may register its own URC callbacks from now on. */
+    if( CellularHandle != NULL )
+    {
+        ( void ) Cellular_RegisterUrcNetworkRegistrationEventCallback( CellularHandle, NULL, NULL );
+        ( void ) Cellular_RegisterUrcPdnEventCallback( CellularHandle, NULL, NULL );
+    }
+
+    if( context.state == CELLULAR_SETUP_STATE_DONE )
     {
-        configPRINTF( ( ">>>  Cellular module registered, IP address %s  <<<\r\n", localIP ) );
+        configPRINTF( ( ">>>  Cellular module registered, IP address %s in %u ms  <<<\r\n", context.localIP,
+                        ( unsigned int ) ( Platform_GetTimeMs() - context.startTimeMs ) ) );
         cellularRet = true;
     }
     else
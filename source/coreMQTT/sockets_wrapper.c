@@ -50,6 +50,9 @@
 #endif
 #include "logging_stack.h"
 
+/* Platform layer include, for the static allocation mode, the event groups and the heap tags. */
+#include "cellular_platform.h"
+
 /*-----------------------------------------------------------*/
 
 /* Celllular socket wrapper needs application provide the cellular handle and pdn context id. */
@@ -91,10 +94,6 @@ extern uint8_t CellularSocketPdnContextId;
 /* Cellular socket AT command timeout. */
 #define CELLULAR_SOCKET_RECV_TIMEOUT_MS        ( 1000UL )
 
-/* Time conversion constants. */
-#define _MILLISECONDS_PER_SECOND               ( 1000 )                                          /**< @brief Milliseconds per second. */
-#define _MILLISECONDS_PER_TICK                 ( _MILLISECONDS_PER_SECOND / configTICK_RATE_HZ ) /**< Milliseconds per FreeRTOS tick. */
-
 /* Logging macros definition. */
 #define IotLogError( ... )    LogError( ( __VA_ARGS__ ) )
 #define IotLogWarn( ... )     LogWarn( ( __VA_ARGS__ ) )
@@ -111,17 +110,23 @@ typedef struct xSOCKET
     TickType_t receiveTimeout;
     TickType_t sendTimeout;
 
-    EventGroupHandle_t socketEventGroupHandle;
+    PlatformEventGroupHandle_t socketEventGroupHandle;
+
+    #if ( PLATFORM_STATIC_ALLOCATION == 1 ) || ( PLATFORM_EVENT_GROUP_NOTIFY == 1 )
+        PlatformStaticEventGroup_t socketEventGroupBuffer;
+    #endif
 } cellularSocketWrapper_t;
 
 /*-----------------------------------------------------------*/
 
-/**
- * @brief Get the count of milliseconds since vTaskStartScheduler was called.
- *
- * @return The count of milliseconds since vTaskStartScheduler was called.
- */
-static uint64_t getTimeMs( void );
+#if ( PLATFORM_STATIC_ALLOCATION == 1 )
+
+/* Socket contexts of the static allocation mode, one for each socket of the cellular library. */
+    static cellularSocketWrapper_t _cellularSocketContexts[ CELLULAR_NUM_SOCKET_MAX ];
+    static bool _cellularSocketContextInUse[ CELLULAR_NUM_SOCKET_MAX ];
+#endif
+
+/*-----------------------------------------------------------*/
 
 /**
  * @brief Receive data from cellular socket.
@@ -231,28 +236,19 @@ static bool _calculateElapsedTime( uint64_t entryTimeMs,
                                    uint32_t timeoutValueMs,
                                    uint64_t * pElapsedTimeMs );
 
-/*-----------------------------------------------------------*/
-
-static uint64_t getTimeMs( void )
-{
-    TimeOut_t xCurrentTime = { 0 };
-
-    /* This must be unsigned because the behavior of signed integer overflow is undefined. */
-    uint64_t ullTickCount = 0ULL;
-
-    /* Get the current tick count and overflow count. vTaskSetTimeOutState()
-     * is used to get these values because they are both static in tasks.c. */
-    vTaskSetTimeOutState( &xCurrentTime );
-
-    /* Adjust the tick count for the number of times a TickType_t has overflowed. */
-    ullTickCount = ( uint64_t ) ( xCurrentTime.xOverflowCount ) << ( sizeof( TickType_t ) * 8 );
-
-    /* Add the current tick count. */
-    ullTickCount += xCurrentTime.xTimeOnEntering;
+/**
+ * @brief Allocate a socket context, from the heap or from the static socket contexts.
+ *
+ * @return The socket context. NULL if there is no memory or no free socket context.
+ */
+static cellularSocketWrapper_t * prvSocketContextAllocate( void );
 
-    /* Return the ticks converted to milliseconds. */
-    return ullTickCount * _MILLISECONDS_PER_TICK;
-}
+/**
+ * @brief Free a socket context allocated with prvSocketContextAllocate.
+ *
+ * @param[in] pCellularSocketContext The socket context to free.
+ */
+static void prvSocketContextFree( cellularSocketWrapper_t * pCellularSocketContext );
 
 /*-----------------------------------------------------------*/
 
@@ -266,7 +262,7 @@ static BaseType_t prvNetworkRecvCellular( const cellularSocketWrapper_t * pCellu
     TickType_t recvTimeout = 0;
     TickType_t recvStartTime = 0;
     CellularError_t socketStatus = CELLULAR_SUCCESS;
-    EventBits_t waitEventBits = 0;
+    PlatformEventGroup_EventBits waitEventBits = 0;
 
     cellularSocketHandle = pCellularSocketContext->cellularSocketHandle;
 
@@ -281,8 +277,8 @@ static BaseType_t prvNetworkRecvCellular( const cellularSocketWrapper_t * pCellu
 
     recvStartTime = xTaskGetTickCount();
 
-    ( void ) xEventGroupClearBits( pCellularSocketContext->socketEventGroupHandle,
-                                   SOCKET_DATA_RECEIVED_CALLBACK_BIT );
+    ( void ) PlatformEventGroup_ClearBits( pCellularSocketContext->socketEventGroupHandle,
+                                           SOCKET_DATA_RECEIVED_CALLBACK_BIT );
     socketStatus = Cellular_SocketRecv( CellularHandle, cellularSocketHandle, buf, len, &recvLength );
 
     /* Calculate remain recvTimeout. */
@@ -301,11 +297,11 @@ static BaseType_t prvNetworkRecvCellular( const cellularSocketWrapper_t * pCellu
     if( ( socketStatus == CELLULAR_SUCCESS ) && ( recvLength == 0U ) &&
         ( recvTimeout != 0U ) )
     {
-        waitEventBits = xEventGroupWaitBits( pCellularSocketContext->socketEventGroupHandle,
-                                             SOCKET_DATA_RECEIVED_CALLBACK_BIT | SOCKET_CLOSE_CALLBACK_BIT,
-                                             pdTRUE,
-                                             pdFALSE,
-                                             recvTimeout );
+        waitEventBits = PlatformEventGroup_WaitBits( pCellularSocketContext->socketEventGroupHandle,
+                                                     SOCKET_DATA_RECEIVED_CALLBACK_BIT | SOCKET_CLOSE_CALLBACK_BIT,
+                                                     pdTRUE,
+                                                     pdFALSE,
+                                                     recvTimeout );
 
         if( ( waitEventBits & SOCKET_CLOSE_CALLBACK_BIT ) != 0U )
         {
@@ -355,14 +351,14 @@ static void prvCellularSocketOpenCallback( CellularUrcEvent_t urcEvent,
         if( urcEvent == CELLULAR_URC_SOCKET_OPENED )
         {
             pCellularSocketContext->ulFlags = pCellularSocketContext->ulFlags | CELLULAR_SOCKET_CONNECT_FLAG;
-            ( void ) xEventGroupSetBits( pCellularSocketContext->socketEventGroupHandle,
-                                         SOCKET_OPEN_CALLBACK_BIT );
+            ( void ) PlatformEventGroup_SetBits( pCellularSocketContext->socketEventGroupHandle,
+                                                 SOCKET_OPEN_CALLBACK_BIT );
         }
         else
         {
             /* Socket open failed. */
-            ( void ) xEventGroupSetBits( pCellularSocketContext->socketEventGroupHandle,
-                                         SOCKET_OPEN_FAILED_CALLBACK_BIT );
+            ( void ) PlatformEventGroup_SetBits( pCellularSocketContext->socketEventGroupHandle,
+                                                 SOCKET_OPEN_FAILED_CALLBACK_BIT );
         }
     }
     else
@@ -383,8 +379,8 @@ static void prvCellularSocketDataReadyCallback( CellularSocketHandle_t socketHan
     if( pCellularSocketContext != NULL )
     {
         IotLogDebug( "Data ready on Socket %p", pCellularSocketContext );
-        ( void ) xEventGroupSetBits( pCellularSocketContext->socketEventGroupHandle,
-                                     SOCKET_DATA_RECEIVED_CALLBACK_BIT );
+        ( void ) PlatformEventGroup_SetBits( pCellularSocketContext->socketEventGroupHandle,
+                                             SOCKET_DATA_RECEIVED_CALLBACK_BIT );
     }
     else
     {
@@ -405,8 +401,8 @@ static void prvCellularSocketClosedCallback( CellularSocketHandle_t socketHandle
     {
         IotLogInfo( "Socket Close on Socket %p", pCellularSocketContext );
         pCellularSocketContext->ulFlags = pCellularSocketContext->ulFlags & ( ~CELLULAR_SOCKET_CONNECT_FLAG );
-        ( void ) xEventGroupSetBits( pCellularSocketContext->socketEventGroupHandle,
-                                     SOCKET_CLOSE_CALLBACK_BIT );
+        ( void ) PlatformEventGroup_SetBits( pCellularSocketContext->socketEventGroupHandle,
+                                             SOCKET_CLOSE_CALLBACK_BIT );
     }
     else
     {
@@ -551,7 +547,7 @@ static bool _calculateElapsedTime( uint64_t entryTimeMs,
                                    uint32_t timeoutValueMs,
                                    uint64_t * pElapsedTimeMs )
 {
-    uint64_t currentTimeMs = getTimeMs();
+    uint64_t currentTimeMs = Platform_GetTimeMs();
     bool isExpired = false;
 
     /* timeoutValueMs with UINT32_MAX_DELAY_MS means wait for ever, same behavior as freertos_plus_tcp. */
@@ -584,6 +580,50 @@ static bool _calculateElapsedTime( uint64_t entryTimeMs,
 
 /*-----------------------------------------------------------*/
 
+static cellularSocketWrapper_t * prvSocketContextAllocate( void )
+{
+    cellularSocketWrapper_t * pCellularSocketContext = NULL;
+
+    #if ( PLATFORM_STATIC_ALLOCATION == 1 )
+        uint32_t index = 0;
+
+        taskENTER_CRITICAL();
+
+        for( index = 0; index < CELLULAR_NUM_SOCKET_MAX; index++ )
+        {
+            if( _cellularSocketContextInUse[ index ] == false )
+            {
+                _cellularSocketContextInUse[ index ] = true;
+                pCellularSocketContext = &_cellularSocketContexts[ index ];
+                break;
+            }
+        }
+
+        taskEXIT_CRITICAL();
+    #else
+        pCellularSocketContext = Platform_MallocTagged( sizeof( cellularSocketWrapper_t ), PLATFORM_HEAP_TAG_SOCKETS );
+    #endif
+
+    return pCellularSocketContext;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvSocketContextFree( cellularSocketWrapper_t * pCellularSocketContext )
+{
+    #if ( PLATFORM_STATIC_ALLOCATION == 1 )
+        uint32_t index = ( uint32_t ) ( pCellularSocketContext - _cellularSocketContexts );
+
+        taskENTER_CRITICAL();
+        _cellularSocketContextInUse[ index ] = false;
+        taskEXIT_CRITICAL();
+    #else
+        Platform_FreeTagged( pCellularSocketContext );
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
 BaseType_t Sockets_Connect( Socket_t * pTcpSocket,
                             const char * pHostName,
                             uint16_t port,
@@ -595,7 +635,7 @@ BaseType_t Sockets_Connect( Socket_t * pTcpSocket,
     CellularError_t cellularSocketStatus = CELLULAR_INVALID_HANDLE;
 
     CellularSocketAddress_t serverAddress = { 0 };
-    EventBits_t waitEventBits = 0;
+    PlatformEventGroup_EventBits waitEventBits = 0;
     BaseType_t retConnect = SOCKETS_ERROR_NONE;
     const uint32_t defaultReceiveTimeoutMs = CELLULAR_SOCKET_RECV_TIMEOUT_MS;
 
@@ -616,7 +656,7 @@ BaseType_t Sockets_Connect( Socket_t * pTcpSocket,
     /* Allocate socket context. */
     if( retConnect == SOCKETS_ERROR_NONE )
     {
-        pCellularSocketContext = pvPortMalloc( sizeof( cellularSocketWrapper_t ) );
+        pCellularSocketContext = prvSocketContextAllocate();
 
         if( pCellularSocketContext == NULL )
         {
@@ -638,7 +678,11 @@ BaseType_t Sockets_Connect( Socket_t * pTcpSocket,
     /* Allocate event group for callback function. */
     if( retConnect == SOCKETS_ERROR_NONE )
     {
-        pCellularSocketContext->socketEventGroupHandle = xEventGroupCreate();
+        #if ( PLATFORM_STATIC_ALLOCATION == 1 ) || ( PLATFORM_EVENT_GROUP_NOTIFY == 1 )
+            pCellularSocketContext->socketEventGroupHandle = PlatformEventGroup_CreateStatic( &pCellularSocketContext->socketEventGroupBuffer );
+        #else
+            pCellularSocketContext->socketEventGroupHandle = PlatformEventGroup_Create();
+        #endif
 
         if( pCellularSocketContext->socketEventGroupHandle == NULL )
         {
@@ -689,8 +733,8 @@ BaseType_t Sockets_Connect( Socket_t * pTcpSocket,
     /* Cellular socket connect. */
     if( retConnect == SOCKETS_ERROR_NONE )
     {
-        ( void ) xEventGroupClearBits( pCellularSocketContext->socketEventGroupHandle,
-                                       SOCKET_DATA_RECEIVED_CALLBACK_BIT | SOCKET_OPEN_FAILED_CALLBACK_BIT );
+        ( void ) PlatformEventGroup_ClearBits( pCellularSocketContext->socketEventGroupHandle,
+                                               SOCKET_DATA_RECEIVED_CALLBACK_BIT | SOCKET_OPEN_FAILED_CALLBACK_BIT );
         cellularSocketStatus = Cellular_SocketConnect( CellularHandle, cellularSocketHandle, CELLULAR_SOCKET_ACCESS_MODE, &serverAddress );
 
         if( cellularSocketStatus != CELLULAR_SUCCESS )
@@ -703,11 +747,11 @@ BaseType_t Sockets_Connect( Socket_t * pTcpSocket,
     /* Wait the socket connection. */
     if( retConnect == SOCKETS_ERROR_NONE )
     {
-        waitEventBits = xEventGroupWaitBits( pCellularSocketContext->socketEventGroupHandle,
-                                             SOCKET_OPEN_CALLBACK_BIT | SOCKET_OPEN_FAILED_CALLBACK_BIT,
-                                             pdTRUE,
-                                             pdFALSE,
-                                             CELLULAR_SOCKET_OPEN_TIMEOUT_TICKS );
+        waitEventBits = PlatformEventGroup_WaitBits( pCellularSocketContext->socketEventGroupHandle,
+                                                     SOCKET_OPEN_CALLBACK_BIT | SOCKET_OPEN_FAILED_CALLBACK_BIT,
+                                                     pdTRUE,
+                                                     pdFALSE,
+                                                     CELLULAR_SOCKET_OPEN_TIMEOUT_TICKS );
 
         if( waitEventBits != SOCKET_OPEN_CALLBACK_BIT )
         {
@@ -734,13 +778,13 @@ BaseType_t Sockets_Connect( Socket_t * pTcpSocket,
 
         if( ( pCellularSocketContext != NULL ) && ( pCellularSocketContext->socketEventGroupHandle != NULL ) )
         {
-            vEventGroupDelete( pCellularSocketContext->socketEventGroupHandle );
+            PlatformEventGroup_Delete( pCellularSocketContext->socketEventGroupHandle );
             pCellularSocketContext->socketEventGroupHandle = NULL;
         }
 
         if( pCellularSocketContext != NULL )
         {
-            vPortFree( pCellularSocketContext );
+            prvSocketContextFree( pCellularSocketContext );
             pCellularSocketContext = NULL;
         }
     }
@@ -800,11 +844,11 @@ void Sockets_Disconnect( Socket_t xSocket )
 
         if( pCellularSocketContext->socketEventGroupHandle != NULL )
         {
-            vEventGroupDelete( pCellularSocketContext->socketEventGroupHandle );
+            PlatformEventGroup_Delete( pCellularSocketContext->socketEventGroupHandle );
             pCellularSocketContext->socketEventGroupHandle = NULL;
         }
 
-        vPortFree( pCellularSocketContext );
+        prvSocketContextFree( pCellularSocketContext );
     }
 
     IotLogDebug( "Sockets close exit with code %d", retClose );
@@ -857,7 +901,7 @@ int32_t Sockets_Send( Socket_t xSocket,
     CellularError_t socketStatus = CELLULAR_SUCCESS;
     cellularSocketWrapper_t * pCellularSocketContext = ( cellularSocketWrapper_t * ) xSocket;
     uint32_t bytesToSend = xDataLength;
-    uint64_t entryTimeMs = getTimeMs();
+    uint64_t entryTimeMs = Platform_GetTimeMs();
     uint64_t elapsedTimeMs = 0;
     uint32_t sendTimeoutMs = 0;
 
@@ -28,6 +28,11 @@
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 
+#if !defined( _WIN32 )
+    /* Random number generator of the host kernel. */
+    #include <sys/random.h>
+#endif
+
 /* mbed TLS includes. */
 #include "mbedtls_config.h"
 #include "threading_alt.h"
@@ -36,6 +41,9 @@
 /* Socket wrapper includes. */
 #include "sockets_wrapper.h"
 
+/* Platform layer include, for the heap tags. */
+#include "cellular_platform.h"
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -58,7 +66,7 @@ void * mbedtls_platform_calloc( size_t nmemb,
         /* Overflow check. */
         if( ( totalSize / size ) == nmemb )
         {
-            pBuffer = pvPortMalloc( totalSize );
+            pBuffer = Platform_MallocTagged( totalSize, PLATFORM_HEAP_TAG_TLS );
 
             if( pBuffer != NULL )
             {
@@ -79,7 +87,7 @@ void * mbedtls_platform_calloc( size_t nmemb,
  */
 void mbedtls_platform_free( void * ptr )
 {
-    vPortFree( ptr );
+    Platform_FreeTagged( ptr );
 }
 
 /*-----------------------------------------------------------*/
@@ -233,7 +241,12 @@ int mbedtls_platform_entropy_poll( void * data,
                                    size_t * olen )
 {
     int status = 0;
-    NTSTATUS rngStatus = 0;
+
+    #if defined( _WIN32 )
+        NTSTATUS rngStatus = 0;
+    #else
+        ssize_t rngStatus = 0;
+    #endif
 
     configASSERT( output != NULL );
     configASSERT( olen != NULL );
@@ -241,10 +254,21 @@ int mbedtls_platform_entropy_poll( void * data,
     /* Context is not used by this function. */
     ( void ) data;
 
-    /* TLS requires a secure random number generator; use the RNG provided
-     * by Windows. This function MUST be re-implemented for other platforms. */
-    rngStatus =
-        BCryptGenRandom( NULL, output, len, BCRYPT_USE_SYSTEM_PREFERRED_RNG );
+    #if defined( _WIN32 )
+        /* TLS requires a secure random number generator; use the RNG provided
+         * by Windows. This function MUST be re-implemented for other platforms. */
+        rngStatus =
+            BCryptGenRandom( NULL, output, len, BCRYPT_USE_SYSTEM_PREFERRED_RNG );
+    #else
+        /* Use the RNG of the host kernel. Requests of up to 256 bytes are never
+         * cut short. */
+        rngStatus = getrandom( output, len, 0 );
+
+        if( rngStatus == ( ssize_t ) len )
+        {
+            rngStatus = 0;
+        }
+    #endif
 
     if( rngStatus == 0 )
     {
@@ -266,7 +290,7 @@ int mbedtls_platform_entropy_poll( void * data,
 /**
  * @brief Function to generate a random number based on a hardware poll.
  *
- * For this FreeRTOS Windows port, this function is redirected by calling
+ * For the Windows and POSIX builds, this function is redirected by calling
  * #mbedtls_platform_entropy_poll.
  *
  * @param[in] data Callback context.
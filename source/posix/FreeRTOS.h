@@ -0,0 +1,248 @@
+/*
+ * Amazon FreeRTOS Cellular Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file FreeRTOS.h
+ * @brief FreeRTOS kernel API subset on native POSIX threads.
+ *
+ * The POSIX build of the demos replaces the FreeRTOS kernel and its Windows
+ * simulator port with the headers of this directory. Tasks are detached
+ * pthreads scheduled by the host kernel on all the cores, mutex semaphores
+ * are pthread mutexes, event groups and queues wait on condition variables
+ * and the tick count is CLOCK_MONOTONIC. Only the part of the kernel API used
+ * by the platform layer, the sockets wrapper, the TLS transport and the demo
+ * tasks is provided.
+ *
+ * Task priorities are ignored and critical sections are a process wide
+ * recursive mutex, so code relying on a higher priority task not being
+ * preempted by a lower one must not be built this way. The platform layer
+ * protects its slab allocator, heap tags, notification event groups, mutex
+ * profiler and worker pool with critical sections, as on a single core
+ * target, so these paths do not scale with the cores of the host.
+ * tools/benchmarks/platform_critical_scaling measures the limit.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Application specific configuration options. */
+#include "FreeRTOSConfig.h"
+
+/*-----------------------------------------------------------*/
+
+typedef long             BaseType_t;
+typedef unsigned long    UBaseType_t;
+typedef uint32_t         TickType_t;
+typedef size_t           StackType_t;
+
+#define pdFALSE                                 ( ( BaseType_t ) 0 )
+#define pdTRUE                                  ( ( BaseType_t ) 1 )
+#define pdPASS                                  ( pdTRUE )
+#define pdFAIL                                  ( pdFALSE )
+
+#define portMAX_DELAY                           ( ( TickType_t ) 0xffffffffUL )
+#define portTICK_PERIOD_MS                      ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portYIELD_FROM_ISR( xSwitchRequired )    ( ( void ) ( xSwitchRequired ) )
+
+/* Every task is a native thread, so threads not created with xTaskCreate may
+ * call the kernel API as well, the FromISR functions included. */
+#define portNATIVE_THREADS_CALL_KERNEL          ( 1 )
+
+#ifndef pdMS_TO_TICKS
+    #define pdMS_TO_TICKS( xTimeInMs )    ( ( TickType_t ) ( ( ( uint64_t ) ( xTimeInMs ) * ( uint64_t ) configTICK_RATE_HZ ) / ( uint64_t ) 1000U ) )
+#endif
+
+#ifndef configSTACK_DEPTH_TYPE
+    #define configSTACK_DEPTH_TYPE    uint16_t
+#endif
+
+#ifndef configMAX_TASK_NAME_LEN
+    #define configMAX_TASK_NAME_LEN    ( 16 )
+#endif
+
+#ifndef configNUM_THREAD_LOCAL_STORAGE_POINTERS
+    #define configNUM_THREAD_LOCAL_STORAGE_POINTERS    0
+#endif
+
+#ifndef configGENERATE_RUN_TIME_STATS
+    #define configGENERATE_RUN_TIME_STATS    0
+#endif
+
+#ifndef configRUN_TIME_COUNTER_TYPE
+    #define configRUN_TIME_COUNTER_TYPE    uint32_t
+#endif
+
+#ifndef configTASK_NOTIFICATION_ARRAY_ENTRIES
+    #define configTASK_NOTIFICATION_ARRAY_ENTRIES    1
+#endif
+
+/* Set to 0 when the application links its own pvPortMalloc and vPortFree, for
+ * example a model of heap_4.c, to measure heap use on the host. xTaskCreate
+ * then takes a block of the task's stack depth from pvPortMalloc, as the
+ * kernel does on a target, although the task runs on its pthread stack. */
+#ifndef configPOSIX_HOST_HEAP
+    #define configPOSIX_HOST_HEAP    1
+#endif
+
+/* Called with pxCurrentTCB set when a task resumes after it blocked. The host
+ * scheduler does not tell when it preempts a thread, so those are not seen. */
+#ifndef traceTASK_SWITCHED_IN
+    #define traceTASK_SWITCHED_IN()
+#endif
+
+/* A process on a host has the C library assert. */
+#ifndef configASSERT
+    #define configASSERT( x )    assert( x )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Task. The stack of the FreeRTOS port is not used, a task runs on the default pthread stack.
+ */
+typedef struct tskTaskControlBlock
+{
+    pthread_t thread;                                   /**< Thread of the task. */
+    void ( * pxTaskCode )( void * );                     /**< Task function. */
+    void * pvParameters;                                /**< Argument of the task function. */
+    bool dynamic;                                       /**< The task control block is freed when the task is deleted. */
+    pthread_mutex_t notifyMutex;                        /**< Protects ulNotifiedValue. */
+    pthread_cond_t notifyCond;                          /**< Signaled when a count of ulNotifiedValue is incremented. */
+    uint32_t ulNotifiedValue[ configTASK_NOTIFICATION_ARRAY_ENTRIES ]; /**< Notification counts of the task, one per index. */
+    char pcTaskName[ configMAX_TASK_NAME_LEN ];         /**< Name of the task. */
+    UBaseType_t uxPriority;                             /**< Priority given at creation, not applied. */
+    UBaseType_t uxTaskNumber;                           /**< Unique number given when the task is added to the list. */
+    struct tskTaskControlBlock * pxNextTask;            /**< Next task of the list of running tasks. */
+    #if ( configPOSIX_HOST_HEAP == 0 )
+        void * pvStack;                                 /**< Stack of xTaskCreate taken from pvPortMalloc, not used. */
+    #endif
+    #if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS > 0 )
+        void * pvThreadLocalStoragePointer[ configNUM_THREAD_LOCAL_STORAGE_POINTERS ]; /**< Thread local storage of the task. */
+    #endif
+} StaticTask_t;
+
+/**
+ * @brief Queue, or mutex semaphore when itemSize is 0.
+ */
+typedef struct QueueDefinition
+{
+    pthread_mutex_t mutex;    /**< Lock of the queue, or the mutex of a mutex semaphore. */
+    pthread_cond_t notEmpty;  /**< Signaled when an item is added. */
+    pthread_cond_t notFull;   /**< Signaled when an item is removed. */
+    uint8_t * pStorage;       /**< Items, length times itemSize bytes. */
+    UBaseType_t length;       /**< Most items in the queue. */
+    UBaseType_t itemSize;     /**< Bytes of an item. */
+    UBaseType_t head;         /**< Index of the oldest item. */
+    UBaseType_t count;        /**< Items in the queue. */
+    bool dynamic;             /**< The queue and its storage are freed when the queue is deleted. */
+} StaticQueue_t;
+
+typedef StaticQueue_t StaticSemaphore_t;
+
+/**
+ * @brief Event group.
+ */
+typedef struct EventGroupDef_t
+{
+    pthread_mutex_t mutex; /**< Lock of the bits. */
+    pthread_cond_t changed; /**< Broadcast when bits are set. */
+    TickType_t bits;        /**< Event bits. */
+    bool dynamic;           /**< The event group is freed when it is deleted. */
+} StaticEventGroup_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Allocate from the heap of the process, or from the heap of the
+ * application when configPOSIX_HOST_HEAP is 0.
+ */
+void * pvPortMalloc( size_t xWantedSize );
+
+/**
+ * @brief Free a block of pvPortMalloc.
+ */
+void vPortFree( void * pv );
+
+/**
+ * @brief The heap of the process has no fixed size, so there is no free size to report.
+ *
+ * @return Always 0 when configPOSIX_HOST_HEAP is 1.
+ */
+size_t xPortGetFreeHeapSize( void );
+
+/**
+ * @brief Same as xPortGetFreeHeapSize.
+ *
+ * @return Always 0 when configPOSIX_HOST_HEAP is 1.
+ */
+size_t xPortGetMinimumEverFreeHeapSize( void );
+
+#if ( configPOSIX_HOST_HEAP == 0 )
+
+/**
+ * @brief Heap statistics, same as in portable.h of the kernel.
+ */
+    typedef struct xHeapStats
+    {
+        size_t xAvailableHeapSpaceInBytes;      /**< Free bytes. */
+        size_t xSizeOfLargestFreeBlockInBytes;  /**< Largest free block. */
+        size_t xSizeOfSmallestFreeBlockInBytes; /**< Smallest free block. */
+        size_t xNumberOfFreeBlocks;             /**< Free blocks. */
+        size_t xMinimumEverFreeBytesRemaining;  /**< Low-water mark of the free bytes. */
+        size_t xNumberOfSuccessfulAllocations;  /**< Calls of pvPortMalloc that returned a block. */
+        size_t xNumberOfSuccessfulFrees;        /**< Calls of vPortFree that freed a block. */
+    } HeapStats_t;
+
+/**
+ * @brief Get the statistics of the heap of the application.
+ *
+ * @param[out] pxHeapStats Heap statistics.
+ */
+    void vPortGetHeapStats( HeapStats_t * pxHeapStats );
+
+#endif /* configPOSIX_HOST_HEAP == 0 */
+
+/**
+ * @brief Enter a critical section. Critical sections nest and exclude each other across all the tasks.
+ *
+ * All the critical sections share one mutex, so the threads entering them
+ * take turns on a multi-core host.
+ */
+void vPortEnterCritical( void );
+
+/**
+ * @brief Exit a critical section.
+ */
+void vPortExitCritical( void );
+
+/*-----------------------------------------------------------*/
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,99 @@
+/*
+ * Amazon FreeRTOS Cellular Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file event_groups.h
+ * @brief FreeRTOS event group API on a POSIX mutex and condition variable.
+ */
+
+#ifndef EVENT_GROUPS_H
+#define EVENT_GROUPS_H
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include event_groups.h"
+#endif
+
+/* As in the kernel, the event group API brings in the task API. */
+#include "task.h"
+
+/*-----------------------------------------------------------*/
+
+typedef struct EventGroupDef_t * EventGroupHandle_t;
+typedef TickType_t               EventBits_t;
+
+/**
+ * @brief Create an event group on the heap.
+ */
+EventGroupHandle_t xEventGroupCreate( void );
+
+/**
+ * @brief Create an event group in pxEventGroupBuffer.
+ */
+EventGroupHandle_t xEventGroupCreateStatic( StaticEventGroup_t * pxEventGroupBuffer );
+
+/**
+ * @brief Delete an event group no task waits on.
+ */
+void vEventGroupDelete( EventGroupHandle_t xEventGroup );
+
+/**
+ * @brief Wait up to xTicksToWait for any or all of uxBitsToWaitFor to be set.
+ *
+ * @return The bits when the wait ended, before they are cleared by xClearOnExit.
+ */
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t xEventGroup,
+                                 const EventBits_t uxBitsToWaitFor,
+                                 const BaseType_t xClearOnExit,
+                                 const BaseType_t xWaitForAllBits,
+                                 TickType_t xTicksToWait );
+
+/**
+ * @brief Clear bits.
+ *
+ * @return The bits before they are cleared.
+ */
+EventBits_t xEventGroupClearBits( EventGroupHandle_t xEventGroup,
+                                  const EventBits_t uxBitsToClear );
+
+/**
+ * @brief Set bits and wake the tasks waiting on the event group.
+ *
+ * @return The bits after they are set.
+ */
+EventBits_t xEventGroupSetBits( EventGroupHandle_t xEventGroup,
+                                const EventBits_t uxBitsToSet );
+
+/**
+ * @brief Set bits. A host has no interrupts, so this is xEventGroupSetBits.
+ */
+BaseType_t xEventGroupSetBitsFromISR( EventGroupHandle_t xEventGroup,
+                                      const EventBits_t uxBitsToSet,
+                                      BaseType_t * pxHigherPriorityTaskWoken );
+
+#define xEventGroupGetBits( xEventGroup )    xEventGroupClearBits( ( xEventGroup ), 0 )
+
+/*-----------------------------------------------------------*/
+
+#endif /* EVENT_GROUPS_H */
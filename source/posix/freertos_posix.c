@@ -0,0 +1,1245 @@
+/*
+ * Amazon FreeRTOS Cellular Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file freertos_posix.c
+ * @brief FreeRTOS kernel API subset on native POSIX threads.
+ */
+
+/*-----------------------------------------------------------*/
+
+/* POSIX include files for the threads and the clock. */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* FreeRTOS API include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+
+/*-----------------------------------------------------------*/
+
+/* Nanoseconds of a tick. */
+#define POSIX_TICK_PERIOD_NS    ( 1000000000ULL / ( uint64_t ) configTICK_RATE_HZ )
+
+/*-----------------------------------------------------------*/
+
+/* Initializes the state below once. */
+static pthread_once_t kernelOnce = PTHREAD_ONCE_INIT;
+
+/* Time of the first tick count, the origin of the ticks. */
+static struct timespec tickOrigin = { 0 };
+
+/* Recursive mutex of the critical sections. One for the whole process, so
+ * the critical sections of unrelated objects exclude each other too. */
+static pthread_mutex_t criticalMutex;
+
+/* Task control block of the calling task, NULL for a thread which is not a task yet. */
+static pthread_key_t currentTaskKey;
+
+/* Tasks whose thread runs, newest first, and their number. Protected by criticalMutex. */
+static StaticTask_t * pxTaskList = NULL;
+static UBaseType_t uxTaskCount = 0;
+
+/* Number of the next task added to the list. */
+static UBaseType_t uxNextTaskNumber = 0;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize the clock origin, the critical section mutex and the task key.
+ */
+static void prvKernelInit( void );
+
+/**
+ * @brief Ticks since the origin, not truncated to TickType_t.
+ *
+ * @return The tick count.
+ */
+static uint64_t prvGetTicks( void );
+
+/**
+ * @brief Absolute time xTicks ticks from now.
+ *
+ * @param[in] clockId Clock the time is measured with.
+ * @param[in] xTicks Ticks from now.
+ * @param[out] pDeadline The absolute time.
+ */
+static void prvGetDeadline( clockid_t clockId,
+                            TickType_t xTicks,
+                            struct timespec * pDeadline );
+
+/**
+ * @brief Initialize a condition variable waiting on CLOCK_MONOTONIC.
+ *
+ * @param[out] pCond The condition variable.
+ */
+static void prvCondInit( pthread_cond_t * pCond );
+
+/**
+ * @brief Wait on a condition variable until the deadline, or for ever if pDeadline is NULL.
+ *
+ * @param[in] pCond The condition variable.
+ * @param[in] pMutex The mutex locked by the caller.
+ * @param[in] pDeadline Absolute CLOCK_MONOTONIC time, or NULL.
+ *
+ * @return false if the deadline passed.
+ */
+static bool prvCondWait( pthread_cond_t * pCond,
+                         pthread_mutex_t * pMutex,
+                         const struct timespec * pDeadline );
+
+/**
+ * @brief Initialize the notification of a task.
+ *
+ * @param[out] pxTcb Task control block.
+ */
+static void prvTaskNotifyInit( StaticTask_t * pxTcb );
+
+/**
+ * @brief Add a task to the list of running tasks and make it the task of the calling thread.
+ *
+ * @param[in] pxTcb Task control block of the calling thread.
+ */
+static void prvTaskListAdd( StaticTask_t * pxTcb );
+
+/**
+ * @brief Call traceTASK_SWITCHED_IN for the calling task when it resumes after it blocked.
+ */
+static void prvTaskSwitchedIn( void );
+
+/**
+ * @brief Release a task control block when its pthread exits.
+ *
+ * @param[in] pArgument The task control block.
+ */
+static void prvTaskExit( void * pArgument );
+
+/**
+ * @brief Entry of the pthread of a task.
+ *
+ * @param[in] pArgument The task control block.
+ *
+ * @return Never returns, the task is deleted when its function returns.
+ */
+static void * prvTaskEntry( void * pArgument );
+
+/**
+ * @brief Start the pthread of a task.
+ *
+ * @param[in] pxTcb Task control block to initialize.
+ * @param[in] pxTaskCode Task function.
+ * @param[in] pcName Name of the task.
+ * @param[in] pvParameters Argument of the task function.
+ * @param[in] uxPriority Priority of the task, only reported.
+ * @param[in] dynamic The task control block is on the heap.
+ * @param[in] pvStack Stack block freed with the task when configPOSIX_HOST_HEAP is 0. May be NULL.
+ *
+ * @return true if the pthread is started.
+ */
+static bool prvTaskStart( StaticTask_t * pxTcb,
+                          TaskFunction_t pxTaskCode,
+                          const char * pcName,
+                          void * pvParameters,
+                          UBaseType_t uxPriority,
+                          bool dynamic,
+                          void * pvStack );
+
+/**
+ * @brief Initialize a queue.
+ *
+ * @param[out] pxQueue The queue.
+ * @param[in] uxQueueLength Most items in the queue.
+ * @param[in] uxItemSize Bytes of an item.
+ * @param[in] pucQueueStorage Items of the queue.
+ * @param[in] dynamic The queue is on the heap.
+ */
+static void prvQueueInit( StaticQueue_t * pxQueue,
+                          UBaseType_t uxQueueLength,
+                          UBaseType_t uxItemSize,
+                          uint8_t * pucQueueStorage,
+                          bool dynamic );
+
+/**
+ * @brief Initialize a mutex semaphore.
+ *
+ * @param[out] pxMutex The mutex semaphore.
+ * @param[in] recursive The owner can lock the mutex again.
+ * @param[in] dynamic The mutex semaphore is on the heap.
+ *
+ * @return The mutex semaphore, NULL if the pthread mutex cannot be created.
+ */
+static SemaphoreHandle_t prvMutexInit( StaticSemaphore_t * pxMutex,
+                                       bool recursive,
+                                       bool dynamic );
+
+/**
+ * @brief Initialize an event group.
+ *
+ * @param[out] pxEventGroup The event group.
+ * @param[in] dynamic The event group is on the heap.
+ */
+static void prvEventGroupInit( StaticEventGroup_t * pxEventGroup,
+                               bool dynamic );
+
+/*-----------------------------------------------------------*/
+
+static void prvKernelInit( void )
+{
+    pthread_mutexattr_t mutexAttr;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &tickOrigin );
+
+    ( void ) pthread_mutexattr_init( &mutexAttr );
+    ( void ) pthread_mutexattr_settype( &mutexAttr, PTHREAD_MUTEX_RECURSIVE );
+    ( void ) pthread_mutex_init( &criticalMutex, &mutexAttr );
+    ( void ) pthread_mutexattr_destroy( &mutexAttr );
+
+    ( void ) pthread_key_create( &currentTaskKey, prvTaskExit );
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetTicks( void )
+{
+    struct timespec now = { 0 };
+    uint64_t elapsedNs = 0;
+
+    ( void ) pthread_once( &kernelOnce, prvKernelInit );
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    elapsedNs = ( ( uint64_t ) ( now.tv_sec - tickOrigin.tv_sec ) * 1000000000ULL ) +
+                ( uint64_t ) now.tv_nsec - ( uint64_t ) tickOrigin.tv_nsec;
+
+    return elapsedNs / POSIX_TICK_PERIOD_NS;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvGetDeadline( clockid_t clockId,
+                            TickType_t xTicks,
+                            struct timespec * pDeadline )
+{
+    uint64_t delayNs = ( uint64_t ) xTicks * POSIX_TICK_PERIOD_NS;
+
+    ( void ) clock_gettime( clockId, pDeadline );
+
+    pDeadline->tv_sec += ( time_t ) ( delayNs / 1000000000ULL );
+    pDeadline->tv_nsec += ( long ) ( delayNs % 1000000000ULL );
+
+    if( pDeadline->tv_nsec >= 1000000000L )
+    {
+        pDeadline->tv_sec++;
+        pDeadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvCondInit( pthread_cond_t * pCond )
+{
+    pthread_condattr_t condAttr;
+
+    ( void ) pthread_condattr_init( &condAttr );
+    ( void ) pthread_condattr_setclock( &condAttr, CLOCK_MONOTONIC );
+    ( void ) pthread_cond_init( pCond, &condAttr );
+    ( void ) pthread_condattr_destroy( &condAttr );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvCondWait( pthread_cond_t * pCond,
+                         pthread_mutex_t * pMutex,
+                         const struct timespec * pDeadline )
+{
+    bool waited = true;
+
+    if( pDeadline == NULL )
+    {
+        ( void ) pthread_cond_wait( pCond, pMutex );
+    }
+    else if( pthread_cond_timedwait( pCond, pMutex, pDeadline ) == ETIMEDOUT )
+    {
+        waited = false;
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    prvTaskSwitchedIn();
+
+    return waited;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( configPOSIX_HOST_HEAP == 1 )
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    return malloc( xWantedSize );
+}
+
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    free( pv );
+}
+
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* configPOSIX_HOST_HEAP == 1 */
+
+void vPortEnterCritical( void )
+{
+    ( void ) pthread_once( &kernelOnce, prvKernelInit );
+    ( void ) pthread_mutex_lock( &criticalMutex );
+}
+
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+    ( void ) pthread_mutex_unlock( &criticalMutex );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvTaskNotifyInit( StaticTask_t * pxTcb )
+{
+    ( void ) pthread_mutex_init( &pxTcb->notifyMutex, NULL );
+    prvCondInit( &pxTcb->notifyCond );
+    ( void ) memset( pxTcb->ulNotifiedValue, 0, sizeof( pxTcb->ulNotifiedValue ) );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvTaskListAdd( StaticTask_t * pxTcb )
+{
+    vPortEnterCritical();
+    pxTcb->pxNextTask = pxTaskList;
+    pxTcb->uxTaskNumber = uxNextTaskNumber;
+    pxTaskList = pxTcb;
+    uxTaskCount++;
+    uxNextTaskNumber++;
+    vPortExitCritical();
+
+    ( void ) pthread_setspecific( currentTaskKey, pxTcb );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvTaskSwitchedIn( void )
+{
+    StaticTask_t * pxCurrentTCB = NULL;
+
+    ( void ) pthread_once( &kernelOnce, prvKernelInit );
+    pxCurrentTCB = pthread_getspecific( currentTaskKey );
+
+    if( pxCurrentTCB != NULL )
+    {
+        traceTASK_SWITCHED_IN();
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvTaskExit( void * pArgument )
+{
+    StaticTask_t * pxTcb = ( StaticTask_t * ) pArgument;
+    StaticTask_t ** ppxLink = NULL;
+
+    vPortEnterCritical();
+
+    for( ppxLink = &pxTaskList; *ppxLink != NULL; ppxLink = &( *ppxLink )->pxNextTask )
+    {
+        if( *ppxLink == pxTcb )
+        {
+            *ppxLink = pxTcb->pxNextTask;
+            uxTaskCount--;
+            break;
+        }
+    }
+
+    vPortExitCritical();
+
+    ( void ) pthread_mutex_destroy( &pxTcb->notifyMutex );
+    ( void ) pthread_cond_destroy( &pxTcb->notifyCond );
+
+    if( pxTcb->dynamic == true )
+    {
+        #if ( configPOSIX_HOST_HEAP == 0 )
+            vPortFree( pxTcb->pvStack );
+        #endif
+        free( pxTcb );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void * prvTaskEntry( void * pArgument )
+{
+    StaticTask_t * pxTcb = ( StaticTask_t * ) pArgument;
+
+    prvTaskListAdd( pxTcb );
+    prvTaskSwitchedIn();
+
+    pxTcb->pxTaskCode( pxTcb->pvParameters );
+
+    /* A FreeRTOS task must not return, delete it if it does. */
+    vTaskDelete( NULL );
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvTaskStart( StaticTask_t * pxTcb,
+                          TaskFunction_t pxTaskCode,
+                          const char * pcName,
+                          void * pvParameters,
+                          UBaseType_t uxPriority,
+                          bool dynamic,
+                          void * pvStack )
+{
+    pthread_attr_t threadAttr;
+    bool started = false;
+
+    ( void ) pthread_once( &kernelOnce, prvKernelInit );
+
+    ( void ) memset( pxTcb, 0, sizeof( StaticTask_t ) );
+    pxTcb->pxTaskCode = pxTaskCode;
+    pxTcb->pvParameters = pvParameters;
+    pxTcb->dynamic = dynamic;
+    pxTcb->uxPriority = uxPriority;
+
+    #if ( configPOSIX_HOST_HEAP == 0 )
+        pxTcb->pvStack = pvStack;
+    #else
+        ( void ) pvStack;
+    #endif
+
+    if( pcName != NULL )
+    {
+        ( void ) strncpy( pxTcb->pcTaskName, pcName, sizeof( pxTcb->pcTaskName ) - 1U );
+    }
+
+    prvTaskNotifyInit( pxTcb );
+
+    ( void ) pthread_attr_init( &threadAttr );
+    ( void ) pthread_attr_setdetachstate( &threadAttr, PTHREAD_CREATE_DETACHED );
+
+    if( pthread_create( &pxTcb->thread, &threadAttr, prvTaskEntry, pxTcb ) == 0 )
+    {
+        started = true;
+    }
+    else
+    {
+        ( void ) pthread_mutex_destroy( &pxTcb->notifyMutex );
+        ( void ) pthread_cond_destroy( &pxTcb->notifyCond );
+    }
+
+    ( void ) pthread_attr_destroy( &threadAttr );
+
+    return started;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+                        const char * const pcName,
+                        const configSTACK_DEPTH_TYPE usStackDepth,
+                        void * const pvParameters,
+                        UBaseType_t uxPriority,
+                        TaskHandle_t * const pxCreatedTask )
+{
+    StaticTask_t * pxTcb = malloc( sizeof( StaticTask_t ) );
+    void * pvStack = NULL;
+    BaseType_t xReturn = pdFAIL;
+
+    #if ( configPOSIX_HOST_HEAP == 0 )
+        if( pxTcb != NULL )
+        {
+            pvStack = pvPortMalloc( ( size_t ) usStackDepth * sizeof( StackType_t ) );
+
+            if( pvStack == NULL )
+            {
+                free( pxTcb );
+                pxTcb = NULL;
+            }
+        }
+    #else
+        ( void ) usStackDepth;
+    #endif
+
+    if( pxTcb != NULL )
+    {
+        if( prvTaskStart( pxTcb, pxTaskCode, pcName, pvParameters, uxPriority, true, pvStack ) == true )
+        {
+            xReturn = pdPASS;
+        }
+        else
+        {
+            #if ( configPOSIX_HOST_HEAP == 0 )
+                vPortFree( pvStack );
+            #endif
+            free( pxTcb );
+            pxTcb = NULL;
+        }
+    }
+
+    if( pxCreatedTask != NULL )
+    {
+        *pxCreatedTask = pxTcb;
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+TaskHandle_t xTaskCreateStatic( TaskFunction_t pxTaskCode,
+                                const char * const pcName,
+                                const uint32_t ulStackDepth,
+                                void * const pvParameters,
+                                UBaseType_t uxPriority,
+                                StackType_t * const puxStackBuffer,
+                                StaticTask_t * const pxTaskBuffer )
+{
+    TaskHandle_t xReturn = NULL;
+
+    ( void ) ulStackDepth;
+    ( void ) puxStackBuffer;
+
+    if( prvTaskStart( pxTaskBuffer, pxTaskCode, pcName, pvParameters, uxPriority, false, NULL ) == true )
+    {
+        xReturn = pxTaskBuffer;
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+void vTaskDelete( TaskHandle_t xTaskToDelete )
+{
+    StaticTask_t * pxTcb = NULL;
+
+    ( void ) pthread_once( &kernelOnce, prvKernelInit );
+    pxTcb = pthread_getspecific( currentTaskKey );
+
+    /* A pthread cannot be stopped safely by another thread. */
+    configASSERT( ( xTaskToDelete == NULL ) || ( xTaskToDelete == pxTcb ) );
+    ( void ) xTaskToDelete;
+    ( void ) pxTcb;
+
+    /* prvTaskExit releases the task control block. */
+    pthread_exit( NULL );
+}
+
+/*-----------------------------------------------------------*/
+
+void vTaskPrioritySet( TaskHandle_t xTask,
+                       UBaseType_t uxNewPriority )
+{
+    ( void ) xTask;
+    ( void ) uxNewPriority;
+}
+
+/*-----------------------------------------------------------*/
+
+void vTaskDelay( const TickType_t xTicksToDelay )
+{
+    struct timespec deadline = { 0 };
+
+    if( xTicksToDelay == 0U )
+    {
+        ( void ) sched_yield();
+    }
+    else
+    {
+        prvGetDeadline( CLOCK_MONOTONIC, xTicksToDelay, &deadline );
+
+        while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL ) == EINTR )
+        {
+        }
+    }
+
+    prvTaskSwitchedIn();
+}
+
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+    return ( TickType_t ) prvGetTicks();
+}
+
+/*-----------------------------------------------------------*/
+
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut )
+{
+    uint64_t ticks = prvGetTicks();
+
+    pxTimeOut->xOverflowCount = ( BaseType_t ) ( ticks >> ( sizeof( TickType_t ) * 8U ) );
+    pxTimeOut->xTimeOnEntering = ( TickType_t ) ticks;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut,
+                                 TickType_t * const pxTicksToWait )
+{
+    uint64_t entered = ( ( uint64_t ) pxTimeOut->xOverflowCount << ( sizeof( TickType_t ) * 8U ) ) +
+                       ( uint64_t ) pxTimeOut->xTimeOnEntering;
+    uint64_t elapsed = prvGetTicks() - entered;
+    BaseType_t xReturn = pdFALSE;
+
+    if( *pxTicksToWait == portMAX_DELAY )
+    {
+        /* Waits for ever. */
+    }
+    else if( elapsed < ( uint64_t ) *pxTicksToWait )
+    {
+        *pxTicksToWait -= ( TickType_t ) elapsed;
+        vTaskSetTimeOutState( pxTimeOut );
+    }
+    else
+    {
+        *pxTicksToWait = 0;
+        xReturn = pdTRUE;
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+    StaticTask_t * pxTcb = NULL;
+
+    ( void ) pthread_once( &kernelOnce, prvKernelInit );
+    pxTcb = pthread_getspecific( currentTaskKey );
+
+    if( pxTcb == NULL )
+    {
+        /* Adopt a thread started outside xTaskCreate, main for example. */
+        pxTcb = calloc( 1, sizeof( StaticTask_t ) );
+        configASSERT( pxTcb != NULL );
+
+        pxTcb->thread = pthread_self();
+        pxTcb->dynamic = true;
+        ( void ) strncpy( pxTcb->pcTaskName, "adopted", sizeof( pxTcb->pcTaskName ) - 1U );
+        prvTaskNotifyInit( pxTcb );
+        prvTaskListAdd( pxTcb );
+    }
+
+    return pxTcb;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskNotifyGiveIndexed( TaskHandle_t xTaskToNotify,
+                                   UBaseType_t uxIndexToNotify )
+{
+    configASSERT( uxIndexToNotify < configTASK_NOTIFICATION_ARRAY_ENTRIES );
+
+    ( void ) pthread_mutex_lock( &xTaskToNotify->notifyMutex );
+    xTaskToNotify->ulNotifiedValue[ uxIndexToNotify ]++;
+    ( void ) pthread_cond_signal( &xTaskToNotify->notifyCond );
+    ( void ) pthread_mutex_unlock( &xTaskToNotify->notifyMutex );
+
+    return pdPASS;
+}
+
+/*-----------------------------------------------------------*/
+
+void vTaskNotifyGiveIndexedFromISR( TaskHandle_t xTaskToNotify,
+                                    UBaseType_t uxIndexToNotify,
+                                    BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void ) pxHigherPriorityTaskWoken;
+    ( void ) xTaskNotifyGiveIndexed( xTaskToNotify, uxIndexToNotify );
+}
+
+/*-----------------------------------------------------------*/
+
+uint32_t ulTaskNotifyTakeIndexed( UBaseType_t uxIndexToWaitOn,
+                                  BaseType_t xClearCountOnExit,
+                                  TickType_t xTicksToWait )
+{
+    StaticTask_t * pxTcb = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = { 0 };
+    const struct timespec * pDeadline = NULL;
+    bool waiting = ( xTicksToWait != 0U );
+    uint32_t ulReturn = 0;
+
+    configASSERT( uxIndexToWaitOn < configTASK_NOTIFICATION_ARRAY_ENTRIES );
+
+    if( xTicksToWait != portMAX_DELAY )
+    {
+        prvGetDeadline( CLOCK_MONOTONIC, xTicksToWait, &deadline );
+        pDeadline = &deadline;
+    }
+
+    ( void ) pthread_mutex_lock( &pxTcb->notifyMutex );
+
+    while( ( pxTcb->ulNotifiedValue[ uxIndexToWaitOn ] == 0U ) && ( waiting == true ) )
+    {
+        waiting = prvCondWait( &pxTcb->notifyCond, &pxTcb->notifyMutex, pDeadline );
+    }
+
+    ulReturn = pxTcb->ulNotifiedValue[ uxIndexToWaitOn ];
+
+    if( ulReturn != 0U )
+    {
+        pxTcb->ulNotifiedValue[ uxIndexToWaitOn ] = ( xClearCountOnExit == pdFALSE ) ? ( ulReturn - 1U ) : 0U;
+    }
+
+    ( void ) pthread_mutex_unlock( &pxTcb->notifyMutex );
+
+    return ulReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+void vTaskStartScheduler( void )
+{
+    for( ; ; )
+    {
+        ( void ) pause();
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxTaskGetNumberOfTasks( void )
+{
+    UBaseType_t uxReturn = 0;
+
+    vPortEnterCritical();
+    uxReturn = uxTaskCount;
+    vPortExitCritical();
+
+    return uxReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray,
+                                  const UBaseType_t uxArraySize,
+                                  configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime )
+{
+    StaticTask_t * pxTcb = NULL;
+    TaskStatus_t * pxStatus = NULL;
+    UBaseType_t uxTask = 0;
+
+    #if ( configGENERATE_RUN_TIME_STATS == 1 )
+        clockid_t threadClock;
+        struct timespec threadTime = { 0 };
+    #endif
+
+    vPortEnterCritical();
+
+    if( uxArraySize >= uxTaskCount )
+    {
+        for( pxTcb = pxTaskList; pxTcb != NULL; pxTcb = pxTcb->pxNextTask )
+        {
+            pxStatus = &pxTaskStatusArray[ uxTask ];
+            pxStatus->xHandle = pxTcb;
+            pxStatus->pcTaskName = pxTcb->pcTaskName;
+            pxStatus->xTaskNumber = pxTcb->uxTaskNumber;
+            pxStatus->eCurrentState = ( pthread_equal( pxTcb->thread, pthread_self() ) != 0 ) ? eRunning : eReady;
+            pxStatus->uxCurrentPriority = pxTcb->uxPriority;
+            pxStatus->uxBasePriority = pxTcb->uxPriority;
+            pxStatus->ulRunTimeCounter = 0;
+            pxStatus->usStackHighWaterMark = 0;
+
+            #if ( configGENERATE_RUN_TIME_STATS == 1 )
+                /* The thread is still running, it leaves the list in prvTaskExit first. */
+                if( ( pthread_getcpuclockid( pxTcb->thread, &threadClock ) == 0 ) &&
+                    ( clock_gettime( threadClock, &threadTime ) == 0 ) )
+                {
+                    pxStatus->ulRunTimeCounter = ( configRUN_TIME_COUNTER_TYPE ) ( ( ( uint64_t ) threadTime.tv_sec * 1000000U ) +
+                                                                                   ( ( uint64_t ) threadTime.tv_nsec / 1000U ) );
+                }
+            #endif
+
+            uxTask++;
+        }
+    }
+
+    if( pulTotalRunTime != NULL )
+    {
+        #if ( configGENERATE_RUN_TIME_STATS == 1 )
+            *pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+        #else
+            *pulTotalRunTime = 0;
+        #endif
+    }
+
+    vPortExitCritical();
+
+    return uxTask;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS > 0 )
+
+    void vTaskSetThreadLocalStoragePointer( TaskHandle_t xTaskToSet,
+                                            BaseType_t xIndex,
+                                            void * pvValue )
+    {
+        StaticTask_t * pxTcb = ( xTaskToSet == NULL ) ? xTaskGetCurrentTaskHandle() : xTaskToSet;
+
+        if( ( xIndex >= 0 ) && ( xIndex < ( BaseType_t ) configNUM_THREAD_LOCAL_STORAGE_POINTERS ) )
+        {
+            pxTcb->pvThreadLocalStoragePointer[ xIndex ] = pvValue;
+        }
+    }
+
+/*-----------------------------------------------------------*/
+
+    void * pvTaskGetThreadLocalStoragePointer( TaskHandle_t xTaskToQuery,
+                                               BaseType_t xIndex )
+    {
+        StaticTask_t * pxTcb = ( xTaskToQuery == NULL ) ? xTaskGetCurrentTaskHandle() : xTaskToQuery;
+        void * pvReturn = NULL;
+
+        if( ( xIndex >= 0 ) && ( xIndex < ( BaseType_t ) configNUM_THREAD_LOCAL_STORAGE_POINTERS ) )
+        {
+            pvReturn = pxTcb->pvThreadLocalStoragePointer[ xIndex ];
+        }
+
+        return pvReturn;
+    }
+#endif /* if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS > 0 ) */
+
+/*-----------------------------------------------------------*/
+
+static void prvQueueInit( StaticQueue_t * pxQueue,
+                          UBaseType_t uxQueueLength,
+                          UBaseType_t uxItemSize,
+                          uint8_t * pucQueueStorage,
+                          bool dynamic )
+{
+    ( void ) memset( pxQueue, 0, sizeof( StaticQueue_t ) );
+    ( void ) pthread_mutex_init( &pxQueue->mutex, NULL );
+    prvCondInit( &pxQueue->notEmpty );
+    prvCondInit( &pxQueue->notFull );
+    pxQueue->pStorage = pucQueueStorage;
+    pxQueue->length = uxQueueLength;
+    pxQueue->itemSize = uxItemSize;
+    pxQueue->dynamic = dynamic;
+}
+
+/*-----------------------------------------------------------*/
+
+QueueHandle_t xQueueCreate( const UBaseType_t uxQueueLength,
+                            const UBaseType_t uxItemSize )
+{
+    /* The items follow the queue in the same allocation. */
+    StaticQueue_t * pxQueue = malloc( sizeof( StaticQueue_t ) + ( uxQueueLength * uxItemSize ) );
+
+    if( pxQueue != NULL )
+    {
+        prvQueueInit( pxQueue, uxQueueLength, uxItemSize, ( uint8_t * ) &pxQueue[ 1 ], true );
+    }
+
+    return pxQueue;
+}
+
+/*-----------------------------------------------------------*/
+
+QueueHandle_t xQueueCreateStatic( const UBaseType_t uxQueueLength,
+                                  const UBaseType_t uxItemSize,
+                                  uint8_t * pucQueueStorage,
+                                  StaticQueue_t * pxStaticQueue )
+{
+    prvQueueInit( pxStaticQueue, uxQueueLength, uxItemSize, pucQueueStorage, false );
+
+    return pxStaticQueue;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueSend( QueueHandle_t xQueue,
+                       const void * const pvItemToQueue,
+                       TickType_t xTicksToWait )
+{
+    struct timespec deadline = { 0 };
+    const struct timespec * pDeadline = NULL;
+    BaseType_t xReturn = pdFAIL;
+    bool waiting = true;
+
+    if( ( xTicksToWait != 0U ) && ( xTicksToWait != portMAX_DELAY ) )
+    {
+        prvGetDeadline( CLOCK_MONOTONIC, xTicksToWait, &deadline );
+        pDeadline = &deadline;
+    }
+
+    ( void ) pthread_mutex_lock( &xQueue->mutex );
+
+    while( ( xQueue->count == xQueue->length ) && ( xTicksToWait != 0U ) && ( waiting == true ) )
+    {
+        waiting = prvCondWait( &xQueue->notFull, &xQueue->mutex, pDeadline );
+    }
+
+    if( xQueue->count < xQueue->length )
+    {
+        ( void ) memcpy( &xQueue->pStorage[ ( ( xQueue->head + xQueue->count ) % xQueue->length ) * xQueue->itemSize ],
+                         pvItemToQueue, xQueue->itemSize );
+        xQueue->count++;
+        ( void ) pthread_cond_signal( &xQueue->notEmpty );
+        xReturn = pdPASS;
+    }
+
+    ( void ) pthread_mutex_unlock( &xQueue->mutex );
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceive( QueueHandle_t xQueue,
+                          void * const pvBuffer,
+                          TickType_t xTicksToWait )
+{
+    struct timespec deadline = { 0 };
+    const struct timespec * pDeadline = NULL;
+    BaseType_t xReturn = pdFAIL;
+    bool waiting = true;
+
+    if( ( xTicksToWait != 0U ) && ( xTicksToWait != portMAX_DELAY ) )
+    {
+        prvGetDeadline( CLOCK_MONOTONIC, xTicksToWait, &deadline );
+        pDeadline = &deadline;
+    }
+
+    ( void ) pthread_mutex_lock( &xQueue->mutex );
+
+    while( ( xQueue->count == 0U ) && ( xTicksToWait != 0U ) && ( waiting == true ) )
+    {
+        waiting = prvCondWait( &xQueue->notEmpty, &xQueue->mutex, pDeadline );
+    }
+
+    if( xQueue->count > 0U )
+    {
+        ( void ) memcpy( pvBuffer, &xQueue->pStorage[ xQueue->head * xQueue->itemSize ], xQueue->itemSize );
+        xQueue->head = ( xQueue->head + 1U ) % xQueue->length;
+        xQueue->count--;
+        ( void ) pthread_cond_signal( &xQueue->notFull );
+        xReturn = pdPASS;
+    }
+
+    ( void ) pthread_mutex_unlock( &xQueue->mutex );
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+    ( void ) pthread_mutex_destroy( &xQueue->mutex );
+    ( void ) pthread_cond_destroy( &xQueue->notEmpty );
+    ( void ) pthread_cond_destroy( &xQueue->notFull );
+
+    if( xQueue->dynamic == true )
+    {
+        free( xQueue );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static SemaphoreHandle_t prvMutexInit( StaticSemaphore_t * pxMutex,
+                                       bool recursive,
+                                       bool dynamic )
+{
+    pthread_mutexattr_t mutexAttr;
+    SemaphoreHandle_t xReturn = NULL;
+
+    /* A mutex semaphore is a queue of one item without data. */
+    prvQueueInit( pxMutex, 1U, 0U, NULL, dynamic );
+    ( void ) pthread_mutex_destroy( &pxMutex->mutex );
+
+    ( void ) pthread_mutexattr_init( &mutexAttr );
+
+    if( recursive == true )
+    {
+        ( void ) pthread_mutexattr_settype( &mutexAttr, PTHREAD_MUTEX_RECURSIVE );
+    }
+
+    if( pthread_mutex_init( &pxMutex->mutex, &mutexAttr ) == 0 )
+    {
+        xReturn = pxMutex;
+    }
+
+    ( void ) pthread_mutexattr_destroy( &mutexAttr );
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+SemaphoreHandle_t xSemaphoreCreateMutex( void )
+{
+    StaticSemaphore_t * pxMutex = malloc( sizeof( StaticSemaphore_t ) );
+    SemaphoreHandle_t xReturn = NULL;
+
+    if( pxMutex != NULL )
+    {
+        xReturn = prvMutexInit( pxMutex, false, true );
+
+        if( xReturn == NULL )
+        {
+            free( pxMutex );
+        }
+    }
+
+    return xReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t * pxMutexBuffer )
+{
+    return prvMutexInit( pxMutexBuffer, false, false );
+}
+
+/*-----------------------------------------------------------*/
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic( StaticSemaphore_t * pxMutexBuffer )
+{
+    return prvMutexInit( pxMutexBuffer, true, false );
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xSemaphoreTake( SemaphoreHandle_t xSemaphore,
+                           TickType_t xBlockTime )
+{
+    struct timespec deadline = { 0 };
+    int lockRet = 0;
+
+    if( xBlockTime == 0U )
+    {
+        lockRet = pthread_mutex_trylock( &xSemaphore->mutex );
+    }
+    else if( xBlockTime == portMAX_DELAY )
+    {
+        lockRet = pthread_mutex_lock( &xSemaphore->mutex );
+    }
+    else
+    {
+        /* pthread_mutex_timedlock only takes a CLOCK_REALTIME deadline. */
+        prvGetDeadline( CLOCK_REALTIME, xBlockTime, &deadline );
+        lockRet = pthread_mutex_timedlock( &xSemaphore->mutex, &deadline );
+    }
+
+    return ( lockRet == 0 ) ? pdTRUE : pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xSemaphoreGive( SemaphoreHandle_t xSemaphore )
+{
+    return ( pthread_mutex_unlock( &xSemaphore->mutex ) == 0 ) ? pdTRUE : pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvEventGroupInit( StaticEventGroup_t * pxEventGroup,
+                               bool dynamic )
+{
+    ( void ) pthread_mutex_init( &pxEventGroup->mutex, NULL );
+    prvCondInit( &pxEventGroup->changed );
+    pxEventGroup->bits = 0;
+    pxEventGroup->dynamic = dynamic;
+}
+
+/*-----------------------------------------------------------*/
+
+EventGroupHandle_t xEventGroupCreate( void )
+{
+    StaticEventGroup_t * pxEventGroup = malloc( sizeof( StaticEventGroup_t ) );
+
+    if( pxEventGroup != NULL )
+    {
+        prvEventGroupInit( pxEventGroup, true );
+    }
+
+    return pxEventGroup;
+}
+
+/*-----------------------------------------------------------*/
+
+EventGroupHandle_t xEventGroupCreateStatic( StaticEventGroup_t * pxEventGroupBuffer )
+{
+    prvEventGroupInit( pxEventGroupBuffer, false );
+
+    return pxEventGroupBuffer;
+}
+
+/*-----------------------------------------------------------*/
+
+void vEventGroupDelete( EventGroupHandle_t xEventGroup )
+{
+    ( void ) pthread_mutex_destroy( &xEventGroup->mutex );
+    ( void ) pthread_cond_destroy( &xEventGroup->changed );
+
+    if( xEventGroup->dynamic == true )
+    {
+        free( xEventGroup );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t xEventGroup,
+                                 const EventBits_t uxBitsToWaitFor,
+                                 const BaseType_t xClearOnExit,
+                                 const BaseType_t xWaitForAllBits,
+                                 TickType_t xTicksToWait )
+{
+    struct timespec deadline = { 0 };
+    const struct timespec * pDeadline = NULL;
+    EventBits_t uxReturn = 0;
+    bool matched = false;
+    bool waiting = true;
+
+    if( ( xTicksToWait != 0U ) && ( xTicksToWait != portMAX_DELAY ) )
+    {
+        prvGetDeadline( CLOCK_MONOTONIC, xTicksToWait, &deadline );
+        pDeadline = &deadline;
+    }
+
+    ( void ) pthread_mutex_lock( &xEventGroup->mutex );
+
+    for( ; ; )
+    {
+        uxReturn = xEventGroup->bits;
+
+        if( xWaitForAllBits == pdTRUE )
+        {
+            matched = ( ( uxReturn & uxBitsToWaitFor ) == uxBitsToWaitFor );
+        }
+        else
+        {
+            matched = ( ( uxReturn & uxBitsToWaitFor ) != 0U );
+        }
+
+        if( ( matched == true ) || ( xTicksToWait == 0U ) || ( waiting == false ) )
+        {
+            break;
+        }
+
+        waiting = prvCondWait( &xEventGroup->changed, &xEventGroup->mutex, pDeadline );
+    }
+
+    if( ( matched == true ) && ( xClearOnExit == pdTRUE ) )
+    {
+        xEventGroup->bits &= ~uxBitsToWaitFor;
+    }
+
+    ( void ) pthread_mutex_unlock( &xEventGroup->mutex );
+
+    return uxReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupClearBits( EventGroupHandle_t xEventGroup,
+                                  const EventBits_t uxBitsToClear )
+{
+    EventBits_t uxReturn = 0;
+
+    ( void ) pthread_mutex_lock( &xEventGroup->mutex );
+    uxReturn = xEventGroup->bits;
+    xEventGroup->bits &= ~uxBitsToClear;
+    ( void ) pthread_mutex_unlock( &xEventGroup->mutex );
+
+    return uxReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupSetBits( EventGroupHandle_t xEventGroup,
+                                const EventBits_t uxBitsToSet )
+{
+    EventBits_t uxReturn = 0;
+
+    ( void ) pthread_mutex_lock( &xEventGroup->mutex );
+    xEventGroup->bits |= uxBitsToSet;
+    uxReturn = xEventGroup->bits;
+    ( void ) pthread_cond_broadcast( &xEventGroup->changed );
+    ( void ) pthread_mutex_unlock( &xEventGroup->mutex );
+
+    return uxReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xEventGroupSetBitsFromISR( EventGroupHandle_t xEventGroup,
+                                      const EventBits_t uxBitsToSet,
+                                      BaseType_t * pxHigherPriorityTaskWoken )
+{
+    ( void ) xEventGroupSetBits( xEventGroup, uxBitsToSet );
+
+    if( pxHigherPriorityTaskWoken != NULL )
+    {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+
+    return pdPASS;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,77 @@
+/*
+ * Amazon FreeRTOS Cellular Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file queue.h
+ * @brief FreeRTOS queue API subset on a POSIX mutex and condition variables.
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include queue.h"
+#endif
+
+/*-----------------------------------------------------------*/
+
+typedef struct QueueDefinition * QueueHandle_t;
+
+/**
+ * @brief Create a queue of uxQueueLength items of uxItemSize bytes on the heap.
+ */
+QueueHandle_t xQueueCreate( const UBaseType_t uxQueueLength,
+                            const UBaseType_t uxItemSize );
+
+/**
+ * @brief Create a queue with its items in pucQueueStorage and its state in pxStaticQueue.
+ */
+QueueHandle_t xQueueCreateStatic( const UBaseType_t uxQueueLength,
+                                  const UBaseType_t uxItemSize,
+                                  uint8_t * pucQueueStorage,
+                                  StaticQueue_t * pxStaticQueue );
+
+/**
+ * @brief Copy an item to the back of the queue, waiting up to xTicksToWait for room.
+ */
+BaseType_t xQueueSend( QueueHandle_t xQueue,
+                       const void * const pvItemToQueue,
+                       TickType_t xTicksToWait );
+
+/**
+ * @brief Copy the oldest item out of the queue, waiting up to xTicksToWait for one.
+ */
+BaseType_t xQueueReceive( QueueHandle_t xQueue,
+                          void * const pvBuffer,
+                          TickType_t xTicksToWait );
+
+/**
+ * @brief Delete a queue or a semaphore.
+ */
+void vQueueDelete( QueueHandle_t xQueue );
+
+/*-----------------------------------------------------------*/
+
+#endif /* QUEUE_H */
@@ -0,0 +1,77 @@
+/*
+ * Amazon FreeRTOS Cellular Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file semphr.h
+ * @brief FreeRTOS mutex semaphore API subset on pthread mutexes.
+ */
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include semphr.h"
+#endif
+
+#include "queue.h"
+
+/*-----------------------------------------------------------*/
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+/**
+ * @brief Create a mutex on the heap.
+ */
+SemaphoreHandle_t xSemaphoreCreateMutex( void );
+
+/**
+ * @brief Create a mutex in pxMutexBuffer.
+ */
+SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t * pxMutexBuffer );
+
+/**
+ * @brief Create a mutex its owner can take again, in pxMutexBuffer.
+ */
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic( StaticSemaphore_t * pxMutexBuffer );
+
+/**
+ * @brief Lock a mutex, waiting up to xBlockTime ticks.
+ */
+BaseType_t xSemaphoreTake( SemaphoreHandle_t xSemaphore,
+                           TickType_t xBlockTime );
+
+/**
+ * @brief Unlock a mutex.
+ */
+BaseType_t xSemaphoreGive( SemaphoreHandle_t xSemaphore );
+
+/* A recursive mutex is a recursive pthread mutex, locked like any other. */
+#define xSemaphoreTakeRecursive( xMutex, xBlockTime )    xSemaphoreTake( ( xMutex ), ( xBlockTime ) )
+#define xSemaphoreGiveRecursive( xMutex )                xSemaphoreGive( ( xMutex ) )
+#define vSemaphoreDelete( xSemaphore )                   vQueueDelete( ( QueueHandle_t ) ( xSemaphore ) )
+
+/*-----------------------------------------------------------*/
+
+#endif /* SEMAPHORE_H */
@@ -0,0 +1,229 @@
+/*
+ * Amazon FreeRTOS Cellular Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file task.h
+ * @brief FreeRTOS task API subset on native POSIX threads.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include task.h"
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define tskKERNEL_VERSION_NUMBER    "POSIX"
+#define tskIDLE_PRIORITY            ( ( UBaseType_t ) 0U )
+
+#define taskENTER_CRITICAL()               vPortEnterCritical()
+#define taskEXIT_CRITICAL()                vPortExitCritical()
+#define taskENTER_CRITICAL_FROM_ISR()      ( vPortEnterCritical(), ( UBaseType_t ) 0U )
+#define taskEXIT_CRITICAL_FROM_ISR( x )    ( ( void ) ( x ), vPortExitCritical() )
+#define taskDISABLE_INTERRUPTS()
+#define taskENABLE_INTERRUPTS()
+
+typedef void ( * TaskFunction_t )( void * );
+typedef struct tskTaskControlBlock * TaskHandle_t;
+
+/**
+ * @brief Tick count and overflow count captured by vTaskSetTimeOutState.
+ */
+typedef struct xTIME_OUT
+{
+    BaseType_t xOverflowCount;
+    TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+/**
+ * @brief State of a task. The host scheduler does not tell it, tasks other than the caller are reported ready.
+ */
+typedef enum
+{
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+/**
+ * @brief Status of a task returned by uxTaskGetSystemState.
+ */
+typedef struct xTASK_STATUS
+{
+    TaskHandle_t xHandle;                         /**< Handle of the task. */
+    const char * pcTaskName;                      /**< Name of the task. */
+    UBaseType_t xTaskNumber;                      /**< Unique number of the task, not reused when a task control block is. */
+    eTaskState eCurrentState;                     /**< eRunning for the caller, eReady otherwise. */
+    UBaseType_t uxCurrentPriority;                /**< Priority given at creation. */
+    UBaseType_t uxBasePriority;                   /**< Same as uxCurrentPriority. */
+    configRUN_TIME_COUNTER_TYPE ulRunTimeCounter; /**< CPU time of the thread in microseconds. */
+    configSTACK_DEPTH_TYPE usStackHighWaterMark;  /**< Always 0, the pthread stack is not measured. */
+} TaskStatus_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Create a task on a detached pthread.
+ *
+ * usStackDepth and uxPriority are not used.
+ */
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+                        const char * const pcName,
+                        const configSTACK_DEPTH_TYPE usStackDepth,
+                        void * const pvParameters,
+                        UBaseType_t uxPriority,
+                        TaskHandle_t * const pxCreatedTask );
+
+/**
+ * @brief Create a task on a detached pthread, with its control block in pxTaskBuffer.
+ *
+ * ulStackDepth, uxPriority and puxStackBuffer are not used.
+ */
+TaskHandle_t xTaskCreateStatic( TaskFunction_t pxTaskCode,
+                                const char * const pcName,
+                                const uint32_t ulStackDepth,
+                                void * const pvParameters,
+                                UBaseType_t uxPriority,
+                                StackType_t * const puxStackBuffer,
+                                StaticTask_t * const pxTaskBuffer );
+
+/**
+ * @brief Delete the calling task. xTaskToDelete must be NULL or the handle of the calling task.
+ */
+void vTaskDelete( TaskHandle_t xTaskToDelete );
+
+/**
+ * @brief Priorities are left to the host scheduler, so this does nothing.
+ */
+void vTaskPrioritySet( TaskHandle_t xTask,
+                       UBaseType_t uxNewPriority );
+
+/**
+ * @brief Sleep for xTicksToDelay ticks.
+ */
+void vTaskDelay( const TickType_t xTicksToDelay );
+
+/**
+ * @brief Ticks since the first call, from CLOCK_MONOTONIC.
+ */
+TickType_t xTaskGetTickCount( void );
+
+/**
+ * @brief Capture the tick count and the number of times it overflowed.
+ */
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut );
+
+/**
+ * @brief Check if a timeout started by vTaskSetTimeOutState has passed.
+ *
+ * @return pdTRUE if it has. Otherwise pdFALSE, pxTicksToWait is set to the
+ * ticks left and pxTimeOut restarted from now.
+ */
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut,
+                                 TickType_t * const pxTicksToWait );
+
+/**
+ * @brief Handle of the calling task. A thread which is not a task gets a handle on its first call.
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle( void );
+
+/**
+ * @brief Increment a notification count of a task and wake it if it waits on that index in ulTaskNotifyTakeIndexed.
+ *
+ * uxIndexToNotify is less than configTASK_NOTIFICATION_ARRAY_ENTRIES.
+ */
+BaseType_t xTaskNotifyGiveIndexed( TaskHandle_t xTaskToNotify,
+                                   UBaseType_t uxIndexToNotify );
+
+/**
+ * @brief Same as xTaskNotifyGiveIndexed. The host scheduler runs the woken task, pxHigherPriorityTaskWoken is not set.
+ */
+void vTaskNotifyGiveIndexedFromISR( TaskHandle_t xTaskToNotify,
+                                    UBaseType_t uxIndexToNotify,
+                                    BaseType_t * pxHigherPriorityTaskWoken );
+
+/**
+ * @brief Wait for a notification count of the calling task to be non zero.
+ *
+ * @return The count before it is cleared, if xClearCountOnExit is pdTRUE, or
+ * decremented. 0 if xTicksToWait passed.
+ */
+uint32_t ulTaskNotifyTakeIndexed( UBaseType_t uxIndexToWaitOn,
+                                  BaseType_t xClearCountOnExit,
+                                  TickType_t xTicksToWait );
+
+/* The functions without an index use index 0, as in the kernel. */
+#define xTaskNotifyGive( xTaskToNotify )                                      xTaskNotifyGiveIndexed( ( xTaskToNotify ), 0 )
+#define vTaskNotifyGiveFromISR( xTaskToNotify, pxHigherPriorityTaskWoken )    vTaskNotifyGiveIndexedFromISR( ( xTaskToNotify ), 0, ( pxHigherPriorityTaskWoken ) )
+#define ulTaskNotifyTake( xClearCountOnExit, xTicksToWait )                   ulTaskNotifyTakeIndexed( 0, ( xClearCountOnExit ), ( xTicksToWait ) )
+
+/**
+ * @brief The tasks already run, so this only keeps main from returning.
+ */
+void vTaskStartScheduler( void );
+
+/**
+ * @brief Number of tasks running, threads adopted by xTaskGetCurrentTaskHandle included.
+ */
+UBaseType_t uxTaskGetNumberOfTasks( void );
+
+/**
+ * @brief Get the status of the tasks running.
+ *
+ * With configGENERATE_RUN_TIME_STATS set to 1, the run time counter of a task
+ * is the CPU time of its thread from the host and pulTotalRunTime is the run
+ * time counter of the configuration, so on a host with several cores the
+ * tasks can add up to more than the total.
+ *
+ * @return The number of entries filled. 0 if uxArraySize is smaller than the number of tasks.
+ */
+UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray,
+                                  const UBaseType_t uxArraySize,
+                                  configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime );
+
+#if ( configNUM_THREAD_LOCAL_STORAGE_POINTERS > 0 )
+
+/**
+ * @brief Set a thread local storage pointer of a task, of the calling task if xTaskToSet is NULL.
+ */
+    void vTaskSetThreadLocalStoragePointer( TaskHandle_t xTaskToSet,
+                                            BaseType_t xIndex,
+                                            void * pvValue );
+
+/**
+ * @brief Get a thread local storage pointer of a task, of the calling task if xTaskToQuery is NULL.
+ */
+    void * pvTaskGetThreadLocalStoragePointer( TaskHandle_t xTaskToQuery,
+                                               BaseType_t xIndex );
+#endif
+
+/*-----------------------------------------------------------*/
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,251 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file bench_common.c
+ * @brief Helpers shared by the benchmarks.
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Time to wait for modem_sim to create its pty link. */
+#define BENCH_SIM_START_TIMEOUT_MS    ( 5000U )
+
+/* Most arguments passed to modem_sim. */
+#define BENCH_SIM_MAX_ARGS            ( 32U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief qsort comparison of two uint64_t.
+ */
+static int prvCompareSamples( const void * pLeft,
+                              const void * pRight );
+
+/**
+ * @brief Sort the samples and print their mean, percentiles and maximum in a unit.
+ */
+static void prvReport( const char * pLabel,
+                       uint64_t * pSamplesNs,
+                       uint32_t count,
+                       double divisor,
+                       const char * pUnit );
+
+/*-----------------------------------------------------------*/
+
+uint64_t Bench_TimeNs( void )
+{
+    struct timespec now = { 0 };
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000ULL ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+int Bench_OpenPty( char * pSlaveName,
+                   size_t slaveNameLength )
+{
+    struct termios settings = { 0 };
+    int masterFd = posix_openpt( O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+
+    if( masterFd < 0 )
+    {
+        ( void ) fprintf( stderr, "posix_openpt fail %d\n", errno );
+    }
+    else if( ( grantpt( masterFd ) != 0 ) || ( unlockpt( masterFd ) != 0 ) ||
+             ( ptsname_r( masterFd, pSlaveName, slaveNameLength ) != 0 ) )
+    {
+        ( void ) fprintf( stderr, "pty setup fail %d\n", errno );
+        ( void ) close( masterFd );
+        masterFd = -1;
+    }
+    else if( tcgetattr( masterFd, &settings ) == 0 )
+    {
+        /* The modem side must not echo or translate either. */
+        cfmakeraw( &settings );
+        ( void ) tcsetattr( masterFd, TCSANOW, &settings );
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return masterFd;
+}
+
+/*-----------------------------------------------------------*/
+
+pid_t Bench_StartModemSim( const char * pSimPath,
+                           const char * pLinkPath,
+                           const char * const * ppArgs )
+{
+    const char * pArgv[ BENCH_SIM_MAX_ARGS + 4U ] = { 0 };
+    struct stat linkStat = { 0 };
+    uint32_t argc = 0;
+    uint32_t waitMs = 0;
+    pid_t simPid = -1;
+
+    pArgv[ argc++ ] = pSimPath;
+    pArgv[ argc++ ] = "-L";
+    pArgv[ argc++ ] = pLinkPath;
+
+    while( ( ppArgs != NULL ) && ( *ppArgs != NULL ) && ( argc < ( BENCH_SIM_MAX_ARGS + 3U ) ) )
+    {
+        pArgv[ argc++ ] = *ppArgs;
+        ppArgs++;
+    }
+
+    ( void ) unlink( pLinkPath );
+    simPid = fork();
+
+    if( simPid == 0 )
+    {
+        ( void ) execv( pSimPath, ( char * const * ) pArgv );
+        ( void ) fprintf( stderr, "exec %s fail %d\n", pSimPath, errno );
+        _exit( EXIT_FAILURE );
+    }
+    else if( simPid > 0 )
+    {
+        while( ( lstat( pLinkPath, &linkStat ) != 0 ) && ( waitMs < BENCH_SIM_START_TIMEOUT_MS ) )
+        {
+            ( void ) usleep( 1000 );
+            waitMs++;
+        }
+
+        if( waitMs >= BENCH_SIM_START_TIMEOUT_MS )
+        {
+            ( void ) fprintf( stderr, "modem_sim did not create %s\n", pLinkPath );
+            Bench_StopModemSim( simPid );
+            simPid = -1;
+        }
+    }
+    else
+    {
+        ( void ) fprintf( stderr, "fork fail %d\n", errno );
+    }
+
+    return simPid;
+}
+
+/*-----------------------------------------------------------*/
+
+void Bench_StopModemSim( pid_t simPid )
+{
+    if( simPid > 0 )
+    {
+        ( void ) kill( simPid, SIGTERM );
+        ( void ) waitpid( simPid, NULL, 0 );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static int prvCompareSamples( const void * pLeft,
+                              const void * pRight )
+{
+    uint64_t left = *( ( const uint64_t * ) pLeft );
+    uint64_t right = *( ( const uint64_t * ) pRight );
+
+    return ( left > right ) - ( left < right );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvReport( const char * pLabel,
+                       uint64_t * pSamplesNs,
+                       uint32_t count,
+                       double divisor,
+                       const char * pUnit )
+{
+    uint64_t sum = 0;
+    uint32_t i = 0;
+
+    if( count == 0U )
+    {
+        ( void ) printf( "%-32s no samples\n", pLabel );
+    }
+    else
+    {
+        qsort( pSamplesNs, count, sizeof( uint64_t ), prvCompareSamples );
+
+        for( i = 0; i < count; i++ )
+        {
+            sum = sum + pSamplesNs[ i ];
+        }
+
+        ( void ) printf( "%-32s n %6u  mean %9.1f %s  p50 %9.1f %s  p99 %9.1f %s  max %9.1f %s\n",
+                         pLabel, count,
+                         ( double ) sum / ( double ) count / divisor, pUnit,
+                         ( double ) pSamplesNs[ count / 2U ] / divisor, pUnit,
+                         ( double ) pSamplesNs[ ( ( uint64_t ) count * 99U ) / 100U ] / divisor, pUnit,
+                         ( double ) pSamplesNs[ count - 1U ] / divisor, pUnit );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+void Bench_ReportLatency( const char * pLabel,
+                          uint64_t * pSamplesNs,
+                          uint32_t count )
+{
+    prvReport( pLabel, pSamplesNs, count, 1000.0, "us" );
+}
+
+/*-----------------------------------------------------------*/
+
+void Bench_ReportLatencyNs( const char * pLabel,
+                            uint64_t * pSamplesNs,
+                            uint32_t count )
+{
+    prvReport( pLabel, pSamplesNs, count, 1.0, "ns" );
+}
+
+/*-----------------------------------------------------------*/
+
+void Bench_ReportLatencyMs( const char * pLabel,
+                            uint64_t * pSamplesNs,
+                            uint32_t count )
+{
+    prvReport( pLabel, pSamplesNs, count, 1000000.0, "ms" );
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,113 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file bench_common.h
+ * @brief Helpers shared by the benchmarks: clock, pty pairs and latency reports.
+ */
+
+#ifndef __BENCH_COMMON_H__
+#define __BENCH_COMMON_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Monotonic time in nanoseconds.
+ *
+ * @return Nanoseconds since an arbitrary point in the past.
+ */
+uint64_t Bench_TimeNs( void );
+
+/**
+ * @brief Open a pty pair in raw mode.
+ *
+ * The slave is opened by its name, like a tty of a modem. The master is the
+ * modem side and is returned non-blocking.
+ *
+ * @param[out] pSlaveName Path of the slave.
+ * @param[in] slaveNameLength Size of pSlaveName.
+ *
+ * @return File descriptor of the master. -1 on error.
+ */
+int Bench_OpenPty( char * pSlaveName,
+                   size_t slaveNameLength );
+
+/**
+ * @brief Start a modem_sim process on a new pty.
+ *
+ * The simulator links its pty slave to pLinkPath and the function waits
+ * until the link exists.
+ *
+ * @param[in] pSimPath Path of the modem_sim executable.
+ * @param[in] pLinkPath Path of the link to the pty slave.
+ * @param[in] ppArgs Extra arguments of the simulator, NULL terminated. May be NULL.
+ *
+ * @return Process id of the simulator. -1 on error.
+ */
+pid_t Bench_StartModemSim( const char * pSimPath,
+                           const char * pLinkPath,
+                           const char * const * ppArgs );
+
+/**
+ * @brief Stop a modem_sim process started with Bench_StartModemSim.
+ *
+ * @param[in] simPid Process id of the simulator.
+ */
+void Bench_StopModemSim( pid_t simPid );
+
+/**
+ * @brief Print the mean, percentiles and maximum of latency samples.
+ *
+ * The samples are sorted in place.
+ *
+ * @param[in] pLabel Label of the report line.
+ * @param[in] pSamplesNs Samples in nanoseconds.
+ * @param[in] count Number of samples.
+ */
+void Bench_ReportLatency( const char * pLabel,
+                          uint64_t * pSamplesNs,
+                          uint32_t count );
+
+/**
+ * @brief Same as Bench_ReportLatency in nanoseconds, for operations well under a microsecond.
+ */
+void Bench_ReportLatencyNs( const char * pLabel,
+                            uint64_t * pSamplesNs,
+                            uint32_t count );
+
+/**
+ * @brief Same as Bench_ReportLatency in milliseconds, for operations of seconds.
+ */
+void Bench_ReportLatencyMs( const char * pLabel,
+                            uint64_t * pSamplesNs,
+                            uint32_t count );
+
+/*-----------------------------------------------------------*/
+
+#endif /* __BENCH_COMMON_H__ */
@@ -0,0 +1,286 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file bench_heap.c
+ * @brief Model of heap_4.c of the FreeRTOS kernel for the benchmarks.
+ *
+ * Benchmarks built with configPOSIX_HOST_HEAP 0 link this file instead of
+ * the malloc of the host, so heap use and fragmentation can be measured as on
+ * a target. Same policy as heap_4.c: one configTOTAL_HEAP_SIZE array, first
+ * fit on a free list in address order, a block split when the remainder can
+ * hold a minimum block, and neighbouring free blocks merged when freed. The
+ * scheduler suspension of heap_4.c is a mutex here, as tasks are pthreads.
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* FreeRTOS include. */
+#include "FreeRTOS.h"
+
+/*-----------------------------------------------------------*/
+
+#if ( configPOSIX_HOST_HEAP != 0 )
+    #error "bench_heap.c replaces the host heap, define configPOSIX_HOST_HEAP 0"
+#endif
+
+/* Alignment of the blocks, portBYTE_ALIGNMENT of most ports. */
+#define BENCH_HEAP_ALIGNMENT        ( ( size_t ) 8U )
+
+/* Size of the block header, rounded up to the alignment. */
+#define BENCH_HEAP_HEADER_SIZE \
+    ( ( sizeof( BenchHeapBlock_t ) + ( BENCH_HEAP_ALIGNMENT - 1U ) ) & ~( BENCH_HEAP_ALIGNMENT - 1U ) )
+
+/* A block is split only if the remainder is at least this size. */
+#define BENCH_HEAP_MINIMUM_BLOCK    ( BENCH_HEAP_HEADER_SIZE << 1 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Header of a block, free or allocated.
+ */
+typedef struct BenchHeapBlock
+{
+    struct BenchHeapBlock * pNext; /**< Next free block in address order. NULL for an allocated block. */
+    size_t size;                   /**< Size of the block with its header. */
+} BenchHeapBlock_t;
+
+/*-----------------------------------------------------------*/
+
+static _Alignas( 16 ) uint8_t heap[ configTOTAL_HEAP_SIZE ];
+static pthread_mutex_t heapMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Free list, start is a header of size 0 in front of the first free block. */
+static BenchHeapBlock_t heapStart = { 0 };
+static bool heapInitialized = false;
+
+static size_t freeBytes = 0;
+static size_t minimumEverFreeBytes = 0;
+static size_t allocationCount = 0;
+static size_t freeCount = 0;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Make the whole heap one free block. Called with heapMutex held.
+ */
+static void prvHeapInit( void );
+
+/**
+ * @brief Insert a block into the free list and merge it with its free neighbours.
+ * Called with heapMutex held.
+ */
+static void prvInsertFreeBlock( BenchHeapBlock_t * pBlock );
+
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+    BenchHeapBlock_t * pFirstBlock = ( BenchHeapBlock_t * ) heap;
+
+    pFirstBlock->size = sizeof( heap ) & ~( BENCH_HEAP_ALIGNMENT - 1U );
+    pFirstBlock->pNext = NULL;
+    heapStart.pNext = pFirstBlock;
+    heapStart.size = 0;
+
+    freeBytes = pFirstBlock->size;
+    minimumEverFreeBytes = freeBytes;
+    heapInitialized = true;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( BenchHeapBlock_t * pBlock )
+{
+    BenchHeapBlock_t * pPrevious = &heapStart;
+
+    while( ( pPrevious->pNext != NULL ) && ( pPrevious->pNext < pBlock ) )
+    {
+        pPrevious = pPrevious->pNext;
+    }
+
+    pBlock->pNext = pPrevious->pNext;
+
+    /* Merge with the next block if they touch. */
+    if( ( pBlock->pNext != NULL ) && ( ( ( uint8_t * ) pBlock + pBlock->size ) == ( uint8_t * ) pBlock->pNext ) )
+    {
+        pBlock->size = pBlock->size + pBlock->pNext->size;
+        pBlock->pNext = pBlock->pNext->pNext;
+    }
+
+    /* Merge with the previous block if they touch, the start header never does. */
+    if( ( pPrevious != &heapStart ) && ( ( ( uint8_t * ) pPrevious + pPrevious->size ) == ( uint8_t * ) pBlock ) )
+    {
+        pPrevious->size = pPrevious->size + pBlock->size;
+        pPrevious->pNext = pBlock->pNext;
+    }
+    else
+    {
+        pPrevious->pNext = pBlock;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    BenchHeapBlock_t * pPrevious = &heapStart;
+    BenchHeapBlock_t * pBlock = NULL;
+    BenchHeapBlock_t * pRemainder = NULL;
+    size_t blockSize = 0;
+    void * pReturn = NULL;
+
+    ( void ) pthread_mutex_lock( &heapMutex );
+
+    if( heapInitialized == false )
+    {
+        prvHeapInit();
+    }
+
+    if( ( xWantedSize > 0U ) && ( xWantedSize < sizeof( heap ) ) )
+    {
+        blockSize = ( xWantedSize + BENCH_HEAP_HEADER_SIZE + ( BENCH_HEAP_ALIGNMENT - 1U ) ) & ~( BENCH_HEAP_ALIGNMENT - 1U );
+        pBlock = heapStart.pNext;
+
+        while( ( pBlock != NULL ) && ( pBlock->size < blockSize ) )
+        {
+            pPrevious = pBlock;
+            pBlock = pBlock->pNext;
+        }
+    }
+
+    if( pBlock != NULL )
+    {
+        pPrevious->pNext = pBlock->pNext;
+
+        if( ( pBlock->size - blockSize ) > BENCH_HEAP_MINIMUM_BLOCK )
+        {
+            pRemainder = ( BenchHeapBlock_t * ) ( ( uint8_t * ) pBlock + blockSize );
+            pRemainder->size = pBlock->size - blockSize;
+            pBlock->size = blockSize;
+            prvInsertFreeBlock( pRemainder );
+        }
+
+        freeBytes = freeBytes - pBlock->size;
+
+        if( freeBytes < minimumEverFreeBytes )
+        {
+            minimumEverFreeBytes = freeBytes;
+        }
+
+        pBlock->pNext = NULL;
+        allocationCount++;
+        pReturn = ( uint8_t * ) pBlock + BENCH_HEAP_HEADER_SIZE;
+    }
+
+    ( void ) pthread_mutex_unlock( &heapMutex );
+
+    return pReturn;
+}
+
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    BenchHeapBlock_t * pBlock = NULL;
+
+    if( pv != NULL )
+    {
+        pBlock = ( BenchHeapBlock_t * ) ( ( uint8_t * ) pv - BENCH_HEAP_HEADER_SIZE );
+        configASSERT( ( ( uint8_t * ) pBlock >= heap ) && ( ( uint8_t * ) pBlock < &heap[ sizeof( heap ) ] ) );
+        configASSERT( pBlock->pNext == NULL );
+
+        ( void ) pthread_mutex_lock( &heapMutex );
+        freeBytes = freeBytes + pBlock->size;
+        freeCount++;
+        prvInsertFreeBlock( pBlock );
+        ( void ) pthread_mutex_unlock( &heapMutex );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return freeBytes;
+}
+
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return minimumEverFreeBytes;
+}
+
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    const BenchHeapBlock_t * pBlock = NULL;
+
+    ( void ) pthread_mutex_lock( &heapMutex );
+
+    if( heapInitialized == false )
+    {
+        prvHeapInit();
+    }
+
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = 0;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = SIZE_MAX;
+    pxHeapStats->xNumberOfFreeBlocks = 0;
+
+    for( pBlock = heapStart.pNext; pBlock != NULL; pBlock = pBlock->pNext )
+    {
+        pxHeapStats->xNumberOfFreeBlocks++;
+
+        if( pBlock->size > pxHeapStats->xSizeOfLargestFreeBlockInBytes )
+        {
+            pxHeapStats->xSizeOfLargestFreeBlockInBytes = pBlock->size;
+        }
+
+        if( pBlock->size < pxHeapStats->xSizeOfSmallestFreeBlockInBytes )
+        {
+            pxHeapStats->xSizeOfSmallestFreeBlockInBytes = pBlock->size;
+        }
+    }
+
+    if( pxHeapStats->xNumberOfFreeBlocks == 0U )
+    {
+        pxHeapStats->xSizeOfSmallestFreeBlockInBytes = 0;
+    }
+
+    pxHeapStats->xAvailableHeapSpaceInBytes = freeBytes;
+    pxHeapStats->xMinimumEverFreeBytesRemaining = minimumEverFreeBytes;
+    pxHeapStats->xNumberOfSuccessfulAllocations = allocationCount;
+    pxHeapStats->xNumberOfSuccessfulFrees = freeCount;
+
+    ( void ) pthread_mutex_unlock( &heapMutex );
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,230 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file cellular_time_to_ip.c
+ * @brief Time from power on to an IP address of cellular_setup.c against modem_sim.
+ *
+ * Every run starts a modem_sim process for the SIM70x0 on a new pty, calls
+ * setupCellular, which brings the module from Cellular_Init to an activated
+ * PDN with an IP address, then cleans the library up and stops the
+ * simulator. The report is the time setupCellular takes. setupCellular also
+ * prints the time of every state transition, so the share of the SIM,
+ * registration and activation states can be read from the output.
+ *
+ * The line rate, command latency, URC delay and registration time are those
+ * of the simulator and are passed to it unchanged.
+ *
+ * Usage: cellular_time_to_ip [-n runs] [-b baud] [-l ms] [-u ms] [-a ms]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* FreeRTOS Cellular Library include. */
+#include "cellular_config.h"
+#include "cellular_config_defaults.h"
+#include "cellular_api.h"
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured bring-ups. */
+#define BENCH_DEFAULT_RUNS         ( 10U )
+
+/* Most arguments passed through to modem_sim. */
+#define BENCH_MAX_SIM_ARGS         ( 10U )
+
+/* Path of the modem_sim executable, set by the build. */
+#ifndef BENCH_MODEM_SIM_PATH
+    #define BENCH_MODEM_SIM_PATH    "modem_sim"
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Defined in cellular_setup.c. */
+extern CellularHandle_t CellularHandle;
+extern bool setupCellular( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Bring the simulated module up once.
+ *
+ * @param[in] pLinkPath Path of the link to the pty of the simulator.
+ * @param[in] ppSimArgs Arguments of the simulator, NULL terminated.
+ * @param[out] pTimeNs Time setupCellular took.
+ *
+ * @return true if the module got an IP address.
+ */
+static bool prvRun( const char * pLinkPath,
+                    const char * const * ppSimArgs,
+                    uint64_t * pTimeNs );
+
+/*-----------------------------------------------------------*/
+
+static bool prvRun( const char * pLinkPath,
+                    const char * const * ppSimArgs,
+                    uint64_t * pTimeNs )
+{
+    bool connected = false;
+    uint64_t startNs = 0;
+    pid_t simPid = Bench_StartModemSim( BENCH_MODEM_SIM_PATH, pLinkPath, ppSimArgs );
+
+    if( simPid < 0 )
+    {
+        ( void ) fprintf( stderr, "Start of %s failed\n", BENCH_MODEM_SIM_PATH );
+    }
+    else if( CellularCommInterface_SetPort( 0U, pLinkPath ) != IOT_COMM_INTERFACE_SUCCESS )
+    {
+        ( void ) fprintf( stderr, "Setting the port to %s failed\n", pLinkPath );
+    }
+    else
+    {
+        startNs = Bench_TimeNs();
+        connected = setupCellular();
+        *pTimeNs = Bench_TimeNs() - startNs;
+    }
+
+    /* Close the comm interface before its pty goes away. */
+    if( CellularHandle != NULL )
+    {
+        ( void ) Cellular_Cleanup( CellularHandle );
+        CellularHandle = NULL;
+    }
+
+    Bench_StopModemSim( simPid );
+
+    return connected;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static char simOptions[ BENCH_MAX_SIM_ARGS ][ 3 ];
+    const char * pSimArgs[ BENCH_MAX_SIM_ARGS + 1U ] = { 0 };
+    char linkPath[ 64 ];
+    uint64_t * pSamples = NULL;
+    uint32_t runs = BENCH_DEFAULT_RUNS;
+    uint32_t simArgCount = 0;
+    uint32_t connectedCount = 0;
+    uint32_t i = 0;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    pSimArgs[ simArgCount++ ] = "-m";
+    pSimArgs[ simArgCount++ ] = "sim70x0";
+
+    while( ( option = getopt( argc, argv, "n:b:l:u:a:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                runs = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'b':
+            case 'l':
+            case 'u':
+            case 'a':
+
+                /* Options of the simulator, passed as they are. */
+                if( ( simArgCount + 2U ) > BENCH_MAX_SIM_ARGS )
+                {
+                    ret = EXIT_FAILURE;
+                }
+                else
+                {
+                    simOptions[ simArgCount ][ 0 ] = '-';
+                    simOptions[ simArgCount ][ 1 ] = ( char ) option;
+                    pSimArgs[ simArgCount ] = simOptions[ simArgCount ];
+                    pSimArgs[ simArgCount + 1U ] = optarg;
+                    simArgCount = simArgCount + 2U;
+                }
+
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( runs == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n runs] [-b baud] [-l ms] [-u ms] [-a ms]\n"
+                                  "  -b, -l, -u and -a are passed to modem_sim, see modem_sim -h.\n",
+                          argv[ 0 ] );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pSamples = malloc( runs * sizeof( uint64_t ) );
+
+        if( pSamples == NULL )
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) snprintf( linkPath, sizeof( linkPath ), "/tmp/cellular_time_to_ip.%d", ( int ) getpid() );
+
+        for( i = 0; i < runs; i++ )
+        {
+            if( prvRun( linkPath, pSimArgs, &pSamples[ connectedCount ] ) == true )
+            {
+                connectedCount++;
+            }
+        }
+
+        ( void ) unlink( linkPath );
+        ( void ) printf( "%u of %u runs got an IP address\n", connectedCount, runs );
+        Bench_ReportLatencyMs( "time to IP", pSamples, connectedCount );
+
+        if( connectedCount != runs )
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,378 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_capture_replay.c
+ * @brief Record a session against modem_sim with comm_if_capture.c and replay it.
+ *
+ * The benchmark starts modem_sim on a new pty and runs a session of status
+ * queries through the recording comm interface on top of comm_if_posix.c.
+ * Each command waits for its OK before the next, like the cellular library.
+ * Closing the interface writes the capture file. The same session then runs
+ * twice against the replaying comm interface, at the recorded timing and as
+ * fast as the commands come.
+ *
+ * The report gives the time per transaction of each run. The real time
+ * replay should match the recording, and the fast replay is the cost of the
+ * replay path alone. The replay counters show whether the whole capture was
+ * replayed and whether the sent bytes matched it.
+ *
+ * Usage: comm_capture_replay [-n commands] [-b baud] [-l ms] [-o capture file]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Cellular comm interface include files. */
+#include "comm_if.h"
+#include "comm_if_capture.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of commands of the session. */
+#define BENCH_DEFAULT_COMMANDS    ( 200U )
+
+/* Time to wait for a response. */
+#define BENCH_TIMEOUT_MS          ( 10000 )
+
+/* Path of the modem_sim executable, set by the build. */
+#ifndef BENCH_MODEM_SIM_PATH
+    #define BENCH_MODEM_SIM_PATH    "modem_sim"
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Status queries of cellular_setup.c, answered by modem_sim. */
+static const char * const sessionCommands[] =
+{
+    "AT+CPIN?\r",
+    "AT+CREG?\r",
+    "AT+CEREG?\r",
+    "AT+COPS?\r",
+    "AT+CSQ\r",
+    "AT+CGATT?\r"
+};
+
+/* Received line and the result of the last command. */
+static char responseLine[ 64 ];
+static uint32_t responseLength = 0;
+static volatile bool errorReceived = false;
+
+/* Posted by the receive callback for every OK or ERROR. */
+static sem_t resultSemaphore;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive callback. Splits the input into lines and posts the result codes.
+ *
+ * pUserData is the comm interface.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Send a command and wait for its result code.
+ *
+ * @return true if the modem answered OK.
+ */
+static bool prvCommand( CellularCommInterface_t * pCommInterface,
+                        CellularCommInterfaceHandle_t handle,
+                        const char * pCommand );
+
+/**
+ * @brief Open a comm interface, run the session and close it.
+ *
+ * @return true if every command was answered with OK.
+ */
+static bool prvSession( const char * pLabel,
+                        CellularCommInterface_t * pCommInterface,
+                        uint64_t * pSamples,
+                        uint32_t commands );
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterface_t * pCommInterface = ( CellularCommInterface_t * ) pUserData;
+    uint8_t buffer[ 256 ];
+    uint32_t readLength = 0;
+    uint32_t i = 0;
+
+    do
+    {
+        ( void ) pCommInterface->recv( commInterfaceHandle, buffer, sizeof( buffer ), 0, &readLength );
+
+        for( i = 0; i < readLength; i++ )
+        {
+            if( buffer[ i ] == ( uint8_t ) '\n' )
+            {
+                responseLine[ responseLength ] = '\0';
+
+                if( strcmp( responseLine, "OK\r" ) == 0 )
+                {
+                    ( void ) sem_post( &resultSemaphore );
+                }
+                else if( strcmp( responseLine, "ERROR\r" ) == 0 )
+                {
+                    errorReceived = true;
+                    ( void ) sem_post( &resultSemaphore );
+                }
+                else
+                {
+                    /* Empty else for MISRA 15.7 compliance. */
+                }
+
+                responseLength = 0;
+            }
+            else if( responseLength < ( sizeof( responseLine ) - 1U ) )
+            {
+                responseLine[ responseLength ] = ( char ) buffer[ i ];
+                responseLength++;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    } while( readLength > 0U );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvCommand( CellularCommInterface_t * pCommInterface,
+                        CellularCommInterfaceHandle_t handle,
+                        const char * pCommand )
+{
+    struct timespec deadline = { 0 };
+    uint32_t sentLength = 0;
+    bool taken = false;
+    bool timeout = false;
+
+    errorReceived = false;
+
+    if( pCommInterface->send( handle, ( const uint8_t * ) pCommand, ( uint32_t ) strlen( pCommand ),
+                              BENCH_TIMEOUT_MS, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+        deadline.tv_sec += BENCH_TIMEOUT_MS / 1000;
+
+        while( ( taken == false ) && ( timeout == false ) )
+        {
+            if( sem_timedwait( &resultSemaphore, &deadline ) == 0 )
+            {
+                taken = true;
+            }
+            else
+            {
+                timeout = ( errno != EINTR );
+            }
+        }
+    }
+
+    if( taken == false )
+    {
+        ( void ) fprintf( stderr, "No response to %s\n", pCommand );
+    }
+
+    return ( taken == true ) && ( errorReceived == false );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvSession( const char * pLabel,
+                        CellularCommInterface_t * pCommInterface,
+                        uint64_t * pSamples,
+                        uint32_t commands )
+{
+    CellularCommInterfaceHandle_t handle = NULL;
+    uint64_t startNs = 0;
+    uint64_t sessionNs = 0;
+    uint32_t i = 0;
+    bool success = false;
+
+    if( ( pCommInterface != NULL ) &&
+        ( pCommInterface->open( prvReceiveCallback, pCommInterface, &handle ) == IOT_COMM_INTERFACE_SUCCESS ) )
+    {
+        success = true;
+        sessionNs = Bench_TimeNs();
+
+        for( i = 0; ( success == true ) && ( i < commands ); i++ )
+        {
+            startNs = Bench_TimeNs();
+            success = prvCommand( pCommInterface, handle,
+                                  sessionCommands[ i % ( sizeof( sessionCommands ) / sizeof( sessionCommands[ 0 ] ) ) ] );
+            pSamples[ i ] = Bench_TimeNs() - startNs;
+        }
+
+        sessionNs = Bench_TimeNs() - sessionNs;
+        ( void ) pCommInterface->close( handle );
+    }
+    else
+    {
+        ( void ) fprintf( stderr, "%s: open failed\n", pLabel );
+    }
+
+    if( success == true )
+    {
+        ( void ) printf( "%s: session %.1f ms\n", pLabel, ( double ) sessionNs / 1e6 );
+        Bench_ReportLatency( "  AT transaction", pSamples, commands );
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    const char * pSimArgs[ 7 ] = { "-m", "bg96", "-b", "115200", "-l", "5", NULL };
+    const char * pCapturePath = NULL;
+    char capturePath[ 64 ];
+    char linkPath[ 64 ];
+    CellularCommReplayStats_t stats = { 0 };
+    uint64_t * pSamples = NULL;
+    uint32_t commands = BENCH_DEFAULT_COMMANDS;
+    pid_t simPid = -1;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "n:b:l:o:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                commands = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'b':
+                pSimArgs[ 3 ] = optarg;
+                break;
+
+            case 'l':
+                pSimArgs[ 5 ] = optarg;
+                break;
+
+            case 'o':
+                pCapturePath = optarg;
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( commands == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n commands] [-b baud] [-l ms] [-o capture file]\n"
+                                  "  -b and -l are passed to modem_sim, see modem_sim -h.\n",
+                          argv[ 0 ] );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pSamples = malloc( commands * sizeof( uint64_t ) );
+        ( void ) sem_init( &resultSemaphore, 0, 0 );
+        ( void ) snprintf( linkPath, sizeof( linkPath ), "/tmp/comm_capture_replay.%d", ( int ) getpid() );
+        ( void ) snprintf( capturePath, sizeof( capturePath ), "/tmp/comm_capture_replay.%d.ccap", ( int ) getpid() );
+
+        if( pCapturePath == NULL )
+        {
+            pCapturePath = capturePath;
+        }
+
+        simPid = Bench_StartModemSim( BENCH_MODEM_SIM_PATH, linkPath, pSimArgs );
+
+        if( ( pSamples == NULL ) || ( simPid < 0 ) ||
+            ( CellularCommInterface_SetPort( 0U, linkPath ) != IOT_COMM_INTERFACE_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Start of %s failed\n", BENCH_MODEM_SIM_PATH );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "%u commands, %s baud, %s ms command latency\n", commands, pSimArgs[ 3 ], pSimArgs[ 5 ] );
+
+        if( prvSession( "record", CellularCommCapture_Record( &CellularCommInterface, pCapturePath ),
+                        pSamples, commands ) == false )
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    Bench_StopModemSim( simPid );
+    ( void ) unlink( linkPath );
+
+    if( ret == EXIT_SUCCESS )
+    {
+        if( ( prvSession( "replay real time", CellularCommCapture_Replay( pCapturePath, CELLULAR_COMM_REPLAY_REAL_TIME ),
+                          pSamples, commands ) == false ) ||
+            ( prvSession( "replay fast", CellularCommCapture_Replay( pCapturePath, CELLULAR_COMM_REPLAY_FAST ),
+                          pSamples, commands ) == false ) )
+        {
+            ret = EXIT_FAILURE;
+        }
+
+        /* Counters of the fast replay. */
+        CellularCommCapture_GetReplayStats( &stats );
+        ( void ) printf( "replay %s, %u bytes received, %u sent, %u sent bytes mismatched, %u stalls\n",
+                         ( stats.complete == true ) ? "complete" : "incomplete",
+                         stats.rxBytes, stats.txBytes, stats.txMismatchBytes, stats.txStallCount );
+
+        if( ( stats.complete == false ) || ( stats.txMismatchBytes != 0U ) )
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( pCapturePath == capturePath )
+    {
+        ( void ) unlink( capturePath );
+    }
+
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
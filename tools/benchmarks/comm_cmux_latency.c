@@ -0,0 +1,395 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_cmux_latency.c
+ * @brief AT latency and uplink throughput over comm_if_cmux.c against modem_sim.
+ *
+ * The benchmark starts modem_sim on a new pty and measures the same traffic
+ * twice: once on comm_if_posix.c directly, then on channel 1 of the 3GPP
+ * TS 27.010 multiplexer on top of it, after AT+CMUX switched modem_sim to
+ * its multiplexer mode. The traffic is a series of AT commands, each timed
+ * from send to its OK, and a stream of 1460-byte sends closed by an AT
+ * command, timed until its OK. The difference between the two runs is the
+ * cost of the framing and of the multiplexer layer. The time CellularCmux_Start
+ * and the open of the channel take is reported too.
+ *
+ * modem_sim runs a single AT parser for all channels and answers on the
+ * channel of the last command, so channels are measured one at a time.
+ * comm_port_split measures AT latency next to a bulk transfer.
+ *
+ * Usage: comm_cmux_latency [-n commands] [-s kilobytes] [-b baud]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Cellular comm interface include files. */
+#include "comm_if.h"
+#include "comm_if_cmux.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured AT commands. */
+#define BENCH_DEFAULT_COMMANDS    ( 100U )
+
+/* Default uplink transfer in kilobytes. */
+#define BENCH_DEFAULT_KB          ( 32U )
+
+/* Payload of a send, the largest socket send of the cellular library. */
+#define BENCH_SEND_SIZE           ( 1460U )
+
+/* Time to wait for a response. */
+#define BENCH_TIMEOUT_MS          ( 10000 )
+
+/* Path of the modem_sim executable, set by the build. */
+#ifndef BENCH_MODEM_SIM_PATH
+    #define BENCH_MODEM_SIM_PATH    "modem_sim"
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Received line and the result of the last command. */
+static char responseLine[ 64 ];
+static uint32_t responseLength = 0;
+static volatile bool errorReceived = false;
+
+/* Posted by the receive callback for every OK or ERROR. */
+static sem_t resultSemaphore;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive callback. Splits the input into lines and posts the result codes.
+ *
+ * pUserData is the comm interface.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Send a command and wait for its result code.
+ *
+ * @return true if the modem answered OK.
+ */
+static bool prvCommand( CellularCommInterface_t * pCommInterface,
+                        CellularCommInterfaceHandle_t handle,
+                        const char * pCommand );
+
+/**
+ * @brief Measure AT latency and uplink throughput on an open comm interface.
+ *
+ * @return true if every command completed.
+ */
+static bool prvMeasure( const char * pLabel,
+                        CellularCommInterface_t * pCommInterface,
+                        CellularCommInterfaceHandle_t handle,
+                        uint64_t * pSamples,
+                        uint32_t commands,
+                        uint32_t uplinkKb );
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterface_t * pCommInterface = ( CellularCommInterface_t * ) pUserData;
+    uint8_t buffer[ 256 ];
+    uint32_t readLength = 0;
+    uint32_t i = 0;
+
+    do
+    {
+        ( void ) pCommInterface->recv( commInterfaceHandle, buffer, sizeof( buffer ), 0, &readLength );
+
+        for( i = 0; i < readLength; i++ )
+        {
+            if( buffer[ i ] == ( uint8_t ) '\n' )
+            {
+                responseLine[ responseLength ] = '\0';
+
+                if( strcmp( responseLine, "OK\r" ) == 0 )
+                {
+                    ( void ) sem_post( &resultSemaphore );
+                }
+                else if( strcmp( responseLine, "ERROR\r" ) == 0 )
+                {
+                    errorReceived = true;
+                    ( void ) sem_post( &resultSemaphore );
+                }
+                else
+                {
+                    /* Empty else for MISRA 15.7 compliance. */
+                }
+
+                responseLength = 0;
+            }
+            else if( responseLength < ( sizeof( responseLine ) - 1U ) )
+            {
+                responseLine[ responseLength ] = ( char ) buffer[ i ];
+                responseLength++;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    } while( readLength > 0U );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvCommand( CellularCommInterface_t * pCommInterface,
+                        CellularCommInterfaceHandle_t handle,
+                        const char * pCommand )
+{
+    struct timespec deadline = { 0 };
+    uint32_t sentLength = 0;
+    bool taken = false;
+    bool timeout = false;
+
+    errorReceived = false;
+
+    if( pCommInterface->send( handle, ( const uint8_t * ) pCommand, ( uint32_t ) strlen( pCommand ),
+                              BENCH_TIMEOUT_MS, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+        deadline.tv_sec += BENCH_TIMEOUT_MS / 1000;
+
+        while( ( taken == false ) && ( timeout == false ) )
+        {
+            if( sem_timedwait( &resultSemaphore, &deadline ) == 0 )
+            {
+                taken = true;
+            }
+            else
+            {
+                timeout = ( errno != EINTR );
+            }
+        }
+    }
+
+    if( taken == false )
+    {
+        ( void ) fprintf( stderr, "No response to %s\n", pCommand );
+    }
+
+    return ( taken == true ) && ( errorReceived == false );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvMeasure( const char * pLabel,
+                        CellularCommInterface_t * pCommInterface,
+                        CellularCommInterfaceHandle_t handle,
+                        uint64_t * pSamples,
+                        uint32_t commands,
+                        uint32_t uplinkKb )
+{
+    static uint8_t payload[ BENCH_SEND_SIZE ];
+    char label[ 48 ];
+    uint64_t startNs = 0;
+    uint64_t uplinkNs = 0;
+    uint32_t uplinkBytes = uplinkKb * 1024U;
+    uint32_t queuedBytes = 0;
+    uint32_t sendLength = 0;
+    uint32_t sentLength = 0;
+    uint32_t i = 0;
+    bool success = prvCommand( pCommInterface, handle, "ATE0\r" );
+
+    /* No carriage return in the payload, modem_sim drops it as one overlong command line. */
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    for( i = 0; ( success == true ) && ( i < commands ); i++ )
+    {
+        startNs = Bench_TimeNs();
+        success = prvCommand( pCommInterface, handle, "AT\r" );
+        pSamples[ i ] = Bench_TimeNs() - startNs;
+    }
+
+    if( success == true )
+    {
+        startNs = Bench_TimeNs();
+
+        while( ( success == true ) && ( queuedBytes < uplinkBytes ) )
+        {
+            sendLength = ( ( uplinkBytes - queuedBytes ) < BENCH_SEND_SIZE ) ? ( uplinkBytes - queuedBytes ) : BENCH_SEND_SIZE;
+            success = ( pCommInterface->send( handle, payload, sendLength, BENCH_TIMEOUT_MS,
+                                              &sentLength ) == IOT_COMM_INTERFACE_SUCCESS ) &&
+                      ( sentLength == sendLength );
+            queuedBytes = queuedBytes + sentLength;
+        }
+
+        /* The OK comes once the modem has taken every byte off the line. */
+        success = ( success == true ) && ( prvCommand( pCommInterface, handle, "\rAT\r" ) == true );
+        uplinkNs = Bench_TimeNs() - startNs;
+    }
+
+    if( success == true )
+    {
+        ( void ) snprintf( label, sizeof( label ), "%s AT send to OK", pLabel );
+        Bench_ReportLatency( label, pSamples, commands );
+        ( void ) printf( "%s uplink %.1f KB/s, %u bytes\n", pLabel,
+                         ( double ) uplinkBytes * 1e9 / 1024.0 / ( double ) uplinkNs, uplinkBytes );
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    const char * pSimArgs[ 7 ] = { "-m", "bg96", "-l", "1", "-b", "115200", NULL };
+    char linkPath[ 64 ];
+    CellularCommInterface_t * pChannel = NULL;
+    CellularCommInterfaceHandle_t handle = NULL;
+    uint64_t * pSamples = NULL;
+    uint64_t startNs = 0;
+    uint64_t cmuxStartNs = 0;
+    uint64_t channelOpenNs = 0;
+    uint32_t commands = BENCH_DEFAULT_COMMANDS;
+    uint32_t uplinkKb = BENCH_DEFAULT_KB;
+    pid_t simPid = -1;
+    bool cmuxStarted = false;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "n:s:b:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                commands = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 's':
+                uplinkKb = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'b':
+                pSimArgs[ 5 ] = optarg;
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( commands == 0U ) || ( uplinkKb == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n commands] [-s kilobytes] [-b baud]\n", argv[ 0 ] );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pSamples = malloc( commands * sizeof( uint64_t ) );
+        ( void ) sem_init( &resultSemaphore, 0, 0 );
+        ( void ) snprintf( linkPath, sizeof( linkPath ), "/tmp/comm_cmux_latency.%d", ( int ) getpid() );
+        simPid = Bench_StartModemSim( BENCH_MODEM_SIM_PATH, linkPath, pSimArgs );
+
+        if( ( pSamples == NULL ) || ( simPid < 0 ) ||
+            ( CellularCommInterface_SetPort( 0U, linkPath ) != IOT_COMM_INTERFACE_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Start of %s failed\n", BENCH_MODEM_SIM_PATH );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "%s baud, %u byte frames\n", pSimArgs[ 5 ], CELLULAR_CMUX_FRAME_SIZE );
+
+        if( ( CellularCommInterface.open( prvReceiveCallback, &CellularCommInterface, &handle ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+            ( prvMeasure( "direct", &CellularCommInterface, handle, pSamples, commands, uplinkKb ) == false ) )
+        {
+            ret = EXIT_FAILURE;
+        }
+
+        if( handle != NULL )
+        {
+            ( void ) CellularCommInterface.close( handle );
+            handle = NULL;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        startNs = Bench_TimeNs();
+        cmuxStarted = ( CellularCmux_Start( &CellularCommInterface ) == IOT_COMM_INTERFACE_SUCCESS );
+        cmuxStartNs = Bench_TimeNs() - startNs;
+        pChannel = CellularCmux_GetChannel( 1U );
+
+        startNs = Bench_TimeNs();
+
+        if( ( cmuxStarted == false ) ||
+            ( pChannel->open( prvReceiveCallback, pChannel, &handle ) != IOT_COMM_INTERFACE_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Start of the multiplexer failed\n" );
+            ret = EXIT_FAILURE;
+        }
+        else
+        {
+            channelOpenNs = Bench_TimeNs() - startNs;
+            ( void ) printf( "CMUX start %.1f ms, channel open %.1f ms\n",
+                             ( double ) cmuxStartNs / 1e6, ( double ) channelOpenNs / 1e6 );
+
+            if( prvMeasure( "CMUX", pChannel, handle, pSamples, commands, uplinkKb ) == false )
+            {
+                ret = EXIT_FAILURE;
+            }
+
+            ( void ) pChannel->close( handle );
+        }
+
+        if( cmuxStarted == true )
+        {
+            ( void ) CellularCmux_Stop();
+        }
+    }
+
+    Bench_StopModemSim( simPid );
+    ( void ) unlink( linkPath );
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
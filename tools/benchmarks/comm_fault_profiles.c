@@ -0,0 +1,442 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_fault_profiles.c
+ * @brief Goodput and recovery time of socket transfers under the fault profiles of comm_if_fault.c.
+ *
+ * The fault comm interface wraps the loopback comm interface with its BG96
+ * script, so the only thing between the driver and the modem model is the
+ * fault injection. For each profile the driver echoes payloads through
+ * socket 0 with AT+QISEND and AT+QIRD, like the cellular library, and gives
+ * every response a deadline. A round fails when a response misses its
+ * deadline, a send fails or the payload does not come back intact. The
+ * driver then recovers as a library would: it pads a send the modem may
+ * still be waiting for, closes the socket to drop its data, and retries until
+ * the modem answers.
+ *
+ * The report of each profile is the goodput, the payload that came back
+ * intact per second, the rounds that failed, the recovery time from a failed
+ * round to the end of the next good one, and the faults injected. The
+ * profiles are seeded, so runs with the same options see the same faults.
+ *
+ * Usage: comm_fault_profiles [-n rounds] [-s payload size] [-d deadline ms]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Fault and loopback comm interface include files. */
+#include "comm_if_fault.h"
+#include "comm_if_loopback.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of rounds of each profile. */
+#define BENCH_DEFAULT_ROUNDS         ( 2000U )
+
+/* Default payload of a round, the largest socket send of the cellular library. */
+#define BENCH_DEFAULT_PAYLOAD        ( 1460U )
+
+/* Largest payload of a round, the largest send of modem_sim and the modules. */
+#define BENCH_MAX_PAYLOAD            ( 1500U )
+
+/* Default deadline of a response. */
+#define BENCH_DEFAULT_DEADLINE_MS    ( 100U )
+
+/* Holds a read of BENCH_MAX_PAYLOAD with its header, trailer and URCs. */
+#define BENCH_RESPONSE_SIZE          ( 4096U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Named fault profile.
+ */
+typedef struct BenchProfile
+{
+    const char * pName;                 /**< Label of the report. */
+    CellularCommFaultProfile_t profile; /**< Faults to inject. */
+} BenchProfile_t;
+
+/*-----------------------------------------------------------*/
+
+static const BenchProfile_t benchProfiles[] =
+{
+    { "clean",                 { .seed = 1U                                                                      } },
+    { "URCs duplicated",       { .seed = 1U, .urcDuplicatePpm = 1000000U                                         } },
+    { "10% URCs delayed 50ms", { .seed = 1U, .urcDelayPpm = 100000U, .urcDelayMs = 50U                           } },
+    { "100 ppm byte drop",     { .seed = 1U, .rxDropPpm = 100U                                                   } },
+    { "100 ppm bit flip",      { .seed = 1U, .rxCorruptPpm = 100U                                                } },
+    { "2% send stall 20ms",    { .seed = 1U, .txStallPpm = 20000U, .txStallMs = 20U                              } },
+    { "0.2% disconnect 200ms", { .seed = 1U, .disconnectPpm = 2000U, .disconnectMs = 200U                        } },
+    { "mixed",                 { .seed = 1U, .rxDropPpm = 20U, .rxCorruptPpm = 20U, .urcDuplicatePpm = 100000U,
+                                 .urcDelayPpm = 100000U, .urcDelayMs = 20U, .txStallPpm = 5000U, .txStallMs = 20U,
+                                 .disconnectPpm = 500U, .disconnectMs = 100U                                     } }
+};
+
+/* Response read by the receive callback since the last command. */
+static uint8_t response[ BENCH_RESPONSE_SIZE ];
+static uint32_t responseLength = 0;
+static pthread_mutex_t responseMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Posted by the receive callback after every read. */
+static sem_t responseSemaphore;
+
+static uint32_t payloadSize = BENCH_DEFAULT_PAYLOAD;
+static uint32_t deadlineMs = BENCH_DEFAULT_DEADLINE_MS;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive callback. Appends everything available to response.
+ *
+ * pUserData is the fault comm interface.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Send data, then wait until the response contains pExpected or the deadline passes.
+ *
+ * @return true if the data was sent and pExpected received.
+ */
+static bool prvTransact( CellularCommInterface_t * pCommInterface,
+                         CellularCommInterfaceHandle_t handle,
+                         const uint8_t * pData,
+                         uint32_t length,
+                         const char * pExpected );
+
+/**
+ * @brief Echo one payload through socket 0 and check it came back intact.
+ *
+ * @return true if the round completed.
+ */
+static bool prvRound( CellularCommInterface_t * pCommInterface,
+                      CellularCommInterfaceHandle_t handle,
+                      const uint8_t * pPayload );
+
+/**
+ * @brief Bring the modem model back to command mode with socket 0 empty.
+ */
+static void prvRecover( CellularCommInterface_t * pCommInterface,
+                        CellularCommInterfaceHandle_t handle );
+
+/**
+ * @brief Run the rounds of a profile and print its report.
+ *
+ * @return true if the fault comm interface could be opened.
+ */
+static bool prvRunProfile( const BenchProfile_t * pBenchProfile,
+                           uint32_t rounds,
+                           uint64_t * pSamples );
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterface_t * pCommInterface = ( CellularCommInterface_t * ) pUserData;
+    uint8_t buffer[ 256 ];
+    uint32_t readLength = 0;
+
+    do
+    {
+        ( void ) pCommInterface->recv( commInterfaceHandle, buffer, sizeof( buffer ), 0, &readLength );
+        ( void ) pthread_mutex_lock( &responseMutex );
+
+        /* Keep the latest bytes if the response overflows. */
+        if( ( responseLength + readLength ) > BENCH_RESPONSE_SIZE )
+        {
+            responseLength = 0;
+        }
+
+        ( void ) memcpy( &response[ responseLength ], buffer, readLength );
+        responseLength = responseLength + readLength;
+        ( void ) pthread_mutex_unlock( &responseMutex );
+    } while( readLength > 0U );
+
+    ( void ) sem_post( &responseSemaphore );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvTransact( CellularCommInterface_t * pCommInterface,
+                         CellularCommInterfaceHandle_t handle,
+                         const uint8_t * pData,
+                         uint32_t length,
+                         const char * pExpected )
+{
+    struct timespec deadline = { 0 };
+    uint32_t sentLength = 0;
+    bool received = false;
+    bool timeout = false;
+
+    ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_nsec += ( long ) ( deadlineMs % 1000U ) * 1000000L;
+    deadline.tv_sec += ( time_t ) ( deadlineMs / 1000U ) + ( deadline.tv_nsec / 1000000000L );
+    deadline.tv_nsec = deadline.tv_nsec % 1000000000L;
+
+    ( void ) pthread_mutex_lock( &responseMutex );
+    responseLength = 0;
+    ( void ) pthread_mutex_unlock( &responseMutex );
+
+    if( ( pCommInterface->send( handle, pData, length, deadlineMs, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS ) &&
+        ( sentLength == length ) )
+    {
+        while( ( received == false ) && ( timeout == false ) )
+        {
+            ( void ) pthread_mutex_lock( &responseMutex );
+            received = ( memmem( response, responseLength, pExpected, strlen( pExpected ) ) != NULL );
+            ( void ) pthread_mutex_unlock( &responseMutex );
+
+            if( ( received == false ) && ( sem_timedwait( &responseSemaphore, &deadline ) != 0 ) )
+            {
+                timeout = ( errno != EINTR );
+            }
+        }
+    }
+
+    return received;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvRound( CellularCommInterface_t * pCommInterface,
+                      CellularCommInterfaceHandle_t handle,
+                      const uint8_t * pPayload )
+{
+    char command[ 32 ];
+    int commandLength = 0;
+    bool success = false;
+
+    commandLength = snprintf( command, sizeof( command ), "AT+QISEND=0,%u\r", payloadSize );
+
+    if( ( prvTransact( pCommInterface, handle, ( const uint8_t * ) command, ( uint32_t ) commandLength, "> " ) == true ) &&
+        ( prvTransact( pCommInterface, handle, pPayload, payloadSize, "SEND OK\r\n" ) == true ) )
+    {
+        commandLength = snprintf( command, sizeof( command ), "AT+QIRD=0,%u\r", payloadSize );
+
+        if( prvTransact( pCommInterface, handle, ( const uint8_t * ) command, ( uint32_t ) commandLength, "\r\nOK\r\n" ) == true )
+        {
+            ( void ) pthread_mutex_lock( &responseMutex );
+            success = ( memmem( response, responseLength, pPayload, payloadSize ) != NULL );
+            ( void ) pthread_mutex_unlock( &responseMutex );
+        }
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvRecover( CellularCommInterface_t * pCommInterface,
+                        CellularCommInterfaceHandle_t handle )
+{
+    static uint8_t padding[ BENCH_MAX_PAYLOAD ];
+    static const char closeCommand[] = "AT+QICLOSE=0\r";
+    uint32_t sentLength = 0;
+    bool recovered = false;
+
+    /* Empty command lines, or the rest of a send whose prompt was lost. */
+    ( void ) memset( padding, '\r', sizeof( padding ) );
+
+    while( recovered == false )
+    {
+        ( void ) pCommInterface->send( handle, padding, payloadSize, deadlineMs, &sentLength );
+        recovered = prvTransact( pCommInterface, handle, ( const uint8_t * ) closeCommand,
+                                 sizeof( closeCommand ) - 1U, "\r\nOK\r\n" );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvRunProfile( const BenchProfile_t * pBenchProfile,
+                           uint32_t rounds,
+                           uint64_t * pSamples )
+{
+    static uint8_t payload[ BENCH_MAX_PAYLOAD ];
+    CellularCommInterface_t * pCommInterface = NULL;
+    CellularCommInterfaceHandle_t handle = NULL;
+    CellularCommFaultStats_t stats = { 0 };
+    uint64_t startNs = 0;
+    uint64_t failNs = 0;
+    uint64_t goodBytes = 0;
+    uint32_t recoveries = 0;
+    uint32_t failedRounds = 0;
+    uint32_t round = 0;
+    uint32_t i = 0;
+    bool recovering = false;
+    bool success = false;
+
+    pCommInterface = CellularCommFault_Wrap( CellularCommLoopback_Get( &CellularCommLoopbackBg96Script, NULL, NULL ),
+                                             &pBenchProfile->profile );
+
+    if( ( pCommInterface == NULL ) ||
+        ( pCommInterface->open( prvReceiveCallback, pCommInterface, &handle ) != IOT_COMM_INTERFACE_SUCCESS ) )
+    {
+        ( void ) fprintf( stderr, "%s: open of the fault comm interface failed\n", pBenchProfile->pName );
+    }
+    else
+    {
+        success = true;
+        startNs = Bench_TimeNs();
+
+        for( round = 0; round < rounds; round++ )
+        {
+            /* A different payload each round, so stale data never passes the check. */
+            for( i = 0; i < payloadSize; i++ )
+            {
+                payload[ i ] = ( uint8_t ) ( 'a' + ( ( i + round ) % 26U ) );
+            }
+
+            if( prvRound( pCommInterface, handle, payload ) == true )
+            {
+                goodBytes = goodBytes + payloadSize;
+
+                if( recovering == true )
+                {
+                    pSamples[ recoveries ] = Bench_TimeNs() - failNs;
+                    recoveries++;
+                    recovering = false;
+                }
+            }
+            else
+            {
+                failedRounds++;
+
+                if( recovering == false )
+                {
+                    failNs = Bench_TimeNs();
+                    recovering = true;
+                }
+
+                prvRecover( pCommInterface, handle );
+            }
+        }
+
+        CellularCommFault_GetStats( &stats );
+        ( void ) printf( "%s: goodput %.1f KB/s, %u of %u rounds failed\n",
+                         pBenchProfile->pName,
+                         ( double ) goodBytes * 1e9 / 1024.0 / ( double ) ( Bench_TimeNs() - startNs ),
+                         failedRounds, rounds );
+        ( void ) printf( "  faults: %u of %u bytes dropped, %u corrupted, %u of %u URCs duplicated, %u delayed, "
+                         "%u stalls, %u disconnects\n",
+                         stats.rxDroppedBytes, stats.rxBytes, stats.rxCorruptedBytes, stats.urcDuplicated, stats.urcCount,
+                         stats.urcDelayed, stats.txStalls, stats.disconnects );
+
+        if( recoveries > 0U )
+        {
+            Bench_ReportLatencyMs( "  recovery", pSamples, recoveries );
+        }
+
+        ( void ) pCommInterface->close( handle );
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    uint64_t * pSamples = NULL;
+    uint32_t rounds = BENCH_DEFAULT_ROUNDS;
+    uint32_t i = 0;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "n:s:d:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                rounds = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 's':
+                payloadSize = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'd':
+                deadlineMs = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( rounds == 0U ) || ( payloadSize == 0U ) ||
+        ( payloadSize > BENCH_MAX_PAYLOAD ) || ( deadlineMs == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n rounds] [-s payload size, 1 to %u] [-d deadline ms]\n",
+                          argv[ 0 ], BENCH_MAX_PAYLOAD );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pSamples = malloc( rounds * sizeof( uint64_t ) );
+        ( void ) sem_init( &responseSemaphore, 0, 0 );
+
+        if( pSamples == NULL )
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "%u rounds of %u bytes, %u ms deadline\n", rounds, payloadSize, deadlineMs );
+
+        for( i = 0; i < ( sizeof( benchProfiles ) / sizeof( benchProfiles[ 0 ] ) ); i++ )
+        {
+            if( prvRunProfile( &benchProfiles[ i ], rounds, pSamples ) == false )
+            {
+                ret = EXIT_FAILURE;
+            }
+        }
+    }
+
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
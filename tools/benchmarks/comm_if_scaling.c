@@ -0,0 +1,464 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_scaling.c
+ * @brief Scaling of the POSIX comm interface with the number of instances.
+ *
+ * Every instance is opened on its own pty pair. A round writes one response
+ * to every master at once and ends when every instance received its response
+ * with recv. The receive latency of an instance is the time from the write
+ * to its master until its receive callback. The report gives the latency,
+ * the rounds per second and the CPU time of the process per response for 1,
+ * 2, 4 and so on instances up to the number given with -i.
+ *
+ * Usage: comm_if_scaling [-i instances] [-n rounds] [-s response size]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured rounds of every instance count. */
+#define BENCH_DEFAULT_ROUNDS       ( 2000U )
+
+/* Rounds run before the measurement to warm up the caches and the threads. */
+#define BENCH_WARMUP_ROUNDS        ( 50U )
+
+/* Largest response written to a pty in one round. */
+#define BENCH_MAX_RESPONSE_SIZE    ( 1024U )
+
+/* Time to wait for the responses of a round. */
+#define BENCH_TIMEOUT_MS           ( 1000 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A comm interface instance and its pty.
+ */
+typedef struct BenchInstance
+{
+    CellularCommInterface_t * pCommInterface;            /**< Comm interface of the instance. */
+    CellularCommInterfaceHandle_t commInterfaceHandle;   /**< Handle returned by open. */
+    int masterFd;                                        /**< Modem side of the pty. */
+    char slaveName[ 64 ];                                /**< Port of the instance. */
+    uint64_t writeTimeNs;                                /**< Time of the write of the response of a round, UINT64_MAX before it. */
+    uint64_t callbackTimeNs;                             /**< Time of the first receive callback after the write, 0 before it. */
+    uint32_t receivedLength;                             /**< Bytes of the response received in a round. */
+} BenchInstance_t;
+
+/*-----------------------------------------------------------*/
+
+/* Posted by the receive callback of every instance. */
+static sem_t callbackSemaphore;
+
+static BenchInstance_t benchInstances[ CELLULAR_COMM_INTERFACE_MAX_INSTANCES ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive callback of the comm interface.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Open the first instanceCount instances on their pty pairs.
+ *
+ * @return true if every instance is opened.
+ */
+static bool prvOpenInstances( uint32_t instanceCount );
+
+/**
+ * @brief Close the instances and their pty pairs.
+ */
+static void prvCloseInstances( uint32_t instanceCount );
+
+/**
+ * @brief Wait until every instance got its receive callback and received a whole response with recv.
+ *
+ * @return true if every response is received.
+ */
+static bool prvReceiveResponses( uint32_t instanceCount,
+                                 uint32_t responseSize );
+
+/**
+ * @brief Run the rounds of an instance count and print the report.
+ *
+ * @return true if every round completed.
+ */
+static bool prvRunRounds( uint32_t instanceCount,
+                          uint32_t rounds,
+                          const uint8_t * pResponse,
+                          uint32_t responseSize,
+                          uint64_t * pSamples );
+
+/**
+ * @brief CPU time of the process in nanoseconds, all its threads included.
+ */
+static uint64_t prvCpuTimeNs( void );
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    BenchInstance_t * pInstance = ( BenchInstance_t * ) pUserData;
+    uint64_t nowNs = Bench_TimeNs();
+    uint64_t expected = 0;
+
+    ( void ) commInterfaceHandle;
+
+    /* A late callback of the previous round comes before the write and is not a sample. */
+    if( nowNs >= __atomic_load_n( &pInstance->writeTimeNs, __ATOMIC_ACQUIRE ) )
+    {
+        ( void ) __atomic_compare_exchange_n( &pInstance->callbackTimeNs, &expected, nowNs,
+                                              false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+    }
+
+    ( void ) sem_post( &callbackSemaphore );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvOpenInstances( uint32_t instanceCount )
+{
+    BenchInstance_t * pInstance = NULL;
+    uint32_t i = 0;
+    bool status = true;
+
+    for( i = 0; ( i < instanceCount ) && ( status == true ); i++ )
+    {
+        pInstance = &benchInstances[ i ];
+        pInstance->commInterfaceHandle = NULL;
+        pInstance->pCommInterface = CellularCommInterface_GetInstance( i );
+        pInstance->masterFd = Bench_OpenPty( pInstance->slaveName, sizeof( pInstance->slaveName ) );
+
+        if( ( pInstance->pCommInterface == NULL ) || ( pInstance->masterFd < 0 ) ||
+            ( CellularCommInterface_SetPort( i, pInstance->slaveName ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+            ( pInstance->pCommInterface->open( prvReceiveCallback, pInstance,
+                                               &pInstance->commInterfaceHandle ) != IOT_COMM_INTERFACE_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Setup of instance %u on %s failed\n", i, pInstance->slaveName );
+            status = false;
+        }
+    }
+
+    if( status == false )
+    {
+        prvCloseInstances( i );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvCloseInstances( uint32_t instanceCount )
+{
+    BenchInstance_t * pInstance = NULL;
+    uint32_t i = 0;
+
+    for( i = 0; i < instanceCount; i++ )
+    {
+        pInstance = &benchInstances[ i ];
+
+        if( pInstance->commInterfaceHandle != NULL )
+        {
+            ( void ) pInstance->pCommInterface->close( pInstance->commInterfaceHandle );
+            pInstance->commInterfaceHandle = NULL;
+        }
+
+        if( pInstance->masterFd >= 0 )
+        {
+            ( void ) close( pInstance->masterFd );
+            pInstance->masterFd = -1;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvReceiveResponses( uint32_t instanceCount,
+                                 uint32_t responseSize )
+{
+    uint8_t buffer[ BENCH_MAX_RESPONSE_SIZE ];
+    BenchInstance_t * pInstance = NULL;
+    struct timespec deadline = { 0 };
+    uint32_t completeCount = 0;
+    uint32_t readLength = 0;
+    uint32_t i = 0;
+    bool timeout = false;
+
+    ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_sec += BENCH_TIMEOUT_MS / 1000;
+
+    while( ( completeCount < instanceCount ) && ( timeout == false ) )
+    {
+        if( sem_timedwait( &callbackSemaphore, &deadline ) != 0 )
+        {
+            timeout = ( errno != EINTR );
+        }
+        else
+        {
+            completeCount = 0;
+
+            for( i = 0; i < instanceCount; i++ )
+            {
+                pInstance = &benchInstances[ i ];
+
+                while( pInstance->receivedLength < responseSize )
+                {
+                    ( void ) pInstance->pCommInterface->recv( pInstance->commInterfaceHandle, buffer,
+                                                              sizeof( buffer ), 0, &readLength );
+
+                    if( readLength == 0U )
+                    {
+                        break;
+                    }
+
+                    pInstance->receivedLength = pInstance->receivedLength + readLength;
+                }
+
+                /* recv may read a response before the callback of its instance ran. */
+                if( ( pInstance->receivedLength >= responseSize ) &&
+                    ( __atomic_load_n( &pInstance->callbackTimeNs, __ATOMIC_ACQUIRE ) != 0U ) )
+                {
+                    completeCount++;
+                }
+            }
+        }
+    }
+
+    return( completeCount == instanceCount );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvRunRounds( uint32_t instanceCount,
+                          uint32_t rounds,
+                          const uint8_t * pResponse,
+                          uint32_t responseSize,
+                          uint64_t * pSamples )
+{
+    char label[ 64 ];
+    uint64_t startNs = 0;
+    uint64_t startCpuNs = 0;
+    uint64_t elapsedNs = 0;
+    uint64_t cpuNs = 0;
+    uint32_t sampleCount = 0;
+    uint32_t round = 0;
+    uint32_t i = 0;
+    bool status = true;
+
+    for( round = 0; ( round < ( rounds + BENCH_WARMUP_ROUNDS ) ) && ( status == true ); round++ )
+    {
+        if( round == BENCH_WARMUP_ROUNDS )
+        {
+            startNs = Bench_TimeNs();
+            startCpuNs = prvCpuTimeNs();
+        }
+
+        for( i = 0; i < instanceCount; i++ )
+        {
+            benchInstances[ i ].receivedLength = 0;
+            __atomic_store_n( &benchInstances[ i ].writeTimeNs, UINT64_MAX, __ATOMIC_RELEASE );
+            __atomic_store_n( &benchInstances[ i ].callbackTimeNs, 0, __ATOMIC_RELEASE );
+        }
+
+        for( i = 0; ( i < instanceCount ) && ( status == true ); i++ )
+        {
+            __atomic_store_n( &benchInstances[ i ].writeTimeNs, Bench_TimeNs(), __ATOMIC_RELEASE );
+            status = ( write( benchInstances[ i ].masterFd, pResponse, responseSize ) == ( ssize_t ) responseSize );
+        }
+
+        if( ( status == false ) || ( prvReceiveResponses( instanceCount, responseSize ) == false ) )
+        {
+            ( void ) fprintf( stderr, "Round %u of %u instances not received\n", round, instanceCount );
+            status = false;
+        }
+        else if( round >= BENCH_WARMUP_ROUNDS )
+        {
+            for( i = 0; i < instanceCount; i++ )
+            {
+                pSamples[ sampleCount ] = __atomic_load_n( &benchInstances[ i ].callbackTimeNs, __ATOMIC_ACQUIRE ) - benchInstances[ i ].writeTimeNs;
+                sampleCount++;
+            }
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+    }
+
+    if( status == true )
+    {
+        elapsedNs = Bench_TimeNs() - startNs;
+        cpuNs = prvCpuTimeNs() - startCpuNs;
+
+        ( void ) snprintf( label, sizeof( label ), "%2u instances, write to callback", instanceCount );
+        Bench_ReportLatency( label, pSamples, sampleCount );
+        ( void ) printf( "%2u instances, %.0f rounds/s, %.1f us CPU per response\n",
+                         instanceCount,
+                         ( double ) rounds * 1e9 / ( double ) elapsedNs,
+                         ( double ) cpuNs / 1e3 / ( double ) sampleCount );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvCpuTimeNs( void )
+{
+    struct rusage usage = { 0 };
+
+    ( void ) getrusage( RUSAGE_SELF, &usage );
+
+    return( ( ( uint64_t ) usage.ru_utime.tv_sec + ( uint64_t ) usage.ru_stime.tv_sec ) * 1000000000ULL +
+            ( ( uint64_t ) usage.ru_utime.tv_usec + ( uint64_t ) usage.ru_stime.tv_usec ) * 1000ULL );
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    uint8_t response[ BENCH_MAX_RESPONSE_SIZE ];
+    uint64_t * pSamples = NULL;
+    uint32_t maxInstances = CELLULAR_COMM_INTERFACE_MAX_INSTANCES;
+    uint32_t rounds = BENCH_DEFAULT_ROUNDS;
+    uint32_t responseSize = 6U;
+    uint32_t instanceCount = 0;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "i:n:s:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'i':
+                maxInstances = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'n':
+                rounds = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 's':
+                responseSize = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( maxInstances == 0U ) || ( maxInstances > CELLULAR_COMM_INTERFACE_MAX_INSTANCES ) ||
+        ( rounds == 0U ) || ( responseSize < 2U ) || ( responseSize > BENCH_MAX_RESPONSE_SIZE ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-i instances, 1 to %u] [-n rounds] [-s response size, 2 to %u]\n",
+                          argv[ 0 ], CELLULAR_COMM_INTERFACE_MAX_INSTANCES, BENCH_MAX_RESPONSE_SIZE );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        /* A response line of the requested size, so it ends a receive burst at once. */
+        ( void ) memset( response, 'A', responseSize );
+        response[ responseSize - 2U ] = '\r';
+        response[ responseSize - 1U ] = '\n';
+
+        pSamples = malloc( ( size_t ) rounds * maxInstances * sizeof( uint64_t ) );
+        ( void ) sem_init( &callbackSemaphore, 0, 0 );
+
+        if( pSamples == NULL )
+        {
+            ret = EXIT_FAILURE;
+        }
+        else
+        {
+            ( void ) printf( "comm_if_posix.c, %u byte responses, %u rounds\n", responseSize, rounds );
+        }
+    }
+
+    /* 1, 2, 4 and so on instances, and maxInstances last. */
+    instanceCount = 1U;
+
+    while( ( ret == EXIT_SUCCESS ) && ( instanceCount <= maxInstances ) )
+    {
+        if( prvOpenInstances( instanceCount ) == false )
+        {
+            ret = EXIT_FAILURE;
+        }
+        else
+        {
+            if( prvRunRounds( instanceCount, rounds, response, responseSize, pSamples ) == false )
+            {
+                ret = EXIT_FAILURE;
+            }
+
+            prvCloseInstances( instanceCount );
+
+            /* Callbacks of the last round may have posted after the wait ended. */
+            while( sem_trywait( &callbackSemaphore ) == 0 )
+            {
+            }
+        }
+
+        if( ( instanceCount < maxInstances ) && ( ( instanceCount * 2U ) > maxInstances ) )
+        {
+            instanceCount = maxInstances;
+        }
+        else
+        {
+            instanceCount = instanceCount * 2U;
+        }
+    }
+
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,367 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_line_rate.c
+ * @brief Line rate negotiation and throughput of comm_if_posix.c against modem_sim.
+ *
+ * The benchmark starts modem_sim at 115200 on a new pty and opens the comm
+ * interface on it. Open negotiates CELLULAR_COMM_INTERFACE_BAUD_RATE and
+ * CELLULAR_COMM_INTERFACE_FLOW_CONTROL, which the build sets for each target,
+ * so the report starts with the time open took and the rate the modem runs at
+ * afterwards, read back with AT+IPR?. Then it measures the AT round trip and
+ * the uplink throughput, a stream of 1460-byte sends closed by an AT command,
+ * timed until its OK. modem_sim paces the line at its current rate.
+ *
+ * -B is passed to modem_sim, which then rejects AT+IPR above that rate, so
+ * open falls back to 115200.
+ *
+ * Usage: comm_line_rate [-n commands] [-s kilobytes] [-B highest modem rate]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured AT commands. */
+#define BENCH_DEFAULT_COMMANDS    ( 50U )
+
+/* Default uplink transfer in kilobytes. */
+#define BENCH_DEFAULT_KB          ( 32U )
+
+/* Payload of a send, the largest socket send of the cellular library. */
+#define BENCH_SEND_SIZE           ( 1460U )
+
+/* Time to wait for a response. Covers the negotiation in open. */
+#define BENCH_TIMEOUT_MS          ( 10000 )
+
+/* Path of the modem_sim executable, set by the build. */
+#ifndef BENCH_MODEM_SIM_PATH
+    #define BENCH_MODEM_SIM_PATH    "modem_sim"
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Received line and the result of the last command. */
+static char responseLine[ 64 ];
+static uint32_t responseLength = 0;
+static uint32_t reportedRate = 0;
+static volatile bool errorReceived = false;
+
+/* Posted by the receive callback for every OK or ERROR. */
+static sem_t resultSemaphore;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive callback. Splits the input into lines and posts the result codes.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Send a command and wait for its result code.
+ *
+ * @return true if the modem answered OK.
+ */
+static bool prvCommand( CellularCommInterfaceHandle_t handle,
+                        const char * pCommand );
+
+/**
+ * @brief Negotiate the line in open, then measure AT latency and uplink throughput.
+ *
+ * @return true if every command completed.
+ */
+static bool prvRun( const char * pLinkPath,
+                    const char * const * ppSimArgs,
+                    uint64_t * pSamples,
+                    uint32_t commands,
+                    uint32_t uplinkKb );
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    uint8_t buffer[ 256 ];
+    uint32_t readLength = 0;
+    uint32_t i = 0;
+
+    ( void ) pUserData;
+
+    do
+    {
+        ( void ) CellularCommInterface.recv( commInterfaceHandle, buffer, sizeof( buffer ), 0, &readLength );
+
+        for( i = 0; i < readLength; i++ )
+        {
+            if( buffer[ i ] == ( uint8_t ) '\n' )
+            {
+                responseLine[ responseLength ] = '\0';
+
+                if( strcmp( responseLine, "OK\r" ) == 0 )
+                {
+                    ( void ) sem_post( &resultSemaphore );
+                }
+                else if( strcmp( responseLine, "ERROR\r" ) == 0 )
+                {
+                    errorReceived = true;
+                    ( void ) sem_post( &resultSemaphore );
+                }
+                else if( strncmp( responseLine, "+IPR: ", 6U ) == 0 )
+                {
+                    reportedRate = ( uint32_t ) strtoul( &responseLine[ 6 ], NULL, 10 );
+                }
+                else
+                {
+                    /* Empty else for MISRA 15.7 compliance. */
+                }
+
+                responseLength = 0;
+            }
+            else if( responseLength < ( sizeof( responseLine ) - 1U ) )
+            {
+                responseLine[ responseLength ] = ( char ) buffer[ i ];
+                responseLength++;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    } while( readLength > 0U );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvCommand( CellularCommInterfaceHandle_t handle,
+                        const char * pCommand )
+{
+    struct timespec deadline = { 0 };
+    uint32_t sentLength = 0;
+    bool taken = false;
+    bool timeout = false;
+
+    errorReceived = false;
+
+    if( CellularCommInterface.send( handle, ( const uint8_t * ) pCommand, ( uint32_t ) strlen( pCommand ),
+                                    BENCH_TIMEOUT_MS, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS )
+    {
+        ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+        deadline.tv_sec += BENCH_TIMEOUT_MS / 1000;
+
+        while( ( taken == false ) && ( timeout == false ) )
+        {
+            if( sem_timedwait( &resultSemaphore, &deadline ) == 0 )
+            {
+                taken = true;
+            }
+            else
+            {
+                timeout = ( errno != EINTR );
+            }
+        }
+    }
+
+    if( taken == false )
+    {
+        ( void ) fprintf( stderr, "No response to %s\n", pCommand );
+    }
+
+    return ( taken == true ) && ( errorReceived == false );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvRun( const char * pLinkPath,
+                    const char * const * ppSimArgs,
+                    uint64_t * pSamples,
+                    uint32_t commands,
+                    uint32_t uplinkKb )
+{
+    static uint8_t payload[ BENCH_SEND_SIZE ];
+    CellularCommInterfaceHandle_t handle = NULL;
+    uint64_t startNs = 0;
+    uint64_t openNs = 0;
+    uint64_t uplinkNs = 0;
+    uint32_t uplinkBytes = uplinkKb * 1024U;
+    uint32_t queuedBytes = 0;
+    uint32_t sendLength = 0;
+    uint32_t sentLength = 0;
+    uint32_t i = 0;
+    bool success = false;
+    pid_t simPid = Bench_StartModemSim( BENCH_MODEM_SIM_PATH, pLinkPath, ppSimArgs );
+
+    /* No carriage return in the payload, modem_sim drops it as one overlong command line. */
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    if( simPid < 0 )
+    {
+        ( void ) fprintf( stderr, "Start of %s failed\n", BENCH_MODEM_SIM_PATH );
+    }
+    else if( CellularCommInterface_SetPort( 0U, pLinkPath ) != IOT_COMM_INTERFACE_SUCCESS )
+    {
+        ( void ) fprintf( stderr, "Setting the port to %s failed\n", pLinkPath );
+    }
+    else
+    {
+        startNs = Bench_TimeNs();
+
+        if( CellularCommInterface.open( prvReceiveCallback, NULL, &handle ) != IOT_COMM_INTERFACE_SUCCESS )
+        {
+            ( void ) fprintf( stderr, "Open of %s failed\n", pLinkPath );
+        }
+        else
+        {
+            openNs = Bench_TimeNs() - startNs;
+            success = ( prvCommand( handle, "ATE0\r" ) == true ) && ( prvCommand( handle, "AT+IPR?\r" ) == true );
+        }
+    }
+
+    for( i = 0; ( success == true ) && ( i < commands ); i++ )
+    {
+        startNs = Bench_TimeNs();
+        success = prvCommand( handle, "AT\r" );
+        pSamples[ i ] = Bench_TimeNs() - startNs;
+    }
+
+    if( success == true )
+    {
+        startNs = Bench_TimeNs();
+
+        while( ( success == true ) && ( queuedBytes < uplinkBytes ) )
+        {
+            sendLength = ( ( uplinkBytes - queuedBytes ) < BENCH_SEND_SIZE ) ? ( uplinkBytes - queuedBytes ) : BENCH_SEND_SIZE;
+            success = ( CellularCommInterface.send( handle, payload, sendLength, BENCH_TIMEOUT_MS,
+                                                    &sentLength ) == IOT_COMM_INTERFACE_SUCCESS ) &&
+                      ( sentLength == sendLength );
+            queuedBytes = queuedBytes + sentLength;
+        }
+
+        /* The OK comes once the modem has taken every byte off the line. */
+        success = ( success == true ) && ( prvCommand( handle, "\rAT\r" ) == true );
+        uplinkNs = Bench_TimeNs() - startNs;
+    }
+
+    if( success == true )
+    {
+        ( void ) printf( "line rate %u, flow control %s, modem at %u after open\n",
+                         CELLULAR_COMM_INTERFACE_BAUD_RATE,
+                         ( CELLULAR_COMM_INTERFACE_FLOW_CONTROL == 1 ) ? "requested" : "off",
+                         reportedRate );
+        ( void ) printf( "open %.1f ms\n", ( double ) openNs / 1e6 );
+        ( void ) printf( "uplink %.1f KB/s, %u bytes\n", ( double ) uplinkBytes * 1e9 / 1024.0 / ( double ) uplinkNs, uplinkBytes );
+        Bench_ReportLatency( "AT send to OK", pSamples, commands );
+    }
+
+    /* Close the comm interface before its pty goes away. */
+    if( handle != NULL )
+    {
+        ( void ) CellularCommInterface.close( handle );
+    }
+
+    Bench_StopModemSim( simPid );
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    const char * pSimArgs[ 9 ] = { "-m", "bg96", "-b", "115200", "-l", "1", NULL, NULL, NULL };
+    char linkPath[ 64 ];
+    uint64_t * pSamples = NULL;
+    uint32_t commands = BENCH_DEFAULT_COMMANDS;
+    uint32_t uplinkKb = BENCH_DEFAULT_KB;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "n:s:B:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                commands = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 's':
+                uplinkKb = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'B':
+                pSimArgs[ 6 ] = "-B";
+                pSimArgs[ 7 ] = optarg;
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( commands == 0U ) || ( uplinkKb == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n commands] [-s kilobytes] [-B highest modem rate]\n", argv[ 0 ] );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pSamples = malloc( commands * sizeof( uint64_t ) );
+        ( void ) sem_init( &resultSemaphore, 0, 0 );
+        ( void ) snprintf( linkPath, sizeof( linkPath ), "/tmp/comm_line_rate.%d", ( int ) getpid() );
+
+        if( ( pSamples == NULL ) || ( prvRun( linkPath, pSimArgs, pSamples, commands, uplinkKb ) == false ) )
+        {
+            ret = EXIT_FAILURE;
+        }
+
+        ( void ) unlink( linkPath );
+    }
+
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
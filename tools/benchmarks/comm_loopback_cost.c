@@ -0,0 +1,333 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_loopback_cost.c
+ * @brief Cost per AT transaction and per payload byte of the loopback comm interface.
+ *
+ * The benchmark opens comm_if_loopback.c with the BG96 script and drives it
+ * the way the cellular library does, from a single thread. The receive
+ * callback reads the response with recv, in the send call that completed the
+ * command, so every sample covers the whole transaction: command parsing,
+ * the script lookup, the receive ring and the callback.
+ *
+ * First it cycles through the status queries of cellular_setup.c and reports
+ * the time per AT transaction. Then it echoes payloads of growing size through
+ * socket 0 with AT+QISEND and AT+QIRD, and reports the time per round trip,
+ * and the cost per payload byte from the difference between the largest and
+ * the smallest payload. The counters of CellularCommLoopback_GetStats check
+ * that every command matched a rule and every byte came back.
+ *
+ * Usage: comm_loopback_cost [-n transactions]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Loopback comm interface include file. */
+#include "comm_if_loopback.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured transactions of each kind. */
+#define BENCH_DEFAULT_TRANSACTIONS    ( 100000U )
+
+/* Largest payload of a round trip, the largest socket send of the cellular library. */
+#define BENCH_MAX_PAYLOAD             ( 1460U )
+
+/* Holds the largest response, a read of BENCH_MAX_PAYLOAD with its header and trailer. */
+#define BENCH_RESPONSE_SIZE           ( 2048U )
+
+/*-----------------------------------------------------------*/
+
+/* Response read by the receive callback since the last command. */
+static uint8_t response[ BENCH_RESPONSE_SIZE ];
+static uint32_t responseLength = 0;
+
+/* Status queries of cellular_setup.c, answered by the BG96 script. */
+static const char * const statusCommands[] =
+{
+    "AT+CPIN?\r",
+    "AT+CREG?\r",
+    "AT+CEREG?\r",
+    "AT+COPS?\r",
+    "AT+CSQ\r",
+    "AT+CGATT?\r"
+};
+
+/* Payload sizes of the round trips. */
+static const uint32_t payloadSizes[] = { 16U, 128U, 512U, BENCH_MAX_PAYLOAD };
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive callback. Appends everything available to response.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Send data and check the end of the response.
+ *
+ * @return true if the response ends with pSuffix.
+ */
+static bool prvTransact( CellularCommInterface_t * pCommInterface,
+                         CellularCommInterfaceHandle_t handle,
+                         const uint8_t * pData,
+                         uint32_t length,
+                         const char * pSuffix );
+
+/**
+ * @brief Echo one payload through socket 0 with AT+QISEND and AT+QIRD.
+ *
+ * @return true if every response was complete.
+ */
+static bool prvRoundTrip( CellularCommInterface_t * pCommInterface,
+                          CellularCommInterfaceHandle_t handle,
+                          const uint8_t * pPayload,
+                          uint32_t length );
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    CellularCommInterface_t * pCommInterface = ( CellularCommInterface_t * ) pUserData;
+    uint32_t readLength = 0;
+
+    do
+    {
+        ( void ) pCommInterface->recv( commInterfaceHandle, &response[ responseLength ],
+                                       BENCH_RESPONSE_SIZE - responseLength, 0, &readLength );
+        responseLength = responseLength + readLength;
+    } while( ( readLength > 0U ) && ( responseLength < BENCH_RESPONSE_SIZE ) );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvTransact( CellularCommInterface_t * pCommInterface,
+                         CellularCommInterfaceHandle_t handle,
+                         const uint8_t * pData,
+                         uint32_t length,
+                         const char * pSuffix )
+{
+    uint32_t sentLength = 0;
+    uint32_t suffixLength = ( uint32_t ) strlen( pSuffix );
+
+    responseLength = 0;
+
+    /* The loopback answers inside send, the response is complete when it returns. */
+    return ( pCommInterface->send( handle, pData, length, 0, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS ) &&
+           ( sentLength == length ) &&
+           ( responseLength >= suffixLength ) &&
+           ( memcmp( &response[ responseLength - suffixLength ], pSuffix, suffixLength ) == 0 );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvRoundTrip( CellularCommInterface_t * pCommInterface,
+                          CellularCommInterfaceHandle_t handle,
+                          const uint8_t * pPayload,
+                          uint32_t length )
+{
+    char command[ 32 ];
+    int commandLength = 0;
+    bool success = false;
+
+    commandLength = snprintf( command, sizeof( command ), "AT+QISEND=0,%u\r", length );
+
+    if( prvTransact( pCommInterface, handle, ( const uint8_t * ) command, ( uint32_t ) commandLength, "> " ) == true )
+    {
+        /* With no peer the payload comes back to socket 0, the receive URC comes before SEND OK. */
+        if( prvTransact( pCommInterface, handle, pPayload, length, "\r\nSEND OK\r\n" ) == true )
+        {
+            commandLength = snprintf( command, sizeof( command ), "AT+QIRD=0,%u\r", length );
+            success = prvTransact( pCommInterface, handle, ( const uint8_t * ) command, ( uint32_t ) commandLength, "\r\nOK\r\n" ) &&
+                      ( responseLength > length );
+        }
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static uint8_t payload[ BENCH_MAX_PAYLOAD ];
+    CellularCommInterface_t * pCommInterface = NULL;
+    CellularCommInterfaceHandle_t handle = NULL;
+    CellularCommLoopbackStats_t stats = { 0 };
+    const char * pCommand = NULL;
+    uint64_t * pSamples = NULL;
+    uint64_t startNs = 0;
+    uint64_t totalNs = 0;
+    uint64_t smallestNs = 0;
+    uint64_t largestNs = 0;
+    uint64_t payloadBytes = 0;
+    uint32_t transactions = BENCH_DEFAULT_TRANSACTIONS;
+    uint32_t commandCount = 0;
+    uint32_t sizeIndex = 0;
+    uint32_t i = 0;
+    char label[ 48 ];
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "n:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                transactions = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( transactions == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n transactions]\n", argv[ 0 ] );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pSamples = malloc( transactions * sizeof( uint64_t ) );
+        pCommInterface = CellularCommLoopback_Get( &CellularCommLoopbackBg96Script, NULL, NULL );
+
+        if( ( pSamples == NULL ) || ( pCommInterface == NULL ) ||
+            ( pCommInterface->open( prvReceiveCallback, pCommInterface, &handle ) != IOT_COMM_INTERFACE_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Open of the loopback comm interface failed\n" );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    for( i = 0; ( ret == EXIT_SUCCESS ) && ( i < transactions ); i++ )
+    {
+        pCommand = statusCommands[ i % ( sizeof( statusCommands ) / sizeof( statusCommands[ 0 ] ) ) ];
+        startNs = Bench_TimeNs();
+
+        if( prvTransact( pCommInterface, handle, ( const uint8_t * ) pCommand, ( uint32_t ) strlen( pCommand ), "\r\nOK\r\n" ) == false )
+        {
+            ( void ) fprintf( stderr, "No OK to %s\n", pCommand );
+            ret = EXIT_FAILURE;
+        }
+
+        pSamples[ i ] = Bench_TimeNs() - startNs;
+        totalNs = totalNs + pSamples[ i ];
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        CellularCommLoopback_GetStats( &stats );
+        commandCount = stats.commandCount;
+        ( void ) printf( "%u AT transactions, %u unmatched, %.1f ns each\n",
+                         stats.commandCount, stats.unmatchedCount, ( double ) totalNs / ( double ) transactions );
+        Bench_ReportLatencyNs( "AT transaction", pSamples, transactions );
+    }
+
+    for( i = 0; i < BENCH_MAX_PAYLOAD; i++ )
+    {
+        payload[ i ] = ( uint8_t ) ( 'a' + ( i % 26U ) );
+    }
+
+    for( sizeIndex = 0; ( ret == EXIT_SUCCESS ) && ( sizeIndex < ( sizeof( payloadSizes ) / sizeof( payloadSizes[ 0 ] ) ) ); sizeIndex++ )
+    {
+        totalNs = 0;
+
+        for( i = 0; ( ret == EXIT_SUCCESS ) && ( i < transactions ); i++ )
+        {
+            startNs = Bench_TimeNs();
+
+            if( prvRoundTrip( pCommInterface, handle, payload, payloadSizes[ sizeIndex ] ) == false )
+            {
+                ( void ) fprintf( stderr, "Round trip of %u bytes failed\n", payloadSizes[ sizeIndex ] );
+                ret = EXIT_FAILURE;
+            }
+
+            pSamples[ i ] = Bench_TimeNs() - startNs;
+            totalNs = totalNs + pSamples[ i ];
+        }
+
+        if( ret == EXIT_SUCCESS )
+        {
+            payloadBytes = payloadBytes + ( ( uint64_t ) payloadSizes[ sizeIndex ] * transactions );
+            ( void ) snprintf( label, sizeof( label ), "%u byte round trip", payloadSizes[ sizeIndex ] );
+            Bench_ReportLatencyNs( label, pSamples, transactions );
+
+            if( sizeIndex == 0U )
+            {
+                smallestNs = totalNs;
+            }
+
+            largestNs = totalNs;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        CellularCommLoopback_GetStats( &stats );
+        ( void ) printf( "%u payload bytes sent, %u read, %u dropped, of %llu\n",
+                         stats.socketTxBytes, stats.socketRxBytes, stats.dropBytes,
+                         ( unsigned long long ) payloadBytes );
+        ( void ) printf( "%.3f ns per payload byte sent and read back, %.1f ns fixed cost per round trip\n",
+                         ( double ) ( largestNs - smallestNs ) /
+                         ( ( double ) ( BENCH_MAX_PAYLOAD - payloadSizes[ 0 ] ) * ( double ) transactions ),
+                         ( ( double ) smallestNs / ( double ) transactions ) -
+                         ( ( double ) payloadSizes[ 0 ] * ( double ) ( largestNs - smallestNs ) /
+                           ( double ) ( BENCH_MAX_PAYLOAD - payloadSizes[ 0 ] ) / ( double ) transactions ) );
+
+        if( ( stats.unmatchedCount != 0U ) || ( stats.dropBytes != 0U ) ||
+            ( ( stats.commandCount - commandCount ) != ( 2U * transactions * ( sizeof( payloadSizes ) / sizeof( payloadSizes[ 0 ] ) ) ) ) )
+        {
+            ( void ) fprintf( stderr, "Unexpected loopback counters\n" );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( handle != NULL )
+    {
+        ( void ) pCommInterface->close( handle );
+    }
+
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,550 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_port_split.c
+ * @brief Latency of control AT commands during a saturating data transfer.
+ *
+ * Two pty pairs stand in for the AT and data ports of a USB module. A modem
+ * thread per pty answers "AT" with OK and "AT+QIRD" with a burst of payload,
+ * and paces its output at the line rate, in order, like a serial port. The
+ * host side keeps a data read outstanding for the whole run, so the data
+ * transfer fills its line, and sends AT commands on the control role.
+ *
+ * The run is made twice. With a shared port the control and data roles use
+ * the same comm interface instance and pty, so an OK waits behind the
+ * payload queued before it. With split ports the data role is instance 1 on
+ * the second pty. The report is the time from send of "AT" to the OK in the
+ * receive callback, and the data throughput.
+ *
+ * Usage: comm_port_split [-n commands] [-b baud] [-s burst size]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured AT commands. */
+#define BENCH_DEFAULT_COMMANDS      ( 50U )
+
+/* Default line rate of both ports in bit/s. */
+#define BENCH_DEFAULT_BAUD          ( 115200U )
+
+/* Default payload of a data read, the largest read of the cellular library. */
+#define BENCH_DEFAULT_BURST_SIZE    ( 1459U )
+
+/* Largest payload of a data read. */
+#define BENCH_MAX_BURST_SIZE        ( 8192U )
+
+/* Output of a modem thread not on the line yet. */
+#define BENCH_MODEM_QUEUE_SIZE      ( 4U * BENCH_MAX_BURST_SIZE )
+
+/* Most bytes written to the pty at once, so pacing stays close to the line rate. */
+#define BENCH_MODEM_WRITE_CHUNK     ( 64U )
+
+/* Time between two AT commands. */
+#define BENCH_COMMAND_GAP_US        ( 20000U )
+
+/* Data transfer before the first AT command. */
+#define BENCH_WARMUP_US             ( 200000U )
+
+/* Time to wait for an OK or a data burst. */
+#define BENCH_TIMEOUT_MS            ( 10000 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Modem side of a pty.
+ */
+typedef struct BenchModem
+{
+    int masterFd;                                 /**< Master of the pty. */
+    uint8_t queue[ BENCH_MODEM_QUEUE_SIZE ];      /**< Output in line order. */
+    size_t queueLength;                           /**< Bytes in queue. */
+    char command[ 32 ];                           /**< Command line being received. */
+    size_t commandLength;                         /**< Bytes in command. */
+    uint64_t lineReadyNs;                         /**< Time the line can take the next byte. */
+} BenchModem_t;
+
+/**
+ * @brief Host side of a comm interface instance.
+ */
+typedef struct BenchHost
+{
+    CellularCommInterface_t * pCommInterface;     /**< Comm interface of the instance. */
+    CellularCommInterfaceHandle_t handle;         /**< Handle of the open instance. */
+    uint32_t okMatch;                             /**< Characters of "OK\r\n" matched so far. */
+    uint32_t burstReceived;                       /**< Payload bytes of the current data read. */
+} BenchHost_t;
+
+/*-----------------------------------------------------------*/
+
+static const char okPattern[] = "OK\r\n";
+
+static BenchModem_t modems[ 2 ];
+static volatile bool modemsRunning = false;
+static uint32_t lineBaud = BENCH_DEFAULT_BAUD;
+static uint32_t burstSize = BENCH_DEFAULT_BURST_SIZE;
+
+/* Posted by the receive callback for every OK and every complete data burst. */
+static sem_t okSemaphore;
+static sem_t burstSemaphore;
+
+/* Payload received by the host in the current run. */
+static uint64_t payloadBytes = 0;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Modem thread. Answers the commands of a pty at the line rate.
+ */
+static void * prvModemThread( void * pArgument );
+
+/**
+ * @brief Receive callback of both roles. pUserData is the BenchHost_t.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Wait on a semaphore for BENCH_TIMEOUT_MS.
+ *
+ * @return true if the semaphore was taken.
+ */
+static bool prvWait( sem_t * pSemaphore );
+
+/**
+ * @brief Measure AT latency on pControl while pData reads continuously.
+ *
+ * @return true if every command and data read completed.
+ */
+static bool prvRun( const char * pLabel,
+                    BenchHost_t * pControl,
+                    BenchHost_t * pData,
+                    uint64_t * pSamples,
+                    uint32_t commands );
+
+/*-----------------------------------------------------------*/
+
+static void prvModemQueue( BenchModem_t * pModem,
+                           const void * pData,
+                           size_t length )
+{
+    if( ( pModem->queueLength + length ) <= sizeof( pModem->queue ) )
+    {
+        ( void ) memcpy( &pModem->queue[ pModem->queueLength ], pData, length );
+        pModem->queueLength = pModem->queueLength + length;
+    }
+    else
+    {
+        ( void ) fprintf( stderr, "Modem queue overflow\n" );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvModemCommand( BenchModem_t * pModem )
+{
+    static const char okResponse[] = "\r\nOK\r\n";
+    uint8_t payload[ BENCH_MAX_BURST_SIZE ];
+    uint32_t i = 0;
+
+    if( strcmp( pModem->command, "AT+QIRD" ) == 0 )
+    {
+        /* Lower case payload never matches "OK". */
+        for( i = 0; i < burstSize; i++ )
+        {
+            payload[ i ] = ( uint8_t ) ( 'a' + ( i % 26U ) );
+        }
+
+        prvModemQueue( pModem, payload, burstSize );
+    }
+    else if( strcmp( pModem->command, "AT" ) == 0 )
+    {
+        prvModemQueue( pModem, okResponse, sizeof( okResponse ) - 1U );
+    }
+    else
+    {
+        ( void ) fprintf( stderr, "Modem: unexpected command %s\n", pModem->command );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void * prvModemThread( void * pArgument )
+{
+    BenchModem_t * pModem = ( BenchModem_t * ) pArgument;
+    struct pollfd pollFd = { 0 };
+    uint8_t buffer[ 64 ];
+    uint64_t nowNs = 0;
+    ssize_t length = 0;
+    size_t writeLength = 0;
+    ssize_t i = 0;
+
+    pollFd.fd = pModem->masterFd;
+    pollFd.events = POLLIN;
+
+    while( modemsRunning == true )
+    {
+        ( void ) poll( &pollFd, 1, 1 );
+
+        while( ( length = read( pModem->masterFd, buffer, sizeof( buffer ) ) ) > 0 )
+        {
+            for( i = 0; i < length; i++ )
+            {
+                if( buffer[ i ] == ( uint8_t ) '\r' )
+                {
+                    pModem->command[ pModem->commandLength ] = '\0';
+                    prvModemCommand( pModem );
+                    pModem->commandLength = 0;
+                }
+                else if( pModem->commandLength < ( sizeof( pModem->command ) - 1U ) )
+                {
+                    pModem->command[ pModem->commandLength ] = ( char ) buffer[ i ];
+                    pModem->commandLength++;
+                }
+                else
+                {
+                    /* Empty else for MISRA 15.7 compliance. */
+                }
+            }
+        }
+
+        /* One chunk at a time, each taking its time on the line. */
+        nowNs = Bench_TimeNs();
+
+        while( ( pModem->queueLength > 0U ) && ( nowNs >= pModem->lineReadyNs ) )
+        {
+            writeLength = ( pModem->queueLength < BENCH_MODEM_WRITE_CHUNK ) ? pModem->queueLength : BENCH_MODEM_WRITE_CHUNK;
+            length = write( pModem->masterFd, pModem->queue, writeLength );
+
+            if( length <= 0 )
+            {
+                break;
+            }
+
+            ( void ) memmove( pModem->queue, &pModem->queue[ length ], pModem->queueLength - ( size_t ) length );
+            pModem->queueLength = pModem->queueLength - ( size_t ) length;
+
+            /* 10 bits per byte with start and stop bits. */
+            if( pModem->lineReadyNs < nowNs )
+            {
+                pModem->lineReadyNs = nowNs;
+            }
+
+            pModem->lineReadyNs = pModem->lineReadyNs + ( ( uint64_t ) length * 10U * 1000000000ULL ) / lineBaud;
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    BenchHost_t * pHost = ( BenchHost_t * ) pUserData;
+    uint8_t buffer[ 256 ];
+    uint32_t readLength = 0;
+    uint32_t i = 0;
+
+    do
+    {
+        ( void ) pHost->pCommInterface->recv( commInterfaceHandle, buffer, sizeof( buffer ), 0, &readLength );
+
+        for( i = 0; i < readLength; i++ )
+        {
+            if( ( buffer[ i ] >= ( uint8_t ) 'a' ) && ( buffer[ i ] <= ( uint8_t ) 'z' ) )
+            {
+                __atomic_add_fetch( &payloadBytes, 1U, __ATOMIC_RELAXED );
+                pHost->burstReceived++;
+
+                if( pHost->burstReceived == burstSize )
+                {
+                    pHost->burstReceived = 0;
+                    ( void ) sem_post( &burstSemaphore );
+                }
+            }
+
+            if( buffer[ i ] == ( uint8_t ) okPattern[ pHost->okMatch ] )
+            {
+                pHost->okMatch++;
+
+                if( pHost->okMatch == ( sizeof( okPattern ) - 1U ) )
+                {
+                    pHost->okMatch = 0;
+                    ( void ) sem_post( &okSemaphore );
+                }
+            }
+            else
+            {
+                pHost->okMatch = ( buffer[ i ] == ( uint8_t ) okPattern[ 0 ] ) ? 1U : 0U;
+            }
+        }
+    } while( readLength > 0U );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvWait( sem_t * pSemaphore )
+{
+    struct timespec deadline = { 0 };
+    bool taken = false;
+    bool timeout = false;
+
+    ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_sec += BENCH_TIMEOUT_MS / 1000;
+
+    while( ( taken == false ) && ( timeout == false ) )
+    {
+        if( sem_timedwait( pSemaphore, &deadline ) == 0 )
+        {
+            taken = true;
+        }
+        else
+        {
+            timeout = ( errno != EINTR );
+        }
+    }
+
+    return taken;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvRun( const char * pLabel,
+                    BenchHost_t * pControl,
+                    BenchHost_t * pData,
+                    uint64_t * pSamples,
+                    uint32_t commands )
+{
+    static const uint8_t command[] = "AT\r";
+    static const uint8_t readCommand[] = "AT+QIRD\r";
+    uint64_t startNs = 0;
+    uint64_t nextCommandNs = 0;
+    uint64_t runStartNs = 0;
+    uint32_t sentLength = 0;
+    uint32_t measured = 0;
+    bool commandPending = false;
+    bool success = true;
+
+    __atomic_store_n( &payloadBytes, 0, __ATOMIC_RELAXED );
+    runStartNs = Bench_TimeNs();
+    nextCommandNs = runStartNs + ( BENCH_WARMUP_US * 1000ULL );
+
+    /* One data read is outstanding at any time, the next one is sent when its burst is complete. */
+    success = ( pData->pCommInterface->send( pData->handle, readCommand, sizeof( readCommand ) - 1U,
+                                             BENCH_TIMEOUT_MS, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS );
+
+    while( ( success == true ) && ( measured < commands ) )
+    {
+        if( sem_trywait( &burstSemaphore ) == 0 )
+        {
+            success = ( pData->pCommInterface->send( pData->handle, readCommand, sizeof( readCommand ) - 1U,
+                                                     BENCH_TIMEOUT_MS, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS );
+        }
+        else if( ( commandPending == false ) && ( Bench_TimeNs() >= nextCommandNs ) )
+        {
+            startNs = Bench_TimeNs();
+            success = ( pControl->pCommInterface->send( pControl->handle, command, sizeof( command ) - 1U,
+                                                        BENCH_TIMEOUT_MS, &sentLength ) == IOT_COMM_INTERFACE_SUCCESS );
+            commandPending = true;
+        }
+        else if( ( commandPending == true ) && ( sem_trywait( &okSemaphore ) == 0 ) )
+        {
+            pSamples[ measured ] = Bench_TimeNs() - startNs;
+            measured++;
+            commandPending = false;
+            nextCommandNs = Bench_TimeNs() + ( BENCH_COMMAND_GAP_US * 1000ULL );
+        }
+        else if( ( commandPending == true ) && ( ( Bench_TimeNs() - startNs ) > ( BENCH_TIMEOUT_MS * 1000000ULL ) ) )
+        {
+            ( void ) fprintf( stderr, "%s: OK of command %u not received\n", pLabel, measured );
+            success = false;
+        }
+        else
+        {
+            ( void ) usleep( 50 );
+        }
+    }
+
+    if( success == true )
+    {
+        ( void ) printf( "%s, data %.0f B/s of %u B/s line rate\n", pLabel,
+                         ( double ) __atomic_load_n( &payloadBytes, __ATOMIC_RELAXED ) * 1e9 / ( double ) ( Bench_TimeNs() - runStartNs ),
+                         lineBaud / 10U );
+        Bench_ReportLatency( "AT send to OK on control", pSamples, measured );
+    }
+
+    /* Let the last data read complete before the next run. */
+    ( void ) prvWait( &burstSemaphore );
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static BenchHost_t hosts[ 2 ];
+    char slaveNames[ 2 ][ 64 ];
+    pthread_t modemThreads[ 2 ];
+    uint64_t * pSamples = NULL;
+    uint32_t commands = BENCH_DEFAULT_COMMANDS;
+    uint32_t i = 0;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "n:b:s:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                commands = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'b':
+                lineBaud = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 's':
+                burstSize = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( commands == 0U ) || ( lineBaud < 1200U ) ||
+        ( burstSize == 0U ) || ( burstSize > BENCH_MAX_BURST_SIZE ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n commands] [-b baud, 1200 or more] [-s burst size, 1 to %u]\n",
+                          argv[ 0 ], BENCH_MAX_BURST_SIZE );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pSamples = malloc( commands * sizeof( uint64_t ) );
+        ( void ) sem_init( &okSemaphore, 0, 0 );
+        ( void ) sem_init( &burstSemaphore, 0, 0 );
+        modemsRunning = true;
+
+        for( i = 0; ( i < 2U ) && ( ret == EXIT_SUCCESS ); i++ )
+        {
+            modems[ i ].masterFd = Bench_OpenPty( slaveNames[ i ], sizeof( slaveNames[ i ] ) );
+
+            if( ( modems[ i ].masterFd < 0 ) ||
+                ( pthread_create( &modemThreads[ i ], NULL, prvModemThread, &modems[ i ] ) != 0 ) )
+            {
+                ret = EXIT_FAILURE;
+            }
+        }
+
+        /* The benchmark configuration defines CELLULAR_COMM_INTERFACE_DATA_INSTANCE as instance 1. */
+        hosts[ 0 ].pCommInterface = CellularCommInterface_GetByRole( CELLULAR_COMM_PORT_ROLE_CONTROL );
+        hosts[ 1 ].pCommInterface = CellularCommInterface_GetByRole( CELLULAR_COMM_PORT_ROLE_DATA );
+
+        if( ( ret != EXIT_SUCCESS ) || ( pSamples == NULL ) ||
+            ( CellularCommInterface_SetPort( CELLULAR_COMM_INTERFACE_CONTROL_INSTANCE, slaveNames[ 0 ] ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+            ( CellularCommInterface_SetPort( CELLULAR_COMM_INTERFACE_DATA_INSTANCE, slaveNames[ 1 ] ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+            ( hosts[ 0 ].pCommInterface->open( prvReceiveCallback, &hosts[ 0 ], &hosts[ 0 ].handle ) != IOT_COMM_INTERFACE_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Setup of the control port failed\n" );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "%u byte data reads, %u baud, control on %s, data on %s\n",
+                         burstSize, lineBaud, slaveNames[ 0 ], slaveNames[ 1 ] );
+
+        /* Both roles on the control instance. */
+        if( prvRun( "shared port", &hosts[ 0 ], &hosts[ 0 ], pSamples, commands ) == false )
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        if( ( hosts[ 1 ].pCommInterface->open( prvReceiveCallback, &hosts[ 1 ], &hosts[ 1 ].handle ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+            ( prvRun( "split ports", &hosts[ 0 ], &hosts[ 1 ], pSamples, commands ) == false ) )
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    for( i = 0; i < 2U; i++ )
+    {
+        if( hosts[ i ].handle != NULL )
+        {
+            ( void ) hosts[ i ].pCommInterface->close( hosts[ i ].handle );
+        }
+    }
+
+    if( modemsRunning == true )
+    {
+        modemsRunning = false;
+
+        for( i = 0; i < 2U; i++ )
+        {
+            if( modems[ i ].masterFd >= 0 )
+            {
+                ( void ) pthread_join( modemThreads[ i ], NULL );
+                ( void ) close( modems[ i ].masterFd );
+            }
+        }
+    }
+
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,306 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_rx_latency.c
+ * @brief Latency of the POSIX comm interface against a pty peer.
+ *
+ * A pty pair stands in for the modem port. The receive latency is the time
+ * from a response written to the master until comm_if_posix.c calls the
+ * receive callback. The send latency is the time from send until the bytes
+ * can be read from the master. Each iteration waits for the previous one to
+ * complete, so the results are the latency of an idle link.
+ *
+ * Usage: comm_rx_latency [-n iterations] [-s response size]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured iterations. */
+#define BENCH_DEFAULT_ITERATIONS    ( 10000U )
+
+/* Iterations run before the measurement to warm up the caches and the threads. */
+#define BENCH_WARMUP_ITERATIONS     ( 100U )
+
+/* Largest response written to the pty in one iteration. */
+#define BENCH_MAX_RESPONSE_SIZE     ( 1024U )
+
+/* Time to wait for a response or a sent command. */
+#define BENCH_TIMEOUT_MS            ( 1000 )
+
+/*-----------------------------------------------------------*/
+
+/* Posted by the receive callback. */
+static sem_t callbackSemaphore;
+
+/* Time of the first receive callback of an iteration, 0 before it. */
+static uint64_t callbackTimeNs = 0;
+
+/* Receive callbacks of the measured iterations. */
+static uint32_t callbackCount = 0;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive callback of the comm interface.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Wait for the receive callback and read a whole response with recv.
+ *
+ * @return true if responseSize bytes are received.
+ */
+static bool prvReceiveResponse( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                uint32_t responseSize );
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    uint64_t expected = 0;
+
+    ( void ) pUserData;
+    ( void ) commInterfaceHandle;
+
+    ( void ) __atomic_compare_exchange_n( &callbackTimeNs, &expected, Bench_TimeNs(),
+                                          false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+    ( void ) __atomic_fetch_add( &callbackCount, 1U, __ATOMIC_RELAXED );
+    ( void ) sem_post( &callbackSemaphore );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvReceiveResponse( CellularCommInterfaceHandle_t commInterfaceHandle,
+                                uint32_t responseSize )
+{
+    uint8_t buffer[ BENCH_MAX_RESPONSE_SIZE ];
+    struct timespec deadline = { 0 };
+    uint32_t receivedLength = 0;
+    uint32_t readLength = 0;
+    bool timeout = false;
+
+    ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_sec += BENCH_TIMEOUT_MS / 1000;
+
+    while( ( receivedLength < responseSize ) && ( timeout == false ) )
+    {
+        if( sem_timedwait( &callbackSemaphore, &deadline ) != 0 )
+        {
+            timeout = ( errno != EINTR );
+        }
+        else
+        {
+            do
+            {
+                ( void ) CellularCommInterface.recv( commInterfaceHandle, buffer, sizeof( buffer ), 0, &readLength );
+                receivedLength = receivedLength + readLength;
+            } while( readLength > 0U );
+        }
+    }
+
+    return( receivedLength == responseSize );
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static const uint8_t command[] = "AT\r";
+    uint8_t response[ BENCH_MAX_RESPONSE_SIZE ];
+    uint8_t peerBuffer[ 64 ];
+    char slaveName[ 64 ];
+    CellularCommInterfaceHandle_t commInterfaceHandle = NULL;
+    struct pollfd masterPollFd = { 0 };
+    uint64_t * pRxSamples = NULL;
+    uint64_t * pTxSamples = NULL;
+    uint64_t startNs = 0;
+    uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+    uint32_t responseSize = 6U;
+    uint32_t sentLength = 0;
+    uint32_t i = 0;
+    int masterFd = -1;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+    bool prompt = false;
+
+    while( ( option = getopt( argc, argv, "n:s:p" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                iterations = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 's':
+                responseSize = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'p':
+                prompt = true;
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( iterations == 0U ) || ( responseSize < 2U ) || ( responseSize > BENCH_MAX_RESPONSE_SIZE ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n iterations] [-s response size, 2 to %u] [-p]\n", argv[ 0 ], BENCH_MAX_RESPONSE_SIZE );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        /* A response line of the requested size, so it ends a receive burst at once,
+         * or ending with the data prompt, which has no line end. */
+        ( void ) memset( response, 'A', responseSize );
+        response[ responseSize - 2U ] = ( prompt == true ) ? '>' : '\r';
+        response[ responseSize - 1U ] = ( prompt == true ) ? ' ' : '\n';
+
+        pRxSamples = malloc( iterations * sizeof( uint64_t ) );
+        pTxSamples = malloc( iterations * sizeof( uint64_t ) );
+        masterFd = Bench_OpenPty( slaveName, sizeof( slaveName ) );
+        ( void ) sem_init( &callbackSemaphore, 0, 0 );
+
+        if( ( pRxSamples == NULL ) || ( pTxSamples == NULL ) || ( masterFd < 0 ) ||
+            ( CellularCommInterface_SetPort( 0, slaveName ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+            ( CellularCommInterface.open( prvReceiveCallback, NULL, &commInterfaceHandle ) != IOT_COMM_INTERFACE_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Setup of the comm interface on %s failed\n", slaveName );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        masterPollFd.fd = masterFd;
+        masterPollFd.events = POLLIN;
+
+        for( i = 0; ( i < ( iterations + BENCH_WARMUP_ITERATIONS ) ) && ( ret == EXIT_SUCCESS ); i++ )
+        {
+            if( i == BENCH_WARMUP_ITERATIONS )
+            {
+                __atomic_store_n( &callbackCount, 0U, __ATOMIC_RELAXED );
+            }
+
+            /* Modem to host. */
+            __atomic_store_n( &callbackTimeNs, 0, __ATOMIC_RELEASE );
+            startNs = Bench_TimeNs();
+
+            if( ( write( masterFd, response, responseSize ) != ( ssize_t ) responseSize ) ||
+                ( prvReceiveResponse( commInterfaceHandle, responseSize ) == false ) )
+            {
+                ( void ) fprintf( stderr, "Response %u not received\n", i );
+                ret = EXIT_FAILURE;
+            }
+            else if( i >= BENCH_WARMUP_ITERATIONS )
+            {
+                pRxSamples[ i - BENCH_WARMUP_ITERATIONS ] = __atomic_load_n( &callbackTimeNs, __ATOMIC_ACQUIRE ) - startNs;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+
+            /* Host to modem. */
+            startNs = Bench_TimeNs();
+
+            if( ( ret == EXIT_SUCCESS ) &&
+                ( ( CellularCommInterface.send( commInterfaceHandle, command, sizeof( command ) - 1U,
+                                                BENCH_TIMEOUT_MS, &sentLength ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+                  ( poll( &masterPollFd, 1, BENCH_TIMEOUT_MS ) != 1 ) ) )
+            {
+                ( void ) fprintf( stderr, "Command %u not sent\n", i );
+                ret = EXIT_FAILURE;
+            }
+            else if( ( ret == EXIT_SUCCESS ) && ( i >= BENCH_WARMUP_ITERATIONS ) )
+            {
+                pTxSamples[ i - BENCH_WARMUP_ITERATIONS ] = Bench_TimeNs() - startNs;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+
+            while( read( masterFd, peerBuffer, sizeof( peerBuffer ) ) > 0 )
+            {
+            }
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "comm_if_posix.c on %s, %u byte responses%s, RX_COALESCE %d\n",
+                         slaveName, responseSize, ( prompt == true ) ? " ending with the prompt" : "",
+                         CELLULAR_COMM_INTERFACE_RX_COALESCE );
+        Bench_ReportLatency( "write to receive callback", pRxSamples, iterations );
+        Bench_ReportLatency( "send to peer readable", pTxSamples, iterations );
+        ( void ) printf( "receive callbacks per KB: %.2f\n",
+                         ( double ) __atomic_load_n( &callbackCount, __ATOMIC_RELAXED ) * 1024.0 /
+                         ( ( double ) responseSize * ( double ) iterations ) );
+    }
+
+    if( commInterfaceHandle != NULL )
+    {
+        ( void ) CellularCommInterface.close( commInterfaceHandle );
+    }
+
+    if( masterFd >= 0 )
+    {
+        ( void ) close( masterFd );
+    }
+
+    free( pRxSamples );
+    free( pTxSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,398 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_trace_overhead.c
+ * @brief Cost of the wire trace of comm_if_trace.h.
+ *
+ * First CommTrace_Record is timed alone for reads of 1 to 1024 bytes, and
+ * its cost per byte is given as a share of one core at the line rate.
+ * Then a writer thread streams data into a pty as fast as it can and the
+ * receive callback reads it with recv, checking every byte. The throughput
+ * and the CPU time of the process per MB are printed. The benchmark is built
+ * twice, comm_trace_overhead with the trace and comm_trace_overhead_off with
+ * CELLULAR_COMM_TRACE_ENABLE 0, so the two stream results give the overhead
+ * of the trace in comm_if_posix.c. With -d a thread dumps the trace to a
+ * file every 2 ms during the stream, as a dump on demand would.
+ *
+ * Usage: comm_trace_overhead [-m MB] [-b baud] [-d]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+/* Wire trace include file. */
+#include "comm_if_trace.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default data streamed through the pty in MB. */
+#define BENCH_DEFAULT_MB              ( 64U )
+
+/* Default line rate the record cost is compared with. */
+#define BENCH_DEFAULT_BAUD            ( 115200U )
+
+/* Calls of CommTrace_Record timed for each read size. */
+#define BENCH_RECORD_ITERATIONS       ( 2000000U )
+
+/* Data pattern period, prime so it does not line up with any buffer size. */
+#define BENCH_PATTERN_PERIOD          ( 251U )
+
+/* Interval of the dump thread. */
+#define BENCH_DUMP_INTERVAL_US        ( 2000U )
+
+/* File written by the dump thread. */
+#define BENCH_DUMP_PATH               "comm_trace_overhead.ccap"
+
+/*-----------------------------------------------------------*/
+
+static int masterFd = -1;
+static size_t streamLength = 0;
+
+/* Set by the receive callback, cleared by the reader. */
+static pthread_mutex_t receiveMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t receiveCondition = PTHREAD_COND_INITIALIZER;
+static bool receivePending = false;
+
+static volatile bool dumpStop = false;
+static uint32_t dumpCount = 0;
+static uint32_t dumpFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+
+/**
+ * @brief Time CommTrace_Record alone.
+ */
+static void prvRecordCost( uint32_t baud );
+
+#endif
+
+/**
+ * @brief Writer thread. Streams the pattern into the pty master.
+ */
+static void * prvWriterThread( void * pArgument );
+
+/**
+ * @brief Dump thread. Writes the trace of instance 0 until dumpStop.
+ */
+static void * prvDumpThread( void * pArgument );
+
+/**
+ * @brief Receive callback of the comm interface.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/*-----------------------------------------------------------*/
+
+#if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+
+static void prvRecordCost( uint32_t baud )
+{
+    static const uint32_t readSizes[] = { 1U, 16U, 64U, 256U, 1024U };
+    static CommTrace_t trace;
+    static uint8_t data[ 1024 ];
+    uint64_t startNs = 0;
+    double callNs = 0;
+    uint32_t i = 0;
+    uint32_t k = 0;
+
+    ( void ) printf( "CommTrace_Record, share of a core at %u baud\n", baud );
+
+    for( k = 0; k < ( sizeof( readSizes ) / sizeof( readSizes[ 0 ] ) ); k++ )
+    {
+        startNs = Bench_TimeNs();
+
+        for( i = 0; i < BENCH_RECORD_ITERATIONS; i++ )
+        {
+            CommTrace_Record( &trace, COMM_TRACE_RX, data, readSizes[ k ] );
+        }
+
+        callNs = ( double ) ( Bench_TimeNs() - startNs ) / ( double ) BENCH_RECORD_ITERATIONS;
+
+        /* 10 bits per byte with start and stop bits. */
+        ( void ) printf( "  %4u byte reads %8.1f ns/call %8.2f ns/byte %8.4f %%\n",
+                         readSizes[ k ], callNs, callNs / readSizes[ k ],
+                         callNs / readSizes[ k ] * ( ( double ) baud / 10.0 ) / 1e9 * 100.0 );
+    }
+}
+
+#endif /* CELLULAR_COMM_TRACE_ENABLE == 1 */
+
+/*-----------------------------------------------------------*/
+
+static void * prvWriterThread( void * pArgument )
+{
+    uint8_t buffer[ 4096 ];
+    size_t position = 0;
+    size_t length = 0;
+    ssize_t written = 0;
+    size_t i = 0;
+
+    ( void ) pArgument;
+
+    while( position < streamLength )
+    {
+        length = ( ( streamLength - position ) < sizeof( buffer ) ) ? ( streamLength - position ) : sizeof( buffer );
+
+        for( i = 0; i < length; i++ )
+        {
+            buffer[ i ] = ( uint8_t ) ( ( position + i ) % BENCH_PATTERN_PERIOD );
+        }
+
+        written = write( masterFd, buffer, length );
+
+        if( written > 0 )
+        {
+            position = position + ( size_t ) written;
+        }
+        else if( ( written < 0 ) && ( errno == EAGAIN ) )
+        {
+            ( void ) usleep( 50 );
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static void * prvDumpThread( void * pArgument )
+{
+    ( void ) pArgument;
+
+    while( dumpStop == false )
+    {
+        #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+            if( CellularCommInterface_DumpTrace( 0, BENCH_DUMP_PATH ) == IOT_COMM_INTERFACE_SUCCESS )
+            {
+                dumpCount++;
+            }
+            else
+            {
+                dumpFailures++;
+            }
+        #endif
+
+        ( void ) usleep( BENCH_DUMP_INTERVAL_US );
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    ( void ) pUserData;
+    ( void ) commInterfaceHandle;
+
+    ( void ) pthread_mutex_lock( &receiveMutex );
+    receivePending = true;
+    ( void ) pthread_cond_signal( &receiveCondition );
+    ( void ) pthread_mutex_unlock( &receiveMutex );
+
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static uint8_t buffer[ 8192 ];
+    char slaveName[ 64 ];
+    CellularCommInterfaceHandle_t commInterfaceHandle = NULL;
+    pthread_t writerThread;
+    pthread_t dumpThread;
+    struct timespec cpuTime = { 0 };
+    struct timespec deadline = { 0 };
+    uint64_t startNs = 0;
+    double elapsedS = 0;
+    double cpuStartS = 0;
+    double cpuS = 0;
+    size_t received = 0;
+    uint32_t mismatches = 0;
+    uint32_t readLength = 0;
+    uint32_t megabytes = BENCH_DEFAULT_MB;
+    uint32_t baud = BENCH_DEFAULT_BAUD;
+    uint32_t i = 0;
+    bool dump = false;
+    bool stalled = false;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "m:b:d" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'm':
+                megabytes = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'b':
+                baud = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'd':
+                dump = true;
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( megabytes == 0U ) || ( baud == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-m MB] [-b baud] [-d]\n", argv[ 0 ] );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        #if ( CELLULAR_COMM_TRACE_ENABLE == 1 )
+            prvRecordCost( baud );
+        #endif
+
+        streamLength = ( size_t ) megabytes << 20;
+        masterFd = Bench_OpenPty( slaveName, sizeof( slaveName ) );
+
+        if( ( masterFd < 0 ) ||
+            ( CellularCommInterface_SetPort( 0, slaveName ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+            ( CellularCommInterface.open( prvReceiveCallback, NULL, &commInterfaceHandle ) != IOT_COMM_INTERFACE_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Setup of the comm interface on %s failed\n", slaveName );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &cpuTime );
+        cpuStartS = ( double ) cpuTime.tv_sec + ( ( double ) cpuTime.tv_nsec / 1e9 );
+        startNs = Bench_TimeNs();
+        ( void ) pthread_create( &writerThread, NULL, prvWriterThread, NULL );
+
+        if( dump == true )
+        {
+            ( void ) pthread_create( &dumpThread, NULL, prvDumpThread, NULL );
+        }
+
+        while( ( received < streamLength ) && ( stalled == false ) )
+        {
+            ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+            deadline.tv_sec += 5;
+            ( void ) pthread_mutex_lock( &receiveMutex );
+
+            while( ( receivePending == false ) && ( stalled == false ) )
+            {
+                stalled = ( pthread_cond_timedwait( &receiveCondition, &receiveMutex, &deadline ) == ETIMEDOUT );
+            }
+
+            receivePending = false;
+            ( void ) pthread_mutex_unlock( &receiveMutex );
+
+            do
+            {
+                ( void ) CellularCommInterface.recv( commInterfaceHandle, buffer, sizeof( buffer ), 0, &readLength );
+
+                for( i = 0; i < readLength; i++ )
+                {
+                    if( buffer[ i ] != ( uint8_t ) ( ( received + i ) % BENCH_PATTERN_PERIOD ) )
+                    {
+                        mismatches++;
+                    }
+                }
+
+                received = received + readLength;
+            } while( readLength > 0U );
+        }
+
+        elapsedS = ( double ) ( Bench_TimeNs() - startNs ) / 1e9;
+        ( void ) clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &cpuTime );
+        cpuS = ( double ) cpuTime.tv_sec + ( ( double ) cpuTime.tv_nsec / 1e9 ) - cpuStartS;
+
+        dumpStop = true;
+        ( void ) pthread_join( writerThread, NULL );
+
+        if( dump == true )
+        {
+            ( void ) pthread_join( dumpThread, NULL );
+        }
+
+        ( void ) printf( "trace %s, %u MB through %s in %.3f s: %.1f MB/s, %.1f ms CPU/MB, %u bytes differ",
+                         ( CELLULAR_COMM_TRACE_ENABLE == 1 ) ? "on" : "off", megabytes, slaveName, elapsedS,
+                         ( double ) received / elapsedS / 1e6, cpuS * 1000.0 / ( double ) megabytes, mismatches );
+
+        if( dump == true )
+        {
+            ( void ) printf( ", %u dumps, %u failed", dumpCount, dumpFailures );
+        }
+
+        ( void ) printf( "\n" );
+
+        if( ( stalled == true ) || ( mismatches > 0U ) )
+        {
+            ( void ) fprintf( stderr, "Stream %s\n", ( stalled == true ) ? "stalled" : "corrupted" );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( commInterfaceHandle != NULL )
+    {
+        ( void ) CellularCommInterface.close( commInterfaceHandle );
+    }
+
+    if( masterFd >= 0 )
+    {
+        ( void ) close( masterFd );
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
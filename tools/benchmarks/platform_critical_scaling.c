@@ -0,0 +1,279 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/**
+ * @file platform_critical_scaling.c
+ * @brief Throughput of the platform layer's critical sections with 1 to 16 threads.
+ *
+ * The POSIX port of the kernel API implements taskENTER_CRITICAL with one
+ * process-wide mutex, like a critical section on a single core target. Every
+ * path of cellular_platform.c that takes it, such as the slab allocator, the
+ * heap tags, the notification event groups, the mutex profiler and the
+ * worker pool, serializes with all the others. Each round starts 1, 2, 4 and
+ * so on threads up to the limit. In the first rounds every thread allocates
+ * and frees 48 bytes with Platform_Malloc and Platform_Free from the slab
+ * allocator in a loop. The next rounds only enter and exit the critical
+ * section around a counter of the thread, and the last ones lock and unlock
+ * a pthread mutex of the thread instead, which is what per-object locks would
+ * cost. The benchmark prints the total operations per second and the time per
+ * operation for each thread count. On a single CPU the threads take turns, so
+ * only a host with several cores shows how the critical section scales.
+ *
+ * Usage: platform_critical_scaling [-n operations per thread] [-t most threads]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <getopt.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Platform layer include. */
+#include "cellular_platform.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of operations of each thread. */
+#define BENCH_DEFAULT_OPERATIONS    ( 1000000U )
+
+/* Default and largest thread count. */
+#define BENCH_MAX_THREADS           ( 16U )
+
+/* Size of the allocations, served by the 64 byte class. */
+#define BENCH_BLOCK_SIZE            ( 48U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Operation of the threads of a round.
+ */
+typedef enum BenchMode
+{
+    BENCH_MODE_SLAB = 0,         /* Platform_Malloc and Platform_Free. */
+    BENCH_MODE_CRITICAL_SECTION, /* Empty critical section. */
+    BENCH_MODE_PER_OBJECT,       /* Empty lock of the thread's own mutex. */
+    BENCH_MODE_COUNT
+} BenchMode_t;
+
+/**
+ * @brief State of a thread of a round.
+ */
+typedef struct BenchThread
+{
+    pthread_t thread;
+    pthread_mutex_t mutex; /* Lock of the thread's own object. */
+    BenchMode_t mode;      /* Operation of the round. */
+    uint32_t counter;      /* Updated under the lock. */
+    bool failed;           /* An allocation failed. */
+} BenchThread_t;
+
+/*-----------------------------------------------------------*/
+
+static BenchThread_t benchThreads[ BENCH_MAX_THREADS ];
+static pthread_barrier_t startBarrier;
+static uint32_t operationsPerThread = BENCH_DEFAULT_OPERATIONS;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run operationsPerThread operations of the round.
+ */
+static void * prvThread( void * pArgument );
+
+/**
+ * @brief Run a round of threadCount threads.
+ *
+ * @return Nanoseconds from the start of the threads until all have finished. 0 on error.
+ */
+static uint64_t prvRunRound( uint32_t threadCount,
+                             BenchMode_t mode );
+
+/*-----------------------------------------------------------*/
+
+static void * prvThread( void * pArgument )
+{
+    BenchThread_t * pBenchThread = ( BenchThread_t * ) pArgument;
+    void * pBlock = NULL;
+    uint32_t i = 0;
+
+    ( void ) pthread_barrier_wait( &startBarrier );
+
+    for( i = 0; i < operationsPerThread; i++ )
+    {
+        if( pBenchThread->mode == BENCH_MODE_SLAB )
+        {
+            pBlock = Platform_Malloc( BENCH_BLOCK_SIZE );
+
+            if( pBlock == NULL )
+            {
+                pBenchThread->failed = true;
+            }
+
+            Platform_Free( pBlock );
+        }
+        else if( pBenchThread->mode == BENCH_MODE_CRITICAL_SECTION )
+        {
+            taskENTER_CRITICAL();
+            pBenchThread->counter++;
+            taskEXIT_CRITICAL();
+        }
+        else
+        {
+            ( void ) pthread_mutex_lock( &pBenchThread->mutex );
+            pBenchThread->counter++;
+            ( void ) pthread_mutex_unlock( &pBenchThread->mutex );
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvRunRound( uint32_t threadCount,
+                             BenchMode_t mode )
+{
+    uint64_t startNs = 0;
+    uint64_t elapsedNs = 0;
+    uint32_t started = 0;
+    uint32_t i = 0;
+    bool failed = false;
+
+    ( void ) pthread_barrier_init( &startBarrier, NULL, threadCount + 1U );
+
+    for( started = 0; started < threadCount; started++ )
+    {
+        benchThreads[ started ].mode = mode;
+        benchThreads[ started ].failed = false;
+
+        if( pthread_create( &benchThreads[ started ].thread, NULL, prvThread, &benchThreads[ started ] ) != 0 )
+        {
+            break;
+        }
+    }
+
+    if( started != threadCount )
+    {
+        /* The started threads wait at the barrier forever, give up. */
+        ( void ) fprintf( stderr, "Thread %u not started\n", started );
+        exit( EXIT_FAILURE );
+    }
+
+    ( void ) pthread_barrier_wait( &startBarrier );
+    startNs = Bench_TimeNs();
+
+    for( i = 0; i < threadCount; i++ )
+    {
+        ( void ) pthread_join( benchThreads[ i ].thread, NULL );
+        failed = failed || benchThreads[ i ].failed;
+    }
+
+    elapsedNs = Bench_TimeNs() - startNs;
+    ( void ) pthread_barrier_destroy( &startBarrier );
+
+    return ( failed == true ) ? 0U : elapsedNs;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static const char * const pModes[ BENCH_MODE_COUNT ] = { "slab", "critical section", "per-object mutex" };
+    uint64_t elapsedNs = 0;
+    uint32_t maxThreads = BENCH_MAX_THREADS;
+    uint32_t threadCount = 0;
+    uint32_t i = 0;
+    BenchMode_t mode = BENCH_MODE_SLAB;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "n:t:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                operationsPerThread = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 't':
+                maxThreads = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( operationsPerThread == 0U ) || ( maxThreads == 0U ) || ( maxThreads > BENCH_MAX_THREADS ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n operations per thread] [-t most threads, 1 to %u]\n", argv[ 0 ], BENCH_MAX_THREADS );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        for( i = 0; i < BENCH_MAX_THREADS; i++ )
+        {
+            ( void ) pthread_mutex_init( &benchThreads[ i ].mutex, NULL );
+        }
+
+        ( void ) printf( "Critical sections of the POSIX port, %u operations per thread, %ld CPUs online\n",
+                         operationsPerThread, sysconf( _SC_NPROCESSORS_ONLN ) );
+    }
+
+    for( mode = BENCH_MODE_SLAB; ( mode < BENCH_MODE_COUNT ) && ( ret == EXIT_SUCCESS ); mode++ )
+    {
+        for( threadCount = 1; ( threadCount <= maxThreads ) && ( ret == EXIT_SUCCESS ); threadCount = threadCount * 2U )
+        {
+            elapsedNs = prvRunRound( threadCount, mode );
+
+            if( elapsedNs == 0U )
+            {
+                ( void ) fprintf( stderr, "Allocation failed with %u threads\n", threadCount );
+                ret = EXIT_FAILURE;
+            }
+            else
+            {
+                ( void ) printf( "%-16s threads %2u: %8.2f M operations/s, %7.1f ns per operation of a thread\n",
+                                 pModes[ mode ], threadCount,
+                                 ( double ) threadCount * ( double ) operationsPerThread * 1000.0 / ( double ) elapsedNs,
+                                 ( double ) elapsedNs / ( double ) operationsPerThread );
+            }
+        }
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
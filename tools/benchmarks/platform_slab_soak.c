@@ -0,0 +1,380 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file platform_slab_soak.c
+ * @brief Allocation latency and heap fragmentation of Platform_Malloc in a soak.
+ *
+ * Each simulated AT transaction allocates what the cellular library does for
+ * a command: a response of 24 bytes, one to four response lines of 16 bytes
+ * with their strings of 8 to 207 bytes, and sometimes a token. It frees them
+ * in reverse order. Every 200 transactions on average one of the long-lived
+ * objects, a socket buffer of 1500 bytes, a URC copy of 300 to 363 bytes or
+ * a context of 200 bytes, is replaced. The sizes come from a fixed seed, so
+ * both builds run the same sequence.
+ *
+ * The heap is the heap_4 model of bench_heap.c. platform_slab_soak is built
+ * with PLATFORM_MALLOC_SLAB_ENABLE 1 and platform_slab_soak_heap4 with 0, so
+ * Platform_Malloc goes straight to the heap. Latency is sampled on every
+ * eighth allocation and free. The free blocks and the largest free block of
+ * the heap are printed at each quarter of the run.
+ *
+ * Usage: platform_slab_soak [-n transactions] [-l long-lived objects]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* FreeRTOS include. */
+#include "FreeRTOS.h"
+
+/* Platform layer include. */
+#include "cellular_platform.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of simulated AT transactions. */
+#define BENCH_DEFAULT_TRANSACTIONS    ( 2000000U )
+
+/* Default number of long-lived objects. A third of them are 200 bytes and
+ * stay in the 256 byte class, so the default PLATFORM_SLAB_BLOCKS_256 also
+ * covers the transactions. */
+#define BENCH_DEFAULT_LONG_LIVED      ( 8U )
+
+/* Most long-lived objects. */
+#define BENCH_MAX_LONG_LIVED          ( 1024U )
+
+/* Most allocations of a transaction. */
+#define BENCH_MAX_TRANSACTION_BLOCKS  ( 10U )
+
+/* One allocation and free of this many is timed. */
+#define BENCH_SAMPLE_INTERVAL         ( 8U )
+
+/* Most latency samples kept of each kind. */
+#define BENCH_MAX_SAMPLES             ( 1048576U )
+
+/* Fixed seed of the sizes. */
+#define BENCH_SEED                    ( 12345U )
+
+/*-----------------------------------------------------------*/
+
+static uint32_t randomState = BENCH_SEED;
+
+static uint64_t * pMallocSamples = NULL;
+static uint64_t * pFreeSamples = NULL;
+static uint32_t mallocSampleCount = 0;
+static uint32_t freeSampleCount = 0;
+static uint64_t operationCount = 0;
+
+/* Live allocations and their peak by the smallest size class that fits them,
+ * whether the slab or the heap serves them. */
+static uint32_t liveDemand[ PLATFORM_SLAB_CLASSES ];
+static uint32_t peakDemand[ PLATFORM_SLAB_CLASSES ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief xorshift32, the same sequence on every host.
+ */
+static uint32_t prvRandom( void );
+
+/**
+ * @brief Smallest size class that fits size, PLATFORM_SLAB_CLASSES for larger sizes.
+ */
+static uint32_t prvSizeClass( size_t size );
+
+/**
+ * @brief Platform_Malloc with a latency sample on every BENCH_SAMPLE_INTERVAL call.
+ */
+static void * prvMalloc( size_t size );
+
+/**
+ * @brief Platform_Free with a latency sample on every BENCH_SAMPLE_INTERVAL call.
+ *
+ * size is the size the block was allocated with, 0 for NULL.
+ */
+static void prvFree( void * pBlock,
+                     size_t size );
+
+/**
+ * @brief Print the state of the heap.
+ */
+static void prvReportHeap( const char * pLabel );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+
+    return randomState;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSizeClass( size_t size )
+{
+    uint32_t sizeClass = 0;
+
+    while( ( sizeClass < PLATFORM_SLAB_CLASSES ) && ( size > ( 32U << sizeClass ) ) )
+    {
+        sizeClass++;
+    }
+
+    return sizeClass;
+}
+
+/*-----------------------------------------------------------*/
+
+static void * prvMalloc( size_t size )
+{
+    uint64_t startNs = 0;
+    void * pBlock = NULL;
+    uint32_t sizeClass = prvSizeClass( size );
+
+    operationCount++;
+
+    if( sizeClass < PLATFORM_SLAB_CLASSES )
+    {
+        liveDemand[ sizeClass ]++;
+
+        if( liveDemand[ sizeClass ] > peakDemand[ sizeClass ] )
+        {
+            peakDemand[ sizeClass ] = liveDemand[ sizeClass ];
+        }
+    }
+
+    if( ( ( operationCount % BENCH_SAMPLE_INTERVAL ) == 0U ) && ( mallocSampleCount < BENCH_MAX_SAMPLES ) )
+    {
+        startNs = Bench_TimeNs();
+        pBlock = Platform_Malloc( size );
+        pMallocSamples[ mallocSampleCount ] = Bench_TimeNs() - startNs;
+        mallocSampleCount++;
+    }
+    else
+    {
+        pBlock = Platform_Malloc( size );
+    }
+
+    return pBlock;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvFree( void * pBlock,
+                     size_t size )
+{
+    uint64_t startNs = 0;
+    uint32_t sizeClass = prvSizeClass( size );
+
+    if( ( pBlock != NULL ) && ( sizeClass < PLATFORM_SLAB_CLASSES ) )
+    {
+        liveDemand[ sizeClass ]--;
+    }
+
+    if( ( ( operationCount % BENCH_SAMPLE_INTERVAL ) == 1U ) && ( freeSampleCount < BENCH_MAX_SAMPLES ) )
+    {
+        startNs = Bench_TimeNs();
+        Platform_Free( pBlock );
+        pFreeSamples[ freeSampleCount ] = Bench_TimeNs() - startNs;
+        freeSampleCount++;
+    }
+    else
+    {
+        Platform_Free( pBlock );
+    }
+
+    operationCount++;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvReportHeap( const char * pLabel )
+{
+    HeapStats_t heapStats = { 0 };
+
+    vPortGetHeapStats( &heapStats );
+    ( void ) printf( "%-32s free %8zu B in %4zu blocks, largest %8zu B, heap allocations %zu\n",
+                     pLabel, heapStats.xAvailableHeapSpaceInBytes, heapStats.xNumberOfFreeBlocks,
+                     heapStats.xSizeOfLargestFreeBlockInBytes, heapStats.xNumberOfSuccessfulAllocations );
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static void * pLongLived[ BENCH_MAX_LONG_LIVED ];
+    static size_t longLivedSizes[ BENCH_MAX_LONG_LIVED ];
+    void * pBlocks[ BENCH_MAX_TRANSACTION_BLOCKS ];
+    size_t blockSizes[ BENCH_MAX_TRANSACTION_BLOCKS ];
+    char label[ 32 ];
+    uint32_t transactions = BENCH_DEFAULT_TRANSACTIONS;
+    uint32_t longLived = BENCH_DEFAULT_LONG_LIVED;
+    uint32_t blockCount = 0;
+    uint32_t lines = 0;
+    uint32_t choice = 0;
+    uint32_t index = 0;
+    uint32_t i = 0;
+    uint32_t k = 0;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    #if ( PLATFORM_MALLOC_SLAB_ENABLE == 1 )
+        PlatformSlabStats_t slabStats = { 0 };
+        PlatformSlabClassStats_t * pClass = NULL;
+    #endif
+
+    while( ( option = getopt( argc, argv, "n:l:" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'n':
+                transactions = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'l':
+                longLived = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( transactions < 4U ) || ( longLived == 0U ) || ( longLived > BENCH_MAX_LONG_LIVED ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n transactions, 4 or more] [-l long-lived objects, 1 to %u]\n",
+                          argv[ 0 ], BENCH_MAX_LONG_LIVED );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pMallocSamples = malloc( BENCH_MAX_SAMPLES * sizeof( uint64_t ) );
+        pFreeSamples = malloc( BENCH_MAX_SAMPLES * sizeof( uint64_t ) );
+
+        if( ( pMallocSamples == NULL ) || ( pFreeSamples == NULL ) )
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "Platform_Malloc, PLATFORM_MALLOC_SLAB_ENABLE %d, %u transactions, %u long-lived objects\n",
+                         PLATFORM_MALLOC_SLAB_ENABLE, transactions, longLived );
+
+        for( k = 0; ( k < transactions ) && ( ret == EXIT_SUCCESS ); k++ )
+        {
+            blockCount = 0;
+            blockSizes[ blockCount++ ] = 24U;
+            lines = 1U + ( prvRandom() % 4U );
+
+            for( i = 0; i < lines; i++ )
+            {
+                blockSizes[ blockCount++ ] = 16U;
+                blockSizes[ blockCount++ ] = 8U + ( prvRandom() % ( ( ( prvRandom() % 8U ) != 0U ) ? 56U : 200U ) );
+            }
+
+            if( ( prvRandom() % 4U ) == 0U )
+            {
+                blockSizes[ blockCount++ ] = 4U + ( prvRandom() % 28U );
+            }
+
+            for( i = 0; i < blockCount; i++ )
+            {
+                pBlocks[ i ] = prvMalloc( blockSizes[ i ] );
+            }
+
+            if( ( prvRandom() % 200U ) == 0U )
+            {
+                index = prvRandom() % longLived;
+                prvFree( pLongLived[ index ], longLivedSizes[ index ] );
+                choice = prvRandom() % 3U;
+                longLivedSizes[ index ] = ( choice == 0U ) ? 1500U : ( ( choice == 1U ) ? ( 300U + ( prvRandom() % 64U ) ) : 200U );
+                pLongLived[ index ] = prvMalloc( longLivedSizes[ index ] );
+            }
+
+            for( i = blockCount; i > 0U; i-- )
+            {
+                if( pBlocks[ i - 1U ] == NULL )
+                {
+                    ( void ) fprintf( stderr, "Allocation failed in transaction %u\n", k );
+                    ret = EXIT_FAILURE;
+                }
+
+                prvFree( pBlocks[ i - 1U ], blockSizes[ i - 1U ] );
+            }
+
+            if( ( ( k + 1U ) % ( transactions / 4U ) ) == 0U )
+            {
+                ( void ) snprintf( label, sizeof( label ), "heap after %u", k + 1U );
+                prvReportHeap( label );
+            }
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        Bench_ReportLatencyNs( "Platform_Malloc", pMallocSamples, mallocSampleCount );
+        Bench_ReportLatencyNs( "Platform_Free", pFreeSamples, freeSampleCount );
+
+        #if ( PLATFORM_MALLOC_SLAB_ENABLE == 1 )
+            Platform_GetSlabStats( &slabStats );
+
+            for( i = 0; i < PLATFORM_SLAB_CLASSES; i++ )
+            {
+                pClass = &slabStats.classes[ i ];
+                ( void ) printf( "class %3u x %3u: allocations %9u misses %8u hit %6.2f %% high-water %3u peak demand %u\n",
+                                 pClass->blockSize, pClass->blockCount, pClass->allocations, pClass->misses,
+                                 ( ( pClass->allocations + pClass->misses ) == 0U ) ? 0.0 :
+                                 100.0 * ( double ) pClass->allocations / ( double ) ( pClass->allocations + pClass->misses ),
+                                 pClass->highWater, peakDemand[ i ] );
+            }
+
+            ( void ) printf( "larger than the classes: %u\n", slabStats.heapAllocations );
+        #endif
+    }
+
+    for( i = 0; i < longLived; i++ )
+    {
+        Platform_Free( pLongLived[ i ] );
+    }
+
+    free( pMallocSamples );
+    free( pFreeSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
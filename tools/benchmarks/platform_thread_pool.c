@@ -0,0 +1,261 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file platform_thread_pool.c
+ * @brief Spawn latency and heap use of Platform_CreateDetachedThread.
+ *
+ * Each iteration spawns a short routine and waits for it to run. The latency
+ * is the time from the call to the start of the routine. Before each spawn a
+ * long-lived allocation of the library is replaced, one of 16 kept at any
+ * time, so task stacks and control blocks are interleaved with other blocks
+ * as on a device. The heap is the heap_4 model of bench_heap.c, and xTaskCreate
+ * takes the task's stack from it. The free heap, its free blocks and the
+ * largest free block are reported before and after the spawns.
+ *
+ * platform_thread_pool runs the routines on the worker pool of the default
+ * size. platform_thread_pool_off is built with PLATFORM_THREAD_POOL_SIZE 0,
+ * so every routine gets a task of its own.
+ *
+ * Usage: platform_thread_pool [-n spawns]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <errno.h>
+#include <getopt.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* FreeRTOS include. */
+#include "FreeRTOS.h"
+
+/* Platform layer include. */
+#include "cellular_platform.h"
+
+#include "bench_common.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured spawns. */
+#define BENCH_DEFAULT_SPAWNS         ( 10000U )
+
+/* Spawns before the measurement, they create the workers of the pool. */
+#define BENCH_WARMUP_SPAWNS          ( 100U )
+
+/* Long-lived allocations kept between the spawns. */
+#define BENCH_KEPT_ALLOCATIONS       ( 16U )
+
+/* Time to wait for a routine to run. */
+#define BENCH_TIMEOUT_MS             ( 1000 )
+
+/* Time for the last deleted tasks to free their stacks. */
+#define BENCH_SETTLE_US              ( 100000U )
+
+/*-----------------------------------------------------------*/
+
+/* Posted by the routine. */
+static sem_t routineSemaphore;
+
+/* Start time of the routine of the current spawn. */
+static uint64_t routineStartNs = 0;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Short routine of a spawn.
+ */
+static void prvRoutine( void * pArgument );
+
+/**
+ * @brief Spawn prvRoutine and wait for it to run.
+ *
+ * @return Spawn latency in ns. 0 if the spawn failed.
+ */
+static uint64_t prvSpawn( void );
+
+/**
+ * @brief Print the state of the heap.
+ */
+static void prvReportHeap( const char * pLabel );
+
+/*-----------------------------------------------------------*/
+
+static void prvRoutine( void * pArgument )
+{
+    ( void ) pArgument;
+
+    __atomic_store_n( &routineStartNs, Bench_TimeNs(), __ATOMIC_RELEASE );
+    ( void ) sem_post( &routineSemaphore );
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvSpawn( void )
+{
+    struct timespec deadline = { 0 };
+    uint64_t startNs = Bench_TimeNs();
+    uint64_t latencyNs = 0;
+    int waitResult = -1;
+
+    if( Platform_CreateDetachedThread( prvRoutine, NULL, PLATFORM_THREAD_DEFAULT_PRIORITY,
+                                       PLATFORM_THREAD_DEFAULT_STACK_SIZE ) == true )
+    {
+        ( void ) clock_gettime( CLOCK_REALTIME, &deadline );
+        deadline.tv_sec += BENCH_TIMEOUT_MS / 1000;
+
+        do
+        {
+            waitResult = sem_timedwait( &routineSemaphore, &deadline );
+        } while( ( waitResult != 0 ) && ( errno == EINTR ) );
+
+        if( waitResult == 0 )
+        {
+            latencyNs = __atomic_load_n( &routineStartNs, __ATOMIC_ACQUIRE ) - startNs;
+        }
+    }
+
+    return latencyNs;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvReportHeap( const char * pLabel )
+{
+    HeapStats_t heapStats = { 0 };
+
+    vPortGetHeapStats( &heapStats );
+    ( void ) printf( "%-32s free %8zu B in %4zu blocks, largest %8zu B, allocations %zu\n",
+                     pLabel, heapStats.xAvailableHeapSpaceInBytes, heapStats.xNumberOfFreeBlocks,
+                     heapStats.xSizeOfLargestFreeBlockInBytes, heapStats.xNumberOfSuccessfulAllocations );
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    void * pKept[ BENCH_KEPT_ALLOCATIONS ] = { NULL };
+    HeapStats_t heapStats = { 0 };
+    uint64_t * pSamples = NULL;
+    uint64_t startNs = 0;
+    double elapsedUs = 0;
+    size_t allocationsBefore = 0;
+    uint32_t spawns = BENCH_DEFAULT_SPAWNS;
+    uint32_t i = 0;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "n:" ) ) != -1 )
+    {
+        if( option == 'n' )
+        {
+            spawns = ( uint32_t ) strtoul( optarg, NULL, 10 );
+        }
+        else
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( spawns == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s [-n spawns]\n", argv[ 0 ] );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        pSamples = malloc( spawns * sizeof( uint64_t ) );
+        ( void ) sem_init( &routineSemaphore, 0, 0 );
+
+        for( i = 0; ( i < BENCH_WARMUP_SPAWNS ) && ( ret == EXIT_SUCCESS ); i++ )
+        {
+            if( prvSpawn() == 0U )
+            {
+                ret = EXIT_FAILURE;
+            }
+        }
+
+        if( ( pSamples == NULL ) || ( ret != EXIT_SUCCESS ) )
+        {
+            ( void ) fprintf( stderr, "Warm-up spawns failed\n" );
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) usleep( BENCH_SETTLE_US );
+        ( void ) printf( "Platform_CreateDetachedThread, PLATFORM_THREAD_POOL_SIZE %u, %u spawns\n",
+                         ( unsigned int ) PLATFORM_THREAD_POOL_SIZE, spawns );
+        prvReportHeap( "heap before" );
+        vPortGetHeapStats( &heapStats );
+        allocationsBefore = heapStats.xNumberOfSuccessfulAllocations;
+        startNs = Bench_TimeNs();
+
+        for( i = 0; ( i < spawns ) && ( ret == EXIT_SUCCESS ); i++ )
+        {
+            /* Sizes of AT response and socket blocks of the library. */
+            vPortFree( pKept[ i % BENCH_KEPT_ALLOCATIONS ] );
+            pKept[ i % BENCH_KEPT_ALLOCATIONS ] = pvPortMalloc( 48U + ( ( i % 7U ) * 32U ) );
+
+            pSamples[ i ] = prvSpawn();
+
+            if( pSamples[ i ] == 0U )
+            {
+                ( void ) fprintf( stderr, "Spawn %u failed\n", i );
+                ret = EXIT_FAILURE;
+            }
+        }
+
+        elapsedUs = ( double ) ( Bench_TimeNs() - startNs ) / 1000.0;
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) usleep( BENCH_SETTLE_US );
+        vPortGetHeapStats( &heapStats );
+        Bench_ReportLatency( "spawn to routine start", pSamples, spawns );
+        ( void ) printf( "%-32s %.1f us per spawn, %.2f heap allocations per spawn\n", "spawn and wait",
+                         elapsedUs / ( double ) spawns,
+                         ( double ) ( heapStats.xNumberOfSuccessfulAllocations - allocationsBefore - spawns ) / ( double ) spawns );
+        prvReportHeap( "heap after" );
+    }
+
+    for( i = 0; i < BENCH_KEPT_ALLOCATIONS; i++ )
+    {
+        vPortFree( pKept[ i ] );
+    }
+
+    free( pSamples );
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
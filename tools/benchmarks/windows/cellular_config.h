@@ -0,0 +1,65 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file cellular_config.h
+ * @brief Cellular config options of the Windows benchmarks.
+ *
+ * The benchmarks set the COM port of the comm interface at runtime with
+ * CellularCommInterface_SetPort, so the port list is empty.
+ */
+
+#ifndef __CELLULAR_CONFIG_H__
+#define __CELLULAR_CONFIG_H__
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+#include "logging_levels.h"
+
+/* Logging configuration for the benchmarks. Only errors, so logging does not
+ * take part in the measurement. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME    "Benchmark"
+#endif
+
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_ERROR
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+#define CELLULAR_COMM_INTERFACE_PORT_LIST    { NULL }
+
+#define CELLULAR_PDN_CONTEXT_ID_MIN          ( 0U )
+#define CELLULAR_PDN_CONTEXT_ID_MAX          ( 4U )
+
+#define CELLULAR_MAX_SEND_DATA_LEN           ( 1459U )
+#define CELLULAR_MAX_RECV_DATA_LEN           ( 1459U )
+
+#endif /* __CELLULAR_CONFIG_H__ */
@@ -0,0 +1,412 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file comm_if_windows_latency.c
+ * @brief Receive latency and idle wake-ups of the Windows comm interface.
+ *
+ * Two COM ports connected back to back, for example a com0com pair, stand in
+ * for the modem port. The comm interface opens the first one, the benchmark
+ * writes responses to the second one. The receive latency is the time from
+ * WriteFile on the peer port until comm_if_windows.c calls the receive
+ * callback from the simulated UART interrupt. Each iteration waits for the
+ * previous one to complete.
+ *
+ * The idle wake-ups are the task switches per second while the port is open
+ * with no traffic and the benchmark task sleeps, with the process CPU time in
+ * the same period. comm_if_windows_latency raises the UART interrupt from the
+ * receive thread, comm_if_windows_latency_poll keeps the 1 ms polling task of
+ * kernels older than V10.6.0, so the two give the numbers before and after.
+ *
+ * Usage: comm_if_windows_latency -p COM5 -q COM6 [-n iterations] [-i idle seconds]
+ */
+
+/*-----------------------------------------------------------*/
+
+#include <windows.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* Cellular comm interface include file. */
+#include "comm_if.h"
+
+/*-----------------------------------------------------------*/
+
+/* Default number of measured iterations. */
+#define BENCH_DEFAULT_ITERATIONS    ( 1000U )
+
+/* Iterations run before the measurement to warm up the threads. */
+#define BENCH_WARMUP_ITERATIONS     ( 20U )
+
+/* Default idle period in seconds. */
+#define BENCH_DEFAULT_IDLE_S        ( 10U )
+
+/* Time to wait for a response in ms. */
+#define BENCH_TIMEOUT_MS            ( 1000U )
+
+/* Stack of the benchmark task. */
+#define BENCH_TASK_STACK_SIZE       ( 1024U )
+
+/* Where comm_if_windows.c raises the UART interrupt, same selection as in the file. */
+#if ( defined( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD ) && ( COMM_IF_INTERRUPT_FROM_WINDOWS_THREAD == 0 ) ) || \
+    ( ( tskKERNEL_VERSION_MAJOR == 10 ) && ( tskKERNEL_VERSION_MINOR < 6 ) )
+    #define BENCH_INTERRUPT_SOURCE    "the polling task"
+#else
+    #define BENCH_INTERRUPT_SOURCE    "the receive thread"
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Counted by traceTASK_SWITCHED_IN in FreeRTOSConfig.h. */
+volatile uint32_t ulBenchTaskSwitches = 0;
+
+/* Options of the run. */
+static const char * pHostPort = NULL;
+static const char * pPeerPort = NULL;
+static uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+static uint32_t idleSeconds = BENCH_DEFAULT_IDLE_S;
+
+/* Given by the receive callback. */
+static SemaphoreHandle_t callbackSemaphore = NULL;
+
+/* Performance counter of the first receive callback of an iteration, 0 before it. */
+static volatile LONG64 callbackTicks = 0;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive callback of the comm interface, called from the UART interrupt.
+ */
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle );
+
+/**
+ * @brief Open the peer port of the COM pair.
+ *
+ * @return Handle of the port. INVALID_HANDLE_VALUE on error.
+ */
+static HANDLE prvOpenPeerPort( const char * pPortName );
+
+/**
+ * @brief Print the mean, percentiles and maximum of latency samples in us.
+ *
+ * The samples are sorted in place.
+ */
+static void prvReportLatency( const char * pLabel,
+                              uint64_t * pSamplesTicks,
+                              uint32_t count,
+                              uint64_t ticksPerSecond );
+
+/**
+ * @brief Task running the measurements. Ends the process.
+ */
+static void prvBenchmarkTask( void * pParameters );
+
+/*-----------------------------------------------------------*/
+
+static CellularCommInterfaceError_t prvReceiveCallback( void * pUserData,
+                                                        CellularCommInterfaceHandle_t commInterfaceHandle )
+{
+    LARGE_INTEGER now = { 0 };
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+    ( void ) pUserData;
+    ( void ) commInterfaceHandle;
+
+    ( void ) QueryPerformanceCounter( &now );
+    ( void ) InterlockedCompareExchange64( &callbackTicks, now.QuadPart, 0 );
+    ( void ) xSemaphoreGiveFromISR( callbackSemaphore, &higherPriorityTaskWoken );
+
+    /* The UART interrupt switches to the woken task when the callback succeeds. */
+    return IOT_COMM_INTERFACE_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+
+static HANDLE prvOpenPeerPort( const char * pPortName )
+{
+    char portPath[ 64 ];
+    COMMTIMEOUTS timeouts = { 0 };
+    DCB dcb = { 0 };
+    HANDLE hPort = INVALID_HANDLE_VALUE;
+
+    ( void ) snprintf( portPath, sizeof( portPath ), "\\\\.\\%s", pPortName );
+    hPort = CreateFileA( portPath, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL );
+
+    if( hPort != INVALID_HANDLE_VALUE )
+    {
+        dcb.DCBlength = sizeof( dcb );
+
+        if( GetCommState( hPort, &dcb ) == TRUE )
+        {
+            dcb.BaudRate = CBR_115200;
+            dcb.ByteSize = 8;
+            dcb.Parity = NOPARITY;
+            dcb.StopBits = ONESTOPBIT;
+            ( void ) SetCommState( hPort, &dcb );
+        }
+
+        /* Reads return at once, the benchmark only drains the port. */
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        ( void ) SetCommTimeouts( hPort, &timeouts );
+    }
+
+    return hPort;
+}
+
+/*-----------------------------------------------------------*/
+
+static int prvCompareSamples( const void * pLeft,
+                              const void * pRight )
+{
+    uint64_t left = *( ( const uint64_t * ) pLeft );
+    uint64_t right = *( ( const uint64_t * ) pRight );
+
+    return ( left > right ) - ( left < right );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvReportLatency( const char * pLabel,
+                              uint64_t * pSamplesTicks,
+                              uint32_t count,
+                              uint64_t ticksPerSecond )
+{
+    double usPerTick = 1000000.0 / ( double ) ticksPerSecond;
+    uint64_t sum = 0;
+    uint32_t i = 0;
+
+    qsort( pSamplesTicks, count, sizeof( uint64_t ), prvCompareSamples );
+
+    for( i = 0; i < count; i++ )
+    {
+        sum = sum + pSamplesTicks[ i ];
+    }
+
+    ( void ) printf( "%-32s n %6u  mean %9.1f us  p50 %9.1f us  p99 %9.1f us  max %9.1f us\n",
+                     pLabel, count,
+                     ( double ) sum / ( double ) count * usPerTick,
+                     ( double ) pSamplesTicks[ count / 2U ] * usPerTick,
+                     ( double ) pSamplesTicks[ ( ( uint64_t ) count * 99U ) / 100U ] * usPerTick,
+                     ( double ) pSamplesTicks[ count - 1U ] * usPerTick );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkTask( void * pParameters )
+{
+    static const char response[] = "OK\r\n";
+    uint8_t buffer[ 64 ];
+    CellularCommInterfaceHandle_t commInterfaceHandle = NULL;
+    LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER startTicks = { 0 };
+    FILETIME creationTime = { 0 };
+    FILETIME exitTime = { 0 };
+    FILETIME kernelTime[ 2 ] = { 0 };
+    FILETIME userTime[ 2 ] = { 0 };
+    ULARGE_INTEGER cpuTime[ 2 ] = { 0 };
+    HANDLE hPeer = INVALID_HANDLE_VALUE;
+    uint64_t * pSamples = NULL;
+    uint32_t switches = 0;
+    uint32_t readLength = 0;
+    uint32_t i = 0;
+    DWORD written = 0;
+    int ret = EXIT_SUCCESS;
+
+    ( void ) pParameters;
+
+    ( void ) QueryPerformanceFrequency( &frequency );
+    pSamples = malloc( iterations * sizeof( uint64_t ) );
+    callbackSemaphore = xSemaphoreCreateBinary();
+    hPeer = prvOpenPeerPort( pPeerPort );
+
+    if( ( pSamples == NULL ) || ( callbackSemaphore == NULL ) || ( hPeer == INVALID_HANDLE_VALUE ) ||
+        ( CellularCommInterface_SetPort( 0, pHostPort ) != IOT_COMM_INTERFACE_SUCCESS ) ||
+        ( CellularCommInterface.open( prvReceiveCallback, NULL, &commInterfaceHandle ) != IOT_COMM_INTERFACE_SUCCESS ) )
+    {
+        ( void ) fprintf( stderr, "Setup of the comm interface on %s with peer %s failed\n", pHostPort, pPeerPort );
+        ret = EXIT_FAILURE;
+    }
+
+    for( i = 0; ( i < ( iterations + BENCH_WARMUP_ITERATIONS ) ) && ( ret == EXIT_SUCCESS ); i++ )
+    {
+        InterlockedExchange64( &callbackTicks, 0 );
+        ( void ) QueryPerformanceCounter( &startTicks );
+
+        /* The benchmark task is the only one running, so it may call the
+         * Windows API directly for the short write of the peer. */
+        if( ( WriteFile( hPeer, response, sizeof( response ) - 1U, &written, NULL ) != TRUE ) ||
+            ( xSemaphoreTake( callbackSemaphore, pdMS_TO_TICKS( BENCH_TIMEOUT_MS ) ) != pdTRUE ) )
+        {
+            ( void ) fprintf( stderr, "Response %u not received\n", i );
+            ret = EXIT_FAILURE;
+        }
+        else
+        {
+            if( i >= BENCH_WARMUP_ITERATIONS )
+            {
+                pSamples[ i - BENCH_WARMUP_ITERATIONS ] = ( uint64_t ) ( InterlockedCompareExchange64( &callbackTicks, 0, 0 ) -
+                                                                         startTicks.QuadPart );
+            }
+
+            do
+            {
+                ( void ) CellularCommInterface.recv( commInterfaceHandle, buffer, sizeof( buffer ), 0, &readLength );
+            } while( readLength > 0U );
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        /* Nothing is received while the task sleeps, every switch is a wake-up of another task. */
+        ( void ) GetProcessTimes( GetCurrentProcess(), &creationTime, &exitTime, &kernelTime[ 0 ], &userTime[ 0 ] );
+        switches = ulBenchTaskSwitches;
+        vTaskDelay( pdMS_TO_TICKS( idleSeconds * 1000U ) );
+        switches = ulBenchTaskSwitches - switches;
+        ( void ) GetProcessTimes( GetCurrentProcess(), &creationTime, &exitTime, &kernelTime[ 1 ], &userTime[ 1 ] );
+
+        for( i = 0; i < 2U; i++ )
+        {
+            cpuTime[ i ].LowPart = kernelTime[ i ].dwLowDateTime;
+            cpuTime[ i ].HighPart = kernelTime[ i ].dwHighDateTime;
+            cpuTime[ i ].QuadPart += ( ( ULONGLONG ) userTime[ i ].dwHighDateTime << 32 ) | userTime[ i ].dwLowDateTime;
+        }
+
+        ( void ) printf( "comm_if_windows.c on %s, peer %s, UART interrupt from %s\n",
+                         pHostPort, pPeerPort, BENCH_INTERRUPT_SOURCE );
+        prvReportLatency( "write to receive callback", pSamples, iterations, ( uint64_t ) frequency.QuadPart );
+
+        /* FILETIME counts 100 ns units. */
+        ( void ) printf( "%-32s %9.1f switches/s  cpu %6.2f ms/s\n", "idle wake-ups",
+                         ( double ) switches / ( double ) idleSeconds,
+                         ( double ) ( cpuTime[ 1 ].QuadPart - cpuTime[ 0 ].QuadPart ) / 10000.0 / ( double ) idleSeconds );
+    }
+
+    if( commInterfaceHandle != NULL )
+    {
+        ( void ) CellularCommInterface.close( commInterfaceHandle );
+    }
+
+    if( hPeer != INVALID_HANDLE_VALUE )
+    {
+        ( void ) CloseHandle( hPeer );
+    }
+
+    free( pSamples );
+    ( void ) fflush( stdout );
+    exit( ret );
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    int i = 0;
+    int ret = EXIT_SUCCESS;
+
+    for( i = 1; ( i + 1 ) < argc; i = i + 2 )
+    {
+        if( strcmp( argv[ i ], "-p" ) == 0 )
+        {
+            pHostPort = argv[ i + 1 ];
+        }
+        else if( strcmp( argv[ i ], "-q" ) == 0 )
+        {
+            pPeerPort = argv[ i + 1 ];
+        }
+        else if( strcmp( argv[ i ], "-n" ) == 0 )
+        {
+            iterations = ( uint32_t ) strtoul( argv[ i + 1 ], NULL, 10 );
+        }
+        else if( strcmp( argv[ i ], "-i" ) == 0 )
+        {
+            idleSeconds = ( uint32_t ) strtoul( argv[ i + 1 ], NULL, 10 );
+        }
+        else
+        {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if( ( ret != EXIT_SUCCESS ) || ( i != argc ) || ( pHostPort == NULL ) || ( pPeerPort == NULL ) ||
+        ( iterations == 0U ) || ( idleSeconds == 0U ) )
+    {
+        ( void ) fprintf( stderr, "Usage: %s -p host COM port -q peer COM port [-n iterations] [-i idle seconds]\n", argv[ 0 ] );
+        ret = EXIT_FAILURE;
+    }
+    else if( xTaskCreate( prvBenchmarkTask, "Benchmark", BENCH_TASK_STACK_SIZE, NULL,
+                          tskIDLE_PRIORITY + 1U, NULL ) != pdPASS )
+    {
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        vTaskStartScheduler();
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+/* configSUPPORT_STATIC_ALLOCATION is set to 1, so the application provides the
+ * memory of the Idle task. */
+void vApplicationGetIdleTaskMemory( StaticTask_t ** ppxIdleTaskTCBBuffer,
+                                    StackType_t ** ppxIdleTaskStackBuffer,
+                                    uint32_t * pulIdleTaskStackSize )
+{
+    static StaticTask_t xIdleTaskTCB;
+    static StackType_t uxIdleTaskStack[ configMINIMAL_STACK_SIZE ];
+
+    *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
+    *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+/*-----------------------------------------------------------*/
+
+/* configSUPPORT_STATIC_ALLOCATION and configUSE_TIMERS are set to 1, so the
+ * application provides the memory of the Timer service task. */
+void vApplicationGetTimerTaskMemory( StaticTask_t ** ppxTimerTaskTCBBuffer,
+                                     StackType_t ** ppxTimerTaskStackBuffer,
+                                     uint32_t * pulTimerTaskStackSize )
+{
+    static StaticTask_t xTimerTaskTCB;
+    static StackType_t uxTimerTaskStack[ configTIMER_TASK_STACK_DEPTH ];
+
+    *ppxTimerTaskTCBBuffer = &xTimerTaskTCB;
+    *ppxTimerTaskStackBuffer = uxTimerTaskStack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,2638 @@
+/*
+ * Amazon FreeRTOS CELLULAR Preview Release
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file modem_sim.c
+ * @brief Host side AT modem simulator attached to a POSIX pty.
+ *
+ * The simulator implements the AT commands used by cellular_setup.c and the
+ * socket path of the BG96, SIM70x0 and Quectel GSM modules. Sockets opened by
+ * the host are bridged to TCP endpoints, optionally redirected to a local
+ * server. Line rate, command latency, URC delay and radio round trip time are
+ * configurable, so throughput and latency of the comm interface and the
+ * cellular library can be measured without a modem.
+ *
+ * AT+CMUX=0 switches to the basic option of the 3GPP TS 27.010 multiplexer.
+ * Every DLCI feeds the same AT parser. Responses and URCs go out on the DLCI
+ * that carried the last AT data, and are held while the host has set FC on
+ * it with an MSC.
+ *
+ * Build: gcc -O2 -o modem_sim tools/modem_sim/modem_sim.c
+ */
+
+/*-----------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/*-----------------------------------------------------------*/
+
+/* Number of sockets, the connect ID range of the simulated modules. */
+#define SIM_MAX_SOCKETS               ( 12U )
+
+/* Number of PDN contexts. */
+#define SIM_MAX_CONTEXTS              ( 16U )
+
+/* Longest AT command line accepted. */
+#define SIM_LINE_MAX                  ( 1024U )
+
+/* Largest payload of a single send command. */
+#define SIM_SEND_MAX                  ( 1500U )
+
+/* Downlink bytes buffered per socket before the TCP endpoint is throttled. */
+#define SIM_SOCKET_RX_LIMIT           ( 65536U )
+
+/* Bytes moved to or from the pty in one transfer. */
+#define SIM_LINE_CHUNK_MAX            ( 4096U )
+
+/* Line time the pty transfers may catch up after an idle period. */
+#define SIM_LINE_BURST_US             ( 2000U )
+
+/* Poll timeout when nothing is scheduled. */
+#define SIM_IDLE_POLL_US              ( 100000U )
+
+/* Address reported for every activated PDN context. */
+#define SIM_LOCAL_IP_ADDRESS          "10.0.0.2"
+
+/* 3GPP TS 27.010 basic option framing. */
+#define SIM_MUX_FLAG                  ( 0xF9U )
+#define SIM_MUX_EA                    ( 0x01U )
+#define SIM_MUX_CR                    ( 0x02U )
+#define SIM_MUX_PF                    ( 0x10U )
+#define SIM_MUX_SABM                  ( 0x2FU )
+#define SIM_MUX_UA                    ( 0x63U )
+#define SIM_MUX_DM                    ( 0x0FU )
+#define SIM_MUX_DISC                  ( 0x43U )
+#define SIM_MUX_UIH                   ( 0xEFU )
+#define SIM_MUX_MSG_CLD               ( 0xC1U )
+#define SIM_MUX_MSG_MSC               ( 0xE1U )
+#define SIM_MUX_MSC_FC                ( 0x02U )
+
+/* Highest DLCI accepted, DLCI 0 is the control channel. */
+#define SIM_MUX_MAX_DLCI              ( 4U )
+
+/* Largest and default information field size (N1). */
+#define SIM_MUX_FRAME_MAX             ( 32768U )
+#define SIM_MUX_DEFAULT_N1            ( 31U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Simulated module profiles.
+ */
+typedef enum SimProfile
+{
+    SIM_PROFILE_BG96 = 0,
+    SIM_PROFILE_SIM70X0,
+    SIM_PROFILE_QGSM
+} SimProfile_t;
+
+/**
+ * @brief Simulator settings from the command line.
+ */
+typedef struct SimConfig
+{
+    SimProfile_t profile;       /**< Simulated module. */
+    uint32_t baudRate;          /**< Line rate in bits per second, 0 for unlimited. */
+    uint32_t maxBaudRate;       /**< Highest line rate AT+IPR accepts, 0 for any. */
+    uint32_t commandLatencyUs;  /**< Time from the end of a command line to its response. */
+    uint32_t urcDelayUs;        /**< Time from an event to the URC reporting it. */
+    uint32_t radioRttUs;        /**< Round trip time of the simulated radio link. */
+    uint32_t attachUs;          /**< Time from AT+CFUN=1 to network registration. */
+    const char * pRedirectHost; /**< Host all sockets connect to, NULL to use the requested host. */
+    const char * pRedirectPort; /**< Port all sockets connect to, NULL to use the requested port. */
+    const char * pLinkPath;     /**< Symbolic link created to the pty slave. */
+    bool verbose;               /**< Log AT traffic to stderr. */
+} SimConfig_t;
+
+/**
+ * @brief Growable byte buffer.
+ */
+typedef struct SimBuffer
+{
+    uint8_t * pData;
+    size_t length;
+    size_t capacity;
+} SimBuffer_t;
+
+/**
+ * @brief Scheduled event types.
+ */
+typedef enum SimEventType
+{
+    SIM_EVENT_EMIT = 0,   /**< Queue data to the pty. */
+    SIM_EVENT_UPLINK,     /**< Send data to the TCP endpoint of a socket. */
+    SIM_EVENT_DOWNLINK,   /**< Data from the TCP endpoint reaches the module. */
+    SIM_EVENT_REMOTE_CLOSE, /**< TCP endpoint close reaches the module. */
+    SIM_EVENT_SET_RATE,   /**< Switch the line rate after AT+IPR. */
+    SIM_EVENT_MUX_START   /**< Enter multiplexer mode after AT+CMUX. */
+} SimEventType_t;
+
+/**
+ * @brief Event scheduled on the simulated timeline.
+ */
+typedef struct SimEvent
+{
+    uint64_t dueUs;
+    SimEventType_t type;
+    uint32_t socketId;
+    uint32_t value;
+    size_t length;
+    struct SimEvent * pNext;
+    uint8_t data[];
+} SimEvent_t;
+
+/**
+ * @brief Simulated module socket.
+ */
+typedef struct SimSocket
+{
+    bool inUse;         /**< Opened by the host and not yet closed. */
+    int fd;             /**< TCP endpoint, -1 if not connected. */
+    SimBuffer_t rx;     /**< Downlink data waiting for the read command. */
+    size_t rxInFlight;  /**< Downlink data scheduled but not yet in rx. */
+    bool rxNotified;    /**< Receive URC sent and rx not yet drained. */
+    bool remoteClosed;  /**< The TCP endpoint closed the connection. */
+    uint32_t generation; /**< Incremented on close, discards events of a previous connection. */
+    uint64_t openedAtUs; /**< Time the open result is reported, the endpoint is not read before. */
+    char remoteHost[ 64 ];
+    uint16_t remotePort;
+} SimSocket_t;
+
+/**
+ * @brief Result of an AT command handler.
+ */
+typedef enum SimResult
+{
+    SIM_RESULT_OK = 0, /**< Append OK to the response. */
+    SIM_RESULT_ERROR,  /**< Discard the response and report ERROR. */
+    SIM_RESULT_NONE    /**< The handler wrote the final result itself. */
+} SimResult_t;
+
+/**
+ * @brief Parsed AT command.
+ */
+typedef struct SimCommand
+{
+    const char * pName; /**< Command name, for example "+QIOPEN". */
+    char type;          /**< '?' for read, '=' for set, 't' for test, 0 for execute. */
+    const char * pArgs; /**< Arguments of a set command. */
+} SimCommand_t;
+
+typedef SimResult_t ( * SimHandler_t )( const SimCommand_t * pCommand );
+
+/**
+ * @brief Entry of an AT command table.
+ */
+typedef struct SimHandlerEntry
+{
+    const char * pName;
+    SimHandler_t handler;
+} SimHandlerEntry_t;
+
+/*-----------------------------------------------------------*/
+
+static SimConfig_t simConfig =
+{
+    .profile          = SIM_PROFILE_BG96,
+    .baudRate         = 115200U,
+    .maxBaudRate      = 0U,
+    .commandLatencyUs = 5000U,
+    .urcDelayUs       = 1000U,
+    .radioRttUs       = 100000U,
+    .attachUs         = 1000000U,
+    .pRedirectHost    = NULL,
+    .pRedirectPort    = NULL,
+    .pLinkPath        = NULL,
+    .verbose          = false
+};
+
+static const char * const profileManufacturer[] = { "Quectel", "SIMCOM_Ltd", "Quectel_Ltd" };
+static const char * const profileModel[] = { "BG96", "SIM7080", "Quectel_M95" };
+
+static volatile sig_atomic_t simStop = 0;
+
+static int ptyMasterFd = -1;
+static SimBuffer_t ptyTxBuffer = { 0 };
+static double ptyTxReadyUs = 0;
+static double ptyRxReadyUs = 0;
+
+static SimEvent_t * pEventList = NULL;
+
+/* Command line parser state. */
+static char lineBuffer[ SIM_LINE_MAX ];
+static size_t lineLength = 0;
+static bool lineOverflow = false;
+static bool echoEnabled = true;
+
+/* Data mode after a send prompt. */
+static bool sendPending = false;
+static uint32_t sendSocketId = 0;
+static size_t sendLength = 0;
+static SimBuffer_t sendBuffer = { 0 };
+
+/* Response of the command being handled. */
+static SimBuffer_t responseBuffer = { 0 };
+static uint32_t responseExtraDelayUs = 0;
+
+/* Multiplexer mode after AT+CMUX. */
+static bool muxMode = false;
+static uint32_t muxFrameSize = SIM_MUX_DEFAULT_N1;
+static uint8_t muxDlci = 1;                                   /* DLCI of the last AT data. */
+static bool muxDlciOpen[ SIM_MUX_MAX_DLCI + 1U ] = { false };
+static bool muxFlowStopped[ SIM_MUX_MAX_DLCI + 1U ] = { false };
+static SimBuffer_t muxTxBuffer = { 0 };                       /* AT output not framed yet. */
+static uint8_t muxFrame[ SIM_MUX_FRAME_MAX + 5U ];            /* Received frame without the flags. */
+static size_t muxFrameLength = 0;
+
+/* Module state. */
+static bool radioOn = true;
+static uint64_t registeredAtUs = 0;
+static uint8_t cregMode = 0;
+static uint8_t cgregMode = 0;
+static uint8_t ceregMode = 0;
+static bool contextActive[ SIM_MAX_CONTEXTS ] = { false };
+static char contextApn[ SIM_MAX_CONTEXTS ][ 64 ] = { { 0 } };
+static SimSocket_t simSockets[ SIM_MAX_SOCKETS ];
+
+/* Counters reported on exit. */
+static uint64_t commandCount = 0;
+static uint64_t uplinkBytes = 0;
+static uint64_t downlinkBytes = 0;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowUs( void )
+{
+    struct timespec now = { 0 };
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000U ) + ( ( uint64_t ) now.tv_nsec / 1000U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvLog( const char * pFormat,
+                    ... )
+{
+    va_list args;
+
+    if( simConfig.verbose == true )
+    {
+        ( void ) fprintf( stderr, "[%10.3f] ", ( double ) prvNowUs() / 1000.0 );
+        va_start( args, pFormat );
+        ( void ) vfprintf( stderr, pFormat, args );
+        va_end( args );
+        ( void ) fputc( '\n', stderr );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvBufferAppend( SimBuffer_t * pBuffer,
+                             const void * pData,
+                             size_t length )
+{
+    size_t newCapacity = 0;
+
+    if( ( pBuffer->length + length ) > pBuffer->capacity )
+    {
+        newCapacity = ( pBuffer->capacity == 0U ) ? 256U : pBuffer->capacity;
+
+        while( newCapacity < ( pBuffer->length + length ) )
+        {
+            newCapacity = newCapacity * 2U;
+        }
+
+        pBuffer->pData = realloc( pBuffer->pData, newCapacity );
+
+        if( pBuffer->pData == NULL )
+        {
+            ( void ) fprintf( stderr, "modem_sim: out of memory\n" );
+            exit( EXIT_FAILURE );
+        }
+
+        pBuffer->capacity = newCapacity;
+    }
+
+    ( void ) memcpy( &pBuffer->pData[ pBuffer->length ], pData, length );
+    pBuffer->length = pBuffer->length + length;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvBufferConsume( SimBuffer_t * pBuffer,
+                              size_t length )
+{
+    ( void ) memmove( pBuffer->pData, &pBuffer->pData[ length ], pBuffer->length - length );
+    pBuffer->length = pBuffer->length - length;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvSchedule( uint32_t delayUs,
+                         SimEventType_t type,
+                         uint32_t socketId,
+                         uint32_t value,
+                         const void * pData,
+                         size_t length )
+{
+    SimEvent_t * pEvent = malloc( sizeof( SimEvent_t ) + length );
+    SimEvent_t ** ppNext = &pEventList;
+
+    if( pEvent == NULL )
+    {
+        ( void ) fprintf( stderr, "modem_sim: out of memory\n" );
+        exit( EXIT_FAILURE );
+    }
+
+    pEvent->dueUs = prvNowUs() + delayUs;
+    pEvent->type = type;
+    pEvent->socketId = socketId;
+    pEvent->value = value;
+    pEvent->length = length;
+
+    if( length > 0U )
+    {
+        ( void ) memcpy( pEvent->data, pData, length );
+    }
+
+    /* Events due at the same time keep their scheduling order. */
+    while( ( *ppNext != NULL ) && ( ( *ppNext )->dueUs <= pEvent->dueUs ) )
+    {
+        ppNext = &( *ppNext )->pNext;
+    }
+
+    pEvent->pNext = *ppNext;
+    *ppNext = pEvent;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvEmit( uint32_t delayUs,
+                     const char * pFormat,
+                     ... )
+{
+    char line[ 256 ];
+    int length = 0;
+    va_list args;
+
+    line[ 0 ] = '\r';
+    line[ 1 ] = '\n';
+    va_start( args, pFormat );
+    length = vsnprintf( &line[ 2 ], sizeof( line ) - 4U, pFormat, args );
+    va_end( args );
+
+    if( length > ( int ) ( sizeof( line ) - 5U ) )
+    {
+        length = ( int ) ( sizeof( line ) - 5U );
+    }
+
+    line[ length + 2 ] = '\r';
+    line[ length + 3 ] = '\n';
+    prvSchedule( delayUs, SIM_EVENT_EMIT, 0, 0, line, ( size_t ) length + 4U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvRespond( const char * pFormat,
+                        ... )
+{
+    char line[ 256 ];
+    int length = 0;
+    va_list args;
+
+    va_start( args, pFormat );
+    length = vsnprintf( line, sizeof( line ), pFormat, args );
+    va_end( args );
+
+    if( length >= ( int ) sizeof( line ) )
+    {
+        length = ( int ) sizeof( line ) - 1;
+    }
+
+    prvBufferAppend( &responseBuffer, "\r\n", 2U );
+    prvBufferAppend( &responseBuffer, line, ( size_t ) length );
+    prvBufferAppend( &responseBuffer, "\r\n", 2U );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvIsRegistered( void )
+{
+    return ( radioOn == true ) && ( prvNowUs() >= registeredAtUs );
+}
+
+/*-----------------------------------------------------------*/
+
+static uint8_t prvAccessTechnology( void )
+{
+    uint8_t act = 0U;
+
+    if( simConfig.profile == SIM_PROFILE_BG96 )
+    {
+        /* eMTC. */
+        act = 8U;
+    }
+    else if( simConfig.profile == SIM_PROFILE_SIM70X0 )
+    {
+        /* E-UTRAN. */
+        act = 7U;
+    }
+    else
+    {
+        /* GSM. */
+        act = 0U;
+    }
+
+    return act;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Argument parsing helpers. Arguments are separated by commas and may be quoted. */
+static const char * prvNextArg( const char * pArgs,
+                                char * pOut,
+                                size_t outLength )
+{
+    size_t i = 0;
+    bool quoted = false;
+
+    while( ( pArgs != NULL ) && ( *pArgs != '\0' ) && ( ( *pArgs != ',' ) || ( quoted == true ) ) )
+    {
+        if( *pArgs == '"' )
+        {
+            quoted = !quoted;
+        }
+        else if( i < ( outLength - 1U ) )
+        {
+            pOut[ i ] = *pArgs;
+            i++;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+
+        pArgs++;
+    }
+
+    pOut[ i ] = '\0';
+
+    if( ( pArgs != NULL ) && ( *pArgs == ',' ) )
+    {
+        pArgs++;
+    }
+    else
+    {
+        pArgs = NULL;
+    }
+
+    return pArgs;
+}
+
+static bool prvArgsToUint( const char * pArgs,
+                           uint32_t * pValues,
+                           uint32_t count )
+{
+    char arg[ 32 ];
+    char * pEnd = NULL;
+    uint32_t i = 0;
+    bool ret = true;
+
+    for( i = 0; ( i < count ) && ( ret == true ); i++ )
+    {
+        if( pArgs == NULL )
+        {
+            ret = false;
+        }
+        else
+        {
+            pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+            pValues[ i ] = ( uint32_t ) strtoul( arg, &pEnd, 10 );
+
+            if( ( arg[ 0 ] == '\0' ) || ( *pEnd != '\0' ) )
+            {
+                ret = false;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvRegistrationUrc( uint32_t delayUs,
+                                bool registered )
+{
+    uint8_t stat = ( registered == true ) ? 1U : ( ( radioOn == true ) ? 2U : 0U );
+
+    if( cregMode != 0U )
+    {
+        prvEmit( delayUs, "+CREG: %u", stat );
+    }
+
+    if( cgregMode != 0U )
+    {
+        prvEmit( delayUs, "+CGREG: %u", stat );
+    }
+
+    if( ceregMode != 0U )
+    {
+        prvEmit( delayUs, "+CEREG: %u", stat );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static SimSocket_t * prvGetSocket( uint32_t socketId )
+{
+    SimSocket_t * pSocket = NULL;
+
+    if( socketId < SIM_MAX_SOCKETS )
+    {
+        pSocket = &simSockets[ socketId ];
+    }
+
+    return pSocket;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvCloseSocket( SimSocket_t * pSocket )
+{
+    if( pSocket->fd >= 0 )
+    {
+        ( void ) close( pSocket->fd );
+    }
+
+    pSocket->fd = -1;
+    pSocket->inUse = false;
+    pSocket->generation++;
+    pSocket->rx.length = 0;
+    pSocket->rxNotified = false;
+    pSocket->remoteClosed = false;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Connect the socket to its TCP endpoint. Returns false if the endpoint is not reachable. */
+static bool prvConnectSocket( SimSocket_t * pSocket )
+{
+    struct addrinfo hints = { 0 };
+    struct addrinfo * pResult = NULL;
+    struct addrinfo * pAddr = NULL;
+    char portString[ 8 ];
+    const char * pHost = ( simConfig.pRedirectHost != NULL ) ? simConfig.pRedirectHost : pSocket->remoteHost;
+    const char * pPort = portString;
+    int fd = -1;
+
+    ( void ) snprintf( portString, sizeof( portString ), "%u", pSocket->remotePort );
+
+    if( simConfig.pRedirectPort != NULL )
+    {
+        pPort = simConfig.pRedirectPort;
+    }
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if( getaddrinfo( pHost, pPort, &hints, &pResult ) == 0 )
+    {
+        for( pAddr = pResult; ( pAddr != NULL ) && ( fd < 0 ); pAddr = pAddr->ai_next )
+        {
+            fd = socket( pAddr->ai_family, pAddr->ai_socktype, pAddr->ai_protocol );
+
+            if( ( fd >= 0 ) && ( connect( fd, pAddr->ai_addr, pAddr->ai_addrlen ) != 0 ) )
+            {
+                ( void ) close( fd );
+                fd = -1;
+            }
+        }
+
+        freeaddrinfo( pResult );
+    }
+
+    prvLog( "socket connect %s:%s %s", pHost, pPort, ( fd >= 0 ) ? "ok" : "failed" );
+    pSocket->fd = fd;
+    pSocket->openedAtUs = prvNowUs() + simConfig.commandLatencyUs + simConfig.radioRttUs;
+
+    return ( fd >= 0 );
+}
+
+/*-----------------------------------------------------------*/
+
+/* Parse the service type, host and port of a socket open command. */
+static bool prvParseOpen( const char * pArgs,
+                          SimSocket_t * pSocket )
+{
+    char arg[ 64 ];
+    bool ret = false;
+
+    pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+
+    if( ( pArgs != NULL ) && ( strcasecmp( arg, "TCP" ) == 0 ) )
+    {
+        pArgs = prvNextArg( pArgs, pSocket->remoteHost, sizeof( pSocket->remoteHost ) );
+
+        if( pArgs != NULL )
+        {
+            ( void ) prvNextArg( pArgs, arg, sizeof( arg ) );
+            pSocket->remotePort = ( uint16_t ) strtoul( arg, NULL, 10 );
+            ret = ( pSocket->remotePort != 0U );
+        }
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Start the data mode of a send command. */
+static SimResult_t prvStartSend( const char * pArgs )
+{
+    uint32_t values[ 2 ] = { 0 };
+    SimSocket_t * pSocket = NULL;
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    if( prvArgsToUint( pArgs, values, 2U ) == true )
+    {
+        pSocket = prvGetSocket( values[ 0 ] );
+
+        if( ( pSocket != NULL ) && ( pSocket->inUse == true ) && ( values[ 1 ] > 0U ) && ( values[ 1 ] <= SIM_SEND_MAX ) )
+        {
+            sendPending = true;
+            sendSocketId = values[ 0 ];
+            sendLength = values[ 1 ];
+            sendBuffer.length = 0;
+            prvBufferAppend( &responseBuffer, "\r\n> ", 4U );
+            result = SIM_RESULT_NONE;
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Move up to length bytes of downlink data of a socket to the response. */
+static size_t prvReadSocket( SimSocket_t * pSocket,
+                             size_t length,
+                             SimBuffer_t * pOut )
+{
+    if( length > pSocket->rx.length )
+    {
+        length = pSocket->rx.length;
+    }
+
+    prvBufferAppend( pOut, pSocket->rx.pData, length );
+    prvBufferConsume( &pSocket->rx, length );
+
+    /* The module reports new data again once the buffer was drained. */
+    if( pSocket->rx.length == 0U )
+    {
+        pSocket->rxNotified = false;
+    }
+
+    return length;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Report downlink data or a remote close of a socket with the URC of the profile. */
+static void prvSocketUrc( uint32_t socketId,
+                          bool closed )
+{
+    if( simConfig.profile == SIM_PROFILE_BG96 )
+    {
+        prvEmit( simConfig.urcDelayUs, "+QIURC: \"%s\",%u", ( closed == true ) ? "closed" : "recv", socketId );
+    }
+    else if( simConfig.profile == SIM_PROFILE_SIM70X0 )
+    {
+        if( closed == true )
+        {
+            prvEmit( simConfig.urcDelayUs, "+CASTATE: %u,0", socketId );
+        }
+        else
+        {
+            prvEmit( simConfig.urcDelayUs, "+CADATAIND: %u", socketId );
+        }
+    }
+    else
+    {
+        if( closed == true )
+        {
+            prvEmit( simConfig.urcDelayUs, "%u, CLOSED", socketId );
+        }
+        else
+        {
+            prvEmit( simConfig.urcDelayUs, "+QIRDI: 0,1,%u", socketId );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/* Commands common to all profiles. */
+
+static SimResult_t prvHandleCpin( const SimCommand_t * pCommand )
+{
+    if( pCommand->type == '?' )
+    {
+        prvRespond( "+CPIN: READY" );
+    }
+
+    return SIM_RESULT_OK;
+}
+
+static SimResult_t prvHandleCfun( const SimCommand_t * pCommand )
+{
+    uint32_t fun = 0;
+    SimResult_t result = SIM_RESULT_OK;
+
+    if( pCommand->type == '?' )
+    {
+        prvRespond( "+CFUN: %u", ( radioOn == true ) ? 1U : 4U );
+    }
+    else if( pCommand->type == '=' )
+    {
+        if( prvArgsToUint( pCommand->pArgs, &fun, 1U ) == false )
+        {
+            result = SIM_RESULT_ERROR;
+        }
+        else if( fun == 1U )
+        {
+            if( radioOn == false )
+            {
+                radioOn = true;
+                registeredAtUs = prvNowUs() + simConfig.attachUs;
+                prvRegistrationUrc( simConfig.commandLatencyUs + 1U, false );
+                prvRegistrationUrc( simConfig.attachUs + simConfig.urcDelayUs, true );
+            }
+        }
+        else
+        {
+            radioOn = false;
+            ( void ) memset( contextActive, 0, sizeof( contextActive ) );
+            prvRegistrationUrc( simConfig.commandLatencyUs + 1U, false );
+        }
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return result;
+}
+
+static SimResult_t prvHandleRegistration( const SimCommand_t * pCommand )
+{
+    uint8_t * pMode = &cregMode;
+    uint32_t mode = 0;
+    uint8_t stat = prvIsRegistered() ? 1U : ( ( radioOn == true ) ? 2U : 0U );
+    SimResult_t result = SIM_RESULT_OK;
+
+    if( strcmp( pCommand->pName, "+CGREG" ) == 0 )
+    {
+        pMode = &cgregMode;
+    }
+    else if( strcmp( pCommand->pName, "+CEREG" ) == 0 )
+    {
+        pMode = &ceregMode;
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    if( pCommand->type == '?' )
+    {
+        if( ( *pMode >= 2U ) && ( stat == 1U ) )
+        {
+            prvRespond( "%s: %u,%u,\"0001\",\"00000001\",%u", pCommand->pName, *pMode, stat, prvAccessTechnology() );
+        }
+        else
+        {
+            prvRespond( "%s: %u,%u", pCommand->pName, *pMode, stat );
+        }
+    }
+    else if( pCommand->type == '=' )
+    {
+        if( prvArgsToUint( pCommand->pArgs, &mode, 1U ) == true )
+        {
+            *pMode = ( uint8_t ) mode;
+        }
+        else
+        {
+            result = SIM_RESULT_ERROR;
+        }
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return result;
+}
+
+static SimResult_t prvHandleCops( const SimCommand_t * pCommand )
+{
+    if( pCommand->type == '?' )
+    {
+        if( prvIsRegistered() == true )
+        {
+            prvRespond( "+COPS: 0,0,\"SIMULATED\",%u", prvAccessTechnology() );
+        }
+        else
+        {
+            prvRespond( "+COPS: 0" );
+        }
+    }
+
+    return SIM_RESULT_OK;
+}
+
+static SimResult_t prvHandleCsq( const SimCommand_t * pCommand )
+{
+    ( void ) pCommand;
+    prvRespond( "+CSQ: %u,99", prvIsRegistered() ? 20U : 99U );
+
+    return SIM_RESULT_OK;
+}
+
+static SimResult_t prvHandleIdentity( const SimCommand_t * pCommand )
+{
+    SimResult_t result = SIM_RESULT_OK;
+
+    if( pCommand->type == 't' )
+    {
+        /* Test command, OK only. */
+    }
+    else if( strcmp( pCommand->pName, "+CGMI" ) == 0 )
+    {
+        prvRespond( "%s", profileManufacturer[ simConfig.profile ] );
+    }
+    else if( strcmp( pCommand->pName, "+CGMM" ) == 0 )
+    {
+        prvRespond( "%s", profileModel[ simConfig.profile ] );
+    }
+    else if( strcmp( pCommand->pName, "+CGMR" ) == 0 )
+    {
+        prvRespond( "SIMULATOR01A01" );
+    }
+    else if( ( strcmp( pCommand->pName, "+CGSN" ) == 0 ) || ( strcmp( pCommand->pName, "+GSN" ) == 0 ) )
+    {
+        prvRespond( "869000000000001" );
+    }
+    else if( strcmp( pCommand->pName, "+CIMI" ) == 0 )
+    {
+        prvRespond( "001010000000001" );
+    }
+    else if( strcmp( pCommand->pName, "+QCCID" ) == 0 )
+    {
+        prvRespond( "+QCCID: 89000000000000000001" );
+    }
+    else if( strcmp( pCommand->pName, "+CCID" ) == 0 )
+    {
+        prvRespond( "89000000000000000001" );
+    }
+    else
+    {
+        result = SIM_RESULT_ERROR;
+    }
+
+    return result;
+}
+
+static SimResult_t prvHandleCgdcont( const SimCommand_t * pCommand )
+{
+    uint32_t i = 0;
+    uint32_t contextId = 0;
+    char arg[ 64 ];
+    const char * pArgs = pCommand->pArgs;
+    SimResult_t result = SIM_RESULT_OK;
+
+    if( pCommand->type == '?' )
+    {
+        for( i = 1U; i < SIM_MAX_CONTEXTS; i++ )
+        {
+            if( contextApn[ i ][ 0 ] != '\0' )
+            {
+                prvRespond( "+CGDCONT: %u,\"IP\",\"%s\",\"0.0.0.0\",0,0", i, contextApn[ i ] );
+            }
+        }
+    }
+    else if( pCommand->type == '=' )
+    {
+        pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+        contextId = ( uint32_t ) strtoul( arg, NULL, 10 );
+
+        if( contextId >= SIM_MAX_CONTEXTS )
+        {
+            result = SIM_RESULT_ERROR;
+        }
+        else if( pArgs != NULL )
+        {
+            pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+
+            if( pArgs != NULL )
+            {
+                ( void ) prvNextArg( pArgs, contextApn[ contextId ], sizeof( contextApn[ contextId ] ) );
+            }
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return result;
+}
+
+static SimResult_t prvHandleCgact( const SimCommand_t * pCommand )
+{
+    uint32_t i = 0;
+
+    if( pCommand->type == '?' )
+    {
+        for( i = 1U; i < SIM_MAX_CONTEXTS; i++ )
+        {
+            if( contextApn[ i ][ 0 ] != '\0' )
+            {
+                prvRespond( "+CGACT: %u,%u", i, ( contextActive[ i ] == true ) ? 1U : 0U );
+            }
+        }
+    }
+
+    return SIM_RESULT_OK;
+}
+
+static SimResult_t prvHandleCgatt( const SimCommand_t * pCommand )
+{
+    if( pCommand->type == '?' )
+    {
+        prvRespond( "+CGATT: %u", prvIsRegistered() ? 1U : 0U );
+    }
+
+    return SIM_RESULT_OK;
+}
+
+static SimResult_t prvHandleCgpaddr( const SimCommand_t * pCommand )
+{
+    uint32_t contextId = 0;
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    if( ( pCommand->type == '=' ) &&
+        ( prvArgsToUint( pCommand->pArgs, &contextId, 1U ) == true ) &&
+        ( contextId < SIM_MAX_CONTEXTS ) )
+    {
+        prvRespond( "+CGPADDR: %u,%s", contextId,
+                    ( contextActive[ contextId ] == true ) ? SIM_LOCAL_IP_ADDRESS : "0.0.0.0" );
+        result = SIM_RESULT_OK;
+    }
+
+    return result;
+}
+
+static SimResult_t prvHandleIpr( const SimCommand_t * pCommand )
+{
+    uint32_t rate = 0;
+    SimResult_t result = SIM_RESULT_OK;
+
+    if( pCommand->type == '?' )
+    {
+        prvRespond( "+IPR: %u", simConfig.baudRate );
+    }
+    else if( pCommand->type == '=' )
+    {
+        if( ( prvArgsToUint( pCommand->pArgs, &rate, 1U ) == true ) && ( rate > 0U ) &&
+            ( ( simConfig.maxBaudRate == 0U ) || ( rate <= simConfig.maxBaudRate ) ) )
+        {
+            /* The new rate applies after the OK has been sent at the old rate. */
+            prvSchedule( simConfig.commandLatencyUs + 1U, SIM_EVENT_SET_RATE, 0, rate, NULL, 0 );
+        }
+        else
+        {
+            result = SIM_RESULT_ERROR;
+        }
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return result;
+}
+
+static SimResult_t prvHandleCmux( const SimCommand_t * pCommand )
+{
+    char arg[ 16 ];
+    const char * pArgs = NULL;
+    uint32_t frameSize = SIM_MUX_DEFAULT_N1;
+    uint32_t i = 0;
+    SimResult_t result = SIM_RESULT_OK;
+
+    if( pCommand->type == 't' )
+    {
+        prvRespond( "+CMUX: (0),(0),(1-6),(31-%u)", SIM_MUX_FRAME_MAX );
+    }
+    else if( pCommand->type == '=' )
+    {
+        /* AT+CMUX=<mode>[,<subset>[,<port speed>[,<N1>]]]. Only the basic option with UIH frames. */
+        pArgs = prvNextArg( pCommand->pArgs, arg, sizeof( arg ) );
+
+        if( strcmp( arg, "0" ) != 0 )
+        {
+            result = SIM_RESULT_ERROR;
+        }
+
+        for( i = 1U; ( i < 4U ) && ( pArgs != NULL ); i++ )
+        {
+            pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+
+            if( ( i == 1U ) && ( arg[ 0 ] != '\0' ) && ( strcmp( arg, "0" ) != 0 ) )
+            {
+                result = SIM_RESULT_ERROR;
+            }
+            else if( ( i == 3U ) && ( arg[ 0 ] != '\0' ) )
+            {
+                frameSize = ( uint32_t ) strtoul( arg, NULL, 10 );
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+
+        if( ( frameSize < SIM_MUX_DEFAULT_N1 ) || ( frameSize > SIM_MUX_FRAME_MAX ) )
+        {
+            result = SIM_RESULT_ERROR;
+        }
+
+        if( result == SIM_RESULT_OK )
+        {
+            /* The multiplexer starts after the OK has been sent. */
+            prvSchedule( simConfig.commandLatencyUs + 1U, SIM_EVENT_MUX_START, 0, frameSize, NULL, 0 );
+        }
+    }
+    else
+    {
+        result = SIM_RESULT_ERROR;
+    }
+
+    return result;
+}
+
+static const SimHandlerEntry_t commonHandlers[] =
+{
+    { "+CPIN",    prvHandleCpin         },
+    { "+CFUN",    prvHandleCfun         },
+    { "+CREG",    prvHandleRegistration },
+    { "+CGREG",   prvHandleRegistration },
+    { "+CEREG",   prvHandleRegistration },
+    { "+COPS",    prvHandleCops         },
+    { "+CSQ",     prvHandleCsq          },
+    { "+CGMI",    prvHandleIdentity     },
+    { "+CGMM",    prvHandleIdentity     },
+    { "+CGMR",    prvHandleIdentity     },
+    { "+CGSN",    prvHandleIdentity     },
+    { "+GSN",     prvHandleIdentity     },
+    { "+CIMI",    prvHandleIdentity     },
+    { "+QCCID",   prvHandleIdentity     },
+    { "+CCID",    prvHandleIdentity     },
+    { "+CGDCONT", prvHandleCgdcont      },
+    { "+CGACT",   prvHandleCgact        },
+    { "+CGATT",   prvHandleCgatt        },
+    { "+CGPADDR", prvHandleCgpaddr      },
+    { "+IPR",     prvHandleIpr          },
+    { "+CMUX",    prvHandleCmux         },
+    { NULL,       NULL                  }
+};
+
+/*-----------------------------------------------------------*/
+
+/* BG96 commands. */
+
+static SimResult_t prvBg96Qsimstat( const SimCommand_t * pCommand )
+{
+    if( pCommand->type == '?' )
+    {
+        prvRespond( "+QSIMSTAT: 0,1" );
+    }
+
+    return SIM_RESULT_OK;
+}
+
+static SimResult_t prvBg96Qicsgp( const SimCommand_t * pCommand )
+{
+    char arg[ 64 ];
+    uint32_t contextId = 0;
+    const char * pArgs = prvNextArg( pCommand->pArgs, arg, sizeof( arg ) );
+    SimResult_t result = SIM_RESULT_OK;
+
+    contextId = ( uint32_t ) strtoul( arg, NULL, 10 );
+
+    if( ( pCommand->type != '=' ) || ( contextId >= SIM_MAX_CONTEXTS ) )
+    {
+        result = ( pCommand->type == 't' ) ? SIM_RESULT_OK : SIM_RESULT_ERROR;
+    }
+    else if( pArgs == NULL )
+    {
+        prvRespond( "+QICSGP: 1,\"%s\",\"\",\"\",0", contextApn[ contextId ] );
+    }
+    else
+    {
+        /* Context type, then APN. */
+        pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+
+        if( pArgs != NULL )
+        {
+            ( void ) prvNextArg( pArgs, contextApn[ contextId ], sizeof( contextApn[ contextId ] ) );
+        }
+    }
+
+    return result;
+}
+
+static SimResult_t prvBg96Qiact( const SimCommand_t * pCommand )
+{
+    uint32_t contextId = 0;
+    uint32_t i = 0;
+    SimResult_t result = SIM_RESULT_OK;
+
+    if( pCommand->type == '?' )
+    {
+        for( i = 1U; i < SIM_MAX_CONTEXTS; i++ )
+        {
+            if( contextActive[ i ] == true )
+            {
+                prvRespond( "+QIACT: %u,1,1,\"%s\"", i, SIM_LOCAL_IP_ADDRESS );
+            }
+        }
+    }
+    else if( ( pCommand->type == '=' ) &&
+             ( prvArgsToUint( pCommand->pArgs, &contextId, 1U ) == true ) &&
+             ( contextId < SIM_MAX_CONTEXTS ) && ( prvIsRegistered() == true ) )
+    {
+        /* Activation completes after a network round trip. */
+        contextActive[ contextId ] = true;
+        responseExtraDelayUs = simConfig.radioRttUs;
+    }
+    else
+    {
+        result = SIM_RESULT_ERROR;
+    }
+
+    return result;
+}
+
+static SimResult_t prvBg96Qideact( const SimCommand_t * pCommand )
+{
+    uint32_t contextId = 0;
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    if( ( prvArgsToUint( pCommand->pArgs, &contextId, 1U ) == true ) && ( contextId < SIM_MAX_CONTEXTS ) )
+    {
+        contextActive[ contextId ] = false;
+        responseExtraDelayUs = simConfig.radioRttUs;
+        result = SIM_RESULT_OK;
+    }
+
+    return result;
+}
+
+static SimResult_t prvBg96Qiopen( const SimCommand_t * pCommand )
+{
+    char arg[ 16 ];
+    const char * pArgs = pCommand->pArgs;
+    uint32_t contextId = 0;
+    uint32_t socketId = 0;
+    SimSocket_t * pSocket = NULL;
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+    contextId = ( uint32_t ) strtoul( arg, NULL, 10 );
+    pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+    socketId = ( uint32_t ) strtoul( arg, NULL, 10 );
+    pSocket = prvGetSocket( socketId );
+
+    if( ( pArgs != NULL ) && ( pSocket != NULL ) && ( pSocket->inUse == false ) &&
+        ( contextId < SIM_MAX_CONTEXTS ) && ( prvParseOpen( pArgs, pSocket ) == true ) )
+    {
+        /* OK first, the connect result follows when the handshake completes. */
+        pSocket->inUse = true;
+
+        if( ( contextActive[ contextId ] == true ) && ( prvConnectSocket( pSocket ) == true ) )
+        {
+            prvEmit( simConfig.commandLatencyUs + simConfig.radioRttUs, "+QIOPEN: %u,0", socketId );
+        }
+        else
+        {
+            prvCloseSocket( pSocket );
+            prvEmit( simConfig.commandLatencyUs + simConfig.radioRttUs, "+QIOPEN: %u,566", socketId );
+        }
+
+        result = SIM_RESULT_OK;
+    }
+
+    return result;
+}
+
+static SimResult_t prvBg96Qird( const SimCommand_t * pCommand )
+{
+    uint32_t values[ 2 ] = { 0 };
+    SimSocket_t * pSocket = NULL;
+    SimBuffer_t data = { 0 };
+    char header[ 32 ];
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    if( prvArgsToUint( pCommand->pArgs, values, 2U ) == true )
+    {
+        pSocket = prvGetSocket( values[ 0 ] );
+
+        if( ( pSocket != NULL ) && ( pSocket->inUse == true ) )
+        {
+            ( void ) prvReadSocket( pSocket, values[ 1 ], &data );
+            ( void ) snprintf( header, sizeof( header ), "\r\n+QIRD: %u\r\n", ( unsigned int ) data.length );
+            prvBufferAppend( &responseBuffer, header, strlen( header ) );
+
+            if( data.length > 0U )
+            {
+                prvBufferAppend( &responseBuffer, data.pData, data.length );
+                prvBufferAppend( &responseBuffer, "\r\n", 2U );
+            }
+
+            free( data.pData );
+            result = SIM_RESULT_OK;
+        }
+    }
+
+    return result;
+}
+
+static SimResult_t prvHandleQiclose( const SimCommand_t * pCommand )
+{
+    uint32_t socketId = 0;
+    SimSocket_t * pSocket = NULL;
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    ( void ) prvArgsToUint( pCommand->pArgs, &socketId, 1U );
+    pSocket = prvGetSocket( socketId );
+
+    if( ( pCommand->type == '=' ) && ( pSocket != NULL ) )
+    {
+        prvCloseSocket( pSocket );
+
+        if( simConfig.profile == SIM_PROFILE_QGSM )
+        {
+            prvRespond( "%u, CLOSE OK", socketId );
+            result = SIM_RESULT_NONE;
+        }
+        else
+        {
+            result = SIM_RESULT_OK;
+        }
+    }
+
+    return result;
+}
+
+static SimResult_t prvHandleQisend( const SimCommand_t * pCommand )
+{
+    return ( pCommand->type == '=' ) ? prvStartSend( pCommand->pArgs ) : SIM_RESULT_ERROR;
+}
+
+static const SimHandlerEntry_t bg96Handlers[] =
+{
+    { "+QSIMSTAT", prvBg96Qsimstat  },
+    { "+QICSGP",   prvBg96Qicsgp    },
+    { "+QIACT",    prvBg96Qiact     },
+    { "+QIDEACT",  prvBg96Qideact   },
+    { "+QIOPEN",   prvBg96Qiopen    },
+    { "+QISEND",   prvHandleQisend  },
+    { "+QIRD",     prvBg96Qird      },
+    { "+QICLOSE",  prvHandleQiclose },
+    { NULL,        NULL             }
+};
+
+/*-----------------------------------------------------------*/
+
+/* SIM70x0 commands. */
+
+static SimResult_t prvSim70x0Cncfg( const SimCommand_t * pCommand )
+{
+    char arg[ 16 ];
+    uint32_t contextId = 0;
+    const char * pArgs = prvNextArg( pCommand->pArgs, arg, sizeof( arg ) );
+    SimResult_t result = SIM_RESULT_OK;
+
+    contextId = ( uint32_t ) strtoul( arg, NULL, 10 );
+
+    if( ( pCommand->type == '=' ) && ( contextId < SIM_MAX_CONTEXTS ) )
+    {
+        /* IP type, then APN. */
+        pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+
+        if( pArgs != NULL )
+        {
+            ( void ) prvNextArg( pArgs, contextApn[ contextId ], sizeof( contextApn[ contextId ] ) );
+        }
+    }
+    else if( pCommand->type == '=' )
+    {
+        result = SIM_RESULT_ERROR;
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return result;
+}
+
+static SimResult_t prvSim70x0Cnact( const SimCommand_t * pCommand )
+{
+    uint32_t values[ 2 ] = { 0 };
+    uint32_t i = 0;
+    SimResult_t result = SIM_RESULT_OK;
+
+    if( pCommand->type == '?' )
+    {
+        for( i = 0U; i < 4U; i++ )
+        {
+            prvRespond( "+CNACT: %u,%u,\"%s\"", i, ( contextActive[ i ] == true ) ? 1U : 0U,
+                        ( contextActive[ i ] == true ) ? SIM_LOCAL_IP_ADDRESS : "0.0.0.0" );
+        }
+    }
+    else if( ( pCommand->type == '=' ) && ( prvArgsToUint( pCommand->pArgs, values, 2U ) == true ) &&
+             ( values[ 0 ] < 4U ) && ( ( values[ 1 ] == 0U ) || ( prvIsRegistered() == true ) ) )
+    {
+        /* OK first, the activation result follows after a network round trip. */
+        contextActive[ values[ 0 ] ] = ( values[ 1 ] != 0U );
+        prvEmit( simConfig.commandLatencyUs + simConfig.radioRttUs, "+APP PDP: %u,%s",
+                 values[ 0 ], ( values[ 1 ] != 0U ) ? "ACTIVE" : "DEACTIVE" );
+    }
+    else
+    {
+        result = SIM_RESULT_ERROR;
+    }
+
+    return result;
+}
+
+static SimResult_t prvSim70x0Caopen( const SimCommand_t * pCommand )
+{
+    char arg[ 16 ];
+    const char * pArgs = pCommand->pArgs;
+    uint32_t socketId = 0;
+    uint32_t contextId = 0;
+    SimSocket_t * pSocket = NULL;
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+    socketId = ( uint32_t ) strtoul( arg, NULL, 10 );
+    pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+    contextId = ( uint32_t ) strtoul( arg, NULL, 10 );
+    pSocket = prvGetSocket( socketId );
+
+    if( ( pArgs != NULL ) && ( pSocket != NULL ) && ( pSocket->inUse == false ) &&
+        ( contextId < SIM_MAX_CONTEXTS ) && ( prvParseOpen( pArgs, pSocket ) == true ) )
+    {
+        /* The result and OK are returned once the handshake completes. */
+        pSocket->inUse = true;
+
+        if( ( contextActive[ contextId ] == true ) && ( prvConnectSocket( pSocket ) == true ) )
+        {
+            prvRespond( "+CAOPEN: %u,0", socketId );
+        }
+        else
+        {
+            prvCloseSocket( pSocket );
+            prvRespond( "+CAOPEN: %u,1", socketId );
+        }
+
+        responseExtraDelayUs = simConfig.radioRttUs;
+        result = SIM_RESULT_OK;
+    }
+
+    return result;
+}
+
+static SimResult_t prvSim70x0Carecv( const SimCommand_t * pCommand )
+{
+    uint32_t values[ 2 ] = { 0 };
+    SimSocket_t * pSocket = NULL;
+    SimBuffer_t data = { 0 };
+    char header[ 32 ];
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    if( prvArgsToUint( pCommand->pArgs, values, 2U ) == true )
+    {
+        pSocket = prvGetSocket( values[ 0 ] );
+
+        if( ( pSocket != NULL ) && ( pSocket->inUse == true ) )
+        {
+            ( void ) prvReadSocket( pSocket, values[ 1 ], &data );
+
+            if( data.length > 0U )
+            {
+                ( void ) snprintf( header, sizeof( header ), "\r\n+CARECV: %u,", ( unsigned int ) data.length );
+                prvBufferAppend( &responseBuffer, header, strlen( header ) );
+                prvBufferAppend( &responseBuffer, data.pData, data.length );
+                prvBufferAppend( &responseBuffer, "\r\n", 2U );
+            }
+            else
+            {
+                prvRespond( "+CARECV: 0" );
+            }
+
+            free( data.pData );
+            result = SIM_RESULT_OK;
+        }
+    }
+
+    return result;
+}
+
+static SimResult_t prvSim70x0Caclose( const SimCommand_t * pCommand )
+{
+    uint32_t socketId = 0;
+    SimSocket_t * pSocket = NULL;
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    if( prvArgsToUint( pCommand->pArgs, &socketId, 1U ) == true )
+    {
+        pSocket = prvGetSocket( socketId );
+
+        if( pSocket != NULL )
+        {
+            prvCloseSocket( pSocket );
+            result = SIM_RESULT_OK;
+        }
+    }
+
+    return result;
+}
+
+static const SimHandlerEntry_t sim70x0Handlers[] =
+{
+    { "+CNCFG",   prvSim70x0Cncfg   },
+    { "+CNACT",   prvSim70x0Cnact   },
+    { "+CAOPEN",  prvSim70x0Caopen  },
+    { "+CASEND",  prvHandleQisend   },
+    { "+CARECV",  prvSim70x0Carecv  },
+    { "+CACLOSE", prvSim70x0Caclose },
+    { NULL,       NULL              }
+};
+
+/*-----------------------------------------------------------*/
+
+/* Quectel GSM commands. */
+
+static SimResult_t prvQgsmQicsgp( const SimCommand_t * pCommand )
+{
+    char arg[ 16 ];
+    const char * pArgs = prvNextArg( pCommand->pArgs, arg, sizeof( arg ) );
+
+    /* Mode, then APN for context 1. */
+    if( ( pCommand->type == '=' ) && ( pArgs != NULL ) )
+    {
+        ( void ) prvNextArg( pArgs, contextApn[ 1 ], sizeof( contextApn[ 1 ] ) );
+    }
+
+    return SIM_RESULT_OK;
+}
+
+static SimResult_t prvQgsmQiact( const SimCommand_t * pCommand )
+{
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    if( ( pCommand->type == 0 ) && ( prvIsRegistered() == true ) )
+    {
+        contextActive[ 1 ] = true;
+        responseExtraDelayUs = simConfig.radioRttUs;
+        result = SIM_RESULT_OK;
+    }
+
+    return result;
+}
+
+static SimResult_t prvQgsmQideact( const SimCommand_t * pCommand )
+{
+    ( void ) pCommand;
+    contextActive[ 1 ] = false;
+    prvRespond( "DEACT OK" );
+    responseExtraDelayUs = simConfig.radioRttUs;
+
+    return SIM_RESULT_NONE;
+}
+
+static SimResult_t prvQgsmQilocip( const SimCommand_t * pCommand )
+{
+    ( void ) pCommand;
+
+    if( contextActive[ 1 ] == true )
+    {
+        prvRespond( SIM_LOCAL_IP_ADDRESS );
+    }
+    else
+    {
+        prvRespond( "ERROR" );
+    }
+
+    return SIM_RESULT_NONE;
+}
+
+static SimResult_t prvQgsmQiopen( const SimCommand_t * pCommand )
+{
+    char arg[ 16 ];
+    const char * pArgs = pCommand->pArgs;
+    uint32_t socketId = 0;
+    SimSocket_t * pSocket = NULL;
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    pArgs = prvNextArg( pArgs, arg, sizeof( arg ) );
+    socketId = ( uint32_t ) strtoul( arg, NULL, 10 );
+    pSocket = prvGetSocket( socketId );
+
+    if( ( pArgs != NULL ) && ( pSocket != NULL ) && ( pSocket->inUse == false ) &&
+        ( prvParseOpen( pArgs, pSocket ) == true ) )
+    {
+        /* OK first, the connect result follows when the handshake completes. */
+        pSocket->inUse = true;
+
+        if( ( contextActive[ 1 ] == true ) && ( prvConnectSocket( pSocket ) == true ) )
+        {
+            prvEmit( simConfig.commandLatencyUs + simConfig.radioRttUs, "%u, CONNECT OK", socketId );
+        }
+        else
+        {
+            prvCloseSocket( pSocket );
+            prvEmit( simConfig.commandLatencyUs + simConfig.radioRttUs, "%u, CONNECT FAIL", socketId );
+        }
+
+        result = SIM_RESULT_OK;
+    }
+
+    return result;
+}
+
+static SimResult_t prvQgsmQird( const SimCommand_t * pCommand )
+{
+    uint32_t values[ 4 ] = { 0 };
+    SimSocket_t * pSocket = NULL;
+    SimBuffer_t data = { 0 };
+    char header[ 96 ];
+    SimResult_t result = SIM_RESULT_ERROR;
+
+    /* AT+QIRD=<id>,<sc>,<sid>,<len> */
+    if( prvArgsToUint( pCommand->pArgs, values, 4U ) == true )
+    {
+        pSocket = prvGetSocket( values[ 2 ] );
+
+        if( ( pSocket != NULL ) && ( pSocket->inUse == true ) )
+        {
+            ( void ) prvReadSocket( pSocket, values[ 3 ], &data );
+
+            if( data.length > 0U )
+            {
+                ( void ) snprintf( header, sizeof( header ), "\r\n+QIRD: %s:%u,TCP,%u\r\n",
+                                   pSocket->remoteHost, pSocket->remotePort, ( unsigned int ) data.length );
+                prvBufferAppend( &responseBuffer, header, strlen( header ) );
+                prvBufferAppend( &responseBuffer, data.pData, data.length );
+                prvBufferAppend( &responseBuffer, "\r\n", 2U );
+            }
+
+            free( data.pData );
+            result = SIM_RESULT_OK;
+        }
+    }
+
+    return result;
+}
+
+static const SimHandlerEntry_t qgsmHandlers[] =
+{
+    { "+QICSGP",  prvQgsmQicsgp    },
+    { "+QIACT",   prvQgsmQiact     },
+    { "+QIDEACT", prvQgsmQideact   },
+    { "+QILOCIP", prvQgsmQilocip   },
+    { "+QIOPEN",  prvQgsmQiopen    },
+    { "+QISEND",  prvHandleQisend  },
+    { "+QIRD",    prvQgsmQird      },
+    { "+QICLOSE", prvHandleQiclose },
+    { NULL,       NULL             }
+};
+
+/*-----------------------------------------------------------*/
+
+static SimHandler_t prvFindHandler( const SimHandlerEntry_t * pTable,
+                                    const char * pName )
+{
+    SimHandler_t handler = NULL;
+
+    for( ; ( pTable->pName != NULL ) && ( handler == NULL ); pTable++ )
+    {
+        if( strcmp( pTable->pName, pName ) == 0 )
+        {
+            handler = pTable->handler;
+        }
+    }
+
+    return handler;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvHandleCommand( char * pLine )
+{
+    static const SimHandlerEntry_t * const profileHandlers[] = { bg96Handlers, sim70x0Handlers, qgsmHandlers };
+    SimCommand_t command = { 0 };
+    SimHandler_t handler = NULL;
+    SimResult_t result = SIM_RESULT_OK;
+    char * pSeparator = NULL;
+    size_t i = 0;
+
+    prvLog( "<- %s", pLine );
+    commandCount++;
+    responseBuffer.length = 0;
+    responseExtraDelayUs = 0;
+
+    if( strncasecmp( pLine, "AT", 2U ) != 0 )
+    {
+        result = SIM_RESULT_ERROR;
+    }
+    else if( pLine[ 2 ] == '\0' )
+    {
+        /* Plain AT. */
+    }
+    else if( ( toupper( ( unsigned char ) pLine[ 2 ] ) == 'E' ) && ( pLine[ 3 ] != '\0' ) && ( pLine[ 4 ] == '\0' ) )
+    {
+        echoEnabled = ( pLine[ 3 ] == '1' );
+    }
+    else if( ( pLine[ 2 ] != '+' ) && ( pLine[ 2 ] != '&' ) )
+    {
+        /* ATV1, ATQ0, ATI and other basic commands. */
+        if( toupper( ( unsigned char ) pLine[ 2 ] ) == 'I' )
+        {
+            prvRespond( "%s %s", profileManufacturer[ simConfig.profile ], profileModel[ simConfig.profile ] );
+        }
+    }
+    else
+    {
+        /* Split the command into name, type and arguments. */
+        command.pName = &pLine[ 2 ];
+        pSeparator = strpbrk( &pLine[ 2 ], "=?" );
+
+        if( pSeparator == NULL )
+        {
+            command.type = 0;
+        }
+        else if( *pSeparator == '?' )
+        {
+            command.type = '?';
+        }
+        else if( pSeparator[ 1 ] == '?' )
+        {
+            command.type = 't';
+        }
+        else
+        {
+            command.type = '=';
+            command.pArgs = &pSeparator[ 1 ];
+        }
+
+        if( pSeparator != NULL )
+        {
+            *pSeparator = '\0';
+        }
+
+        for( i = 0; pLine[ 2 + i ] != '\0'; i++ )
+        {
+            pLine[ 2 + i ] = ( char ) toupper( ( unsigned char ) pLine[ 2 + i ] );
+        }
+
+        handler = prvFindHandler( profileHandlers[ simConfig.profile ], command.pName );
+
+        if( handler == NULL )
+        {
+            handler = prvFindHandler( commonHandlers, command.pName );
+        }
+
+        /* Configuration commands not simulated are accepted. */
+        if( handler != NULL )
+        {
+            result = handler( &command );
+        }
+    }
+
+    if( result == SIM_RESULT_OK )
+    {
+        prvBufferAppend( &responseBuffer, "\r\nOK\r\n", 6U );
+    }
+    else if( result == SIM_RESULT_ERROR )
+    {
+        responseBuffer.length = 0;
+        prvBufferAppend( &responseBuffer, "\r\nERROR\r\n", 9U );
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    prvSchedule( simConfig.commandLatencyUs + responseExtraDelayUs, SIM_EVENT_EMIT, 0, 0,
+                 responseBuffer.pData, responseBuffer.length );
+}
+
+/*-----------------------------------------------------------*/
+
+/* Queue AT output to the pty. In multiplexer mode it is framed by prvMuxFillTx. */
+static void prvOutput( const void * pData,
+                       size_t length )
+{
+    prvBufferAppend( ( muxMode == true ) ? &muxTxBuffer : &ptyTxBuffer, pData, length );
+}
+
+/*-----------------------------------------------------------*/
+
+/* The payload of a send command is complete. */
+static void prvCompleteSend( void )
+{
+    SimSocket_t * pSocket = prvGetSocket( sendSocketId );
+
+    prvLog( "<- %u bytes for socket %u", ( unsigned int ) sendBuffer.length, sendSocketId );
+    sendPending = false;
+
+    /* The payload is acknowledged once it is buffered, it reaches the endpoint after half a round trip. */
+    if( pSocket != NULL )
+    {
+        prvSchedule( simConfig.radioRttUs / 2U, SIM_EVENT_UPLINK, sendSocketId, pSocket->generation,
+                     sendBuffer.pData, sendBuffer.length );
+    }
+
+    if( ( pSocket != NULL ) && ( pSocket->inUse == true ) && ( pSocket->remoteClosed == false ) )
+    {
+        prvEmit( simConfig.commandLatencyUs, ( simConfig.profile == SIM_PROFILE_SIM70X0 ) ? "OK" : "SEND OK" );
+    }
+    else
+    {
+        prvEmit( simConfig.commandLatencyUs, ( simConfig.profile == SIM_PROFILE_SIM70X0 ) ? "ERROR" : "SEND FAIL" );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvReceiveBytes( const uint8_t * pData,
+                             size_t length )
+{
+    size_t i = 0;
+    size_t copyLength = 0;
+
+    while( i < length )
+    {
+        if( sendPending == true )
+        {
+            copyLength = sendLength - sendBuffer.length;
+
+            if( copyLength > ( length - i ) )
+            {
+                copyLength = length - i;
+            }
+
+            prvBufferAppend( &sendBuffer, &pData[ i ], copyLength );
+            i = i + copyLength;
+
+            if( sendBuffer.length == sendLength )
+            {
+                prvCompleteSend();
+            }
+        }
+        else
+        {
+            if( echoEnabled == true )
+            {
+                prvOutput( &pData[ i ], 1U );
+            }
+
+            if( pData[ i ] == '\r' )
+            {
+                lineBuffer[ lineLength ] = '\0';
+
+                if( ( lineOverflow == false ) && ( lineLength > 0U ) )
+                {
+                    prvHandleCommand( lineBuffer );
+                }
+
+                lineLength = 0;
+                lineOverflow = false;
+            }
+            else if( pData[ i ] == '\n' )
+            {
+                /* Line feeds after the carriage return are ignored. */
+            }
+            else if( lineLength < ( SIM_LINE_MAX - 1U ) )
+            {
+                lineBuffer[ lineLength ] = ( char ) pData[ i ];
+                lineLength++;
+            }
+            else
+            {
+                lineOverflow = true;
+            }
+
+            i++;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/* Reversed CRC-8 with polynomial x^8 + x^2 + x + 1 over the address, control and length fields. */
+static uint8_t prvMuxFcs( const uint8_t * pData,
+                          size_t length )
+{
+    uint8_t fcs = 0xFFU;
+    size_t i = 0;
+    uint32_t bit = 0;
+
+    for( i = 0; i < length; i++ )
+    {
+        fcs = fcs ^ pData[ i ];
+
+        for( bit = 0; bit < 8U; bit++ )
+        {
+            fcs = ( ( fcs & 0x01U ) != 0U ) ? ( uint8_t ) ( ( fcs >> 1 ) ^ 0xE0U ) : ( uint8_t ) ( fcs >> 1 );
+        }
+    }
+
+    return ( uint8_t ) ( 0xFFU - fcs );
+}
+
+/* Leave multiplexer mode and drop its state. */
+static void prvMuxReset( void )
+{
+    muxMode = false;
+    muxDlci = 1U;
+    muxFrameLength = 0;
+    muxTxBuffer.length = 0;
+    ( void ) memset( muxDlciOpen, 0, sizeof( muxDlciOpen ) );
+    ( void ) memset( muxFlowStopped, 0, sizeof( muxFlowStopped ) );
+}
+
+/* Queue a frame to the pty. Frames sent by the module set C/R in responses only. */
+static void prvMuxSendFrame( uint8_t dlci,
+                             uint8_t control,
+                             bool response,
+                             const uint8_t * pInfo,
+                             size_t infoLength )
+{
+    uint8_t header[ 5 ];
+    size_t headerLength = 4U;
+
+    header[ 0 ] = SIM_MUX_FLAG;
+    header[ 1 ] = ( uint8_t ) ( dlci << 2 ) | ( ( response == true ) ? SIM_MUX_CR : 0U ) | SIM_MUX_EA;
+    header[ 2 ] = control;
+
+    if( infoLength <= 127U )
+    {
+        header[ 3 ] = ( uint8_t ) ( ( infoLength << 1 ) | SIM_MUX_EA );
+    }
+    else
+    {
+        header[ 3 ] = ( uint8_t ) ( ( infoLength << 1 ) & 0xFEU );
+        header[ 4 ] = ( uint8_t ) ( infoLength >> 7 );
+        headerLength = 5U;
+    }
+
+    prvBufferAppend( &ptyTxBuffer, header, headerLength );
+
+    if( infoLength > 0U )
+    {
+        prvBufferAppend( &ptyTxBuffer, pInfo, infoLength );
+    }
+
+    header[ 0 ] = prvMuxFcs( &header[ 1 ], headerLength - 1U );
+    header[ 1 ] = SIM_MUX_FLAG;
+    prvBufferAppend( &ptyTxBuffer, header, 2U );
+}
+
+/* Frame the AT output while less than a frame waits for the line, so FC takes effect within a frame. */
+static void prvMuxFillTx( void )
+{
+    size_t frameLength = 0;
+
+    while( ( muxMode == true ) && ( muxTxBuffer.length > 0U ) && ( muxFlowStopped[ muxDlci ] == false ) &&
+           ( ptyTxBuffer.length < muxFrameSize ) )
+    {
+        frameLength = ( muxTxBuffer.length < muxFrameSize ) ? muxTxBuffer.length : muxFrameSize;
+        prvMuxSendFrame( muxDlci, SIM_MUX_UIH, false, muxTxBuffer.pData, frameLength );
+        prvBufferConsume( &muxTxBuffer, frameLength );
+    }
+}
+
+/* Multiplexer control message from the host on DLCI 0. */
+static void prvMuxControl( const uint8_t * pInfo,
+                           size_t infoLength )
+{
+    uint8_t response[ 4 ];
+    uint8_t dlci = 0;
+
+    if( ( infoLength >= 4U ) && ( pInfo[ 0 ] == ( SIM_MUX_MSG_MSC | SIM_MUX_CR ) ) )
+    {
+        dlci = pInfo[ 2 ] >> 2;
+
+        if( dlci <= SIM_MUX_MAX_DLCI )
+        {
+            muxFlowStopped[ dlci ] = ( ( pInfo[ 3 ] & SIM_MUX_MSC_FC ) != 0U );
+            prvLog( "<- MSC DLCI %u FC %u", dlci, ( muxFlowStopped[ dlci ] == true ) ? 1U : 0U );
+        }
+
+        response[ 0 ] = SIM_MUX_MSG_MSC;
+        response[ 1 ] = pInfo[ 1 ];
+        response[ 2 ] = pInfo[ 2 ];
+        response[ 3 ] = pInfo[ 3 ];
+        prvMuxSendFrame( 0U, SIM_MUX_UIH, false, response, 4U );
+    }
+    else if( ( infoLength >= 2U ) && ( pInfo[ 0 ] == ( SIM_MUX_MSG_CLD | SIM_MUX_CR ) ) )
+    {
+        prvLog( "<- CLD" );
+        response[ 0 ] = SIM_MUX_MSG_CLD;
+        response[ 1 ] = SIM_MUX_EA;
+        prvMuxSendFrame( 0U, SIM_MUX_UIH, false, response, 2U );
+        prvMuxReset();
+    }
+    else
+    {
+        /* Responses and other messages need no action. */
+    }
+}
+
+/* Handle a received frame with a valid FCS. */
+static void prvMuxHandleFrame( const uint8_t * pInfo,
+                               size_t infoLength )
+{
+    uint8_t dlci = muxFrame[ 0 ] >> 2;
+    uint8_t control = muxFrame[ 1 ] & ( uint8_t ) ~SIM_MUX_PF;
+
+    if( ( control == SIM_MUX_SABM ) && ( dlci <= SIM_MUX_MAX_DLCI ) )
+    {
+        prvLog( "<- SABM DLCI %u", dlci );
+        muxDlciOpen[ dlci ] = true;
+        muxFlowStopped[ dlci ] = false;
+        prvMuxSendFrame( dlci, SIM_MUX_UA | SIM_MUX_PF, true, NULL, 0U );
+    }
+    else if( control == SIM_MUX_SABM )
+    {
+        prvMuxSendFrame( dlci, SIM_MUX_DM | SIM_MUX_PF, true, NULL, 0U );
+    }
+    else if( control == SIM_MUX_DISC )
+    {
+        prvLog( "<- DISC DLCI %u", dlci );
+        prvMuxSendFrame( dlci, SIM_MUX_UA | SIM_MUX_PF, true, NULL, 0U );
+
+        if( dlci == 0U )
+        {
+            prvMuxReset();
+        }
+        else if( dlci <= SIM_MUX_MAX_DLCI )
+        {
+            muxDlciOpen[ dlci ] = false;
+        }
+        else
+        {
+            /* Empty else for MISRA 15.7 compliance. */
+        }
+    }
+    else if( ( control == SIM_MUX_UIH ) && ( dlci == 0U ) )
+    {
+        prvMuxControl( pInfo, infoLength );
+    }
+    else if( ( control == SIM_MUX_UIH ) && ( dlci <= SIM_MUX_MAX_DLCI ) && ( muxDlciOpen[ dlci ] == true ) )
+    {
+        muxDlci = dlci;
+        prvReceiveBytes( pInfo, infoLength );
+    }
+    else
+    {
+        prvLog( "<- frame 0x%02x on DLCI %u ignored", control, dlci );
+    }
+}
+
+/* Collect frames from the pty. The basic option has no transparency, so frames are delimited by their length. */
+static void prvMuxReceive( const uint8_t * pData,
+                           size_t length )
+{
+    size_t headerLength = 0;
+    size_t infoLength = 0;
+    size_t i = 0;
+
+    for( i = 0; ( i < length ) && ( muxMode == true ); i++ )
+    {
+        if( ( muxFrameLength == 0U ) && ( pData[ i ] == SIM_MUX_FLAG ) )
+        {
+            /* Opening, closing or repeated flag. */
+            continue;
+        }
+
+        muxFrame[ muxFrameLength ] = pData[ i ];
+        muxFrameLength++;
+
+        if( muxFrameLength >= 3U )
+        {
+            headerLength = ( ( muxFrame[ 2 ] & SIM_MUX_EA ) != 0U ) ? 3U : 4U;
+            infoLength = 0;
+
+            if( muxFrameLength >= headerLength )
+            {
+                infoLength = ( size_t ) muxFrame[ 2 ] >> 1;
+
+                if( headerLength == 4U )
+                {
+                    infoLength = infoLength | ( ( size_t ) muxFrame[ 3 ] << 7 );
+                }
+            }
+
+            if( infoLength > muxFrameSize )
+            {
+                /* Resynchronize on the next flag. */
+                prvLog( "<- frame of %u bytes over N1 dropped", ( unsigned int ) infoLength );
+                muxFrameLength = 0;
+            }
+            else if( ( muxFrameLength >= headerLength ) && ( muxFrameLength == ( headerLength + infoLength + 1U ) ) )
+            {
+                /* UIH frames exclude the information field from the FCS. Other frames carry none. */
+                if( muxFrame[ muxFrameLength - 1U ] == prvMuxFcs( muxFrame, headerLength ) )
+                {
+                    prvMuxHandleFrame( &muxFrame[ headerLength ], infoLength );
+                }
+                else
+                {
+                    prvLog( "<- frame with bad FCS dropped" );
+                }
+
+                muxFrameLength = 0;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvRunEvent( const SimEvent_t * pEvent )
+{
+    SimSocket_t * pSocket = prvGetSocket( pEvent->socketId );
+    bool wasEmpty = false;
+
+    switch( pEvent->type )
+    {
+        case SIM_EVENT_EMIT:
+            prvOutput( pEvent->data, pEvent->length );
+            break;
+
+        case SIM_EVENT_UPLINK:
+
+            if( ( pSocket->fd >= 0 ) && ( pSocket->generation == pEvent->value ) &&
+                ( send( pSocket->fd, pEvent->data, pEvent->length, MSG_NOSIGNAL ) == ( ssize_t ) pEvent->length ) )
+            {
+                uplinkBytes = uplinkBytes + pEvent->length;
+            }
+
+            break;
+
+        case SIM_EVENT_DOWNLINK:
+            pSocket->rxInFlight = pSocket->rxInFlight - pEvent->length;
+
+            if( ( pSocket->inUse == true ) && ( pSocket->generation == pEvent->value ) )
+            {
+                wasEmpty = ( pSocket->rx.length == 0U );
+                prvBufferAppend( &pSocket->rx, pEvent->data, pEvent->length );
+                downlinkBytes = downlinkBytes + pEvent->length;
+
+                if( ( wasEmpty == true ) && ( pSocket->rxNotified == false ) )
+                {
+                    pSocket->rxNotified = true;
+                    prvSocketUrc( pEvent->socketId, false );
+                }
+            }
+
+            break;
+
+        case SIM_EVENT_REMOTE_CLOSE:
+
+            if( ( pSocket->inUse == true ) && ( pSocket->generation == pEvent->value ) )
+            {
+                prvSocketUrc( pEvent->socketId, true );
+            }
+
+            break;
+
+        case SIM_EVENT_SET_RATE:
+            prvLog( "line rate %u", pEvent->value );
+            simConfig.baudRate = pEvent->value;
+            break;
+
+        case SIM_EVENT_MUX_START:
+            prvLog( "multiplexer mode, N1 %u", pEvent->value );
+            prvMuxReset();
+            muxMode = true;
+            muxFrameSize = pEvent->value;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/* Number of bytes the line can carry now in one direction. */
+static size_t prvLineBudget( double * pReadyUs,
+                             uint64_t nowUs )
+{
+    double usPerByte = 0;
+    size_t budget = SIM_LINE_CHUNK_MAX;
+
+    if( simConfig.baudRate != 0U )
+    {
+        /* 8N1, ten bit times per byte. */
+        usPerByte = 10000000.0 / ( double ) simConfig.baudRate;
+
+        if( ( *pReadyUs + SIM_LINE_BURST_US ) < ( double ) nowUs )
+        {
+            *pReadyUs = ( double ) nowUs - SIM_LINE_BURST_US;
+        }
+
+        budget = ( ( double ) nowUs > *pReadyUs ) ? ( size_t ) ( ( ( double ) nowUs - *pReadyUs ) / usPerByte ) : 0U;
+
+        if( budget > SIM_LINE_CHUNK_MAX )
+        {
+            budget = SIM_LINE_CHUNK_MAX;
+        }
+    }
+
+    return budget;
+}
+
+static void prvLineConsume( double * pReadyUs,
+                            size_t length )
+{
+    if( simConfig.baudRate != 0U )
+    {
+        *pReadyUs = *pReadyUs + ( ( double ) length * 10000000.0 / ( double ) simConfig.baudRate );
+    }
+}
+
+/* Time until the line can carry another byte. */
+static uint64_t prvLineWaitUs( double readyUs,
+                               uint64_t nowUs )
+{
+    double waitUs = readyUs + ( 10000000.0 / ( double ) simConfig.baudRate ) - ( double ) nowUs;
+
+    return ( waitUs > 0 ) ? ( uint64_t ) waitUs : 0U;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvPumpPty( uint64_t nowUs,
+                        bool readable )
+{
+    uint8_t buffer[ SIM_LINE_CHUNK_MAX ];
+    size_t budget = 0;
+    ssize_t length = 0;
+
+    budget = prvLineBudget( &ptyTxReadyUs, nowUs );
+    prvMuxFillTx();
+
+    if( ( budget > 0U ) && ( ptyTxBuffer.length > 0U ) )
+    {
+        length = write( ptyMasterFd, ptyTxBuffer.pData, ( budget < ptyTxBuffer.length ) ? budget : ptyTxBuffer.length );
+
+        if( length > 0 )
+        {
+            prvBufferConsume( &ptyTxBuffer, ( size_t ) length );
+            prvLineConsume( &ptyTxReadyUs, ( size_t ) length );
+        }
+    }
+
+    /* Frame the next output, so the line does not wait an idle poll for it. */
+    prvMuxFillTx();
+
+    budget = prvLineBudget( &ptyRxReadyUs, nowUs );
+
+    if( ( readable == true ) && ( budget > 0U ) )
+    {
+        length = read( ptyMasterFd, buffer, budget );
+
+        if( length > 0 )
+        {
+            prvLineConsume( &ptyRxReadyUs, ( size_t ) length );
+
+            if( muxMode == true )
+            {
+                prvMuxReceive( buffer, ( size_t ) length );
+            }
+            else
+            {
+                prvReceiveBytes( buffer, ( size_t ) length );
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvPumpSocket( uint32_t socketId )
+{
+    SimSocket_t * pSocket = &simSockets[ socketId ];
+    uint8_t buffer[ SIM_SEND_MAX ];
+    ssize_t length = 0;
+
+    length = recv( pSocket->fd, buffer, sizeof( buffer ), MSG_DONTWAIT );
+
+    if( length > 0 )
+    {
+        pSocket->rxInFlight = pSocket->rxInFlight + ( size_t ) length;
+        prvSchedule( simConfig.radioRttUs / 2U, SIM_EVENT_DOWNLINK, socketId, pSocket->generation, buffer, ( size_t ) length );
+    }
+    else if( ( length == 0 ) || ( ( errno != EAGAIN ) && ( errno != EWOULDBLOCK ) && ( errno != EINTR ) ) )
+    {
+        prvLog( "socket %u closed by the endpoint", socketId );
+        ( void ) close( pSocket->fd );
+        pSocket->fd = -1;
+        pSocket->remoteClosed = true;
+        prvSchedule( simConfig.radioRttUs / 2U, SIM_EVENT_REMOTE_CLOSE, socketId, pSocket->generation, NULL, 0 );
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static int prvOpenPty( void )
+{
+    struct termios options = { 0 };
+    const char * pSlaveName = NULL;
+    int slaveFd = -1;
+    int ret = -1;
+
+    ptyMasterFd = posix_openpt( O_RDWR | O_NOCTTY );
+
+    if( ( ptyMasterFd >= 0 ) && ( grantpt( ptyMasterFd ) == 0 ) && ( unlockpt( ptyMasterFd ) == 0 ) )
+    {
+        pSlaveName = ptsname( ptyMasterFd );
+    }
+
+    if( pSlaveName != NULL )
+    {
+        /* Keep the slave open so the master stays usable while the host reopens the port. */
+        slaveFd = open( pSlaveName, O_RDWR | O_NOCTTY );
+    }
+
+    if( ( slaveFd >= 0 ) && ( tcgetattr( slaveFd, &options ) == 0 ) )
+    {
+        cfmakeraw( &options );
+        ( void ) tcsetattr( slaveFd, TCSANOW, &options );
+        ( void ) fcntl( ptyMasterFd, F_SETFL, O_NONBLOCK );
+        ( void ) printf( "%s\n", pSlaveName );
+        ( void ) fflush( stdout );
+        ret = 0;
+
+        if( simConfig.pLinkPath != NULL )
+        {
+            ( void ) unlink( simConfig.pLinkPath );
+
+            if( symlink( pSlaveName, simConfig.pLinkPath ) != 0 )
+            {
+                ( void ) fprintf( stderr, "modem_sim: cannot create %s: %s\n", simConfig.pLinkPath, strerror( errno ) );
+                ret = -1;
+            }
+        }
+    }
+    else
+    {
+        ( void ) fprintf( stderr, "modem_sim: cannot open a pty: %s\n", strerror( errno ) );
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvRun( void )
+{
+    struct pollfd fds[ 1U + SIM_MAX_SOCKETS ];
+    uint32_t socketIds[ 1U + SIM_MAX_SOCKETS ];
+    nfds_t fdCount = 0;
+    uint64_t nowUs = 0;
+    uint64_t timeoutUs = 0;
+    uint64_t waitUs = 0;
+    struct timespec timeout = { 0 };
+    SimEvent_t * pEvent = NULL;
+    bool rxReady = false;
+    bool ptyReadable = false;
+    uint32_t i = 0;
+    nfds_t j = 0;
+
+    while( simStop == 0 )
+    {
+        nowUs = prvNowUs();
+
+        while( ( pEventList != NULL ) && ( pEventList->dueUs <= nowUs ) )
+        {
+            pEvent = pEventList;
+            pEventList = pEvent->pNext;
+            prvRunEvent( pEvent );
+            free( pEvent );
+        }
+
+        prvPumpPty( nowUs, ptyReadable );
+        ptyReadable = false;
+
+        /* Wake up for the next event, the next byte time or the pty and socket descriptors. */
+        timeoutUs = SIM_IDLE_POLL_US;
+
+        if( ( pEventList != NULL ) && ( ( pEventList->dueUs - nowUs ) < timeoutUs ) )
+        {
+            timeoutUs = ( pEventList->dueUs > nowUs ) ? ( pEventList->dueUs - nowUs ) : 0U;
+        }
+
+        rxReady = ( simConfig.baudRate == 0U ) || ( prvLineBudget( &ptyRxReadyUs, nowUs ) > 0U );
+
+        if( simConfig.baudRate != 0U )
+        {
+            if( ptyTxBuffer.length > 0U )
+            {
+                waitUs = prvLineWaitUs( ptyTxReadyUs, nowUs );
+                timeoutUs = ( waitUs < timeoutUs ) ? waitUs : timeoutUs;
+            }
+
+            if( rxReady == false )
+            {
+                waitUs = prvLineWaitUs( ptyRxReadyUs, nowUs );
+                timeoutUs = ( waitUs < timeoutUs ) ? waitUs : timeoutUs;
+            }
+        }
+
+        fdCount = 0;
+        fds[ 0 ].fd = ptyMasterFd;
+        fds[ 0 ].events = ( short ) ( ( rxReady == true ) ? POLLIN : 0 );
+
+        if( ( ptyTxBuffer.length > 0U ) && ( simConfig.baudRate == 0U ) )
+        {
+            fds[ 0 ].events = ( short ) ( fds[ 0 ].events | POLLOUT );
+        }
+
+        fdCount++;
+
+        for( i = 0; i < SIM_MAX_SOCKETS; i++ )
+        {
+            if( ( simSockets[ i ].fd >= 0 ) && ( simSockets[ i ].openedAtUs > nowUs ) )
+            {
+                /* Data from the endpoint can not overtake the open result. */
+                waitUs = simSockets[ i ].openedAtUs - nowUs;
+                timeoutUs = ( waitUs < timeoutUs ) ? waitUs : timeoutUs;
+            }
+            else if( ( simSockets[ i ].fd >= 0 ) &&
+                     ( ( simSockets[ i ].rx.length + simSockets[ i ].rxInFlight ) < SIM_SOCKET_RX_LIMIT ) )
+            {
+                fds[ fdCount ].fd = simSockets[ i ].fd;
+                fds[ fdCount ].events = POLLIN;
+                socketIds[ fdCount ] = i;
+                fdCount++;
+            }
+            else
+            {
+                /* Empty else for MISRA 15.7 compliance. */
+            }
+        }
+
+        timeout.tv_sec = ( time_t ) ( timeoutUs / 1000000U );
+        timeout.tv_nsec = ( long ) ( ( timeoutUs % 1000000U ) * 1000U );
+
+        if( ppoll( fds, fdCount, &timeout, NULL ) > 0 )
+        {
+            ptyReadable = ( ( fds[ 0 ].revents & POLLIN ) != 0 );
+
+            for( j = 1; j < fdCount; j++ )
+            {
+                if( fds[ j ].revents != 0 )
+                {
+                    prvPumpSocket( socketIds[ j ] );
+                }
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvSignalHandler( int signal )
+{
+    ( void ) signal;
+    simStop = 1;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvUsage( void )
+{
+    ( void ) fprintf( stderr,
+                      "usage: modem_sim [options]\n"
+                      "  -m <bg96|sim70x0|qgsm>  simulated module (default bg96)\n"
+                      "  -b <baud>               line rate in bit/s, 0 for unlimited (default 115200)\n"
+                      "  -B <baud>               highest line rate AT+IPR accepts, 0 for any (default 0)\n"
+                      "  -l <ms>                 command response latency (default 5)\n"
+                      "  -u <ms>                 URC delay (default 1)\n"
+                      "  -r <ms>                 radio round trip time (default 100)\n"
+                      "  -a <ms>                 network registration time after AT+CFUN=1 (default 1000)\n"
+                      "  -t <host[:port]>        connect all sockets to this TCP endpoint\n"
+                      "  -L <path>               create a symbolic link to the pty slave\n"
+                      "  -v                      log AT traffic to stderr\n" );
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvMsToUs( const char * pValue )
+{
+    return ( uint32_t ) ( strtod( pValue, NULL ) * 1000.0 );
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static char redirect[ 128 ];
+    char * pColon = NULL;
+    uint32_t i = 0;
+    int option = 0;
+    int ret = EXIT_SUCCESS;
+
+    while( ( option = getopt( argc, argv, "m:b:B:l:u:r:a:t:L:vh" ) ) != -1 )
+    {
+        switch( option )
+        {
+            case 'm':
+
+                if( strcmp( optarg, "bg96" ) == 0 )
+                {
+                    simConfig.profile = SIM_PROFILE_BG96;
+                }
+                else if( strcmp( optarg, "sim70x0" ) == 0 )
+                {
+                    simConfig.profile = SIM_PROFILE_SIM70X0;
+                }
+                else if( strcmp( optarg, "qgsm" ) == 0 )
+                {
+                    simConfig.profile = SIM_PROFILE_QGSM;
+                }
+                else
+                {
+                    ret = EXIT_FAILURE;
+                }
+
+                break;
+
+            case 'b':
+                simConfig.baudRate = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'B':
+                simConfig.maxBaudRate = ( uint32_t ) strtoul( optarg, NULL, 10 );
+                break;
+
+            case 'l':
+                simConfig.commandLatencyUs = prvMsToUs( optarg );
+                break;
+
+            case 'u':
+                simConfig.urcDelayUs = prvMsToUs( optarg );
+                break;
+
+            case 'r':
+                simConfig.radioRttUs = prvMsToUs( optarg );
+                break;
+
+            case 'a':
+                simConfig.attachUs = prvMsToUs( optarg );
+                break;
+
+            case 't':
+                ( void ) snprintf( redirect, sizeof( redirect ), "%s", optarg );
+                pColon = strrchr( redirect, ':' );
+
+                if( pColon != NULL )
+                {
+                    *pColon = '\0';
+                    simConfig.pRedirectPort = &pColon[ 1 ];
+                }
+
+                simConfig.pRedirectHost = redirect;
+                break;
+
+            case 'L':
+                simConfig.pLinkPath = optarg;
+                break;
+
+            case 'v':
+                simConfig.verbose = true;
+                break;
+
+            default:
+                ret = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if( ret != EXIT_SUCCESS )
+    {
+        prvUsage();
+    }
+    else
+    {
+        for( i = 0; i < SIM_MAX_SOCKETS; i++ )
+        {
+            simSockets[ i ].fd = -1;
+        }
+
+        ( void ) signal( SIGINT, prvSignalHandler );
+        ( void ) signal( SIGTERM, prvSignalHandler );
+        ( void ) signal( SIGPIPE, SIG_IGN );
+
+        if( prvOpenPty() != 0 )
+        {
+            ret = EXIT_FAILURE;
+        }
+        else
+        {
+            ptyTxReadyUs = ( double ) prvNowUs();
+            ptyRxReadyUs = ptyTxReadyUs;
+            prvRun();
+
+            ( void ) fprintf( stderr, "modem_sim: %llu commands, %llu bytes uplink, %llu bytes downlink\n",
+                              ( unsigned long long ) commandCount,
+                              ( unsigned long long ) uplinkBytes,
+                              ( unsigned long long ) downlinkBytes );
+
+            if( simConfig.pLinkPath != NULL )
+            {
+                ( void ) unlink( simConfig.pLinkPath );
+            }
+        }
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/